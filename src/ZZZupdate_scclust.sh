@@ -1,5 +1,15 @@
 #!/bin/bash
 
+# libscclust carries local changes that are not in upstream scclust (NNG
+# files, mapped data sets, blocking, hierarchical and statistics changes,
+# run reports, allocator hooks, distance metrics, ...). This script replaces
+# libscclust with upstream master and would discard them. Only run it with
+# SCC_FORCE_UPSTREAM=1 once the local changes have been merged upstream.
+if [ "${SCC_FORCE_UPSTREAM}" != "1" ]; then
+	echo "libscclust has local changes that would be overwritten; see the comment in $0." >&2
+	exit 1
+fi
+
 rm -rf libscclust
 mkdir libscclust
 wget https://github.com/fsavje/scclust/archive/master.zip
@@ -12,23 +22,32 @@ cd ..
 rm libscclust/Makefile
 cat <<EOF > libscclust/Makefile
 # Use 64-bit arc ref: -DSCC_ARC64
-# Use stable NNG: -DSCC_STABLE_NNG
-# Use stable findseed: -DSCC_STABLE_FINDSEED
+# Always use stable NNG: -DSCC_STABLE_NNG
+# Always use stable findseed: -DSCC_STABLE_FINDSEED
 XTRA_FLAGS =
 
 LIBOBJS = \\
+	src/allocator.o \\
 	src/data_set.o \\
+	src/data_set_collapse.o \\
 	src/digraph_core.o \\
 	src/digraph_operations.o \\
 	src/dist_search_imp.o \\
 	src/error.o \\
+	src/file_map.o \\
 	src/hierarchical_clustering.o \\
+	src/hierarchical_sort.o \\
 	src/nng_batch_clustering.o \\
+	src/nng_blocked_clustering.o \\
 	src/nng_clustering.o \\
 	src/nng_core.o \\
 	src/nng_findseeds.o \\
+	src/nng_store.o \\
+	src/run_context.o \\
+	src/run_report.o \\
 	src/scclust_spi.o \\
 	src/scclust.o \\
+	src/spatial_order.o \\
 	src/utilities.o
 
 libscclust.a: \$(LIBOBJS)
@@ -37,10 +56,29 @@ libscclust.a: \$(LIBOBJS)
 %.o: %.c
 	\$(R_CC) \$(R_CPPFLAGS) \$(R_CFLAGS) \$(XTRA_FLAGS) -c \$< -o \$@
 
+BENCHES = \\
+	bench/bench_edge_sort \\
+	bench/bench_mapped_data \\
+	bench/bench_pipeline
+
+bench: \$(BENCHES)
+
+bench/%: bench/%.c libscclust.a
+	\$(R_CC) \$(R_CPPFLAGS) \$(R_CFLAGS) \$(XTRA_FLAGS) \$< libscclust.a -lm -o \$@
+
+TESTS = \\
+	tests/test_concurrent_runs
+
+check: \$(TESTS)
+	for t in \$(TESTS); do ./\$\$t || exit 1; done
+
+tests/%: tests/%.c libscclust.a
+	\$(R_CC) \$(R_CPPFLAGS) \$(R_CFLAGS) \$(XTRA_FLAGS) \$< libscclust.a -lm -lpthread -o \$@
+
 clean:
-	\$(R_RM) libscclust.a \$(LIBOBJS)
+	\$(R_RM) libscclust.a \$(LIBOBJS) \$(BENCHES) \$(TESTS)
 
-.PHONY: clean
+.PHONY: bench check clean
 EOF
 
 rm -r scclust-master master.zip
@@ -0,0 +1,173 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+/* Sorting of hierarchical clustering edge lists: radix sort against qsort.
+ *
+ * Usage: bench_edge_sort [num_edges ...]
+ *
+ * Each edge list holds distances between a center and uniformly distributed
+ * points in three dimensions, as when a cluster is broken. The default sizes
+ * range from 10^4 to 10^7 edges.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/scclust.h"
+#include "../src/hierarchical_sort.h"
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+typedef struct ibench_Edge {
+	double distance;
+	scc_PointIndex head;
+} ibench_Edge;
+
+
+static void ibench_fill_edges(size_t len_edges,
+                              double dists[],
+                              scc_PointIndex heads[]);
+
+
+static int ibench_compare_dist_edges(const void* a,
+                                     const void* b);
+
+
+static double ibench_seconds(void);
+
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(const int argc, char** const argv)
+{
+	static const size_t default_sizes[] = { 10000, 100000, 1000000, 10000000 };
+	const size_t num_sizes = (argc > 1) ? (size_t) (argc - 1) : (sizeof(default_sizes) / sizeof(default_sizes[0]));
+
+	printf("%12s %12s %12s %8s\n", "num_edges", "qsort_sec", "radix_sec", "speedup");
+	for (size_t s = 0; s < num_sizes; ++s) {
+		const size_t len_edges = (argc > 1) ? (size_t) strtoull(argv[s + 1], NULL, 10) : default_sizes[s];
+		if (len_edges == 0) {
+			fprintf(stderr, "Invalid arguments.\n");
+			return EXIT_FAILURE;
+		}
+
+		double* const dists = malloc(sizeof(double[len_edges]));
+		scc_PointIndex* const heads = malloc(sizeof(scc_PointIndex[len_edges]));
+		double* const scratch_dists = malloc(sizeof(double[len_edges]));
+		scc_PointIndex* const scratch_heads = malloc(sizeof(scc_PointIndex[len_edges]));
+		ibench_Edge* const qsorted = malloc(sizeof(ibench_Edge[len_edges]));
+		if ((dists == NULL) || (heads == NULL) || (scratch_dists == NULL) ||
+		        (scratch_heads == NULL) || (qsorted == NULL)) {
+			fprintf(stderr, "Out of memory.\n");
+			return EXIT_FAILURE;
+		}
+
+		ibench_fill_edges(len_edges, dists, heads);
+		for (size_t i = 0; i < len_edges; ++i) {
+			qsorted[i] = (ibench_Edge) {
+				.distance = dists[i],
+				.head = heads[i],
+			};
+		}
+
+		const double time_qsort = ibench_seconds();
+		qsort(qsorted, len_edges, sizeof(ibench_Edge), ibench_compare_dist_edges);
+		const double time_radix = ibench_seconds();
+		iscc_hi_sort_edges(len_edges, dists, heads, scratch_dists, scratch_heads);
+		const double time_done = ibench_seconds();
+
+		bool same_order = true;
+		for (size_t i = 0; i < len_edges; ++i) {
+			same_order = same_order && (qsorted[i].distance == dists[i]);
+		}
+
+		free(dists);
+		free(heads);
+		free(scratch_dists);
+		free(scratch_heads);
+		free(qsorted);
+
+		if (!same_order) {
+			fprintf(stderr, "Sorted orders differ.\n");
+			return EXIT_FAILURE;
+		}
+
+		printf("%12zu %12.4f %12.4f %7.1fx\n",
+		       len_edges,
+		       time_radix - time_qsort,
+		       time_done - time_radix,
+		       (time_radix - time_qsort) / (time_done - time_radix));
+	}
+
+	return EXIT_SUCCESS;
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static void ibench_fill_edges(const size_t len_edges,
+                              double dists[const],
+                              scc_PointIndex heads[const])
+{
+	srand(12345);
+	for (size_t i = 0; i < len_edges; ++i) {
+		double sq_dist = 0.0;
+		for (int d = 0; d < 3; ++d) {
+			const double value_diff = ((double) rand()) / RAND_MAX - 0.5;
+			sq_dist += value_diff * value_diff;
+		}
+		dists[i] = sqrt(sq_dist);
+		heads[i] = (scc_PointIndex) (i % INT32_MAX);
+	}
+}
+
+
+static int ibench_compare_dist_edges(const void* const a,
+                                     const void* const b)
+{
+	const double dist_a = ((const ibench_Edge*)a)->distance;
+	const double dist_b = ((const ibench_Edge*)b)->distance;
+
+	if (dist_a < dist_b) return -1;
+	if (dist_a > dist_b) return 1;
+	return 0;
+}
+
+
+static double ibench_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((double) ts.tv_sec) + ((double) ts.tv_nsec) / 1e9;
+}
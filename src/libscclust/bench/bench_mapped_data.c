@@ -0,0 +1,168 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+/* Throughput of size-constrained clustering on a memory-mapped data set.
+ *
+ * Usage: bench_mapped_data <file> <num_data_points> <num_dimensions> [size_constraint]
+ *
+ * If <file> does not exist, a raw row-major file with uniformly distributed
+ * data is written first. Choose `num_data_points * num_dimensions * 8` larger
+ * than the memory of the machine to measure out-of-core throughput; the page
+ * cache should be dropped between runs for cold-cache numbers.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../include/scclust.h"
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static bool ibench_write_data_file(const char* file_path,
+                                   uint64_t num_data_points,
+                                   uint32_t num_dimensions);
+
+
+static double ibench_seconds(void);
+
+
+static int ibench_fail(scc_ErrorCode ec);
+
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(const int argc, char** const argv)
+{
+	if ((argc != 4) && (argc != 5)) {
+		fprintf(stderr, "Usage: %s <file> <num_data_points> <num_dimensions> [size_constraint]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	const char* const file_path = argv[1];
+	const uint64_t num_data_points = strtoull(argv[2], NULL, 10);
+	const uint32_t num_dimensions = (uint32_t) strtoul(argv[3], NULL, 10);
+	const uint32_t size_constraint = (argc == 5) ? (uint32_t) strtoul(argv[4], NULL, 10) : 2;
+
+	if ((num_data_points == 0) || (num_dimensions == 0) || (size_constraint < 2)) {
+		fprintf(stderr, "Invalid arguments.\n");
+		return EXIT_FAILURE;
+	}
+
+	FILE* const existing = fopen(file_path, "rb");
+	if (existing != NULL) {
+		fclose(existing);
+	} else if (!ibench_write_data_file(file_path, num_data_points, num_dimensions)) {
+		fprintf(stderr, "Cannot write data file.\n");
+		return EXIT_FAILURE;
+	}
+
+	scc_ErrorCode ec;
+	const double time_start = ibench_seconds();
+
+	scc_DataSet* data_set;
+	if ((ec = scc_init_data_set_from_file(file_path, SCC_DF_RAW, num_dimensions, &data_set)) != SCC_ER_OK) {
+		return ibench_fail(ec);
+	}
+
+	scc_Clustering* clustering;
+	if ((ec = scc_init_empty_clustering(num_data_points, NULL, &clustering)) != SCC_ER_OK) {
+		scc_free_data_set(&data_set);
+		return ibench_fail(ec);
+	}
+
+	scc_ClusterOptions options = scc_get_default_options();
+	options.size_constraint = size_constraint;
+
+	const double time_mapped = ibench_seconds();
+	ec = scc_sc_clustering(data_set, &options, clustering);
+	const double time_done = ibench_seconds();
+
+	uint64_t num_clusters = 0;
+	if (ec == SCC_ER_OK) {
+		ec = scc_get_clustering_info(clustering, NULL, &num_clusters);
+	}
+
+	scc_free_clustering(&clustering);
+	scc_free_data_set(&data_set);
+
+	if (ec != SCC_ER_OK) return ibench_fail(ec);
+
+	const double data_mb = ((double) num_data_points) * num_dimensions * sizeof(double) / 1048576.0;
+	const double cluster_seconds = time_done - time_mapped;
+	printf("data_mb:         %.1f\n", data_mb);
+	printf("num_clusters:    %llu\n", (unsigned long long) num_clusters);
+	printf("map_seconds:     %.3f\n", time_mapped - time_start);
+	printf("cluster_seconds: %.3f\n", cluster_seconds);
+	printf("points_per_sec:  %.0f\n", ((double) num_data_points) / cluster_seconds);
+
+	return EXIT_SUCCESS;
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static bool ibench_write_data_file(const char* const file_path,
+                                   const uint64_t num_data_points,
+                                   const uint32_t num_dimensions)
+{
+	FILE* const file = fopen(file_path, "wb");
+	if (file == NULL) return false;
+
+	double row[num_dimensions];
+	bool write_ok = true;
+	srand(12345);
+	for (uint64_t i = 0; write_ok && (i < num_data_points); ++i) {
+		for (uint32_t d = 0; d < num_dimensions; ++d) {
+			row[d] = ((double) rand()) / RAND_MAX;
+		}
+		write_ok = (fwrite(row, sizeof(double), num_dimensions, file) == num_dimensions);
+	}
+
+	return (fclose(file) == 0) && write_ok;
+}
+
+
+static double ibench_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((double) ts.tv_sec) + ((double) ts.tv_nsec) / 1e9;
+}
+
+
+static int ibench_fail(const scc_ErrorCode ec)
+{
+	char error_message[255];
+	scc_get_latest_error(sizeof(error_message), error_message);
+	fprintf(stderr, "Error %d: %s\n", (int) ec, error_message);
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,636 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+/* Stage timings of the clustering pipeline on synthetic workloads.
+ *
+ * Usage: bench_pipeline <workload> <num_data_points> <num_dimensions> [size_constraint] [seed] [num_threads]
+ *
+ * Workloads:
+ *   blobs       Gaussian blobs with about 1000 points each
+ *   uniform     uniformly distributed points in the unit cube
+ *   duplicates  discrete data with four levels per dimension
+ *   propensity  one-dimensional propensity scores (`num_dimensions` is ignored)
+ *   typed       Gaussian blobs with two type labels, one of each type per cluster
+ *
+ * The data are generated with a fixed generator, so a seed gives the same
+ * workload on every platform. The stages are timed separately: the NNG, seed
+ * finding with each seed method, assignment, the whole size-constrained
+ * clustering in input order and with spatial renumbering (and the batch
+ * method for untyped workloads, with fixed batch sizes and with adaptive
+ * sizing in index and spatial order, and pair matching when the size
+ * constraint is two), hierarchical refinement and clustering statistics.
+ * The results are written to stdout as a single JSON object.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/scclust.h"
+#include "../src/allocator.h"
+#include "../src/digraph_core.h"
+#include "../src/nng_core.h"
+#include "../src/nng_findseeds.h"
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+typedef enum ibench_Workload {
+	IBENCH_WL_BLOBS,
+	IBENCH_WL_UNIFORM,
+	IBENCH_WL_DUPLICATES,
+	IBENCH_WL_PROPENSITY,
+	IBENCH_WL_TYPED,
+} ibench_Workload;
+
+
+static const char* const IBENCH_WORKLOAD_NAMES[] = { "blobs", "uniform", "duplicates", "propensity", "typed" };
+
+static const char* const IBENCH_SEED_METHOD_NAMES[] = { "lexical",
+                                                        "batches",
+                                                        "inwards_order",
+                                                        "inwards_updating",
+                                                        "exclusion_order",
+                                                        "exclusion_updating",
+                                                        "pair_matching" };
+
+
+// Batch sizes timed with the batch method. Zero is one batch with all points.
+static const uint32_t IBENCH_BATCH_SIZES[] = { 1, 100, 10000, 0 };
+
+#define IBENCH_NUM_FIXED_BATCH_RUNS (sizeof(IBENCH_BATCH_SIZES) / sizeof(IBENCH_BATCH_SIZES[0]))
+#define IBENCH_NUM_BATCH_RUNS (IBENCH_NUM_FIXED_BATCH_RUNS + 2)
+
+
+// Distance metrics timed in addition to the Euclidean metric
+static const scc_DistanceMetric IBENCH_METRICS[] = { SCC_DM_MANHATTAN,
+                                                     SCC_DM_CHEBYSHEV,
+                                                     SCC_DM_WEIGHTED_EUCLIDEAN,
+                                                     SCC_DM_COSINE,
+                                                     SCC_DM_MAHALANOBIS };
+
+static const char* const IBENCH_METRIC_NAMES[] = { "manhattan",
+                                                   "chebyshev",
+                                                   "weighted_euclidean",
+                                                   "cosine",
+                                                   "mahalanobis" };
+
+#define IBENCH_NUM_METRICS (sizeof(IBENCH_METRICS) / sizeof(IBENCH_METRICS[0]))
+
+
+static bool ibench_parse_workload(const char* name,
+                                  ibench_Workload* out_workload);
+
+
+static void ibench_generate_data(ibench_Workload workload,
+                                 uint64_t num_data_points,
+                                 uint32_t num_dimensions,
+                                 uint64_t seed,
+                                 double out_data[],
+                                 scc_TypeLabel out_type_labels[]);
+
+
+static uint64_t ibench_next_random(uint64_t* state);
+
+
+static double ibench_uniform(uint64_t* state);
+
+
+static double ibench_normal(uint64_t* state);
+
+
+static scc_ErrorCode ibench_get_nng(void* data_set,
+                                    uint64_t num_data_points,
+                                    uint32_t size_constraint,
+                                    bool typed,
+                                    const scc_TypeLabel type_labels[],
+                                    iscc_Digraph* out_nng);
+
+
+static double ibench_seconds(void);
+
+
+static int ibench_fail(scc_ErrorCode ec);
+
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(const int argc, char** const argv)
+{
+	if ((argc < 4) || (argc > 7)) {
+		fprintf(stderr, "Usage: %s <workload> <num_data_points> <num_dimensions> [size_constraint] [seed] [num_threads]\n", argv[0]);
+		fprintf(stderr, "Workloads: blobs, uniform, duplicates, propensity, typed\n");
+		return EXIT_FAILURE;
+	}
+
+	ibench_Workload workload;
+	if (!ibench_parse_workload(argv[1], &workload)) {
+		fprintf(stderr, "Unknown workload: %s\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	const uint64_t num_data_points = strtoull(argv[2], NULL, 10);
+	const uint32_t num_dimensions = (workload == IBENCH_WL_PROPENSITY) ? 1 : (uint32_t) strtoul(argv[3], NULL, 10);
+	const uint32_t size_constraint = (argc >= 5) ? (uint32_t) strtoul(argv[4], NULL, 10) : 2;
+	const uint64_t seed = (argc >= 6) ? strtoull(argv[5], NULL, 10) : 12345;
+	const uint32_t num_threads = (argc >= 7) ? (uint32_t) strtoul(argv[6], NULL, 10) : 1;
+	const bool typed = (workload == IBENCH_WL_TYPED);
+	const bool pair_matching = !typed && (size_constraint == 2);
+	const int last_seed_method = pair_matching ? SCC_SM_PAIR_MATCHING : SCC_SM_EXCLUSION_UPDATING;
+
+	if ((num_data_points == 0) || (num_dimensions == 0) || (size_constraint < 2) ||
+	        (num_data_points < size_constraint) || (num_threads == 0)) {
+		fprintf(stderr, "Invalid arguments.\n");
+		return EXIT_FAILURE;
+	}
+
+	scc_ErrorCode ec;
+	if ((ec = scc_set_num_threads(num_threads)) != SCC_ER_OK) return ibench_fail(ec);
+
+	double* const data = malloc(sizeof(double[num_data_points * num_dimensions]));
+	scc_TypeLabel* const type_labels = malloc(sizeof(scc_TypeLabel[num_data_points]));
+	scc_Clabel* const labels = malloc(sizeof(scc_Clabel[num_data_points]));
+	if ((data == NULL) || (type_labels == NULL) || (labels == NULL)) {
+		fprintf(stderr, "Out of memory.\n");
+		return EXIT_FAILURE;
+	}
+	ibench_generate_data(workload, num_data_points, num_dimensions, seed, data, type_labels);
+
+	scc_DataSet* data_set;
+	if ((ec = scc_init_data_set(num_data_points, num_dimensions, num_data_points * num_dimensions, data, &data_set)) != SCC_ER_OK) {
+		return ibench_fail(ec);
+	}
+
+	// Nearest neighbor graph
+	iscc_Digraph nng;
+	double time_start = ibench_seconds();
+	if ((ec = ibench_get_nng(data_set, num_data_points, size_constraint, typed, type_labels, &nng)) != SCC_ER_OK) {
+		return ibench_fail(ec);
+	}
+	const double nng_seconds = ibench_seconds() - time_start;
+
+	// Seed finding with each method on the same NNG
+	double seed_seconds[SCC_SM_PAIR_MATCHING + 1];
+	size_t seed_counts[SCC_SM_PAIR_MATCHING + 1];
+	iscc_SeedResult lexical_seeds = { 0, 0, NULL };
+	for (int sm = SCC_SM_LEXICAL; sm <= last_seed_method; ++sm) {
+		if (sm == SCC_SM_BATCHES) continue;
+		iscc_SeedResult seed_result = {
+			.capacity = 1 + (num_data_points / size_constraint),
+			.count = 0,
+			.seeds = NULL,
+		};
+		time_start = ibench_seconds();
+		if ((ec = iscc_find_seeds(&nng, (scc_SeedMethod) sm, false, &seed_result)) != SCC_ER_OK) {
+			return ibench_fail(ec);
+		}
+		seed_seconds[sm] = ibench_seconds() - time_start;
+		seed_counts[sm] = seed_result.count;
+		if (sm == SCC_SM_LEXICAL) {
+			lexical_seeds = seed_result;
+		} else {
+			iscc_free(seed_result.seeds);
+		}
+	}
+
+	// Assignment from the lexical seeds
+	scc_Clustering* clustering;
+	if ((ec = scc_init_empty_clustering(num_data_points, labels, &clustering)) != SCC_ER_OK) {
+		return ibench_fail(ec);
+	}
+	time_start = ibench_seconds();
+	if ((ec = iscc_make_nng_clusters_from_seeds(clustering,
+	                                            data_set,
+	                                            &lexical_seeds,
+	                                            &nng,
+	                                            !typed,
+	                                            SCC_UM_ANY_NEIGHBOR,
+	                                            false,
+	                                            0.0,
+	                                            0,
+	                                            NULL,
+	                                            SCC_UM_IGNORE,
+	                                            false,
+	                                            0.0)) != SCC_ER_OK) {
+		return ibench_fail(ec);
+	}
+	const double assignment_seconds = ibench_seconds() - time_start;
+	scc_free_clustering(&clustering);
+	iscc_free(lexical_seeds.seeds);
+	iscc_free_digraph(&nng);
+
+	// Whole size-constrained clustering
+	scc_ClusterOptions options = scc_get_default_options();
+	options.size_constraint = size_constraint;
+	uint32_t type_constraints[2] = { 1, 1 };
+	if (typed) {
+		options.num_types = 2;
+		options.type_constraints = type_constraints;
+		options.len_type_labels = num_data_points;
+		options.type_labels = type_labels;
+	}
+
+	if ((ec = scc_init_empty_clustering(num_data_points, NULL, &clustering)) != SCC_ER_OK) {
+		return ibench_fail(ec);
+	}
+	time_start = ibench_seconds();
+	if ((ec = scc_sc_clustering(data_set, &options, clustering)) != SCC_ER_OK) {
+		return ibench_fail(ec);
+	}
+	const double sc_seconds = ibench_seconds() - time_start;
+	uint64_t sc_num_clusters;
+	if ((ec = scc_get_clustering_info(clustering, NULL, &sc_num_clusters)) != SCC_ER_OK) {
+		return ibench_fail(ec);
+	}
+
+	// Whole clustering with data points renumbered along a space-filling curve
+	scc_ClusterOptions renumbered_options = options;
+	renumbered_options.spatial_renumbering = true;
+	scc_Clustering* renumbered_clustering;
+	if ((ec = scc_init_empty_clustering(num_data_points, NULL, &renumbered_clustering)) != SCC_ER_OK) {
+		return ibench_fail(ec);
+	}
+	time_start = ibench_seconds();
+	if ((ec = scc_sc_clustering(data_set, &renumbered_options, renumbered_clustering)) != SCC_ER_OK) {
+		return ibench_fail(ec);
+	}
+	const double renumbered_seconds = ibench_seconds() - time_start;
+	uint64_t renumbered_num_clusters;
+	if ((ec = scc_get_clustering_info(renumbered_clustering, NULL, &renumbered_num_clusters)) != SCC_ER_OK) {
+		return ibench_fail(ec);
+	}
+	scc_free_clustering(&renumbered_clustering);
+
+	// Whole clustering with pairs matched along the NNG
+	double pair_matching_seconds = 0.0;
+	uint64_t pair_matching_num_clusters = 0;
+	if (pair_matching) {
+		scc_ClusterOptions pair_options = options;
+		pair_options.seed_method = SCC_SM_PAIR_MATCHING;
+		scc_Clustering* pair_clustering;
+		if ((ec = scc_init_empty_clustering(num_data_points, NULL, &pair_clustering)) != SCC_ER_OK) {
+			return ibench_fail(ec);
+		}
+		time_start = ibench_seconds();
+		if ((ec = scc_sc_clustering(data_set, &pair_options, pair_clustering)) != SCC_ER_OK) {
+			return ibench_fail(ec);
+		}
+		pair_matching_seconds = ibench_seconds() - time_start;
+		if ((ec = scc_get_clustering_info(pair_clustering, NULL, &pair_matching_num_clusters)) != SCC_ER_OK) {
+			return ibench_fail(ec);
+		}
+		scc_free_clustering(&pair_clustering);
+	}
+
+	// Whole clustering with each distance metric, including the transformation
+	// of the data. Metrics are skipped when the data is invalid for them (zero
+	// vectors with cosine distance or singular covariance matrices).
+	double metric_seconds[IBENCH_NUM_METRICS] = { 0.0 };
+	uint64_t metric_num_clusters[IBENCH_NUM_METRICS] = { 0 };
+	bool metric_ok[IBENCH_NUM_METRICS] = { false };
+	double* const dimension_weights = malloc(sizeof(double[num_dimensions]));
+	if (dimension_weights == NULL) {
+		fprintf(stderr, "Out of memory.\n");
+		return EXIT_FAILURE;
+	}
+	for (uint32_t d = 0; d < num_dimensions; ++d) {
+		dimension_weights[d] = 1.0 / (1.0 + (double) d);
+	}
+	for (size_t m = 0; m < IBENCH_NUM_METRICS; ++m) {
+		const bool weighted = (IBENCH_METRICS[m] == SCC_DM_WEIGHTED_EUCLIDEAN);
+		scc_DataSet* metric_data_set;
+		time_start = ibench_seconds();
+		ec = scc_init_data_set_with_metric(num_data_points,
+		                                   num_dimensions,
+		                                   num_data_points * num_dimensions,
+		                                   data,
+		                                   IBENCH_METRICS[m],
+		                                   weighted ? num_dimensions : 0,
+		                                   weighted ? dimension_weights : NULL,
+		                                   &metric_data_set);
+		if (ec == SCC_ER_INVALID_INPUT) continue;
+		if (ec != SCC_ER_OK) return ibench_fail(ec);
+		scc_Clustering* metric_clustering;
+		if ((ec = scc_init_empty_clustering(num_data_points, NULL, &metric_clustering)) != SCC_ER_OK) {
+			return ibench_fail(ec);
+		}
+		if ((ec = scc_sc_clustering(metric_data_set, &options, metric_clustering)) != SCC_ER_OK) {
+			return ibench_fail(ec);
+		}
+		metric_seconds[m] = ibench_seconds() - time_start;
+		if ((ec = scc_get_clustering_info(metric_clustering, NULL, &metric_num_clusters[m])) != SCC_ER_OK) {
+			return ibench_fail(ec);
+		}
+		metric_ok[m] = true;
+		scc_free_clustering(&metric_clustering);
+		scc_free_data_set(&metric_data_set);
+	}
+	free(dimension_weights);
+
+	// Batch method with each fixed batch size, then adaptive sizing without a limit
+	// in index order and in spatial order
+	double batches_seconds[IBENCH_NUM_BATCH_RUNS] = { 0.0 };
+	uint64_t batches_nn_queries[IBENCH_NUM_BATCH_RUNS] = { 0 };
+	uint64_t batches_num_clusters[IBENCH_NUM_BATCH_RUNS] = { 0 };
+	for (size_t r = 0; (r < IBENCH_NUM_BATCH_RUNS) && !typed; ++r) {
+		const bool adaptive = (r >= IBENCH_NUM_FIXED_BATCH_RUNS);
+		scc_RunReport batch_report;
+		scc_ClusterOptions batch_options = options;
+		batch_options.seed_method = SCC_SM_BATCHES;
+		batch_options.batch_size = adaptive ? 0 : IBENCH_BATCH_SIZES[r];
+		batch_options.adaptive_batch_size = adaptive;
+		batch_options.spatial_batch_order = (r == IBENCH_NUM_BATCH_RUNS - 1);
+		batch_options.run_report = &batch_report;
+		scc_Clustering* batch_clustering;
+		if ((ec = scc_init_empty_clustering(num_data_points, NULL, &batch_clustering)) != SCC_ER_OK) {
+			return ibench_fail(ec);
+		}
+		time_start = ibench_seconds();
+		if ((ec = scc_sc_clustering(data_set, &batch_options, batch_clustering)) != SCC_ER_OK) {
+			return ibench_fail(ec);
+		}
+		batches_seconds[r] = ibench_seconds() - time_start;
+		batches_nn_queries[r] = batch_report.num_nn_queries;
+		if ((ec = scc_get_clustering_info(batch_clustering, NULL, &batches_num_clusters[r])) != SCC_ER_OK) {
+			return ibench_fail(ec);
+		}
+		scc_free_clustering(&batch_clustering);
+	}
+
+	// Clustering statistics
+	scc_ClusteringStats stats;
+	time_start = ibench_seconds();
+	if ((ec = scc_get_clustering_stats(data_set, clustering, &stats)) != SCC_ER_OK) {
+		return ibench_fail(ec);
+	}
+	const double stats_seconds = ibench_seconds() - time_start;
+
+	// Hierarchical refinement of the size-constrained clustering. Ties in the
+	// duplicated data are split by projection.
+	scc_HierarchicalOptions hi_options = scc_get_default_hierarchical_options();
+	hi_options.size_constraint = size_constraint;
+	if (workload == IBENCH_WL_DUPLICATES) {
+		hi_options.bisection_method = SCC_BM_SAMPLED_PROJECTION;
+	}
+	double hierarchical_seconds = 0.0;
+	uint64_t hierarchical_num_clusters = 0;
+	if (!typed) {
+		time_start = ibench_seconds();
+		if ((ec = scc_hierarchical_clustering_with_options(data_set, &hi_options, clustering)) != SCC_ER_OK) {
+			return ibench_fail(ec);
+		}
+		hierarchical_seconds = ibench_seconds() - time_start;
+		if ((ec = scc_get_clustering_info(clustering, NULL, &hierarchical_num_clusters)) != SCC_ER_OK) {
+			return ibench_fail(ec);
+		}
+	}
+
+	scc_free_clustering(&clustering);
+	scc_free_data_set(&data_set);
+	free(data);
+	free(type_labels);
+	free(labels);
+
+	uint32_t major, minor, patch;
+	scc_get_compiled_version(&major, &minor, &patch);
+
+	printf("{\n");
+	printf("  \"version\": \"%u.%u.%u\",\n", major, minor, patch);
+	printf("  \"workload\": \"%s\",\n", IBENCH_WORKLOAD_NAMES[workload]);
+	printf("  \"num_data_points\": %llu,\n", (unsigned long long) num_data_points);
+	printf("  \"num_dimensions\": %u,\n", num_dimensions);
+	printf("  \"size_constraint\": %u,\n", size_constraint);
+	printf("  \"seed\": %llu,\n", (unsigned long long) seed);
+	printf("  \"num_threads\": %u,\n", num_threads);
+	printf("  \"stages\": {\n");
+	printf("    \"nng\": { \"seconds\": %.6f },\n", nng_seconds);
+	printf("    \"seeds\": {\n");
+	for (int sm = SCC_SM_LEXICAL; sm <= last_seed_method; ++sm) {
+		if (sm == SCC_SM_BATCHES) continue;
+		printf("      \"%s\": { \"seconds\": %.6f, \"num_seeds\": %llu }%s\n",
+		       IBENCH_SEED_METHOD_NAMES[sm],
+		       seed_seconds[sm],
+		       (unsigned long long) seed_counts[sm],
+		       (sm < last_seed_method) ? "," : "");
+	}
+	printf("    },\n");
+	printf("    \"assignment\": { \"seconds\": %.6f },\n", assignment_seconds);
+	printf("    \"sc_clustering\": { \"seconds\": %.6f, \"num_clusters\": %llu },\n",
+	       sc_seconds, (unsigned long long) sc_num_clusters);
+	printf("    \"sc_clustering_renumbered\": { \"seconds\": %.6f, \"num_clusters\": %llu },\n",
+	       renumbered_seconds, (unsigned long long) renumbered_num_clusters);
+	if (pair_matching) {
+		printf("    \"sc_clustering_pair_matching\": { \"seconds\": %.6f, \"num_clusters\": %llu },\n",
+		       pair_matching_seconds, (unsigned long long) pair_matching_num_clusters);
+	}
+	printf("    \"sc_clustering_metrics\": {\n");
+	for (size_t m = 0; m < IBENCH_NUM_METRICS; ++m) {
+		if (metric_ok[m]) {
+			printf("      \"%s\": { \"seconds\": %.6f, \"num_clusters\": %llu }%s\n",
+			       IBENCH_METRIC_NAMES[m],
+			       metric_seconds[m],
+			       (unsigned long long) metric_num_clusters[m],
+			       (m < IBENCH_NUM_METRICS - 1) ? "," : "");
+		} else {
+			printf("      \"%s\": null%s\n",
+			       IBENCH_METRIC_NAMES[m],
+			       (m < IBENCH_NUM_METRICS - 1) ? "," : "");
+		}
+	}
+	printf("    },\n");
+	if (!typed) {
+		printf("    \"batches\": [\n");
+		for (size_t r = 0; r < IBENCH_NUM_BATCH_RUNS; ++r) {
+			const bool adaptive = (r >= IBENCH_NUM_FIXED_BATCH_RUNS);
+			const bool spatial = (r == IBENCH_NUM_BATCH_RUNS - 1);
+			printf("      { \"batch_size\": %u, \"adaptive\": %s, \"spatial\": %s, \"seconds\": %.6f, \"num_nn_queries\": %llu, \"num_clusters\": %llu }%s\n",
+			       adaptive ? 0 : IBENCH_BATCH_SIZES[r],
+			       adaptive ? "true" : "false",
+			       spatial ? "true" : "false",
+			       batches_seconds[r],
+			       (unsigned long long) batches_nn_queries[r],
+			       (unsigned long long) batches_num_clusters[r],
+			       spatial ? "" : ",");
+		}
+		printf("    ],\n");
+		printf("    \"hierarchical\": { \"seconds\": %.6f, \"num_clusters\": %llu },\n",
+		       hierarchical_seconds, (unsigned long long) hierarchical_num_clusters);
+	}
+	printf("    \"stats\": { \"seconds\": %.6f, \"avg_dist_weighted\": %.9g, \"max_dist\": %.9g }\n",
+	       stats_seconds, stats.avg_dist_weighted, stats.max_dist);
+	printf("  }\n");
+	printf("}\n");
+
+	return EXIT_SUCCESS;
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static bool ibench_parse_workload(const char* const name,
+                                  ibench_Workload* const out_workload)
+{
+	for (int wl = IBENCH_WL_BLOBS; wl <= IBENCH_WL_TYPED; ++wl) {
+		if (strcmp(name, IBENCH_WORKLOAD_NAMES[wl]) == 0) {
+			*out_workload = (ibench_Workload) wl;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+static void ibench_generate_data(const ibench_Workload workload,
+                                 const uint64_t num_data_points,
+                                 const uint32_t num_dimensions,
+                                 const uint64_t seed,
+                                 double out_data[const],
+                                 scc_TypeLabel out_type_labels[const])
+{
+	uint64_t state = seed;
+	const uint64_t num_blobs = 1 + num_data_points / 1000;
+
+	for (uint64_t i = 0; i < num_data_points; ++i) {
+		double* const row = out_data + i * num_dimensions;
+		out_type_labels[i] = 0;
+		switch (workload) {
+		case IBENCH_WL_BLOBS:
+		case IBENCH_WL_TYPED:
+			{
+				// Blob centers are derived from the blob index, so they need no storage
+				uint64_t blob_state = seed ^ (ibench_next_random(&state) % num_blobs);
+				for (uint32_t d = 0; d < num_dimensions; ++d) {
+					row[d] = 10.0 * ibench_uniform(&blob_state) + 0.5 * ibench_normal(&state);
+				}
+				if (workload == IBENCH_WL_TYPED) {
+					out_type_labels[i] = (ibench_uniform(&state) < 0.3) ? 1 : 0;
+				}
+			}
+			break;
+		case IBENCH_WL_UNIFORM:
+			for (uint32_t d = 0; d < num_dimensions; ++d) {
+				row[d] = ibench_uniform(&state);
+			}
+			break;
+		case IBENCH_WL_DUPLICATES:
+			for (uint32_t d = 0; d < num_dimensions; ++d) {
+				row[d] = (double) (ibench_next_random(&state) % 4);
+			}
+			break;
+		case IBENCH_WL_PROPENSITY:
+			row[0] = 1.0 / (1.0 + exp(-ibench_normal(&state)));
+			break;
+		}
+	}
+
+	// Make sure both types are present
+	if ((workload == IBENCH_WL_TYPED) && (num_data_points >= 2)) {
+		out_type_labels[0] = 0;
+		out_type_labels[1] = 1;
+	}
+}
+
+
+static uint64_t ibench_next_random(uint64_t* const state)
+{
+	// splitmix64
+	uint64_t z = (*state += UINT64_C(0x9E3779B97F4A7C15));
+	z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+	z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+	return z ^ (z >> 31);
+}
+
+
+static double ibench_uniform(uint64_t* const state)
+{
+	return ((double) (ibench_next_random(state) >> 11)) / 9007199254740992.0;
+}
+
+
+static double ibench_normal(uint64_t* const state)
+{
+	// Box-Muller; the second draw is discarded to keep the generator stateless
+	const double u1 = 1.0 - ibench_uniform(state);
+	const double u2 = ibench_uniform(state);
+	return sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+}
+
+
+static scc_ErrorCode ibench_get_nng(void* const data_set,
+                                    const uint64_t num_data_points,
+                                    const uint32_t size_constraint,
+                                    const bool typed,
+                                    const scc_TypeLabel type_labels[const],
+                                    iscc_Digraph* const out_nng)
+{
+	if (!typed) {
+		return iscc_get_nng_with_size_constraint(data_set,
+		                                         num_data_points,
+		                                         size_constraint,
+		                                         0,
+		                                         NULL,
+		                                         false,
+		                                         0.0,
+		                                         false,
+		                                         out_nng);
+	}
+
+	const uint32_t type_constraints[2] = { 1, 1 };
+	return iscc_get_nng_with_type_constraint(data_set,
+	                                         num_data_points,
+	                                         size_constraint,
+	                                         2,
+	                                         type_constraints,
+	                                         type_labels,
+	                                         0,
+	                                         NULL,
+	                                         false,
+	                                         0.0,
+	                                         false,
+	                                         out_nng);
+}
+
+
+static double ibench_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((double) ts.tv_sec) + ((double) ts.tv_nsec) / 1e9;
+}
+
+
+static int ibench_fail(const scc_ErrorCode ec)
+{
+	char error_message[255];
+	scc_get_latest_error(sizeof(error_message), error_message);
+	fprintf(stderr, "Error %d: %s\n", (int) ec, error_message);
+	return EXIT_FAILURE;
+}
@@ -90,7 +90,10 @@ typedef enum scc_ErrorCode {
 	SCC_ER_DIST_SEARCH_ERROR,
 
 	/// Functionality not yet implemented.
-	SCC_ER_NOT_IMPLEMENTED
+	SCC_ER_NOT_IMPLEMENTED,
+
+	/// Failed to read or write file.
+	SCC_ER_IO_ERROR
 
 } scc_ErrorCode;
 
@@ -169,7 +172,9 @@ typedef struct scc_DataSet scc_DataSet;
 
 /** Construct new data set from raw data.
  *
- *  Creates a #scc_DataSet based on supplied raw data.
+ *  Creates a #scc_DataSet based on supplied raw data. Nearest neighbor searches
+ *  on data sets with one dimension use a sorted index, and searches on data sets
+ *  with two dimensions use a uniform grid. Other data sets are searched by brute force.
  *
  *  \param[in] num_data_points the number of data points in the data set.
  *  \param[in] num_dimensions the number of dimensions for each data point.
@@ -189,6 +194,97 @@ scc_ErrorCode scc_init_data_set(uint64_t num_data_points,
                                 scc_DataSet** out_data_set);
 
 
+/// Enum to specify distance metrics for #scc_init_data_set_with_metric.
+typedef enum scc_DistanceMetric {
+	/// Euclidean distance. This is the metric used by #scc_init_data_set.
+	SCC_DM_EUCLIDEAN,
+
+	/// Manhattan (L1) distance.
+	SCC_DM_MANHATTAN,
+
+	/// Chebyshev (L-infinity) distance.
+	SCC_DM_CHEBYSHEV,
+
+	/** Euclidean distance with a non-negative weight for each dimension. The metric parameters
+	 *  are the `num_dimensions` weights, and the distance is `sqrt(sum_d w_d (x_d - y_d)^2)`.
+	 */
+	SCC_DM_WEIGHTED_EUCLIDEAN,
+
+	/** Cosine distance, `1 - cos(angle)` between the data points. No data point may be
+	 *  a zero vector. Cosine distance is not a metric, so it voids the guarantee on the
+	 *  maximum within-cluster distance.
+	 */
+	SCC_DM_COSINE,
+
+	/** Mahalanobis distance. The metric parameters are a positive definite covariance matrix
+	 *  of `num_dimensions * num_dimensions` elements. If no parameters are supplied, the
+	 *  sample covariance matrix of the data set is used.
+	 */
+	SCC_DM_MAHALANOBIS
+} scc_DistanceMetric;
+
+
+/** Construct new data set from raw data with a distance metric.
+ *
+ *  Like #scc_init_data_set, but distances between data points are measured with \p metric.
+ *  Weighted Euclidean, cosine and Mahalanobis distances are computed as Euclidean
+ *  distances on a transformed copy of the data (scaled, normalized to unit length,
+ *  and whitened, respectively), which the data set owns. The data is transformed once
+ *  when the data set is constructed, and all metrics use the built-in search indices.
+ *
+ *  \param[in] num_data_points the number of data points in the data set.
+ *  \param[in] num_dimensions the number of dimensions for each data point.
+ *  \param[in] len_data_matrix the length of #data_matrix.
+ *  \param[in] data_matrix the raw data, ordered as in #scc_init_data_set.
+ *  \param[in] metric the distance metric.
+ *  \param[in] len_metric_parameters the length of #metric_parameters.
+ *  \param[in] metric_parameters the parameters of the metric, as described in #scc_DistanceMetric.
+ *                               Must be `NULL` for metrics without parameters.
+ *  \param[out] out_data_set double pointer to where to write the data set reference.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_init_data_set_with_metric(uint64_t num_data_points,
+                                            uint32_t num_dimensions,
+                                            size_t len_data_matrix,
+                                            const double data_matrix[],
+                                            scc_DistanceMetric metric,
+                                            size_t len_metric_parameters,
+                                            const double metric_parameters[],
+                                            scc_DataSet** out_data_set);
+
+
+/// Enum to specify file formats for #scc_init_data_set_from_file.
+typedef enum scc_DataFileFormat {
+	/// Raw array of doubles in native byte order, ordered first by point, then by dimension.
+	SCC_DF_RAW,
+
+	/// NumPy `.npy` file containing a one- or two-dimensional, row-major array of doubles.
+	SCC_DF_NPY
+} scc_DataFileFormat;
+
+
+/** Construct new data set from file.
+ *
+ *  Creates a #scc_DataSet with data read from a file. The file is memory-mapped
+ *  read-only when the platform supports it, so the data set can be larger than
+ *  the available memory. The file must not be changed while the data set is in use.
+ *
+ *  \param[in] file_path path to the data file.
+ *  \param[in] file_format the format of the file.
+ *  \param[in] num_dimensions the number of dimensions for each data point. Required
+ *                            for #SCC_DF_RAW. For #SCC_DF_NPY, the dimensions are read
+ *                            from the file and \p num_dimensions may be zero.
+ *  \param[out] out_data_set double pointer to where to write the data set reference.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_init_data_set_from_file(const char* file_path,
+                                          scc_DataFileFormat file_format,
+                                          uint32_t num_dimensions,
+                                          scc_DataSet** out_data_set);
+
+
 /** Free data set.
  *
  *  Frees a #scc_DataSet previously allocated by #scc_init_data_set.
@@ -273,7 +369,11 @@ typedef enum scc_SeedMethod {
 	 */
 	SCC_SM_LEXICAL,
 
-
+	/** Find seeds lexically while searching nearest neighbors in batches of `batch_size` data points.
+	 *
+	 *  With several threads set with #scc_set_num_threads, upcoming batches are searched
+	 *  while earlier batches are assigned. The clustering is the same for any number of threads.
+	 */
 	SCC_SM_BATCHES,
 
 	/** Find seeds ordered by inwards pointing arcs.
@@ -310,7 +410,18 @@ typedef enum scc_SeedMethod {
 	 *  and find seeds in ascending order by this count. Unlike the #SCC_SM_EXCLUSION_ORDER, this method updates the edge count after finding a
 	 *  seed so that only edges where the tails that still can become seeds are counted.
 	 */
-	SCC_SM_EXCLUSION_UPDATING
+	SCC_SM_EXCLUSION_UPDATING,
+
+	/** Find seeds by matching vertices with their nearest neighbors.
+	 *
+	 *  This method can only be used when the desired size is two and there are no type constraints. Vertices that no unassigned vertex
+	 *  points to are picked as seeds first, so that their nearest neighbors are the only vertices in their clusters that other vertices
+	 *  can point to. The number of seeds is the largest possible in the NNG, and the method runs in linear time.
+	 *
+	 *  Like #SCC_SM_INWARDS_UPDATING, this method ensures that the maximum distance between any two vertices in a common cluster in the
+	 *  final clustering is bounded by twice the maximum distance in the NNG, unless tied distances make the NNG contain odd cycles.
+	 */
+	SCC_SM_PAIR_MATCHING
 
 } scc_SeedMethod;
 
@@ -331,11 +442,99 @@ typedef enum scc_RadiusMethod {
 } scc_RadiusMethod;
 
 
+/** Outcome of one block in a blocked clustering.
+ *
+ *  See `blocking_labels` in #scc_ClusterOptions.
+ */
+typedef struct scc_BlockReport {
+	/// Blocking label of the block.
+	scc_TypeLabel blocking_label;
+
+	/// Number of data points in the block.
+	uint64_t num_data_points;
+
+	/// Number of clusters in the block.
+	uint64_t num_clusters;
+
+	/// #SCC_ER_OK if the block was clustered, #SCC_ER_NO_SOLUTION if the constraints could not be satisfied in the block.
+	scc_ErrorCode error;
+} scc_BlockReport;
+
+
+/// Phases timed in a #scc_RunReport.
+typedef enum scc_RunPhase {
+	/// Construction of the nearest neighbor graph.
+	SCC_RP_NNG,
+
+	/// Seed finding, including construction of the exclusion graph.
+	SCC_RP_SEED_FINDING,
+
+	/// Construction of the exclusion graph. This time is included in #SCC_RP_SEED_FINDING.
+	SCC_RP_EXCLUSION_GRAPH,
+
+	/// Assignment of data points to clusters. With #SCC_SM_BATCHES, this includes the nearest neighbor searches.
+	SCC_RP_ASSIGNMENT,
+
+	/// Breaking of clusters in hierarchical clustering.
+	SCC_RP_HIERARCHICAL,
+
+	/// Number of phases (not a phase).
+	SCC_RP_NUM_PHASES
+} scc_RunPhase;
+
+
+/** Timings and counters of a clustering run.
+ *
+ *  See `run_report` in #scc_ClusterOptions and #scc_HierarchicalOptions. With blocked clustering,
+ *  phase times are summed over blocks, so they may exceed `total_seconds` when blocks run concurrently.
+ *  A report only counts the work of the call it is passed to, also when other threads run clustering
+ *  functions at the same time.
+ */
+typedef struct scc_RunReport {
+	/// Wall time of the whole call in seconds.
+	double total_seconds;
+
+	/// Wall time of each #scc_RunPhase in seconds.
+	double phase_seconds[SCC_RP_NUM_PHASES];
+
+	/** Number of distances calculated as distance matrices or distance rows.
+	 *
+	 *  Distances calculated within nearest neighbor and maximum distance searches are not included.
+	 */
+	uint64_t num_dist_evaluations;
+
+	/// Number of points queried in nearest neighbor searches.
+	uint64_t num_nn_queries;
+
+	/// Number of points queried in maximum distance searches.
+	uint64_t num_max_dist_queries;
+
+	/// Number of arcs in the nearest neighbor graphs.
+	uint64_t nng_arcs;
+
+	/// Number of arcs in the exclusion graphs.
+	uint64_t exclusion_graph_arcs;
+
+	/// Peak number of bytes allocated for digraphs at any one time.
+	size_t peak_digraph_bytes;
+
+	/// Peak number of bytes held by the arena. Zero unless arena mode is set with #scc_set_arena_mode.
+	size_t peak_arena_bytes;
+
+	/** Peak number of bytes allocated by the run at any one time.
+	 *
+	 *  Includes the arena, digraphs and all other buffers, but not memory allocated before the call
+	 *  (e.g., the data set). Memory allocated before the call and freed during it is not subtracted.
+	 */
+	size_t peak_alloc_bytes;
+} scc_RunReport;
+
+
 typedef struct scc_ClusterOptions {
 	/** scc_ClusterOptions struct version
 	 *
 	 *  \note
-	 *  This must be set to "722678001".
+	 *  This must be set to "722678007".
 	 */
 	int32_t options_version;
 	uint32_t size_constraint;
@@ -355,6 +554,72 @@ typedef struct scc_ClusterOptions {
 	scc_RadiusMethod secondary_radius;
 	double secondary_supplied_radius;
 	uint32_t batch_size;
+
+	/** Adapt the batch size of #SCC_SM_BATCHES to the share of wasted searches.
+	 *
+	 *  If \c true, batches start small and are doubled while almost all searched points
+	 *  are still unassigned when reached, and halved when many were assigned by earlier
+	 *  points in the same batch. `batch_size` is then the largest batch, which bounds
+	 *  the memory used for search results. The clustering does not depend on the batch size.
+	 */
+	bool adaptive_batch_size;
+
+	/** Visit data points along a space-filling curve with #SCC_SM_BATCHES.
+	 *
+	 *  If \c true, batches are formed in the order of a Morton (Z-order) curve through the
+	 *  data space rather than in index order, so nearby points are searched together. Seeds
+	 *  are found in the curve order, and cluster labels are assigned in the order seeds are
+	 *  found, so the labels follow the curve rather than the point indices. The order is
+	 *  computed once per call and requires the built-in distance functions.
+	 */
+	bool spatial_batch_order;
+
+	/** Make the clustering independent of tie-breaking in the nearest neighbor search.
+	 *
+	 *  If \c true, neighbors are sorted by point index and seeds with equal counts are found
+	 *  in ascending order of point index. This gives the same clustering across platforms and
+	 *  search libraries at a small cost. Compiling with `SCC_STABLE_NNG` or `SCC_STABLE_FINDSEED`
+	 *  makes the corresponding part always stable.
+	 */
+	bool stable;
+
+	/** Renumber data points along a space-filling curve before clustering.
+	 *
+	 *  If \c true, #scc_sc_clustering clusters a copy of the data set where the points
+	 *  are ordered by a Morton (Z-order) curve, so that points close in space have close
+	 *  indices in the nearest neighbor graph. Labels are mapped back to the original
+	 *  indices. Seeds are found in the new order, so the clustering may differ from the
+	 *  one without renumbering. Requires the built-in distance functions and memory for
+	 *  a copy of the data matrix.
+	 */
+	bool spatial_renumbering;
+
+	/** Labels of blocks that must be matched exactly.
+	 *
+	 *  If not \c NULL, data points are only clustered with points with the same
+	 *  label. Each block is clustered as an independent problem with its own
+	 *  nearest neighbor search, and blocks are processed concurrently when several
+	 *  threads are set with #scc_set_num_threads. Cluster labels are consecutive
+	 *  over blocks in ascending order of blocking labels. Data points in blocks where
+	 *  the constraints cannot be satisfied are left unassigned. Requires a
+	 *  #scc_DataSet and the built-in distance functions.
+	 */
+	size_t len_blocking_labels;
+	const scc_TypeLabel* blocking_labels;
+
+	/** Optional output with one report per block in ascending order of blocking labels.
+	 *
+	 *  At most `len_block_reports` reports are written.
+	 */
+	size_t len_block_reports;
+	scc_BlockReport* block_reports;
+
+	/** Optional output with timings and counters of the run.
+	 *
+	 *  If not \c NULL, the report is reset when the input has been checked and
+	 *  filled when the function returns. Collection is skipped entirely when \c NULL.
+	 */
+	scc_RunReport* run_report;
 } scc_ClusterOptions;
 
 
@@ -366,12 +631,158 @@ scc_ErrorCode scc_sc_clustering(void* data_set,
                                 scc_Clustering* out_clustering);
 
 
+/** Write NNG to file.
+ *
+ *  Constructs the nearest neighbor graph and finds seeds in the same way as
+ *  #scc_sc_clustering with the same options, and writes them to a binary file.
+ *  The assignment stage can then be run repeatedly with
+ *  #scc_sc_clustering_from_nng_file without repeating the nearest neighbor search.
+ *
+ *  \param[in] data_set the data set to construct the NNG with.
+ *  \param[in] options the clustering options.
+ *  \param include_arc_distances if \c true, the length of each arc is stored in the
+ *                               file. Radius estimation when loading the file then
+ *                               does not require distance calculations.
+ *  \param[in] file_path path to the file to write.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_write_nng_file(void* data_set,
+                                 const scc_ClusterOptions* options,
+                                 bool include_arc_distances,
+                                 const char* file_path);
+
+
+/** Derive clustering from NNG file.
+ *
+ *  Loads a file written by #scc_write_nng_file and derives a clustering from it.
+ *  The file is memory-mapped when the platform supports it. The data set and the
+ *  options that affect the NNG (the size and type constraints, the primary data
+ *  points, the seed radius and #scc_ClusterOptions.stable) must be the same as
+ *  when the file was written. Other options may differ. If the seed method
+ *  differs, seeds are found anew in the stored NNG. With custom distance
+ *  functions, only the number of data points of the data set is checked.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_sc_clustering_from_nng_file(void* data_set,
+                                              const scc_ClusterOptions* options,
+                                              const char* file_path,
+                                              scc_Clustering* out_clustering);
+
+
+/** Derive clustering with identical data points collapsed.
+ *
+ *  Data points with identical coordinates are collapsed into one representative
+ *  that is weighted by the number of points it represents. The NNG is constructed
+ *  on the unique points so that the total weight of each neighborhood satisfies
+ *  the size constraint, and the labels are expanded back to all data points.
+ *  The size constraint is satisfied as with #scc_sc_clustering, and the search
+ *  is faster when data points are frequently duplicated (e.g., with discrete
+ *  covariates). For metrics that transform the data (see #scc_init_data_set_with_metric),
+ *  coordinates are compared after the transformation, so, e.g., parallel data points are
+ *  collapsed with cosine distance.
+ *
+ *  Unlike #scc_sc_clustering, `data_set` must be a #scc_DataSet and the built-in
+ *  distance functions must be used. Type constraints and #SCC_SM_BATCHES are
+ *  not supported.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_sc_clustering_collapse_duplicates(scc_DataSet* data_set,
+                                                    const scc_ClusterOptions* options,
+                                                    scc_Clustering* out_clustering);
+
+
 scc_ErrorCode scc_hierarchical_clustering(void* data_set,
                                           uint32_t size_constraint,
                                           bool batch_assign,
                                           scc_Clustering* out_clustering);
 
 
+/** Enum to specify how clusters are broken in hierarchical clustering.
+ */
+typedef enum scc_BisectionMethod {
+	/** Break clusters at an approximately farthest pair of points.
+	 *
+	 *  The farthest pair is found by iterating farthest point searches until no new
+	 *  farthest point appears. The remaining points are assigned to the closest of the
+	 *  two centers, subject to the size constraint.
+	 */
+	SCC_BM_FARTHEST_PAIR,
+
+	/** Break clusters by projected order.
+	 *
+	 *  The centers are the farthest pair among `bisection_sample_size` evenly spaced
+	 *  members of the cluster. Points are ordered by their projection onto the line
+	 *  between the centers (i.e., by the difference of squared distances to the
+	 *  centers) and split where they become closer to the second center. The split is
+	 *  moved if needed so both parts satisfy the size constraint. This is faster than
+	 *  #SCC_BM_FARTHEST_PAIR for large clusters but may give less balanced clusters.
+	 */
+	SCC_BM_SAMPLED_PROJECTION,
+} scc_BisectionMethod;
+
+
+typedef struct scc_HierarchicalOptions {
+	int32_t options_version;
+	uint32_t size_constraint;
+
+	/** Assign points in batches of `size_constraint` points.
+	 *
+	 *  With #SCC_BM_SAMPLED_PROJECTION, the split is rounded to a multiple of the size constraint.
+	 */
+	bool batch_assign;
+	scc_BisectionMethod bisection_method;
+
+	/** Number of members sampled to find centers with #SCC_BM_SAMPLED_PROJECTION.
+	 *
+	 *  Must be 2 or greater. Finding the centers requires the distances between all
+	 *  sampled points.
+	 */
+	uint32_t bisection_sample_size;
+
+	/** Store edges with single precision distances.
+	 *
+	 *  Edge lists use 8 bytes per point rather than 12, and distances to the
+	 *  centers are computed in chunks rather than for the whole cluster at once.
+	 *  This roughly halves the working memory. Points whose distances differ by
+	 *  less than the single precision rounding may be assigned in different order.
+	 */
+	bool compact_edges;
+
+	/** Maximum working memory in bytes. Zero means no limit.
+	 *
+	 *  If the predicted working memory exceeds the budget, #SCC_ER_NO_MEMORY is
+	 *  returned before any clusters are broken. The prediction includes memory for
+	 *  all threads but excludes the data set and the cluster labels.
+	 */
+	size_t memory_budget;
+
+	/** Optional output with timings and counters of the run.
+	 *
+	 *  If not \c NULL, the report is reset when the input has been checked and
+	 *  filled when the function returns.
+	 */
+	scc_RunReport* run_report;
+} scc_HierarchicalOptions;
+
+
+scc_HierarchicalOptions scc_get_default_hierarchical_options(void);
+
+
+/** Hierarchical clustering with options.
+ *
+ *  Same as #scc_hierarchical_clustering, but takes a #scc_HierarchicalOptions
+ *  struct which also specifies how clusters are broken.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_hierarchical_clustering_with_options(void* data_set,
+                                                       const scc_HierarchicalOptions* options,
+                                                       scc_Clustering* out_clustering);
+
+
 // =============================================================================
 // Utility functions
 // =============================================================================
@@ -389,6 +800,73 @@ scc_ErrorCode scc_check_clustering(const scc_Clustering* clustering,
                                    bool* out_is_OK);
 
 
+/** Set number of threads.
+ *
+ *  Sets the number of threads used by functions that support parallel
+ *  processing. The default is one thread. Has no effect if the library
+ *  is compiled without OpenMP.
+ *
+ *  \note
+ *  Distance functions set with #scc_set_dist_functions must be thread-safe
+ *  if more than one thread is used.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_set_num_threads(uint32_t num_threads);
+
+
+/** Memory allocation functions.
+ *
+ *  See #scc_set_allocator.
+ */
+typedef struct scc_Allocator {
+	/// Allocates `size` bytes with the semantics of `malloc`.
+	void* (*malloc_fn)(size_t size, void* context);
+
+	/// Resizes an allocation with the semantics of `realloc`.
+	void* (*realloc_fn)(void* ptr, size_t size, void* context);
+
+	/// Frees an allocation with the semantics of `free`.
+	void (*free_fn)(void* ptr, void* context);
+
+	/// Passed unchanged to the functions.
+	void* context;
+} scc_Allocator;
+
+
+/** Set memory allocation functions.
+ *
+ *  All memory allocated by the library is allocated with these functions.
+ *  If \p allocator is \c NULL, the standard library functions are used, which is the default.
+ *
+ *  \note
+ *  Objects allocated by the library (e.g., #scc_Clustering and #scc_DataSet) are freed
+ *  with the functions that are set when they are freed. The allocator may therefore only be
+ *  changed when no such objects exist. The functions must be thread-safe if more than
+ *  one thread is used.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_set_allocator(const scc_Allocator* allocator);
+
+
+/** Set arena mode.
+ *
+ *  In arena mode, the temporary buffers of a clustering run (e.g., digraphs, seed buffers
+ *  and search scratch) are served from an arena that is allocated in large chunks and
+ *  released in one step when #scc_sc_clustering or #scc_hierarchical_clustering_with_options
+ *  returns. Buffers freed in reverse order of allocation are reused within the run.
+ *  This avoids heap fragmentation from repeated large allocations at the cost of
+ *  possibly higher peak memory. Temporary buffers allocated by parallel threads are
+ *  allocated directly with the functions set by #scc_set_allocator. Each call has its own
+ *  arena, so clustering functions may be called concurrently from different threads.
+ *  Arena mode is off by default.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_set_arena_mode(bool use_arena);
+
+
 /// Struct to report clustering statistics
 typedef struct scc_ClusteringStats {
 	uint64_t num_data_points;
@@ -405,6 +883,31 @@ typedef struct scc_ClusteringStats {
 	double avg_max_dist;
 	double avg_dist_weighted;
 	double avg_dist_unweighted;
+
+	/** Number of clusters whose distance statistics are estimated by sampling.
+	 *
+	 *  Zero unless the statistics are derived with #scc_get_approximate_clustering_stats.
+	 *  For sampled clusters, `sum_dists` and the average distances are estimated,
+	 *  `min_dist` is an upper bound and `max_dist` is a lower bound.
+	 */
+	uint64_t num_sampled_clusters;
+
+	/** Upper bound of `max_dist`.
+	 *
+	 *  Equals `max_dist` when no cluster is sampled. Otherwise it is derived
+	 *  with the triangle inequality, so it is valid only for metric distances.
+	 */
+	double max_dist_upper_bound;
+
+	/** Half-width of the approximate 95% confidence interval of `avg_dist_weighted`.
+	 *
+	 *  Based on Student's t-distribution, with degrees of freedom from the sampled
+	 *  batches. Infinite if the variance of a sampled cluster cannot be estimated.
+	 */
+	double avg_dist_weighted_margin;
+
+	/// Half-width of the approximate 95% confidence interval of `avg_dist_unweighted`.
+	double avg_dist_unweighted_margin;
 } scc_ClusteringStats;
 
 
@@ -413,6 +916,57 @@ scc_ErrorCode scc_get_clustering_stats(void* data_set,
                                        scc_ClusteringStats* out_stats);
 
 
+/** Get approximate clustering statistics.
+ *
+ *  Same as #scc_get_clustering_stats, but the distance statistics of clusters
+ *  with more than `max_sample_pairs` pairs of points are estimated from a random
+ *  sample of pairs. Pairs are drawn in batches until `max_sample_pairs` pairs are
+ *  drawn or, if `target_relative_error` is positive, until the half-width of the
+ *  confidence interval of the cluster's average distance is below
+ *  `target_relative_error` times the estimate. Pairs are drawn in batches of 32,
+ *  and at least eight batches are drawn from each sampled cluster, so budgets
+ *  below 256 pairs are raised to 256. The sampling is deterministic, so
+ *  repeated calls give the same statistics.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_get_approximate_clustering_stats(void* data_set,
+                                                   const scc_Clustering* clustering,
+                                                   uint64_t max_sample_pairs,
+                                                   double target_relative_error,
+                                                   scc_ClusteringStats* out_stats);
+
+
+/** Get statistics of each cluster.
+ *
+ *  Fills the caller-provided buffers with, for each cluster, its size, its
+ *  diameter (the largest within-cluster distance), its average within-cluster
+ *  distance and its radius. The radius is the largest distance from the member
+ *  that best serves as seed to the other members, i.e., the smallest of the
+ *  members' largest within-cluster distances. Distances are derived in the same
+ *  pass as in #scc_get_clustering_stats, so all statistics of a cluster are
+ *  derived with one evaluation of each within-cluster distance. The distance
+ *  statistics of clusters with fewer than two members are zero.
+ *
+ *  \param[in] data_set the data set the clustering is derived from.
+ *  \param[in] clustering the clustering to describe.
+ *  \param[in] len_out_buffers length of the output buffers. Must be at least the number of clusters.
+ *  \param[out] out_sizes buffer for the cluster sizes. May be `NULL`.
+ *  \param[out] out_diameters buffer for the diameters. May be `NULL`.
+ *  \param[out] out_mean_dists buffer for the average distances. May be `NULL`.
+ *  \param[out] out_radii buffer for the radii. May be `NULL`.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_get_cluster_stats(void* data_set,
+                                    const scc_Clustering* clustering,
+                                    size_t len_out_buffers,
+                                    uint64_t out_sizes[],
+                                    double out_diameters[],
+                                    double out_mean_dists[],
+                                    double out_radii[]);
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,436 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "allocator.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+	#include <omp.h>
+#endif // ifdef _OPENMP
+#include "../include/scclust.h"
+#include "error.h"
+#include "run_context.h"
+#include "run_report.h"
+
+// Alignment of allocations. Also the size of the header before each allocation, which holds its size.
+#define ISCC_ALLOC_ALIGN 16
+
+// Smallest chunk of the arena in bytes. Chunks double in size as the arena grows.
+static const size_t ISCC_ARENA_MIN_CHUNK = 1048576;
+
+
+// =============================================================================
+// Internal structs
+// =============================================================================
+
+/** Chunk of memory in the arena.
+ *
+ *  Allocations are placed consecutively after the chunk header. Each allocation
+ *  is preceded by a header with its (rounded) size. Freeing the last allocation
+ *  in a chunk returns its memory to the chunk, and when all allocations in a chunk
+ *  are freed, the whole chunk is reused.
+ */
+typedef struct iscc_ArenaChunk {
+	struct iscc_ArenaChunk* prev;
+	size_t capacity;
+	size_t used;
+	size_t live;
+} iscc_ArenaChunk;
+
+
+// =============================================================================
+// Internal variables
+// =============================================================================
+
+static void* iscc_std_malloc(size_t size,
+                             void* context);
+
+
+static void* iscc_std_realloc(void* ptr,
+                              size_t size,
+                              void* context);
+
+
+static void iscc_std_free(void* ptr,
+                          void* context);
+
+
+static scc_Allocator iscc_allocator = {
+	.malloc_fn = iscc_std_malloc,
+	.realloc_fn = iscc_std_realloc,
+	.free_fn = iscc_std_free,
+	.context = NULL,
+};
+
+static bool iscc_use_arena = false;
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static inline bool iscc_in_parallel(void);
+
+
+static inline size_t iscc_arena_round(size_t size);
+
+
+static inline char* iscc_arena_chunk_data(iscc_ArenaChunk* chunk);
+
+
+static inline iscc_RunContext* iscc_active_arena(void);
+
+
+static iscc_ArenaChunk* iscc_arena_find_chunk(const void* ptr);
+
+
+static void* iscc_arena_malloc(iscc_RunContext* context,
+                               size_t size);
+
+
+static void* iscc_arena_realloc(iscc_ArenaChunk* chunk,
+                                void* ptr,
+                                size_t size);
+
+
+static void iscc_arena_free(iscc_ArenaChunk* chunk,
+                            void* ptr);
+
+
+// =============================================================================
+// Public function implementations
+// =============================================================================
+
+scc_ErrorCode scc_set_allocator(const scc_Allocator* const allocator)
+{
+	if (allocator == NULL) {
+		iscc_allocator = (scc_Allocator) {
+			.malloc_fn = iscc_std_malloc,
+			.realloc_fn = iscc_std_realloc,
+			.free_fn = iscc_std_free,
+			.context = NULL,
+		};
+		return iscc_no_error();
+	}
+	if ((allocator->malloc_fn == NULL) ||
+	        (allocator->realloc_fn == NULL) ||
+	        (allocator->free_fn == NULL)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid allocator.");
+	}
+	iscc_allocator = *allocator;
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode scc_set_arena_mode(const bool use_arena)
+{
+	iscc_use_arena = use_arena;
+	return iscc_no_error();
+}
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+void* iscc_malloc(const size_t size)
+{
+	if (size > SIZE_MAX - ISCC_ALLOC_ALIGN) return NULL;
+	char* const block = iscc_allocator.malloc_fn(ISCC_ALLOC_ALIGN + size, iscc_allocator.context);
+	if (block == NULL) return NULL;
+	*((size_t*) block) = size;
+	iscc_report_alloc(size);
+	return block + ISCC_ALLOC_ALIGN;
+}
+
+
+void* iscc_calloc(const size_t num,
+                  const size_t size)
+{
+	if ((size > 0) && (num > SIZE_MAX / size)) return NULL;
+	void* const ptr = iscc_malloc(num * size);
+	if (ptr != NULL) memset(ptr, 0, num * size);
+	return ptr;
+}
+
+
+void* iscc_realloc(void* const ptr,
+                   const size_t size)
+{
+	if (ptr == NULL) return iscc_malloc(size);
+	iscc_ArenaChunk* const chunk = iscc_arena_find_chunk(ptr);
+	if (chunk != NULL) return iscc_arena_realloc(chunk, ptr, size);
+
+	if (size > SIZE_MAX - ISCC_ALLOC_ALIGN) return NULL;
+	char* const old_block = ((char*) ptr) - ISCC_ALLOC_ALIGN;
+	const size_t old_size = *((size_t*) old_block);
+	char* const block = iscc_allocator.realloc_fn(old_block, ISCC_ALLOC_ALIGN + size, iscc_allocator.context);
+	if (block == NULL) return NULL;
+	*((size_t*) block) = size;
+	iscc_report_free(old_size);
+	iscc_report_alloc(size);
+	return block + ISCC_ALLOC_ALIGN;
+}
+
+
+void iscc_free(void* const ptr)
+{
+	if (ptr == NULL) return;
+	iscc_ArenaChunk* const chunk = iscc_arena_find_chunk(ptr);
+	if (chunk != NULL) {
+		iscc_arena_free(chunk, ptr);
+	} else {
+		char* const block = ((char*) ptr) - ISCC_ALLOC_ALIGN;
+		iscc_report_free(*((size_t*) block));
+		iscc_allocator.free_fn(block, iscc_allocator.context);
+	}
+}
+
+
+void* iscc_tmp_malloc(const size_t size)
+{
+	iscc_RunContext* const context = iscc_active_arena();
+	if (context == NULL) return iscc_malloc(size);
+	return iscc_arena_malloc(context, size);
+}
+
+
+void* iscc_tmp_calloc(const size_t num,
+                      const size_t size)
+{
+	iscc_RunContext* const context = iscc_active_arena();
+	if (context == NULL) return iscc_calloc(num, size);
+	if ((size > 0) && (num > SIZE_MAX / size)) return NULL;
+	void* const ptr = iscc_arena_malloc(context, num * size);
+	if (ptr != NULL) memset(ptr, 0, num * size);
+	return ptr;
+}
+
+
+bool iscc_start_arena(iscc_RunContext* const context)
+{
+	assert(context != NULL);
+
+	if (!iscc_use_arena || context->arena_active) return false;
+	assert(context->arena_top == NULL);
+	context->arena_active = true;
+	context->arena_bytes = 0;
+	return true;
+}
+
+
+void iscc_release_arena(iscc_RunContext* const context)
+{
+	assert(context != NULL);
+
+	while (context->arena_top != NULL) {
+		iscc_ArenaChunk* const prev = context->arena_top->prev;
+		iscc_report_free(iscc_arena_round(sizeof(iscc_ArenaChunk)) + context->arena_top->capacity);
+		iscc_allocator.free_fn(context->arena_top, iscc_allocator.context);
+		context->arena_top = prev;
+	}
+	context->arena_active = false;
+	context->arena_bytes = 0;
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static void* iscc_std_malloc(const size_t size,
+                             void* const context)
+{
+	(void) context;
+	return malloc(size);
+}
+
+
+static void* iscc_std_realloc(void* const ptr,
+                              const size_t size,
+                              void* const context)
+{
+	(void) context;
+	return realloc(ptr, size);
+}
+
+
+static void iscc_std_free(void* const ptr,
+                          void* const context)
+{
+	(void) context;
+	free(ptr);
+}
+
+
+static inline bool iscc_in_parallel(void)
+{
+	// The arena is only changed outside parallel regions, so threads in a run never modify it concurrently
+	#ifdef _OPENMP
+		return (omp_in_parallel() != 0);
+	#else
+		return false;
+	#endif // ifdef _OPENMP
+}
+
+
+static inline size_t iscc_arena_round(const size_t size)
+{
+	return (size + (ISCC_ALLOC_ALIGN - 1)) & ~((size_t) (ISCC_ALLOC_ALIGN - 1));
+}
+
+
+static inline char* iscc_arena_chunk_data(iscc_ArenaChunk* const chunk)
+{
+	return ((char*) chunk) + iscc_arena_round(sizeof(iscc_ArenaChunk));
+}
+
+
+static inline iscc_RunContext* iscc_active_arena(void)
+{
+	iscc_RunContext* const context = iscc_get_run_context();
+	if ((context == NULL) || !context->arena_active || iscc_in_parallel()) return NULL;
+	return context;
+}
+
+
+static iscc_ArenaChunk* iscc_arena_find_chunk(const void* const ptr)
+{
+	const iscc_RunContext* const context = iscc_get_run_context();
+	if (context == NULL) return NULL;
+	const uintptr_t address = (uintptr_t) ptr;
+	for (iscc_ArenaChunk* chunk = context->arena_top; chunk != NULL; chunk = chunk->prev) {
+		const uintptr_t data = (uintptr_t) iscc_arena_chunk_data(chunk);
+		if ((address > data) && (address < data + chunk->used)) return chunk;
+	}
+	return NULL;
+}
+
+
+static void* iscc_arena_malloc(iscc_RunContext* const context,
+                               size_t size)
+{
+	assert(context != NULL);
+	assert(context->arena_active);
+	assert(!iscc_in_parallel());
+
+	if (size == 0) size = 1;
+	if (size > SIZE_MAX / 2 - ISCC_ARENA_MIN_CHUNK) return NULL;
+	const size_t block_size = ISCC_ALLOC_ALIGN + iscc_arena_round(size);
+
+	iscc_ArenaChunk* chunk = context->arena_top;
+	if ((chunk == NULL) || (chunk->capacity - chunk->used < block_size)) {
+		size_t capacity = ISCC_ARENA_MIN_CHUNK;
+		if (chunk != NULL) {
+			if (capacity < 2 * chunk->capacity) capacity = 2 * chunk->capacity;
+			if (chunk->live == 0) {
+				// The chunk is too small and unused, replace it
+				context->arena_top = chunk->prev;
+				context->arena_bytes -= iscc_arena_round(sizeof(iscc_ArenaChunk)) + chunk->capacity;
+				iscc_report_free(iscc_arena_round(sizeof(iscc_ArenaChunk)) + chunk->capacity);
+				iscc_allocator.free_fn(chunk, iscc_allocator.context);
+			}
+		}
+		if (capacity < block_size) capacity = block_size;
+
+		const size_t chunk_bytes = iscc_arena_round(sizeof(iscc_ArenaChunk)) + capacity;
+		chunk = iscc_allocator.malloc_fn(chunk_bytes, iscc_allocator.context);
+		if (chunk == NULL) return NULL;
+		*chunk = (iscc_ArenaChunk) {
+			.prev = context->arena_top,
+			.capacity = capacity,
+			.used = 0,
+			.live = 0,
+		};
+		context->arena_top = chunk;
+		context->arena_bytes += chunk_bytes;
+		iscc_report_alloc(chunk_bytes);
+		iscc_report_arena_bytes(context->arena_bytes);
+	}
+
+	char* const block = iscc_arena_chunk_data(chunk) + chunk->used;
+	*((size_t*) block) = block_size;
+	chunk->used += block_size;
+	++chunk->live;
+
+	return block + ISCC_ALLOC_ALIGN;
+}
+
+
+static void* iscc_arena_realloc(iscc_ArenaChunk* const chunk,
+                                void* const ptr,
+                                const size_t size)
+{
+	assert(chunk != NULL);
+	assert(ptr != NULL);
+
+	if (size > SIZE_MAX / 2) return NULL;
+	char* const block = ((char*) ptr) - ISCC_ALLOC_ALIGN;
+	const size_t old_block_size = *((size_t*) block);
+	const size_t new_block_size = ISCC_ALLOC_ALIGN + iscc_arena_round((size == 0) ? 1 : size);
+	const bool resize_in_place = !iscc_in_parallel() &&
+	                             (block + old_block_size == iscc_arena_chunk_data(chunk) + chunk->used);
+
+	if (new_block_size <= old_block_size) {
+		if (resize_in_place) {
+			chunk->used -= old_block_size - new_block_size;
+			*((size_t*) block) = new_block_size;
+		}
+		return ptr;
+	}
+
+	if (resize_in_place && (new_block_size - old_block_size <= chunk->capacity - chunk->used)) {
+		chunk->used += new_block_size - old_block_size;
+		*((size_t*) block) = new_block_size;
+		return ptr;
+	}
+
+	void* const new_ptr = iscc_tmp_malloc(size);
+	if (new_ptr == NULL) return NULL;
+	memcpy(new_ptr, ptr, old_block_size - ISCC_ALLOC_ALIGN);
+	iscc_free(ptr);
+	return new_ptr;
+}
+
+
+static void iscc_arena_free(iscc_ArenaChunk* const chunk,
+                            void* const ptr)
+{
+	assert(chunk != NULL);
+	assert(chunk->live > 0);
+	assert(ptr != NULL);
+
+	// Memory freed by parallel threads is reclaimed when the arena is released
+	if (iscc_in_parallel()) return;
+
+	char* const block = ((char*) ptr) - ISCC_ALLOC_ALIGN;
+	const size_t block_size = *((size_t*) block);
+	--chunk->live;
+	if (chunk->live == 0) {
+		chunk->used = 0;
+	} else if (block + block_size == iscc_arena_chunk_data(chunk) + chunk->used) {
+		chunk->used -= block_size;
+	}
+}
@@ -0,0 +1,92 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+/** @file
+ *
+ * Memory allocation with user-supplied functions and an optional arena.
+ *
+ * All allocations in the library go through these functions. Memory for
+ * objects that outlive a call (e.g., cluster labels) is allocated with
+ * #iscc_malloc and #iscc_calloc. Temporary buffers of a clustering run are
+ * allocated with #iscc_tmp_malloc and #iscc_tmp_calloc, which are served from
+ * the arena of the current run (see run_context.h) when arena mode is set.
+ * #iscc_free and #iscc_realloc accept memory from either source. Each allocation
+ * is preceded by a header with its size, so the bytes allocated in a run can be
+ * counted for its run report.
+ */
+
+#ifndef SCC_ALLOCATOR_HG
+#define SCC_ALLOCATOR_HG
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "run_context.h"
+
+
+// =============================================================================
+// Function prototypes
+// =============================================================================
+
+void* iscc_malloc(size_t size);
+
+
+void* iscc_calloc(size_t num,
+                  size_t size);
+
+
+void* iscc_realloc(void* ptr,
+                   size_t size);
+
+
+void iscc_free(void* ptr);
+
+
+/// Allocates a temporary buffer, from the arena if one is active.
+void* iscc_tmp_malloc(size_t size);
+
+
+/// Allocates a zeroed temporary buffer, from the arena if one is active.
+void* iscc_tmp_calloc(size_t num,
+                      size_t size);
+
+
+/** Starts an arena for the temporaries of a clustering run.
+ *
+ *  If arena mode is not set or the run already has an arena, nothing is done
+ *  and \c false is returned. Called by #iscc_begin_run.
+ *
+ *  \param context context of the run.
+ *
+ *  \return \c true if an arena was started.
+ */
+bool iscc_start_arena(iscc_RunContext* context);
+
+
+/** Releases the arena of a run.
+ *
+ *  All memory allocated from the arena is freed, whether or not it has been
+ *  passed to #iscc_free. Does nothing if the run has no arena.
+ *
+ *  \param context context of the run.
+ */
+void iscc_release_arena(iscc_RunContext* context);
+
+
+#endif // ifndef SCC_ALLOCATOR_HG
@@ -21,16 +21,49 @@
 #include "../include/scclust.h"
 
 #include <assert.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include "allocator.h"
 #include "error.h"
 #include "data_set_struct.h"
+#include "file_map.h"
 #include "scclust_types.h"
 
 
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static scc_ErrorCode iscc_make_data_set(uint64_t num_data_points,
+                                        uint32_t num_dimensions,
+                                        size_t len_data_matrix,
+                                        const double data_matrix[],
+                                        scc_DistanceMetric metric,
+                                        iscc_FileMap file_map,
+                                        scc_DataSet** out_data_set);
+
+
+static scc_ErrorCode iscc_transform_data_set(scc_DataSet* data_set,
+                                             size_t len_metric_parameters,
+                                             const double metric_parameters[]);
+
+
+static scc_ErrorCode iscc_get_whitening_factor(const scc_DataSet* data_set,
+                                               size_t len_metric_parameters,
+                                               const double metric_parameters[],
+                                               double out_factor[]);
+
+
+static scc_ErrorCode iscc_parse_npy_header(const iscc_FileMap* file_map,
+                                           uint64_t* out_num_data_points,
+                                           uint32_t* out_num_dimensions,
+                                           size_t* out_data_offset);
+
+
 // =============================================================================
 // Public function implementations
 // =============================================================================
@@ -40,6 +73,81 @@ scc_ErrorCode scc_init_data_set(const uint64_t num_data_points,
                                 const size_t len_data_matrix,
                                 const double data_matrix[const],
                                 scc_DataSet** const out_data_set)
+{
+	return scc_init_data_set_with_metric(num_data_points,
+	                                     num_dimensions,
+	                                     len_data_matrix,
+	                                     data_matrix,
+	                                     SCC_DM_EUCLIDEAN,
+	                                     0,
+	                                     NULL,
+	                                     out_data_set);
+}
+
+
+scc_ErrorCode scc_init_data_set_with_metric(const uint64_t num_data_points,
+                                            const uint32_t num_dimensions,
+                                            const size_t len_data_matrix,
+                                            const double data_matrix[const],
+                                            const scc_DistanceMetric metric,
+                                            const size_t len_metric_parameters,
+                                            const double metric_parameters[const],
+                                            scc_DataSet** const out_data_set)
+{
+	if (out_data_set == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Output parameter may not be NULL.");
+	}
+	// Initialize to null, so subsequent functions detect invalid clustering
+	// if user doesn't check for errors.
+	*out_data_set = NULL;
+
+	if ((metric != SCC_DM_EUCLIDEAN) &&
+	        (metric != SCC_DM_MANHATTAN) &&
+	        (metric != SCC_DM_CHEBYSHEV) &&
+	        (metric != SCC_DM_WEIGHTED_EUCLIDEAN) &&
+	        (metric != SCC_DM_COSINE) &&
+	        (metric != SCC_DM_MAHALANOBIS)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Unknown distance metric.");
+	}
+	if ((len_metric_parameters > 0) && (metric_parameters == NULL)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid metric parameters.");
+	}
+	if ((len_metric_parameters > 0) &&
+	        (metric != SCC_DM_WEIGHTED_EUCLIDEAN) &&
+	        (metric != SCC_DM_MAHALANOBIS)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Distance metric does not take parameters.");
+	}
+
+	scc_ErrorCode ec;
+	if ((ec = iscc_make_data_set(num_data_points,
+	                             num_dimensions,
+	                             len_data_matrix,
+	                             data_matrix,
+	                             metric,
+	                             ISCC_NULL_FILE_MAP,
+	                             out_data_set)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	if ((metric == SCC_DM_WEIGHTED_EUCLIDEAN) ||
+	        (metric == SCC_DM_COSINE) ||
+	        (metric == SCC_DM_MAHALANOBIS)) {
+		if ((ec = iscc_transform_data_set(*out_data_set,
+		                                  len_metric_parameters,
+		                                  metric_parameters)) != SCC_ER_OK) {
+			scc_free_data_set(out_data_set);
+			return ec;
+		}
+	}
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode scc_init_data_set_from_file(const char* const file_path,
+                                          const scc_DataFileFormat file_format,
+                                          const uint32_t num_dimensions,
+                                          scc_DataSet** const out_data_set)
 {
 	if (out_data_set == NULL) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Output parameter may not be NULL.");
@@ -48,6 +156,126 @@ scc_ErrorCode scc_init_data_set(const uint64_t num_data_points,
 	// if user doesn't check for errors.
 	*out_data_set = NULL;
 
+	if (file_path == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid file path.");
+	}
+	if ((file_format != SCC_DF_RAW) && (file_format != SCC_DF_NPY)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Unknown file format.");
+	}
+	if ((file_format == SCC_DF_RAW) && (num_dimensions == 0)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Data set must have positive number of dimensions.");
+	}
+
+	// Distance searches scan the data matrix front to back
+	scc_ErrorCode ec;
+	iscc_FileMap file_map;
+	if ((ec = iscc_map_file(file_path, ISCC_FA_SEQUENTIAL, &file_map)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	uint64_t file_num_data_points = 0;
+	uint32_t file_num_dimensions = 0;
+	size_t data_offset = 0;
+	if (file_format == SCC_DF_RAW) {
+		const size_t row_size = sizeof(double) * num_dimensions;
+		if ((file_map.length % row_size) != 0) {
+			iscc_unmap_file(&file_map);
+			return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "File size is not a multiple of the row size.");
+		}
+		file_num_data_points = (uint64_t) (file_map.length / row_size);
+		file_num_dimensions = num_dimensions;
+		data_offset = 0;
+	} else {
+		if ((ec = iscc_parse_npy_header(&file_map,
+		                                &file_num_data_points,
+		                                &file_num_dimensions,
+		                                &data_offset)) != SCC_ER_OK) {
+			iscc_unmap_file(&file_map);
+			return ec;
+		}
+		if ((num_dimensions != 0) && (num_dimensions != file_num_dimensions)) {
+			iscc_unmap_file(&file_map);
+			return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Number of dimensions does not match file.");
+		}
+	}
+
+	const double* const data_matrix = (const double*) (((const char*) file_map.memory) + data_offset);
+	if ((ec = iscc_make_data_set(file_num_data_points,
+	                             file_num_dimensions,
+	                             (file_map.length - data_offset) / sizeof(double),
+	                             data_matrix,
+	                             SCC_DM_EUCLIDEAN,
+	                             file_map,
+	                             out_data_set)) != SCC_ER_OK) {
+		iscc_unmap_file(&file_map);
+		return ec;
+	}
+
+	return iscc_no_error();
+}
+
+
+void scc_free_data_set(scc_DataSet** const data_set)
+{
+	if ((data_set != NULL) && (*data_set != NULL)) {
+		iscc_unmap_file(&(*data_set)->file_map);
+		iscc_free((*data_set)->transformed_data_matrix);
+		iscc_free(*data_set);
+		*data_set = NULL;
+	}
+}
+
+
+bool scc_is_initialized_data_set(const scc_DataSet* const data_set)
+{
+	if (data_set == NULL) return false;
+	if (data_set->data_set_version != ISCC_DATASET_STRUCT_VERSION) return false;
+	if (data_set->num_data_points == 0) return false;
+	if (data_set->num_dimensions == 0) return false;
+	if (data_set->data_matrix == NULL) return false;
+	return true;
+}
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+scc_ErrorCode iscc_init_derived_data_set(const scc_DataSet* const parent,
+                                         const uint64_t num_data_points,
+                                         const size_t len_data_matrix,
+                                         const double data_matrix[const],
+                                         scc_DataSet** const out_data_set)
+{
+	assert(scc_is_initialized_data_set(parent));
+	assert(out_data_set != NULL);
+
+	*out_data_set = NULL;
+
+	return iscc_make_data_set(num_data_points,
+	                          (uint32_t) parent->num_dimensions,
+	                          len_data_matrix,
+	                          data_matrix,
+	                          parent->metric,
+	                          ISCC_NULL_FILE_MAP,
+	                          out_data_set);
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static scc_ErrorCode iscc_make_data_set(const uint64_t num_data_points,
+                                        const uint32_t num_dimensions,
+                                        const size_t len_data_matrix,
+                                        const double data_matrix[const],
+                                        const scc_DistanceMetric metric,
+                                        const iscc_FileMap file_map,
+                                        scc_DataSet** const out_data_set)
+{
+	assert(out_data_set != NULL);
+
 	if (num_data_points == 0) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Data set must have positive number of data points.");
 	}
@@ -70,7 +298,7 @@ scc_ErrorCode scc_init_data_set(const uint64_t num_data_points,
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data matrix.");
 	}
 
-	scc_DataSet* tmp_dso = malloc(sizeof(scc_DataSet));
+	scc_DataSet* tmp_dso = iscc_malloc(sizeof(scc_DataSet));
 	if (tmp_dso == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 	*tmp_dso = (scc_DataSet) {
@@ -78,6 +306,9 @@ scc_ErrorCode scc_init_data_set(const uint64_t num_data_points,
 		.num_data_points = (size_t) num_data_points,
 		.num_dimensions = (uint_fast16_t) num_dimensions,
 		.data_matrix = data_matrix,
+		.file_map = file_map,
+		.metric = metric,
+		.transformed_data_matrix = NULL,
 	};
 
 	*out_data_set = tmp_dso;
@@ -86,21 +317,306 @@ scc_ErrorCode scc_init_data_set(const uint64_t num_data_points,
 }
 
 
-void scc_free_data_set(scc_DataSet** const data_set)
+static scc_ErrorCode iscc_transform_data_set(scc_DataSet* const data_set,
+                                             const size_t len_metric_parameters,
+                                             const double metric_parameters[const])
 {
-	if ((data_set != NULL) && (*data_set != NULL)) {
-		free(*data_set);
-		*data_set = NULL;
+	assert(scc_is_initialized_data_set(data_set));
+	assert((data_set->metric == SCC_DM_WEIGHTED_EUCLIDEAN) ||
+	       (data_set->metric == SCC_DM_COSINE) ||
+	       (data_set->metric == SCC_DM_MAHALANOBIS));
+	assert(data_set->transformed_data_matrix == NULL);
+
+	const size_t num_data_points = data_set->num_data_points;
+	const size_t num_dimensions = (size_t) data_set->num_dimensions;
+	if (num_data_points > SIZE_MAX / sizeof(double) / num_dimensions) {
+		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many data points.");
+	}
+
+	// Scale of each dimension, or the whitening factor for Mahalanobis distances
+	double* factor = NULL;
+	scc_ErrorCode ec = SCC_ER_OK;
+	if (data_set->metric == SCC_DM_WEIGHTED_EUCLIDEAN) {
+		if (len_metric_parameters != num_dimensions) {
+			return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Weighted Euclidean distance requires one weight for each dimension.");
+		}
+		factor = iscc_tmp_malloc(sizeof(double[num_dimensions]));
+		if (factor == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			if (!(metric_parameters[d] >= 0.0) || !isfinite(metric_parameters[d])) {
+				iscc_free(factor);
+				return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Dimension weights must be non-negative and finite.");
+			}
+			factor[d] = sqrt(metric_parameters[d]);
+		}
+	} else if (data_set->metric == SCC_DM_MAHALANOBIS) {
+		if (num_dimensions > SIZE_MAX / sizeof(double) / num_dimensions) {
+			return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many data dimensions.");
+		}
+		factor = iscc_tmp_malloc(sizeof(double) * num_dimensions * num_dimensions);
+		if (factor == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+		if ((ec = iscc_get_whitening_factor(data_set,
+		                                    len_metric_parameters,
+		                                    metric_parameters,
+		                                    factor)) != SCC_ER_OK) {
+			iscc_free(factor);
+			return ec;
+		}
+	}
+
+	double* const transformed = iscc_malloc(sizeof(double) * num_data_points * num_dimensions);
+	if (transformed == NULL) {
+		iscc_free(factor);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	for (size_t i = 0; i < num_data_points; ++i) {
+		const double* const row = data_set->data_matrix + i * num_dimensions;
+		double* const out_row = transformed + i * num_dimensions;
+		if (data_set->metric == SCC_DM_WEIGHTED_EUCLIDEAN) {
+			for (size_t d = 0; d < num_dimensions; ++d) {
+				out_row[d] = factor[d] * row[d];
+			}
+		} else if (data_set->metric == SCC_DM_COSINE) {
+			// Unit length rows, so squared Euclidean distances are `2 - 2 cos(angle)`
+			double norm = 0.0;
+			for (size_t d = 0; d < num_dimensions; ++d) {
+				norm += row[d] * row[d];
+			}
+			norm = sqrt(norm);
+			if (!(norm > 0.0) || !isfinite(norm)) {
+				ec = iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Cosine distance requires non-zero, finite data points.");
+				break;
+			}
+			for (size_t d = 0; d < num_dimensions; ++d) {
+				out_row[d] = row[d] / norm;
+			}
+		} else {
+			// Solve `L z = x` where `L` is the lower triangular whitening factor
+			for (size_t d = 0; d < num_dimensions; ++d) {
+				const double* const factor_row = factor + d * num_dimensions;
+				double value = row[d];
+				for (size_t e = 0; e < d; ++e) {
+					value -= factor_row[e] * out_row[e];
+				}
+				out_row[d] = value / factor_row[d];
+			}
+		}
 	}
+
+	iscc_free(factor);
+
+	if (ec != SCC_ER_OK) {
+		iscc_free(transformed);
+		return ec;
+	}
+
+	data_set->transformed_data_matrix = transformed;
+	data_set->data_matrix = transformed;
+
+	return iscc_no_error();
 }
 
 
-bool scc_is_initialized_data_set(const scc_DataSet* const data_set)
+static scc_ErrorCode iscc_get_whitening_factor(const scc_DataSet* const data_set,
+                                               const size_t len_metric_parameters,
+                                               const double metric_parameters[const],
+                                               double out_factor[const])
 {
-	if (data_set == NULL) return false;
-	if (data_set->data_set_version != ISCC_DATASET_STRUCT_VERSION) return false;
-	if (data_set->num_data_points == 0) return false;
-	if (data_set->num_dimensions == 0) return false;
-	if (data_set->data_matrix == NULL) return false;
-	return true;
+	assert(scc_is_initialized_data_set(data_set));
+	assert(data_set->metric == SCC_DM_MAHALANOBIS);
+	assert(out_factor != NULL);
+
+	const size_t num_data_points = data_set->num_data_points;
+	const size_t num_dimensions = (size_t) data_set->num_dimensions;
+	const double* const data_matrix = data_set->data_matrix;
+
+	// The factor is computed in place of the lower triangle of the covariance matrix
+	if (len_metric_parameters > 0) {
+		if (len_metric_parameters != num_dimensions * num_dimensions) {
+			return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Covariance matrix must have `num_dimensions * num_dimensions` elements.");
+		}
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			for (size_t e = 0; e <= d; ++e) {
+				if (metric_parameters[d * num_dimensions + e] != metric_parameters[e * num_dimensions + d]) {
+					return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Covariance matrix must be symmetric.");
+				}
+				out_factor[d * num_dimensions + e] = metric_parameters[d * num_dimensions + e];
+			}
+		}
+	} else {
+		if (num_data_points < 2) {
+			return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Sample covariance matrix requires at least two data points.");
+		}
+		double* const means = iscc_tmp_calloc(num_dimensions, sizeof(double));
+		if (means == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+		for (size_t i = 0; i < num_data_points; ++i) {
+			for (size_t d = 0; d < num_dimensions; ++d) {
+				means[d] += data_matrix[i * num_dimensions + d];
+			}
+		}
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			means[d] /= (double) num_data_points;
+			for (size_t e = 0; e <= d; ++e) {
+				out_factor[d * num_dimensions + e] = 0.0;
+			}
+		}
+		for (size_t i = 0; i < num_data_points; ++i) {
+			const double* const row = data_matrix + i * num_dimensions;
+			for (size_t d = 0; d < num_dimensions; ++d) {
+				const double diff_d = row[d] - means[d];
+				for (size_t e = 0; e <= d; ++e) {
+					out_factor[d * num_dimensions + e] += diff_d * (row[e] - means[e]);
+				}
+			}
+		}
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			for (size_t e = 0; e <= d; ++e) {
+				out_factor[d * num_dimensions + e] /= (double) (num_data_points - 1);
+			}
+		}
+		iscc_free(means);
+	}
+
+	// Cholesky decomposition, `S = L L'`
+	for (size_t e = 0; e < num_dimensions; ++e) {
+		double* const row_e = out_factor + e * num_dimensions;
+		double diag = row_e[e];
+		for (size_t f = 0; f < e; ++f) {
+			diag -= row_e[f] * row_e[f];
+		}
+		if (!(diag > 0.0) || !isfinite(diag)) {
+			return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Covariance matrix must be positive definite.");
+		}
+		row_e[e] = sqrt(diag);
+		for (size_t d = e + 1; d < num_dimensions; ++d) {
+			double* const row_d = out_factor + d * num_dimensions;
+			double value = row_d[e];
+			for (size_t f = 0; f < e; ++f) {
+				value -= row_d[f] * row_e[f];
+			}
+			row_d[e] = value / row_e[e];
+		}
+	}
+
+	return iscc_no_error();
+}
+
+
+static scc_ErrorCode iscc_parse_npy_header(const iscc_FileMap* const file_map,
+                                           uint64_t* const out_num_data_points,
+                                           uint32_t* const out_num_dimensions,
+                                           size_t* const out_data_offset)
+{
+	assert(file_map != NULL);
+	assert(file_map->memory != NULL);
+	assert(out_num_data_points != NULL);
+	assert(out_num_dimensions != NULL);
+	assert(out_data_offset != NULL);
+
+	// Format: "\x93NUMPY", major and minor version, header length, and a
+	// Python dict literal describing the array
+	const unsigned char* const bytes = file_map->memory;
+	if ((file_map->length < 10) || (memcmp(bytes, "\x93NUMPY", 6) != 0)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Not a npy file.");
+	}
+
+	size_t header_start;
+	size_t header_length;
+	if (bytes[6] == 1) {
+		header_start = 10;
+		header_length = (size_t) bytes[8] | ((size_t) bytes[9] << 8);
+	} else if (((bytes[6] == 2) || (bytes[6] == 3)) && (file_map->length >= 12)) {
+		header_start = 12;
+		header_length = (size_t) bytes[8] | ((size_t) bytes[9] << 8) |
+		                ((size_t) bytes[10] << 16) | ((size_t) bytes[11] << 24);
+	} else {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Unsupported npy version.");
+	}
+	if (header_length > file_map->length - header_start) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Corrupt npy file.");
+	}
+
+	char* const header = iscc_malloc(header_length + 1);
+	if (header == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+	memcpy(header, bytes + header_start, header_length);
+	header[header_length] = '\0';
+
+	const uint16_t byte_order_probe = 1;
+	const bool little_endian = (*((const unsigned char*) &byte_order_probe) == 1);
+
+	const char* const descr = strstr(header, "'descr':");
+	const char* const fortran_order = strstr(header, "'fortran_order':");
+	const char* shape = strstr(header, "'shape':");
+	bool header_ok = (descr != NULL) && (fortran_order != NULL) && (shape != NULL);
+
+	if (header_ok) {
+		const char* const native_descr = little_endian ? "'<f8'" : "'>f8'";
+		const char* descr_value = descr + strlen("'descr':");
+		while (*descr_value == ' ') ++descr_value;
+		header_ok = (strncmp(descr_value, native_descr, strlen(native_descr)) == 0);
+		if (!header_ok) {
+			iscc_free(header);
+			return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Data in npy file must be doubles in native byte order.");
+		}
+	}
+
+	if (header_ok) {
+		const char* fortran_value = fortran_order + strlen("'fortran_order':");
+		while (*fortran_value == ' ') ++fortran_value;
+		header_ok = (strncmp(fortran_value, "False", 5) == 0);
+		if (!header_ok) {
+			iscc_free(header);
+			return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Data in npy file must be in row-major order.");
+		}
+	}
+
+	uint64_t shape_values[2] = { 0, 1 };
+	size_t num_shape_values = 0;
+	if (header_ok) {
+		shape = strchr(shape, '(');
+		header_ok = (shape != NULL);
+	}
+	if (header_ok) {
+		++shape;
+		while (header_ok) {
+			while (*shape == ' ') ++shape;
+			if (*shape == ')') break;
+			char* shape_end;
+			const unsigned long long value = strtoull(shape, &shape_end, 10);
+			header_ok = (shape_end != shape) && (num_shape_values < 2);
+			if (header_ok) {
+				shape_values[num_shape_values] = (uint64_t) value;
+				++num_shape_values;
+				shape = shape_end;
+				while (*shape == ' ') ++shape;
+				if (*shape == ',') ++shape;
+			}
+		}
+		header_ok = header_ok && (num_shape_values >= 1);
+	}
+
+	iscc_free(header);
+
+	if (!header_ok) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Cannot parse npy header.");
+	}
+	if ((shape_values[1] == 0) || (shape_values[1] > UINT16_MAX)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid number of dimensions in npy file.");
+	}
+
+	const size_t data_offset = header_start + header_length;
+	if ((data_offset % sizeof(double)) != 0) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Unaligned data in npy file.");
+	}
+	if ((shape_values[0] > (file_map->length - data_offset) / sizeof(double)) ||
+	        (shape_values[0] * shape_values[1] > (file_map->length - data_offset) / sizeof(double))) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Corrupt npy file.");
+	}
+
+	*out_num_data_points = shape_values[0];
+	*out_num_dimensions = (uint32_t) shape_values[1];
+	*out_data_offset = data_offset;
+
+	return iscc_no_error();
 }
@@ -0,0 +1,228 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "data_set_collapse.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/scclust.h"
+#include "allocator.h"
+#include "data_set_struct.h"
+#include "error.h"
+#include "scclust_types.h"
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static inline uint64_t iscc_hash_row(const double row[],
+                                     uint_fast16_t num_dimensions,
+                                     bool is_primary);
+
+
+static inline bool iscc_rows_equal(const double row1[],
+                                   const double row2[],
+                                   uint_fast16_t num_dimensions);
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+scc_ErrorCode iscc_collapse_data_set(const scc_DataSet* const data_set,
+                                     const size_t len_primary_data_points,
+                                     const scc_PointIndex primary_data_points[const],
+                                     iscc_CollapsedDataSet* const out_collapsed)
+{
+	assert(scc_is_initialized_data_set(data_set));
+	assert((primary_data_points == NULL) || (len_primary_data_points > 0));
+	assert(out_collapsed != NULL);
+
+	*out_collapsed = ISCC_NULL_COLLAPSED_DATA_SET;
+
+	const size_t num_data_points = data_set->num_data_points;
+	const uint_fast16_t num_dimensions = data_set->num_dimensions;
+
+	// Open addressing hash table with at least twice as many slots as data points
+	if (num_data_points > SIZE_MAX / 4) {
+		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many data points.");
+	}
+	size_t table_size = 16;
+	while (table_size < 2 * num_data_points) table_size *= 2;
+	const size_t table_mask = table_size - 1;
+
+	// Slots store unique index + 1, zero is an empty slot
+	size_t* const table = iscc_tmp_calloc(table_size, sizeof(size_t));
+	uint64_t* const unique_hash = iscc_tmp_malloc(sizeof(uint64_t[num_data_points]));
+	size_t* const unique_first = iscc_tmp_malloc(sizeof(size_t[num_data_points]));
+	bool* const is_primary = (primary_data_points == NULL) ? NULL : iscc_tmp_calloc(num_data_points, sizeof(bool));
+	out_collapsed->point_group = iscc_tmp_malloc(sizeof(scc_PointIndex[num_data_points]));
+	out_collapsed->group_weights = iscc_tmp_calloc(num_data_points, sizeof(size_t));
+	if ((table == NULL) || (unique_hash == NULL) || (unique_first == NULL) ||
+	        ((primary_data_points != NULL) && (is_primary == NULL)) ||
+	        (out_collapsed->point_group == NULL) || (out_collapsed->group_weights == NULL)) {
+		iscc_free(table);
+		iscc_free(unique_hash);
+		iscc_free(unique_first);
+		iscc_free(is_primary);
+		iscc_free_collapsed_data_set(out_collapsed);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	if (primary_data_points != NULL) {
+		for (size_t i = 0; i < len_primary_data_points; ++i) {
+			is_primary[primary_data_points[i]] = true;
+		}
+	}
+
+	size_t num_unique = 0;
+	for (size_t i = 0; i < num_data_points; ++i) {
+		const double* const row = data_set->data_matrix + i * num_dimensions;
+		const bool row_primary = (is_primary == NULL) || is_primary[i];
+		const uint64_t hash = iscc_hash_row(row, num_dimensions, row_primary);
+
+		size_t slot = (size_t) hash & table_mask;
+		for (; table[slot] != 0; slot = (slot + 1) & table_mask) {
+			const size_t u = table[slot] - 1;
+			const size_t first = unique_first[u];
+			if ((unique_hash[u] == hash) &&
+			        (((is_primary == NULL) || (is_primary[first] == row_primary))) &&
+			        iscc_rows_equal(data_set->data_matrix + first * num_dimensions, row, num_dimensions)) {
+				break;
+			}
+		}
+
+		if (table[slot] == 0) {
+			unique_hash[num_unique] = hash;
+			unique_first[num_unique] = i;
+			++num_unique;
+			table[slot] = num_unique;
+		}
+
+		const size_t u = table[slot] - 1;
+		out_collapsed->point_group[i] = (scc_PointIndex) u;
+		++(out_collapsed->group_weights[u]);
+	}
+
+	iscc_free(table);
+	iscc_free(unique_hash);
+
+	out_collapsed->num_unique = num_unique;
+	out_collapsed->unique_data_matrix = iscc_tmp_malloc(sizeof(double) * num_unique * num_dimensions);
+	if (out_collapsed->unique_data_matrix == NULL) {
+		iscc_free(unique_first);
+		iscc_free(is_primary);
+		iscc_free_collapsed_data_set(out_collapsed);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+	for (size_t u = 0; u < num_unique; ++u) {
+		memcpy(out_collapsed->unique_data_matrix + u * num_dimensions,
+		       data_set->data_matrix + unique_first[u] * num_dimensions,
+		       sizeof(double[num_dimensions]));
+	}
+	iscc_free(unique_first);
+
+	scc_ErrorCode ec;
+	if ((ec = iscc_init_derived_data_set(data_set,
+	                                     (uint64_t) num_unique,
+	                                     num_unique * num_dimensions,
+	                                     out_collapsed->unique_data_matrix,
+	                                     &out_collapsed->unique_data_set)) != SCC_ER_OK) {
+		iscc_free(is_primary);
+		iscc_free_collapsed_data_set(out_collapsed);
+		return ec;
+	}
+
+	// Primary data points are listed in the same order as in `primary_data_points`
+	if (primary_data_points != NULL) {
+		out_collapsed->unique_primary_data_points = iscc_tmp_malloc(sizeof(scc_PointIndex[num_unique]));
+		if (out_collapsed->unique_primary_data_points == NULL) {
+			iscc_free(is_primary);
+			iscc_free_collapsed_data_set(out_collapsed);
+			return iscc_make_error(SCC_ER_NO_MEMORY);
+		}
+		// `is_primary` is reused to mark listed unique points
+		for (size_t i = 0; i < num_unique; ++i) is_primary[i] = false;
+		for (size_t i = 0; i < len_primary_data_points; ++i) {
+			const scc_PointIndex u = out_collapsed->point_group[primary_data_points[i]];
+			if (!is_primary[u]) {
+				is_primary[u] = true;
+				out_collapsed->unique_primary_data_points[out_collapsed->len_unique_primary_data_points] = u;
+				++(out_collapsed->len_unique_primary_data_points);
+			}
+		}
+		iscc_free(is_primary);
+	}
+
+	return iscc_no_error();
+}
+
+
+void iscc_free_collapsed_data_set(iscc_CollapsedDataSet* const collapsed)
+{
+	if (collapsed != NULL) {
+		scc_free_data_set(&collapsed->unique_data_set);
+		iscc_free(collapsed->unique_data_matrix);
+		iscc_free(collapsed->point_group);
+		iscc_free(collapsed->group_weights);
+		iscc_free(collapsed->unique_primary_data_points);
+		*collapsed = ISCC_NULL_COLLAPSED_DATA_SET;
+	}
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static inline uint64_t iscc_hash_row(const double row[const],
+                                     const uint_fast16_t num_dimensions,
+                                     const bool is_primary)
+{
+	// FNV-1a over the coordinates. Adding zero maps negative zero to
+	// positive zero so that coordinates that compare equal hash equally.
+	uint64_t hash = UINT64_C(14695981039346656037) ^ (uint64_t) is_primary;
+	for (uint_fast16_t d = 0; d < num_dimensions; ++d) {
+		const double value = row[d] + 0.0;
+		unsigned char bytes[sizeof(double)];
+		memcpy(bytes, &value, sizeof(double));
+		for (size_t b = 0; b < sizeof(double); ++b) {
+			hash ^= bytes[b];
+			hash *= UINT64_C(1099511628211);
+		}
+	}
+	return hash;
+}
+
+
+static inline bool iscc_rows_equal(const double row1[const],
+                                   const double row2[const],
+                                   const uint_fast16_t num_dimensions)
+{
+	for (uint_fast16_t d = 0; d < num_dimensions; ++d) {
+		if (row1[d] != row2[d]) return false;
+	}
+	return true;
+}
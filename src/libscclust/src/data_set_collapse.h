@@ -0,0 +1,88 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+/** @file
+ *
+ * Collapsing of identical data points.
+ *
+ * Data points with identical coordinates are collapsed into one
+ * representative point that is weighted by the number of points it
+ * represents. Clustering can then be done on the unique points and
+ * the labels expanded back to all points.
+ */
+
+#ifndef SCC_DATA_SET_COLLAPSE_HG
+#define SCC_DATA_SET_COLLAPSE_HG
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "../include/scclust.h"
+
+
+// =============================================================================
+// Structs and variables
+// =============================================================================
+
+/** A data set with identical data points collapsed.
+ *
+ *  Two data points are collapsed only if they have identical coordinates and
+ *  either both or none of them are primary data points.
+ */
+typedef struct iscc_CollapsedDataSet {
+	/// Number of unique data points.
+	size_t num_unique;
+
+	/// Data set with the unique data points, in order of first occurrence.
+	scc_DataSet* unique_data_set;
+
+	/// Data matrix of #unique_data_set.
+	double* unique_data_matrix;
+
+	/// Unique data point of each data point in the original data set.
+	scc_PointIndex* point_group;
+
+	/// Number of original data points represented by each unique data point.
+	size_t* group_weights;
+
+	/// Length of #unique_primary_data_points.
+	size_t len_unique_primary_data_points;
+
+	/// Unique data points that represent primary data points, `NULL` if all points are primary.
+	scc_PointIndex* unique_primary_data_points;
+} iscc_CollapsedDataSet;
+
+
+static const iscc_CollapsedDataSet ISCC_NULL_COLLAPSED_DATA_SET = { 0, NULL, NULL, NULL, NULL, 0, NULL };
+
+
+// =============================================================================
+// Function prototypes
+// =============================================================================
+
+scc_ErrorCode iscc_collapse_data_set(const scc_DataSet* data_set,
+                                     size_t len_primary_data_points,
+                                     const scc_PointIndex primary_data_points[],
+                                     iscc_CollapsedDataSet* out_collapsed);
+
+
+void iscc_free_collapsed_data_set(iscc_CollapsedDataSet* collapsed);
+
+
+#endif // ifndef SCC_DATA_SET_COLLAPSE_HG
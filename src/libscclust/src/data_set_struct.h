@@ -25,6 +25,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include "../include/scclust.h"
+#include "file_map.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -40,10 +41,38 @@ struct scc_DataSet {
 	size_t num_data_points;
 	uint_fast16_t num_dimensions;
 	const double* data_matrix;
+	iscc_FileMap file_map;
+	scc_DistanceMetric metric;
+	double* transformed_data_matrix;
 };
 
 
-static const int32_t ISCC_DATASET_STRUCT_VERSION = 722328001;
+static const int32_t ISCC_DATASET_STRUCT_VERSION = 722328002;
+
+
+// =============================================================================
+// Function prototypes
+// =============================================================================
+
+/** Construct data set from rows of another data set.
+ *
+ *  The new data set uses the same distance metric as \p parent. The rows in
+ *  \p data_matrix must be taken from the data matrix of \p parent, which is
+ *  already transformed for metrics that require it, so they are not transformed again.
+ *
+ *  \param[in] parent the data set the rows are taken from.
+ *  \param[in] num_data_points the number of data points in the new data set.
+ *  \param[in] len_data_matrix the length of #data_matrix.
+ *  \param[in] data_matrix the rows of the new data set.
+ *  \param[out] out_data_set double pointer to where to write the data set reference.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode iscc_init_derived_data_set(const scc_DataSet* parent,
+                                         uint64_t num_data_points,
+                                         size_t len_data_matrix,
+                                         const double data_matrix[],
+                                         scc_DataSet** out_data_set);
 
 
 #ifdef __cplusplus
@@ -26,10 +26,20 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include "../include/scclust.h"
+#include "allocator.h"
 #include "error.h"
+#include "run_report.h"
 #include "scclust_types.h"
 
 
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static inline size_t iscc_digraph_bytes(size_t vertices,
+                                        size_t max_arcs);
+
+
 // =============================================================================
 // External function implementations
 // =============================================================================
@@ -37,8 +47,13 @@
 void iscc_free_digraph(iscc_Digraph* const dg)
 {
 	if (dg != NULL) {
-		free(dg->head);
-		free(dg->tail_ptr);
+		if (!dg->external_arrays) {
+			if (dg->tail_ptr != NULL) {
+				iscc_report_digraph_free(iscc_digraph_bytes(dg->vertices, dg->max_arcs));
+			}
+			iscc_free(dg->head);
+			iscc_free(dg->tail_ptr);
+		}
 		*dg = ISCC_NULL_DIGRAPH;
 	}
 }
@@ -97,18 +112,21 @@ scc_ErrorCode iscc_init_digraph(const size_t vertices,
 		.vertices = vertices,
 		.max_arcs = (size_t) max_arcs,
 		.head = NULL,
-		.tail_ptr = malloc(sizeof(iscc_ArcIndex[vertices + 1])),
+		.tail_ptr = iscc_tmp_malloc(sizeof(iscc_ArcIndex[vertices + 1])),
+		.external_arrays = false,
 	};
 	if (out_dg->tail_ptr == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 	if (max_arcs > 0) {
-		out_dg->head = malloc(sizeof(scc_PointIndex[max_arcs]));
+		out_dg->head = iscc_tmp_malloc(sizeof(scc_PointIndex[max_arcs]));
 		if (out_dg->head == NULL) {
 			iscc_free_digraph(out_dg);
 			return iscc_make_error(SCC_ER_NO_MEMORY);
 		}
 	}
 
+	iscc_report_digraph_alloc(iscc_digraph_bytes(vertices, (size_t) max_arcs));
+
 	assert(iscc_digraph_is_initialized(out_dg));
 
 	return iscc_no_error();
@@ -131,18 +149,21 @@ scc_ErrorCode iscc_empty_digraph(const size_t vertices,
 		.vertices = vertices,
 		.max_arcs = (size_t) max_arcs,
 		.head = NULL,
-		.tail_ptr = calloc(vertices + 1, sizeof(iscc_ArcIndex)),
+		.tail_ptr = iscc_tmp_calloc(vertices + 1, sizeof(iscc_ArcIndex)),
+		.external_arrays = false,
 	};
 	if (out_dg->tail_ptr == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 	if (max_arcs > 0) {
-		out_dg->head = malloc(sizeof(scc_PointIndex[max_arcs]));
+		out_dg->head = iscc_tmp_malloc(sizeof(scc_PointIndex[max_arcs]));
 		if (out_dg->head == NULL) {
 			iscc_free_digraph(out_dg);
 			return iscc_make_error(SCC_ER_NO_MEMORY);
 		}
 	}
 
+	iscc_report_digraph_alloc(iscc_digraph_bytes(vertices, (size_t) max_arcs));
+
 	assert(iscc_digraph_is_valid(out_dg));
 
 	return iscc_no_error();
@@ -153,22 +174,41 @@ scc_ErrorCode iscc_change_arc_storage(iscc_Digraph* const dg,
                                       const uintmax_t new_max_arcs)
 {
 	assert(iscc_digraph_is_initialized(dg));
+	assert(!dg->external_arrays);
 	assert(dg->tail_ptr[dg->vertices] <= new_max_arcs);
 	if ((new_max_arcs > ISCC_ARCINDEX_MAX) || (new_max_arcs > SIZE_MAX)) {
 		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many arcs in graph (adjust the `iscc_ArcIndex` type).");
 	}
 	if (dg->max_arcs == new_max_arcs) return iscc_no_error();
 
+	const size_t old_max_arcs = dg->max_arcs;
 	if (new_max_arcs == 0) {
-		free(dg->head);
+		iscc_free(dg->head);
 		dg->head = NULL;
 		dg->max_arcs = 0;
 	} else {
-		scc_PointIndex* const tmp_ptr = realloc(dg->head, sizeof(scc_PointIndex[new_max_arcs]));
+		scc_PointIndex* const tmp_ptr = iscc_realloc(dg->head, sizeof(scc_PointIndex[new_max_arcs]));
 		if (tmp_ptr == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 		dg->head = tmp_ptr;
 		dg->max_arcs = (size_t) new_max_arcs;
 	}
 
+	if (old_max_arcs < dg->max_arcs) {
+		iscc_report_digraph_alloc(sizeof(scc_PointIndex[dg->max_arcs - old_max_arcs]));
+	} else {
+		iscc_report_digraph_free(sizeof(scc_PointIndex[old_max_arcs - dg->max_arcs]));
+	}
+
 	return iscc_no_error();
 }
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static inline size_t iscc_digraph_bytes(const size_t vertices,
+                                        const size_t max_arcs)
+{
+	return sizeof(iscc_ArcIndex[vertices + 1]) + sizeof(scc_PointIndex[max_arcs]);
+}
@@ -77,6 +77,13 @@ typedef struct iscc_Digraph {
 	 *  we must have `#tail_ptr[i] <= #tail_ptr[i+1] <= #max_arcs`.
 	 */
 	iscc_ArcIndex* tail_ptr;
+
+	/** Indicator whether #head and #tail_ptr point to memory not owned by the digraph.
+	 *
+	 *  This is the case when the digraph is loaded from a memory-mapped file. #iscc_free_digraph
+	 *  does not free external memory, and the arc storage of such digraphs cannot be changed.
+	 */
+	bool external_arrays;
 } iscc_Digraph;
 
 
@@ -84,7 +91,7 @@ typedef struct iscc_Digraph {
  *
  *  The null digraph is an easily detectable invalid digraph.
  */
-static const iscc_Digraph ISCC_NULL_DIGRAPH = { 0, 0, NULL, NULL };
+static const iscc_Digraph ISCC_NULL_DIGRAPH = { 0, 0, NULL, NULL, false };
 
 
 // =============================================================================
@@ -27,6 +27,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "allocator.h"
 #include "digraph_core.h"
 #include "error.h"
 #include "scclust_types.h"
@@ -57,7 +58,7 @@ bool iscc_digraphs_equal(const iscc_Digraph* const dg_a,
 	if (dg_a->vertices != dg_b->vertices) return false;
 	if ((dg_a->tail_ptr[dg_a->vertices] == 0) && (dg_b->tail_ptr[dg_b->vertices] == 0)) return true;
 
-	int_fast8_t* const single_row = calloc(dg_a->vertices, sizeof(int_fast8_t));
+	int_fast8_t* const single_row = iscc_calloc(dg_a->vertices, sizeof(int_fast8_t));
 
 	for (size_t v = 0; v < dg_a->vertices; ++v) {
 		const scc_PointIndex* const arc_a_stop = dg_a->head + dg_a->tail_ptr[v + 1];
@@ -70,7 +71,7 @@ bool iscc_digraphs_equal(const iscc_Digraph* const dg_a,
 		for (const scc_PointIndex* arc_b = dg_b->head + dg_b->tail_ptr[v];
 		        arc_b != arc_b_stop; ++arc_b) {
 			if (single_row[*arc_b] == 0) {
-				free(single_row);
+				iscc_free(single_row);
 				return false;
 			}
 			single_row[*arc_b] = 2;
@@ -78,14 +79,14 @@ bool iscc_digraphs_equal(const iscc_Digraph* const dg_a,
 
 		for (size_t i = 0; i < dg_a->vertices; ++i) {
 			if (single_row[i] == 1) {
-				free(single_row);
+				iscc_free(single_row);
 				return false;
 			}
 			single_row[i] = 0;
 		}
 	}
 
-	free(single_row);
+	iscc_free(single_row);
 
 	return true;
 }
@@ -194,7 +195,7 @@ void iscc_print_digraph(const iscc_Digraph* const dg)
 		return;
 	}
 
-	bool* const single_row = calloc(dg->vertices, sizeof(bool));
+	bool* const single_row = iscc_calloc(dg->vertices, sizeof(bool));
 	if (single_row == NULL) {
 		printf("Out of memory.\n\n");
 		return;
@@ -220,5 +221,5 @@ void iscc_print_digraph(const iscc_Digraph* const dg)
 	}
 	putchar('\n');
 
-	free(single_row);
+	iscc_free(single_row);
 }
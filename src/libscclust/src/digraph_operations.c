@@ -25,6 +25,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include "allocator.h"
 #include "digraph_core.h"
 #include "error.h"
 #include "scclust_types.h"
@@ -108,7 +109,7 @@ scc_ErrorCode iscc_digraph_union_and_delete(const uint_fast16_t num_in_dgs,
 		out_arcs_write += in_dgs[i].tail_ptr[vertices];
 	}
 
-	scc_PointIndex* const row_markers = malloc(sizeof(scc_PointIndex[vertices]));
+	scc_PointIndex* const row_markers = iscc_tmp_malloc(sizeof(scc_PointIndex[vertices]));
 	if (row_markers == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 	scc_ErrorCode ec;
@@ -124,7 +125,7 @@ scc_ErrorCode iscc_digraph_union_and_delete(const uint_fast16_t num_in_dgs,
 
 		// Try again. If fail, give up.
 		if ((ec = iscc_init_digraph(vertices, out_arcs_write, out_dg)) != SCC_ER_OK) {
-			free(row_markers);
+			iscc_free(row_markers);
 			return ec;
 		}
 	}
@@ -133,7 +134,7 @@ scc_ErrorCode iscc_digraph_union_and_delete(const uint_fast16_t num_in_dgs,
 	                                          row_markers, len_tails_to_keep, tails_to_keep,
 	                                          keep_self_loops, true, out_dg->tail_ptr, out_dg->head);
 
-	free(row_markers);
+	iscc_free(row_markers);
 
 	if ((ec = iscc_change_arc_storage(out_dg, out_arcs_write)) != SCC_ER_OK) {
 		iscc_free_digraph(out_dg);
@@ -158,7 +159,7 @@ scc_ErrorCode iscc_digraph_difference(iscc_Digraph* const minuend_dg,
 	if (iscc_digraph_is_empty(minuend_dg)) return iscc_no_error();
 	assert(minuend_dg->head != NULL);
 
-	scc_PointIndex* const row_markers = malloc(sizeof(scc_PointIndex[minuend_dg->vertices]));
+	scc_PointIndex* const row_markers = iscc_tmp_malloc(sizeof(scc_PointIndex[minuend_dg->vertices]));
 	if (row_markers == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 	for (size_t v = 0; v < minuend_dg->vertices; ++v) {
@@ -190,7 +191,7 @@ scc_ErrorCode iscc_digraph_difference(iscc_Digraph* const minuend_dg,
 	}
 	minuend_dg->tail_ptr[vertices] = out_arcs_write;
 
-	free(row_markers);
+	iscc_free(row_markers);
 
 	return iscc_change_arc_storage(minuend_dg, out_arcs_write);
 }
@@ -252,7 +253,7 @@ scc_ErrorCode iscc_adjacency_product(const iscc_Digraph* const in_dg_a,
 
 	const size_t vertices = in_dg_a->vertices;
 
-	scc_PointIndex* const row_markers = malloc(sizeof(scc_PointIndex[vertices]));
+	scc_PointIndex* const row_markers = iscc_tmp_malloc(sizeof(scc_PointIndex[vertices]));
 	if (row_markers == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 	// Try greedy memory count first
@@ -276,7 +277,7 @@ scc_ErrorCode iscc_adjacency_product(const iscc_Digraph* const in_dg_a,
 
 		// Try again. If fail, give up.
 		if ((ec = iscc_init_digraph(vertices, out_arcs_write, out_dg)) != SCC_ER_OK) {
-			free(row_markers);
+			iscc_free(row_markers);
 			return ec;
 		}
 	}
@@ -285,7 +286,7 @@ scc_ErrorCode iscc_adjacency_product(const iscc_Digraph* const in_dg_a,
 	                                           row_markers, force_loops,
 	                                           true, out_dg->tail_ptr, out_dg->head);
 
-	free(row_markers);
+	iscc_free(row_markers);
 
 	if ((ec = iscc_change_arc_storage(out_dg, out_arcs_write)) != SCC_ER_OK) {
 		iscc_free_digraph(out_dg);
@@ -25,6 +25,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include "../include/scclust_spi.h"
+#include "run_report.h"
 
 
 // =============================================================================
@@ -48,6 +49,10 @@ typedef struct iscc_dist_functions_struct {
 extern iscc_dist_functions_struct iscc_dist_functions;
 
 
+/// Returns \c true if the built-in distance functions are set.
+bool iscc_using_imp_dist_functions(void);
+
+
 // =============================================================================
 // Miscellaneous functions
 // =============================================================================
@@ -69,6 +74,7 @@ static inline bool iscc_get_dist_matrix(void* data_set,
                                         const scc_PointIndex point_indices[],
                                         double output_dists[])
 {
+	iscc_report_dist_evaluations(((uint64_t) len_point_indices * (len_point_indices - 1)) / 2);
 	return iscc_dist_functions.get_dist_matrix(data_set,
 	                                           len_point_indices,
 	                                           point_indices,
@@ -83,6 +89,7 @@ static inline bool iscc_get_dist_rows(void* data_set,
                                       const scc_PointIndex column_indices[],
                                       double output_dists[])
 {
+	iscc_report_dist_evaluations((uint64_t) len_query_indices * len_column_indices);
 	return iscc_dist_functions.get_dist_rows(data_set,
 	                                         len_query_indices,
 	                                         query_indices,
@@ -114,6 +121,7 @@ static inline bool iscc_get_max_dist(iscc_MaxDistObject* max_dist_object,
                                      scc_PointIndex out_max_indices[],
                                      double out_max_dists[])
 {
+	iscc_report_max_dist_queries(len_query_indices);
 	return iscc_dist_functions.get_max_dist(max_dist_object,
 	                                        len_query_indices,
 	                                        query_indices,
@@ -154,6 +162,7 @@ static inline bool iscc_nearest_neighbor_search(iscc_NNSearchObject* nn_search_o
                                                 scc_PointIndex out_query_indices[],
                                                 scc_PointIndex out_nn_indices[])
 {
+	iscc_report_nn_queries(len_query_indices);
 	return iscc_dist_functions.nearest_neighbor_search(nn_search_object,
 	                                                   len_query_indices,
 	                                                   query_indices,
@@ -24,35 +24,300 @@
 #include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include "../include/scclust.h"
+#include "allocator.h"
 #include "data_set_struct.h"
 #include "scclust_types.h"
 
 
+// =============================================================================
+// Internal variables
+// =============================================================================
+
+/* Distance searches process queries in blocks. Each pass over the search points
+ * serves all queries in a block, so the data matrix is streamed sequentially
+ * once per block rather than once per query. This bounds page cache pressure
+ * when the data matrix is memory-mapped and larger than memory. The block size
+ * is chosen so that the query rows and the per-query search state fit in
+ * this many bytes.
+ */
+static const size_t ISCC_SEARCH_BLOCK_BYTES = 262144;
+
+
 // =============================================================================
 // Distance calculations
 // =============================================================================
 
-static inline double iscc_get_sq_dist(const scc_DataSet* const data_set,
-                                      const size_t index1,
-                                      const size_t index2)
+/* Searches compare distance keys rather than distances. A key is an increasing
+ * function of the distance between two rows of the data matrix, which holds the
+ * transformed data for the weighted Euclidean, Mahalanobis and cosine metrics.
+ * For those metrics and the Euclidean metric, the key is the squared Euclidean
+ * distance between the rows. For the Manhattan and Chebyshev metrics, the key
+ * is the distance itself. Keys are converted to distances only when distances
+ * are reported.
+ */
+typedef enum iscc_DistKeyType {
+	ISCC_DK_SQ_EUCLIDEAN,
+	ISCC_DK_MANHATTAN,
+	ISCC_DK_CHEBYSHEV,
+} iscc_DistKeyType;
+
+
+static inline size_t iscc_get_index(const scc_PointIndex indices[const],
+                                    const size_t i)
+{
+	return (indices == NULL) ? i : (size_t) indices[i];
+}
+
+
+static inline const double* iscc_get_row(const scc_DataSet* const data_set,
+                                         const size_t index)
+{
+	assert(index < data_set->num_data_points);
+	return &data_set->data_matrix[index * data_set->num_dimensions];
+}
+
+
+static inline iscc_DistKeyType iscc_get_dist_key_type(const scc_DataSet* const data_set)
 {
-	assert(index1 < data_set->num_data_points);
-	assert(index2 < data_set->num_data_points);
+	switch (data_set->metric) {
+		case SCC_DM_MANHATTAN:
+			return ISCC_DK_MANHATTAN;
+		case SCC_DM_CHEBYSHEV:
+			return ISCC_DK_CHEBYSHEV;
+		default:
+			return ISCC_DK_SQ_EUCLIDEAN;
+	}
+}
 
-	const double* data1 = &data_set->data_matrix[index1 * data_set->num_dimensions];
-	const double* const data1_stop = data1 + data_set->num_dimensions;
-	const double* data2 = &data_set->data_matrix[index2 * data_set->num_dimensions];
 
-	double tmp_dist = 0.0;
-	while (data1 != data1_stop) {
-		const double value_diff = (*data1 - *data2);
-		++data1;
-		++data2;
-		tmp_dist += value_diff * value_diff;
+static inline double iscc_dist_key_to_dist(const double dist_key,
+                                           const scc_DataSet* const data_set)
+{
+	switch (data_set->metric) {
+		case SCC_DM_MANHATTAN:
+		case SCC_DM_CHEBYSHEV:
+			return dist_key;
+		case SCC_DM_COSINE:
+			// Rows have unit length, so the squared distance is `2 - 2 cos(angle)`
+			return dist_key / 2.0;
+		default:
+			return sqrt(dist_key);
 	}
-	return tmp_dist;
+}
+
+
+static inline double iscc_dist_to_dist_key(const double dist,
+                                           const scc_DataSet* const data_set)
+{
+	switch (data_set->metric) {
+		case SCC_DM_MANHATTAN:
+		case SCC_DM_CHEBYSHEV:
+			return dist;
+		case SCC_DM_COSINE:
+			return 2.0 * dist;
+		default:
+			return dist * dist;
+	}
+}
+
+
+// Key of two points that differ by `length` in a single dimension
+static inline double iscc_length_to_dist_key(const double length,
+                                             const iscc_DistKeyType key_type)
+{
+	return (key_type == ISCC_DK_SQ_EUCLIDEAN) ? (length * length) : length;
+}
+
+
+static inline double iscc_add_sq_euclidean_key(const double dist_key,
+                                               const double value_diff)
+{
+	return dist_key + value_diff * value_diff;
+}
+
+
+static inline double iscc_add_manhattan_key(const double dist_key,
+                                            const double value_diff)
+{
+	return dist_key + fabs(value_diff);
+}
+
+
+static inline double iscc_add_chebyshev_key(const double dist_key,
+                                            const double value_diff)
+{
+	const double abs_diff = fabs(value_diff);
+	return (abs_diff > dist_key) ? abs_diff : dist_key;
+}
+
+
+typedef void (*iscc_DistKeysToBlock)(const double* row,
+                                     size_t len_block,
+                                     const double* const block_rows[],
+                                     double out_dist_keys[],
+                                     uint_fast16_t num_dimensions);
+
+
+/* Key of two rows, and keys of a row to a block of rows, for any number of
+ * dimensions.
+ */
+#define ISCC_DIST_KEY_FUNCTIONS(NAME)                                                             \
+	static inline double iscc_get_##NAME##_key_rows(const double* const data1,                   \
+	                                                const double* const data2,                   \
+	                                                const uint_fast16_t num_dimensions)          \
+	{                                                                                             \
+		double dist_key = 0.0;                                                                    \
+		for (uint_fast16_t d = 0; d < num_dimensions; ++d) {                                      \
+			dist_key = iscc_add_##NAME##_key(dist_key, data1[d] - data2[d]);                      \
+		}                                                                                         \
+		return dist_key;                                                                          \
+	}                                                                                             \
+                                                                                                  \
+	static void iscc_get_##NAME##_keys_to_block(const double* const row,                         \
+	                                            const size_t len_block,                          \
+	                                            const double* const block_rows[const],           \
+	                                            double out_dist_keys[const],                     \
+	                                            const uint_fast16_t num_dimensions)              \
+	{                                                                                             \
+		for (size_t j = 0; j < len_block; ++j) {                                                  \
+			out_dist_keys[j] = iscc_get_##NAME##_key_rows(block_rows[j], row, num_dimensions);    \
+		}                                                                                         \
+	}
+
+ISCC_DIST_KEY_FUNCTIONS(sq_euclidean)
+ISCC_DIST_KEY_FUNCTIONS(manhattan)
+ISCC_DIST_KEY_FUNCTIONS(chebyshev)
+
+#undef ISCC_DIST_KEY_FUNCTIONS
+
+
+/* Kernels for common numbers of dimensions, where the inner loop has a
+ * constant trip count and is fully unrolled. The terms are accumulated in the
+ * same order as in `iscc_get_*_key_rows()`, so the keys are identical. The
+ * split kernels compute all differences before accumulating them, which keeps
+ * the loads and subtractions off the chain of maxima with the Chebyshev metric
+ * (about twice as fast), but prevents vectorization of the sums.
+ */
+#define ISCC_DIST_KEYS_TO_BLOCK_FIXED(NAME, DIMS)                                                 \
+	static void iscc_get_##NAME##_keys_to_block_##DIMS(const double* const row,                  \
+	                                                   const size_t len_block,                   \
+	                                                   const double* const block_rows[const],    \
+	                                                   double out_dist_keys[const],              \
+	                                                   const uint_fast16_t num_dimensions)       \
+	{                                                                                             \
+		assert(num_dimensions == DIMS);                                                           \
+		(void) num_dimensions;                                                                    \
+		for (size_t j = 0; j < len_block; ++j) {                                                  \
+			const double* const block_row = block_rows[j];                                        \
+			double dist_key = 0.0;                                                                \
+			for (size_t d = 0; d < DIMS; ++d) {                                                   \
+				dist_key = iscc_add_##NAME##_key(dist_key, block_row[d] - row[d]);                \
+			}                                                                                     \
+			out_dist_keys[j] = dist_key;                                                          \
+		}                                                                                         \
+	}
+
+#define ISCC_DIST_KEYS_TO_BLOCK_FIXED_SPLIT(NAME, DIMS)                                           \
+	static void iscc_get_##NAME##_keys_to_block_##DIMS(const double* const row,                  \
+	                                                   const size_t len_block,                   \
+	                                                   const double* const block_rows[const],    \
+	                                                   double out_dist_keys[const],              \
+	                                                   const uint_fast16_t num_dimensions)       \
+	{                                                                                             \
+		assert(num_dimensions == DIMS);                                                           \
+		(void) num_dimensions;                                                                    \
+		for (size_t j = 0; j < len_block; ++j) {                                                  \
+			const double* const block_row = block_rows[j];                                        \
+			double value_diffs[DIMS];                                                             \
+			for (size_t d = 0; d < DIMS; ++d) {                                                   \
+				value_diffs[d] = block_row[d] - row[d];                                           \
+			}                                                                                     \
+			double dist_key = 0.0;                                                                \
+			for (size_t d = 0; d < DIMS; ++d) {                                                   \
+				dist_key = iscc_add_##NAME##_key(dist_key, value_diffs[d]);                       \
+			}                                                                                     \
+			out_dist_keys[j] = dist_key;                                                          \
+		}                                                                                         \
+	}
+
+#define ISCC_DIST_KEYS_TO_BLOCK_ALL_FIXED(KERNEL, NAME)                                           \
+	KERNEL(NAME, 1)                                                                               \
+	KERNEL(NAME, 2)                                                                               \
+	KERNEL(NAME, 3)                                                                               \
+	KERNEL(NAME, 4)                                                                               \
+	KERNEL(NAME, 6)                                                                               \
+	KERNEL(NAME, 8)                                                                               \
+	KERNEL(NAME, 12)                                                                              \
+	KERNEL(NAME, 16)
+
+ISCC_DIST_KEYS_TO_BLOCK_ALL_FIXED(ISCC_DIST_KEYS_TO_BLOCK_FIXED, sq_euclidean)
+ISCC_DIST_KEYS_TO_BLOCK_ALL_FIXED(ISCC_DIST_KEYS_TO_BLOCK_FIXED, manhattan)
+ISCC_DIST_KEYS_TO_BLOCK_ALL_FIXED(ISCC_DIST_KEYS_TO_BLOCK_FIXED_SPLIT, chebyshev)
+
+#undef ISCC_DIST_KEYS_TO_BLOCK_ALL_FIXED
+#undef ISCC_DIST_KEYS_TO_BLOCK_FIXED_SPLIT
+#undef ISCC_DIST_KEYS_TO_BLOCK_FIXED
+
+
+static inline double iscc_get_dist_key_rows(const double* const data1,
+                                            const double* const data2,
+                                            const uint_fast16_t num_dimensions,
+                                            const iscc_DistKeyType key_type)
+{
+	switch (key_type) {
+		case ISCC_DK_MANHATTAN:
+			return iscc_get_manhattan_key_rows(data1, data2, num_dimensions);
+		case ISCC_DK_CHEBYSHEV:
+			return iscc_get_chebyshev_key_rows(data1, data2, num_dimensions);
+		default:
+			return iscc_get_sq_euclidean_key_rows(data1, data2, num_dimensions);
+	}
+}
+
+
+#define ISCC_SELECT_DIST_KEYS_TO_BLOCK(NAME)                                                      \
+	switch (num_dimensions) {                                                                     \
+		case 1: return iscc_get_##NAME##_keys_to_block_1;                                         \
+		case 2: return iscc_get_##NAME##_keys_to_block_2;                                         \
+		case 3: return iscc_get_##NAME##_keys_to_block_3;                                         \
+		case 4: return iscc_get_##NAME##_keys_to_block_4;                                         \
+		case 6: return iscc_get_##NAME##_keys_to_block_6;                                         \
+		case 8: return iscc_get_##NAME##_keys_to_block_8;                                         \
+		case 12: return iscc_get_##NAME##_keys_to_block_12;                                       \
+		case 16: return iscc_get_##NAME##_keys_to_block_16;                                       \
+		default: return iscc_get_##NAME##_keys_to_block;                                          \
+	}
+
+static iscc_DistKeysToBlock iscc_select_dist_keys_to_block(const iscc_DistKeyType key_type,
+                                                           const uint_fast16_t num_dimensions)
+{
+	switch (key_type) {
+		case ISCC_DK_MANHATTAN:
+			ISCC_SELECT_DIST_KEYS_TO_BLOCK(manhattan)
+		case ISCC_DK_CHEBYSHEV:
+			ISCC_SELECT_DIST_KEYS_TO_BLOCK(chebyshev)
+		default:
+			ISCC_SELECT_DIST_KEYS_TO_BLOCK(sq_euclidean)
+	}
+}
+
+#undef ISCC_SELECT_DIST_KEYS_TO_BLOCK
+
+
+static inline size_t iscc_get_block_size(const scc_DataSet* const data_set,
+                                         const size_t bytes_per_item,
+                                         const size_t len_items)
+{
+	assert(len_items > 0);
+	const size_t item_size = sizeof(double) * data_set->num_dimensions + bytes_per_item;
+	size_t block_size = ISCC_SEARCH_BLOCK_BYTES / item_size;
+	if (block_size == 0) block_size = 1;
+	if (block_size > len_items) block_size = len_items;
+	return block_size;
 }
 
 
@@ -87,19 +352,18 @@ bool iscc_imp_get_dist_matrix(void* const data_set,
 	assert(len_point_indices > 1);
 	assert(output_dists != NULL);
 
-	if (point_indices == NULL) {
-		for (size_t p1 = 0; p1 < len_point_indices; ++p1) {
-			for (size_t p2 = p1 + 1; p2 < len_point_indices; ++p2) {
-				*output_dists = sqrt(iscc_get_sq_dist(data_set, p1, p2));
-				++output_dists;
-			}
-		}
-	} else {
-		for (size_t p1 = 0; p1 < len_point_indices; ++p1) {
-			for (size_t p2 = p1 + 1; p2 < len_point_indices; ++p2) {
-				*output_dists = sqrt(iscc_get_sq_dist(data_set, (size_t) point_indices[p1], (size_t) point_indices[p2]));
-				++output_dists;
-			}
+	const scc_DataSet* const data_set_cast = (const scc_DataSet*) data_set;
+	const iscc_DistKeyType key_type = iscc_get_dist_key_type(data_set_cast);
+
+	for (size_t p1 = 0; p1 < len_point_indices; ++p1) {
+		const double* const row1 = iscc_get_row(data_set_cast, iscc_get_index(point_indices, p1));
+		for (size_t p2 = p1 + 1; p2 < len_point_indices; ++p2) {
+			*output_dists = iscc_dist_key_to_dist(iscc_get_dist_key_rows(row1,
+			                                                             iscc_get_row(data_set_cast, iscc_get_index(point_indices, p2)),
+			                                                             data_set_cast->num_dimensions,
+			                                                             key_type),
+			                                      data_set_cast);
+			++output_dists;
 		}
 	}
 
@@ -119,35 +383,24 @@ bool iscc_imp_get_dist_rows(void* const data_set,
 	assert(len_column_indices > 0);
 	assert(output_dists != NULL);
 
-	if ((query_indices != NULL) && (column_indices != NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			for (size_t c = 0; c < len_column_indices; ++c) {
-				*output_dists = sqrt(iscc_get_sq_dist(data_set, (size_t) query_indices[q], (size_t) column_indices[c]));
-				++output_dists;
-			}
-		}
-
-	} else if ((query_indices == NULL) && (column_indices != NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			for (size_t c = 0; c < len_column_indices; ++c) {
-				*output_dists = sqrt(iscc_get_sq_dist(data_set, q, (size_t) column_indices[c]));
-				++output_dists;
-			}
-		}
+	const scc_DataSet* const data_set_cast = (const scc_DataSet*) data_set;
+	const iscc_DistKeyType key_type = iscc_get_dist_key_type(data_set_cast);
 
-	} else if ((query_indices != NULL) && (column_indices == NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			for (size_t c = 0; c < len_column_indices; ++c) {
-				*output_dists = sqrt(iscc_get_sq_dist(data_set, (size_t) query_indices[q], c));
-				++output_dists;
-			}
-		}
+	// Column points are processed in tiles so that each tile is read once
+	// for all queries.
+	const size_t tile_size = iscc_get_block_size(data_set_cast, 0, len_column_indices);
 
-	} else if ((query_indices == NULL) && (column_indices == NULL)) {
+	for (size_t tile_start = 0; tile_start < len_column_indices; tile_start += tile_size) {
+		const size_t tile_stop = (len_column_indices - tile_start > tile_size) ? (tile_start + tile_size) : len_column_indices;
 		for (size_t q = 0; q < len_query_indices; ++q) {
-			for (size_t c = 0; c < len_column_indices; ++c) {
-				*output_dists = sqrt(iscc_get_sq_dist(data_set, q, c));
-				++output_dists;
+			const double* const query_row = iscc_get_row(data_set_cast, iscc_get_index(query_indices, q));
+			double* const output_row = output_dists + q * len_column_indices;
+			for (size_t c = tile_start; c < tile_stop; ++c) {
+				output_row[c] = iscc_dist_key_to_dist(iscc_get_dist_key_rows(query_row,
+				                                                             iscc_get_row(data_set_cast, iscc_get_index(column_indices, c)),
+				                                                             data_set_cast->num_dimensions,
+				                                                             key_type),
+				                                      data_set_cast);
 			}
 		}
 	}
@@ -165,10 +418,11 @@ struct iscc_MaxDistObject {
 	scc_DataSet* data_set;
 	size_t len_search_indices;
 	const scc_PointIndex* search_indices;
+	iscc_DistKeysToBlock dist_keys_to_block;
 };
 
 
-static const int32_t ISCC_MAXDIST_STRUCT_VERSION = 722439001;
+static const int32_t ISCC_MAXDIST_STRUCT_VERSION = 722439003;
 
 
 bool iscc_imp_init_max_dist_object(void* const data_set,
@@ -180,7 +434,7 @@ bool iscc_imp_init_max_dist_object(void* const data_set,
 	assert(len_search_indices > 0);
 	assert(out_max_dist_object != NULL);
 
-	*out_max_dist_object = malloc(sizeof(iscc_MaxDistObject));
+	*out_max_dist_object = iscc_tmp_malloc(sizeof(iscc_MaxDistObject));
 	if (*out_max_dist_object == NULL) return false;
 
 	**out_max_dist_object = (iscc_MaxDistObject) {
@@ -188,6 +442,8 @@ bool iscc_imp_init_max_dist_object(void* const data_set,
 		.data_set = data_set,
 		.len_search_indices = len_search_indices,
 		.search_indices = search_indices,
+		.dist_keys_to_block = iscc_select_dist_keys_to_block(iscc_get_dist_key_type(data_set),
+		                                                     ((const scc_DataSet*) data_set)->num_dimensions),
 	};
 
 	return true;
@@ -202,72 +458,55 @@ bool iscc_imp_get_max_dist(iscc_MaxDistObject* const max_dist_object,
 {
 	assert(max_dist_object != NULL);
 	assert(max_dist_object->max_dist_version == ISCC_MAXDIST_STRUCT_VERSION);
-	scc_DataSet* const data_set = max_dist_object->data_set;
+	const scc_DataSet* const data_set = max_dist_object->data_set;
 	const size_t len_search_indices = max_dist_object->len_search_indices;
 	const scc_PointIndex* const search_indices = max_dist_object->search_indices;
+	const iscc_DistKeysToBlock dist_keys_to_block = max_dist_object->dist_keys_to_block;
 
-	assert(iscc_imp_check_data_set(data_set));
+	assert(iscc_imp_check_data_set(max_dist_object->data_set));
 	assert(len_search_indices > 0);
 	assert(len_query_indices > 0);
 	assert(out_max_indices != NULL);
 	assert(out_max_dists != NULL);
 
-	double tmp_dist;
-	double max_dist;
+	const size_t block_size = iscc_get_block_size(data_set, sizeof(const double*) + sizeof(double), len_query_indices);
+	const double** const block_rows = iscc_tmp_malloc(sizeof(const double*[block_size]));
+	double* const block_dists = iscc_tmp_malloc(sizeof(double[block_size]));
+	if ((block_rows == NULL) || (block_dists == NULL)) {
+		iscc_free(block_rows);
+		iscc_free(block_dists);
+		return false;
+	}
 
-	if ((query_indices != NULL) && (search_indices != NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			max_dist = -1.0;
-			for (size_t s = 0; s < len_search_indices; ++s) {
-				tmp_dist = iscc_get_sq_dist(data_set, (size_t) query_indices[q], (size_t) search_indices[s]);
-				if (max_dist < tmp_dist) {
-					max_dist = tmp_dist;
-					out_max_indices[q] = search_indices[s];
-				}
-			}
-			out_max_dists[q] = sqrt(max_dist);
-		}
+	for (size_t block_start = 0; block_start < len_query_indices; block_start += block_size) {
+		const size_t len_block = (len_query_indices - block_start > block_size) ? block_size : (len_query_indices - block_start);
+		scc_PointIndex* const max_indices = out_max_indices + block_start;
+		double* const max_dists = out_max_dists + block_start;
 
-	} else if ((query_indices == NULL) && (search_indices != NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			max_dist = -1.0;
-			for (size_t s = 0; s < len_search_indices; ++s) {
-				tmp_dist = iscc_get_sq_dist(data_set, q, (size_t) search_indices[s]);
-				if (max_dist < tmp_dist) {
-					max_dist = tmp_dist;
-					out_max_indices[q] = search_indices[s];
-				}
-			}
-			out_max_dists[q] = sqrt(max_dist);
+		for (size_t j = 0; j < len_block; ++j) {
+			block_rows[j] = iscc_get_row(data_set, iscc_get_index(query_indices, block_start + j));
+			max_dists[j] = -1.0;
 		}
 
-	} else if ((query_indices != NULL) && (search_indices == NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			max_dist = -1.0;
-			for (size_t s = 0; s < len_search_indices; ++s) {
-				tmp_dist = iscc_get_sq_dist(data_set, (size_t) query_indices[q], s);
-				if (max_dist < tmp_dist) {
-					max_dist = tmp_dist;
-					out_max_indices[q] = (scc_PointIndex) s;
+		for (size_t s = 0; s < len_search_indices; ++s) {
+			const size_t search_point = iscc_get_index(search_indices, s);
+			dist_keys_to_block(iscc_get_row(data_set, search_point), len_block, block_rows, block_dists, data_set->num_dimensions);
+			for (size_t j = 0; j < len_block; ++j) {
+				if (max_dists[j] < block_dists[j]) {
+					max_dists[j] = block_dists[j];
+					max_indices[j] = (scc_PointIndex) search_point;
 				}
 			}
-			out_max_dists[q] = sqrt(max_dist);
 		}
 
-	} else if ((query_indices == NULL) && (search_indices == NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			max_dist = -1.0;
-			for (size_t s = 0; s < len_search_indices; ++s) {
-				tmp_dist = iscc_get_sq_dist(data_set, q, s);
-				if (max_dist < tmp_dist) {
-					max_dist = tmp_dist;
-					out_max_indices[q] = (scc_PointIndex) s;
-				}
-			}
-			out_max_dists[q] = sqrt(max_dist);
+		for (size_t j = 0; j < len_block; ++j) {
+			max_dists[j] = iscc_dist_key_to_dist(max_dists[j], data_set);
 		}
 	}
 
+	iscc_free(block_rows);
+	iscc_free(block_dists);
+
 	return true;
 }
 
@@ -276,7 +515,7 @@ bool iscc_imp_close_max_dist_object(iscc_MaxDistObject** const max_dist_object)
 {
 	if (max_dist_object != NULL && *max_dist_object != NULL) {
 		assert((*max_dist_object)->max_dist_version == ISCC_MAXDIST_STRUCT_VERSION);
-		free(*max_dist_object);
+		iscc_free(*max_dist_object);
 		*max_dist_object = NULL;
 	}
 	return true;
@@ -287,15 +526,47 @@ bool iscc_imp_close_max_dist_object(iscc_MaxDistObject** const max_dist_object)
 // Nearest neighbor search functions implementations
 // =============================================================================
 
+/* Search objects on data sets with one or two dimensions keep an index of the
+ * search points. With one dimension, the points are sorted so the nearest
+ * neighbors of a query are found by walking outwards from its position. With
+ * two dimensions, the points are bucketed in a uniform grid and cells are
+ * visited in rings around the query until no unvisited cell can contain a
+ * closer point. Both return the same neighbors, in the same order, as the
+ * brute force search: ties in distance are broken by position in the search
+ * indices.
+ */
+typedef enum iscc_NNSearchIndex {
+	ISCC_NN_BRUTE_FORCE,
+	ISCC_NN_SORTED_1D,
+	ISCC_NN_GRID_2D,
+} iscc_NNSearchIndex;
+
+
 struct iscc_NNSearchObject {
 	int32_t nn_search_version;
 	scc_DataSet* data_set;
 	size_t len_search_indices;
 	const scc_PointIndex* search_indices;
+	iscc_NNSearchIndex index_type;
+	iscc_DistKeysToBlock dist_keys_to_block;
+	size_t* sorted_positions;
+	double* sorted_rows;
+	size_t grid_cols;
+	size_t grid_rows;
+	double grid_min[2];
+	double grid_inv_width[2];
+	double grid_min_width;
+	size_t* grid_cell_start;
 };
 
 
-static const int32_t ISCC_NN_SEARCH_STRUCT_VERSION = 722294001;
+static const int32_t ISCC_NN_SEARCH_STRUCT_VERSION = 722294004;
+
+
+typedef struct iscc_SortPoint1D {
+	double value;
+	size_t position;
+} iscc_SortPoint1D;
 
 
 static inline void iscc_add_dist_to_list(const double add_dist,
@@ -317,6 +588,444 @@ static inline void iscc_add_dist_to_list(const double add_dist,
 }
 
 
+static inline void iscc_add_dist_pos_to_list(const double add_dist,
+                                             const size_t add_position,
+                                             double* dist_list,
+                                             size_t* position_list,
+                                             const double* const dist_list_start)
+{
+	assert(dist_list != NULL);
+	assert(position_list != NULL);
+	assert(dist_list_start != NULL);
+
+	for (; (dist_list != dist_list_start) &&
+	       ((add_dist < dist_list[-1]) || ((add_dist == dist_list[-1]) && (add_position < position_list[-1])));
+	       --dist_list, --position_list) {
+		dist_list[0] = dist_list[-1];
+		position_list[0] = position_list[-1];
+	}
+	dist_list[0] = add_dist;
+	position_list[0] = add_position;
+}
+
+
+static int iscc_compare_SortPoint1D(const void* const a,
+                                    const void* const b)
+{
+	const iscc_SortPoint1D* const sp_a = (const iscc_SortPoint1D*) a;
+	const iscc_SortPoint1D* const sp_b = (const iscc_SortPoint1D*) b;
+	if (sp_a->value != sp_b->value) return (sp_a->value < sp_b->value) ? -1 : 1;
+	return (sp_a->position > sp_b->position) - (sp_a->position < sp_b->position);
+}
+
+
+static int iscc_compare_size_t(const void* const a,
+                               const void* const b)
+{
+	const size_t s_a = *((const size_t*) a);
+	const size_t s_b = *((const size_t*) b);
+	return (s_a > s_b) - (s_a < s_b);
+}
+
+
+static inline double iscc_get_dist_key_1d(const double value,
+                                          const double query,
+                                          const iscc_DistKeyType key_type)
+{
+	const double value_diff = value - query;
+	return (key_type == ISCC_DK_SQ_EUCLIDEAN) ? (value_diff * value_diff) : fabs(value_diff);
+}
+
+
+static bool iscc_init_sorted_1d_index(iscc_NNSearchObject* const nn_search_object)
+{
+	const scc_DataSet* const data_set = nn_search_object->data_set;
+	const size_t len_search_indices = nn_search_object->len_search_indices;
+
+	iscc_SortPoint1D* const sort_points = iscc_tmp_malloc(sizeof(iscc_SortPoint1D[len_search_indices]));
+	if (sort_points == NULL) return false;
+
+	for (size_t s = 0; s < len_search_indices; ++s) {
+		sort_points[s] = (iscc_SortPoint1D) {
+			.value = *iscc_get_row(data_set, iscc_get_index(nn_search_object->search_indices, s)),
+			.position = s,
+		};
+		if (!isfinite(sort_points[s].value)) {
+			// Not well-ordered, use brute force search
+			iscc_free(sort_points);
+			return true;
+		}
+	}
+
+	qsort(sort_points, len_search_indices, sizeof(iscc_SortPoint1D), iscc_compare_SortPoint1D);
+
+	nn_search_object->sorted_positions = iscc_tmp_malloc(sizeof(size_t[len_search_indices]));
+	nn_search_object->sorted_rows = iscc_tmp_malloc(sizeof(double[len_search_indices]));
+	if ((nn_search_object->sorted_positions == NULL) || (nn_search_object->sorted_rows == NULL)) {
+		iscc_free(sort_points);
+		return false;
+	}
+
+	for (size_t i = 0; i < len_search_indices; ++i) {
+		nn_search_object->sorted_positions[i] = sort_points[i].position;
+		nn_search_object->sorted_rows[i] = sort_points[i].value;
+	}
+	iscc_free(sort_points);
+
+	nn_search_object->index_type = ISCC_NN_SORTED_1D;
+	return true;
+}
+
+
+static bool iscc_init_grid_2d_index(iscc_NNSearchObject* const nn_search_object)
+{
+	const scc_DataSet* const data_set = nn_search_object->data_set;
+	const size_t len_search_indices = nn_search_object->len_search_indices;
+
+	double min[2] = { 0.0, 0.0 };
+	double max[2] = { 0.0, 0.0 };
+	for (size_t s = 0; s < len_search_indices; ++s) {
+		const double* const row = iscc_get_row(data_set, iscc_get_index(nn_search_object->search_indices, s));
+		for (size_t d = 0; d < 2; ++d) {
+			// Not well-ordered, use brute force search
+			if (!isfinite(row[d])) return true;
+			if ((s == 0) || (row[d] < min[d])) min[d] = row[d];
+			if ((s == 0) || (row[d] > max[d])) max[d] = row[d];
+		}
+	}
+
+	// About two points per cell, with cells as close to square as possible
+	const double range[2] = { max[0] - min[0], max[1] - min[1] };
+	if (!isfinite(range[0]) || !isfinite(range[1])) return true;
+	const size_t num_cells = (len_search_indices / 2 > 0) ? (len_search_indices / 2) : 1;
+	size_t grid_cols = 1;
+	size_t grid_rows = 1;
+	if ((range[0] > 0.0) && (range[1] > 0.0)) {
+		const double cols = sqrt(((double) num_cells) * (range[0] / range[1]));
+		grid_cols = (cols < 1.0) ? 1 : ((cols > (double) num_cells) ? num_cells : (size_t) cols);
+		grid_rows = (num_cells + grid_cols - 1) / grid_cols;
+	} else if (range[0] > 0.0) {
+		grid_cols = num_cells;
+	} else if (range[1] > 0.0) {
+		grid_rows = num_cells;
+	}
+
+	const size_t grid_size[2] = { grid_cols, grid_rows };
+	nn_search_object->grid_cols = grid_cols;
+	nn_search_object->grid_rows = grid_rows;
+	nn_search_object->grid_min_width = HUGE_VAL;
+	for (size_t d = 0; d < 2; ++d) {
+		nn_search_object->grid_min[d] = min[d];
+		nn_search_object->grid_inv_width[d] = 0.0;
+		if (grid_size[d] > 1) {
+			const double width = range[d] / (double) grid_size[d];
+			nn_search_object->grid_inv_width[d] = 1.0 / width;
+			if (width < nn_search_object->grid_min_width) nn_search_object->grid_min_width = width;
+		}
+	}
+
+	size_t* const point_cell = iscc_tmp_malloc(sizeof(size_t[len_search_indices]));
+	nn_search_object->grid_cell_start = iscc_tmp_calloc(grid_cols * grid_rows + 1, sizeof(size_t));
+	nn_search_object->sorted_positions = iscc_tmp_malloc(sizeof(size_t[len_search_indices]));
+	nn_search_object->sorted_rows = iscc_tmp_malloc(sizeof(double) * 2 * len_search_indices);
+	if ((point_cell == NULL) || (nn_search_object->grid_cell_start == NULL) ||
+	        (nn_search_object->sorted_positions == NULL) || (nn_search_object->sorted_rows == NULL)) {
+		iscc_free(point_cell);
+		return false;
+	}
+
+	// Counting sort of points into cells
+	size_t* const cell_start = nn_search_object->grid_cell_start;
+	for (size_t s = 0; s < len_search_indices; ++s) {
+		const double* const row = iscc_get_row(data_set, iscc_get_index(nn_search_object->search_indices, s));
+		double cell_coord[2];
+		for (size_t d = 0; d < 2; ++d) {
+			cell_coord[d] = (row[d] - min[d]) * nn_search_object->grid_inv_width[d];
+			if (cell_coord[d] > (double) (grid_size[d] - 1)) cell_coord[d] = (double) (grid_size[d] - 1);
+		}
+		point_cell[s] = ((size_t) cell_coord[1]) * grid_cols + ((size_t) cell_coord[0]);
+		++cell_start[point_cell[s] + 1];
+	}
+	for (size_t c = 0; c < grid_cols * grid_rows; ++c) {
+		cell_start[c + 1] += cell_start[c];
+	}
+	for (size_t s = 0; s < len_search_indices; ++s) {
+		const double* const row = iscc_get_row(data_set, iscc_get_index(nn_search_object->search_indices, s));
+		const size_t i = cell_start[point_cell[s]];
+		++cell_start[point_cell[s]];
+		nn_search_object->sorted_positions[i] = s;
+		nn_search_object->sorted_rows[2 * i] = row[0];
+		nn_search_object->sorted_rows[2 * i + 1] = row[1];
+	}
+	// Shift cell starts back after placing points
+	for (size_t c = grid_cols * grid_rows; c > 0; --c) {
+		cell_start[c] = cell_start[c - 1];
+	}
+	cell_start[0] = 0;
+	iscc_free(point_cell);
+
+	nn_search_object->index_type = ISCC_NN_GRID_2D;
+	return true;
+}
+
+
+static bool iscc_search_sorted_1d(const iscc_NNSearchObject* const nn_search_object,
+                                  const double query,
+                                  const uint32_t k,
+                                  const bool radius_search,
+                                  const double radius_key,
+                                  size_t** const tie_scratch,
+                                  size_t out_positions[const],
+                                  bool* const out_found)
+{
+	const size_t len_search_indices = nn_search_object->len_search_indices;
+	const double* const values = nn_search_object->sorted_rows;
+	const size_t* const positions = nn_search_object->sorted_positions;
+	const iscc_DistKeyType key_type = iscc_get_dist_key_type(nn_search_object->data_set);
+
+	// First sorted point not smaller than the query. Left of it, distances
+	// decrease towards the query; from it, distances increase.
+	size_t low = 0;
+	size_t high = len_search_indices;
+	while (low < high) {
+		const size_t mid = low + (high - low) / 2;
+		if (values[mid] < query) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	size_t left = low;      // Next left candidate is `left - 1`
+	size_t right = low;     // Next right candidate is `right`
+	size_t found = 0;
+	while ((found < k) && ((left > 0) || (right < len_search_indices))) {
+		const double left_dist = (left > 0) ? iscc_get_dist_key_1d(values[left - 1], query, key_type) : HUGE_VAL;
+		const double right_dist = (right < len_search_indices) ? iscc_get_dist_key_1d(values[right], query, key_type) : HUGE_VAL;
+		const double dist = (left_dist < right_dist) ? left_dist : right_dist;
+		if (radius_search && (dist > radius_key)) break;
+
+		// Points at exactly `dist` form `[left_stop, left)` and `[right, right_stop)`
+		size_t left_stop = left;
+		if (left_dist == dist) {
+			low = 0;
+			high = left - 1;
+			while (low < high) {
+				const size_t mid = low + (high - low) / 2;
+				if (iscc_get_dist_key_1d(values[mid], query, key_type) > dist) {
+					low = mid + 1;
+				} else {
+					high = mid;
+				}
+			}
+			left_stop = low;
+		}
+		size_t right_stop = right;
+		if (right_dist == dist) {
+			low = right + 1;
+			high = len_search_indices;
+			while (low < high) {
+				const size_t mid = low + (high - low) / 2;
+				if (iscc_get_dist_key_1d(values[mid], query, key_type) > dist) {
+					high = mid;
+				} else {
+					low = mid + 1;
+				}
+			}
+			right_stop = low;
+		}
+
+		const size_t num_needed = k - found;
+		if (((left_stop == left) || (values[left_stop] == values[left - 1])) &&
+		        ((right_stop == right) || (values[right] == values[right_stop - 1]))) {
+			// Each side is a run of equal values, which is sorted by position
+			size_t l = left_stop;
+			size_t r = right;
+			for (size_t i = 0; i < num_needed; ++i) {
+				if ((l < left) && ((r == right_stop) || (positions[l] < positions[r]))) {
+					out_positions[found] = positions[l];
+					++l;
+				} else if (r < right_stop) {
+					out_positions[found] = positions[r];
+					++r;
+				} else {
+					break;
+				}
+				++found;
+			}
+		} else {
+			// Distinct values at the same rounded distance, sort ties by position
+			if (*tie_scratch == NULL) {
+				*tie_scratch = iscc_tmp_malloc(sizeof(size_t[len_search_indices]));
+				if (*tie_scratch == NULL) return false;
+			}
+			size_t num_ties = 0;
+			for (size_t i = left_stop; i < left; ++i) {
+				(*tie_scratch)[num_ties] = positions[i];
+				++num_ties;
+			}
+			for (size_t i = right; i < right_stop; ++i) {
+				(*tie_scratch)[num_ties] = positions[i];
+				++num_ties;
+			}
+			qsort(*tie_scratch, num_ties, sizeof(size_t), iscc_compare_size_t);
+			for (size_t i = 0; (i < num_ties) && (i < num_needed); ++i) {
+				out_positions[found] = (*tie_scratch)[i];
+				++found;
+			}
+		}
+
+		left = left_stop;
+		right = right_stop;
+	}
+
+	*out_found = (found == k);
+	return true;
+}
+
+
+static void iscc_search_grid_2d(const iscc_NNSearchObject* const nn_search_object,
+                                const double query_row[const],
+                                const uint32_t k,
+                                const bool radius_search,
+                                const double radius_key,
+                                double dist_list[const],
+                                size_t out_positions[const],
+                                bool* const out_found)
+{
+	const size_t grid_cols = nn_search_object->grid_cols;
+	const size_t grid_rows = nn_search_object->grid_rows;
+	const size_t* const cell_start = nn_search_object->grid_cell_start;
+	const double* const sorted_rows = nn_search_object->sorted_rows;
+	const size_t* const positions = nn_search_object->sorted_positions;
+	const iscc_DistKeyType key_type = iscc_get_dist_key_type(nn_search_object->data_set);
+
+	// Cell of query, clamped to the grid
+	size_t query_cell[2];
+	const size_t grid_size[2] = { grid_cols, grid_rows };
+	for (size_t d = 0; d < 2; ++d) {
+		const double cell_coord = (query_row[d] - nn_search_object->grid_min[d]) * nn_search_object->grid_inv_width[d];
+		if (!(cell_coord > 0.0)) {
+			query_cell[d] = 0;
+		} else if (cell_coord > (double) (grid_size[d] - 1)) {
+			query_cell[d] = grid_size[d] - 1;
+		} else {
+			query_cell[d] = (size_t) cell_coord;
+		}
+	}
+
+	size_t max_ring = 0;
+	for (size_t d = 0; d < 2; ++d) {
+		if (query_cell[d] > max_ring) max_ring = query_cell[d];
+		if (grid_size[d] - 1 - query_cell[d] > max_ring) max_ring = grid_size[d] - 1 - query_cell[d];
+	}
+
+	size_t found = 0;
+	for (size_t ring = 0; ring <= max_ring; ++ring) {
+		const size_t row_start = (query_cell[1] > ring) ? (query_cell[1] - ring) : 0;
+		const size_t row_stop = (grid_rows - 1 - query_cell[1] > ring) ? (query_cell[1] + ring) : (grid_rows - 1);
+		const size_t col_start = (query_cell[0] > ring) ? (query_cell[0] - ring) : 0;
+		const size_t col_stop = (grid_cols - 1 - query_cell[0] > ring) ? (query_cell[0] + ring) : (grid_cols - 1);
+
+		for (size_t row = row_start; row <= row_stop; ++row) {
+			const bool full_row = (ring == 0) || (row + ring == query_cell[1]) || (row == query_cell[1] + ring);
+			for (size_t col = col_start; col <= col_stop; ++col) {
+				if (!full_row && (col + ring != query_cell[0]) && (col != query_cell[0] + ring)) {
+					// Only cells on the ring, jump to its right side
+					if (query_cell[0] + ring > col_stop) break;
+					col = query_cell[0] + ring;
+				}
+
+				const size_t cell = row * grid_cols + col;
+				for (size_t i = cell_start[cell]; i < cell_start[cell + 1]; ++i) {
+					const double tmp_dist = iscc_get_dist_key_rows(sorted_rows + 2 * i, query_row, 2, key_type);
+					if (found < k) {
+						if (radius_search && (tmp_dist > radius_key)) continue;
+						iscc_add_dist_pos_to_list(tmp_dist, positions[i], dist_list + found, out_positions + found, dist_list);
+						++found;
+					} else if ((tmp_dist < dist_list[k - 1]) ||
+					               ((tmp_dist == dist_list[k - 1]) && (positions[i] < out_positions[k - 1]))) {
+						iscc_add_dist_pos_to_list(tmp_dist, positions[i], dist_list + k - 1, out_positions + k - 1, dist_list);
+					}
+				}
+			}
+		}
+
+		// Points in unvisited cells are at least `ring` cell widths away. The
+		// bound is shrunk slightly to guard against rounding in cell assignment.
+		const double min_unvisited = ((double) ring) * nn_search_object->grid_min_width * (1.0 - 1e-9);
+		const double min_unvisited_key = iscc_length_to_dist_key(min_unvisited, key_type);
+		if ((found == k) && (min_unvisited_key > dist_list[k - 1])) break;
+		if (radius_search && (min_unvisited_key > radius_key)) break;
+	}
+
+	*out_found = (found == k);
+}
+
+
+static bool iscc_indexed_nearest_neighbor_search(const iscc_NNSearchObject* const nn_search_object,
+                                                 const size_t len_query_indices,
+                                                 const scc_PointIndex query_indices[const],
+                                                 const uint32_t k,
+                                                 const bool radius_search,
+                                                 const double radius,
+                                                 size_t* const out_num_ok_queries,
+                                                 scc_PointIndex out_query_indices[const],
+                                                 scc_PointIndex out_nn_indices[const])
+{
+	assert(nn_search_object->index_type != ISCC_NN_BRUTE_FORCE);
+
+	double* const dist_list = iscc_tmp_malloc(sizeof(double[k]));
+	size_t* const position_list = iscc_tmp_malloc(sizeof(size_t[k]));
+	if ((dist_list == NULL) || (position_list == NULL)) {
+		iscc_free(dist_list);
+		iscc_free(position_list);
+		return false;
+	}
+
+	size_t* tie_scratch = NULL;
+	size_t num_ok_queries = 0;
+	const double radius_key = iscc_dist_to_dist_key(radius, nn_search_object->data_set);
+	for (size_t q = 0; q < len_query_indices; ++q) {
+		const size_t query_index = iscc_get_index(query_indices, q);
+		const double* const query_row = iscc_get_row(nn_search_object->data_set, query_index);
+
+		bool found = false;
+		if (nn_search_object->index_type == ISCC_NN_SORTED_1D) {
+			if (!iscc_search_sorted_1d(nn_search_object, query_row[0], k, radius_search, radius_key,
+			                           &tie_scratch, position_list, &found)) {
+				iscc_free(dist_list);
+				iscc_free(position_list);
+				return false;
+			}
+		} else {
+			iscc_search_grid_2d(nn_search_object, query_row, k, radius_search, radius_key,
+			                    dist_list, position_list, &found);
+		}
+
+		assert(found || out_query_indices != NULL);
+		if (found) {
+			if (out_query_indices != NULL) {
+				out_query_indices[num_ok_queries] = (scc_PointIndex) query_index;
+			}
+			scc_PointIndex* const nn_indices = out_nn_indices + num_ok_queries * k;
+			for (uint32_t i = 0; i < k; ++i) {
+				nn_indices[i] = (scc_PointIndex) iscc_get_index(nn_search_object->search_indices, position_list[i]);
+			}
+			++num_ok_queries;
+		}
+	}
+
+	*out_num_ok_queries = num_ok_queries;
+
+	iscc_free(dist_list);
+	iscc_free(position_list);
+	iscc_free(tie_scratch);
+
+	return true;
+}
+
+
 bool iscc_imp_init_nn_search_object(void* const data_set,
                                     const size_t len_search_indices,
                                     const scc_PointIndex search_indices[const],
@@ -326,7 +1035,7 @@ bool iscc_imp_init_nn_search_object(void* const data_set,
 	assert(len_search_indices > 0);
 	assert(out_nn_search_object != NULL);
 
-	*out_nn_search_object = malloc(sizeof(iscc_NNSearchObject));
+	*out_nn_search_object = iscc_tmp_malloc(sizeof(iscc_NNSearchObject));
 	if (*out_nn_search_object == NULL) return false;
 
 	**out_nn_search_object = (iscc_NNSearchObject) {
@@ -334,8 +1043,27 @@ bool iscc_imp_init_nn_search_object(void* const data_set,
 		.data_set = data_set,
 		.len_search_indices = len_search_indices,
 		.search_indices = search_indices,
+		.index_type = ISCC_NN_BRUTE_FORCE,
+		.dist_keys_to_block = iscc_select_dist_keys_to_block(iscc_get_dist_key_type(data_set),
+		                                                     ((const scc_DataSet*) data_set)->num_dimensions),
+		.sorted_positions = NULL,
+		.sorted_rows = NULL,
+		.grid_cell_start = NULL,
 	};
 
+	bool index_ok = true;
+	const scc_DataSet* const data_set_cast = (const scc_DataSet*) data_set;
+	if (data_set_cast->num_dimensions == 1) {
+		index_ok = iscc_init_sorted_1d_index(*out_nn_search_object);
+	} else if (data_set_cast->num_dimensions == 2) {
+		index_ok = iscc_init_grid_2d_index(*out_nn_search_object);
+	}
+
+	if (!index_ok) {
+		iscc_imp_close_nn_search_object(out_nn_search_object);
+		return false;
+	}
+
 	return true;
 }
 
@@ -352,11 +1080,12 @@ bool iscc_imp_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_objec
 {
 	assert(nn_search_object != NULL);
 	assert(nn_search_object->nn_search_version == ISCC_NN_SEARCH_STRUCT_VERSION);
-	scc_DataSet* const data_set = nn_search_object->data_set;
+	const scc_DataSet* const data_set = nn_search_object->data_set;
 	const size_t len_search_indices = nn_search_object->len_search_indices;
 	const scc_PointIndex* const search_indices = nn_search_object->search_indices;
+	const iscc_DistKeysToBlock dist_keys_to_block = nn_search_object->dist_keys_to_block;
 
-	assert(iscc_imp_check_data_set(data_set));
+	assert(iscc_imp_check_data_set(nn_search_object->data_set));
 	assert(len_search_indices > 0);
 	assert(len_query_indices > 0);
 	assert(k > 0);
@@ -365,104 +1094,88 @@ bool iscc_imp_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_objec
 	assert(out_num_ok_queries != NULL);
 	assert(out_nn_indices != NULL);
 
-	double tmp_dist;
+	if (nn_search_object->index_type != ISCC_NN_BRUTE_FORCE) {
+		return iscc_indexed_nearest_neighbor_search(nn_search_object,
+		                                            len_query_indices,
+		                                            query_indices,
+		                                            k,
+		                                            radius_search,
+		                                            radius,
+		                                            out_num_ok_queries,
+		                                            out_query_indices,
+		                                            out_nn_indices);
+	}
+
+	const size_t block_size = iscc_get_block_size(data_set,
+	                                              sizeof(const double*) + sizeof(double) + sizeof(uint32_t) +
+	                                                  k * (sizeof(double) + sizeof(scc_PointIndex)),
+	                                              len_query_indices);
+	const double** const block_rows = iscc_tmp_malloc(sizeof(const double*[block_size]));
+	double* const block_dists = iscc_tmp_malloc(sizeof(double[block_size]));
+	uint32_t* const found = iscc_tmp_malloc(sizeof(uint32_t[block_size]));
+	double* const sort_scratch = iscc_tmp_malloc(sizeof(double) * block_size * k);
+	scc_PointIndex* const index_scratch = iscc_tmp_malloc(sizeof(scc_PointIndex) * block_size * k);
+	if ((block_rows == NULL) || (block_dists == NULL) || (found == NULL) ||
+	        (sort_scratch == NULL) || (index_scratch == NULL)) {
+		iscc_free(block_rows);
+		iscc_free(block_dists);
+		iscc_free(found);
+		iscc_free(sort_scratch);
+		iscc_free(index_scratch);
+		return false;
+	}
+
 	size_t num_ok_queries = 0;
-	scc_PointIndex* index_write = out_nn_indices;
-	double* const sort_scratch = malloc(sizeof(double[k]));
-	if (sort_scratch == NULL) return false;
-	double* const sort_scratch_end = sort_scratch + k - 1;
-	const double radius_sq = radius * radius;
+	const double radius_key = iscc_dist_to_dist_key(radius, data_set);
 
-	if (search_indices == NULL) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			size_t query = q;
-			if (query_indices != NULL) {
-				query = (size_t) query_indices[q];
-			}
-			size_t s = 0;
-			uint32_t found;
-			scc_PointIndex* const index_write_end = index_write + k - 1;
-
-			if (radius_search) {
-				found = 0;
-				for (; (s < len_search_indices) && (found < k); ++s) {
-					tmp_dist = iscc_get_sq_dist(data_set, query, s);
-					if (tmp_dist > radius_sq) continue;
-					iscc_add_dist_to_list(tmp_dist, (scc_PointIndex) s, sort_scratch + found, index_write + found, sort_scratch);
-					++found;
-				}
-			} else {
-				for (; s < k; ++s) {
-					tmp_dist = iscc_get_sq_dist(data_set, query, s);
-					iscc_add_dist_to_list(tmp_dist, (scc_PointIndex) s, sort_scratch + s, index_write + s, sort_scratch);
-				}
-				found = k;
-			}
+	for (size_t block_start = 0; block_start < len_query_indices; block_start += block_size) {
+		const size_t len_block = (len_query_indices - block_start > block_size) ? block_size : (len_query_indices - block_start);
 
-			for (; s < len_search_indices; ++s) {
-				assert(found == k);
-				tmp_dist = iscc_get_sq_dist(data_set, query, s);
-				if (tmp_dist >= *sort_scratch_end) continue;
-				iscc_add_dist_to_list(tmp_dist, (scc_PointIndex) s, sort_scratch_end, index_write_end, sort_scratch);
-			}
+		for (size_t j = 0; j < len_block; ++j) {
+			block_rows[j] = iscc_get_row(data_set, iscc_get_index(query_indices, block_start + j));
+			found[j] = 0;
+		}
 
-			assert(found == k || out_query_indices != NULL);
-			if (found == k) {
-				if (out_query_indices != NULL) {
-					out_query_indices[num_ok_queries] = (scc_PointIndex) query;
+		// For each query, the search points are visited in the same order as an
+		// unblocked search, so ties are resolved identically.
+		for (size_t s = 0; s < len_search_indices; ++s) {
+			const scc_PointIndex search_point = (scc_PointIndex) iscc_get_index(search_indices, s);
+			dist_keys_to_block(iscc_get_row(data_set, (size_t) search_point), len_block, block_rows, block_dists, data_set->num_dimensions);
+
+			for (size_t j = 0; j < len_block; ++j) {
+				const double tmp_dist = block_dists[j];
+				double* const dist_list = sort_scratch + j * k;
+				scc_PointIndex* const index_list = index_scratch + j * k;
+				if (found[j] < k) {
+					if (radius_search && (tmp_dist > radius_key)) continue;
+					iscc_add_dist_to_list(tmp_dist, search_point, dist_list + found[j], index_list + found[j], dist_list);
+					++found[j];
+				} else {
+					if (tmp_dist >= dist_list[k - 1]) continue;
+					iscc_add_dist_to_list(tmp_dist, search_point, dist_list + k - 1, index_list + k - 1, dist_list);
 				}
-				++num_ok_queries;
-				index_write += k;
 			}
 		}
-	} else {
-		assert(search_indices != NULL);
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			size_t query = q;
-			if (query_indices != NULL) {
-				query = (size_t) query_indices[q];
-			}
-			size_t s = 0;
-			uint32_t found;
-			scc_PointIndex* const index_write_end = index_write + k - 1;
-
-			if (radius_search) {
-				found = 0;
-				for (; (s < len_search_indices) && (found < k); ++s) {
-					tmp_dist = iscc_get_sq_dist(data_set, query, (size_t) search_indices[s]);
-					if (tmp_dist > radius_sq) continue;
-					iscc_add_dist_to_list(tmp_dist, search_indices[s], sort_scratch + found, index_write + found, sort_scratch);
-					++found;
-				}
-			} else {
-				for (; s < k; ++s) {
-					tmp_dist = iscc_get_sq_dist(data_set, query, (size_t) search_indices[s]);
-					iscc_add_dist_to_list(tmp_dist, search_indices[s], sort_scratch + s, index_write + s, sort_scratch);
-				}
-				found = k;
-			}
-
-			for (; s < len_search_indices; ++s) {
-				assert(found == k);
-				tmp_dist = iscc_get_sq_dist(data_set, query, (size_t) search_indices[s]);
-				if (tmp_dist >= *sort_scratch_end) continue;
-				iscc_add_dist_to_list(tmp_dist, search_indices[s], sort_scratch_end, index_write_end, sort_scratch);
-			}
 
-			assert(found == k || out_query_indices != NULL);
-			if (found == k) {
+		for (size_t j = 0; j < len_block; ++j) {
+			assert(found[j] == k || out_query_indices != NULL);
+			if (found[j] == k) {
 				if (out_query_indices != NULL) {
-					out_query_indices[num_ok_queries] = (scc_PointIndex) query;
+					out_query_indices[num_ok_queries] = (scc_PointIndex) iscc_get_index(query_indices, block_start + j);
 				}
+				memcpy(out_nn_indices + num_ok_queries * k, index_scratch + j * k, sizeof(scc_PointIndex[k]));
 				++num_ok_queries;
-				index_write += k;
 			}
 		}
 	}
 
 	*out_num_ok_queries = num_ok_queries;
 
-	free(sort_scratch);
+	iscc_free(block_rows);
+	iscc_free(block_dists);
+	iscc_free(found);
+	iscc_free(sort_scratch);
+	iscc_free(index_scratch);
 
 	return true;
 }
@@ -472,7 +1185,10 @@ bool iscc_imp_close_nn_search_object(iscc_NNSearchObject** const nn_search_objec
 {
 	if (nn_search_object != NULL && *nn_search_object != NULL) {
 		assert((*nn_search_object)->nn_search_version == ISCC_NN_SEARCH_STRUCT_VERSION);
-		free(*nn_search_object);
+		iscc_free((*nn_search_object)->sorted_positions);
+		iscc_free((*nn_search_object)->sorted_rows);
+		iscc_free((*nn_search_object)->grid_cell_start);
+		iscc_free(*nn_search_object);
 		*nn_search_object = NULL;
 	}
 	return true;
@@ -44,12 +44,18 @@ scc_ErrorCode iscc_make_error__(const scc_ErrorCode ec,
                                 const char* const file,
                                 const int line)
 {
-	assert((ec > SCC_ER_OK) && (ec <= SCC_ER_NOT_IMPLEMENTED));
-
-	iscc_error_code = ec;
-	iscc_error_msg = msg;
-	iscc_error_file = file;
-	iscc_error_line = line;
+	assert((ec > SCC_ER_OK) && (ec <= SCC_ER_IO_ERROR));
+
+	// Errors may be raised concurrently when blocks are clustered in parallel
+	#ifdef _OPENMP
+		#pragma omp critical (iscc_error_state)
+	#endif // ifdef _OPENMP
+	{
+		iscc_error_code = ec;
+		iscc_error_msg = msg;
+		iscc_error_file = file;
+		iscc_error_line = line;
+	}
 
 	return ec;
 }
@@ -102,6 +108,9 @@ bool scc_get_latest_error(const size_t len_error_message_buffer,
 			case SCC_ER_NOT_IMPLEMENTED:
 				error_message = "Functionality not yet implemented.";
 				break;
+			case SCC_ER_IO_ERROR:
+				error_message = "Failed to read or write file.";
+				break;
 			default:
 				error_message = "Unknown error code.";
 				break;
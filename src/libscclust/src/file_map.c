@@ -0,0 +1,146 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#if defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))
+	#define ISCC_USE_MMAP
+	#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "file_map.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../include/scclust.h"
+#include "allocator.h"
+#include "error.h"
+
+#ifdef ISCC_USE_MMAP
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif // ifdef ISCC_USE_MMAP
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+scc_ErrorCode iscc_map_file(const char* const file_path,
+                            const iscc_FileAccess access,
+                            iscc_FileMap* const out_map)
+{
+	assert(file_path != NULL);
+	assert((access == ISCC_FA_NORMAL) ||
+	       (access == ISCC_FA_SEQUENTIAL) ||
+	       (access == ISCC_FA_WILLNEED));
+	assert(out_map != NULL);
+
+	*out_map = ISCC_NULL_FILE_MAP;
+
+	#ifdef ISCC_USE_MMAP
+
+		const int fd = open(file_path, O_RDONLY);
+		if (fd == -1) return iscc_make_error_msg(SCC_ER_IO_ERROR, "Cannot open file.");
+
+		struct stat file_stat;
+		if ((fstat(fd, &file_stat) != 0) || (file_stat.st_size <= 0) ||
+		        ((uintmax_t) file_stat.st_size > SIZE_MAX)) {
+			close(fd);
+			return iscc_make_error_msg(SCC_ER_IO_ERROR, "Cannot read file.");
+		}
+
+		const size_t length = (size_t) file_stat.st_size;
+		void* const memory = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (memory == MAP_FAILED) return iscc_make_error_msg(SCC_ER_IO_ERROR, "Cannot map file.");
+
+		// Hints are advisory, ignore failures
+		if (access == ISCC_FA_SEQUENTIAL) {
+			posix_madvise(memory, length, POSIX_MADV_SEQUENTIAL);
+		} else if (access == ISCC_FA_WILLNEED) {
+			posix_madvise(memory, length, POSIX_MADV_WILLNEED);
+		}
+
+		*out_map = (iscc_FileMap) {
+			.memory = memory,
+			.length = length,
+			.is_mapped = true,
+		};
+
+	#else
+
+		// No memory mapping on this platform, read the file into memory instead
+		(void) access;
+		FILE* const file = fopen(file_path, "rb");
+		if (file == NULL) return iscc_make_error_msg(SCC_ER_IO_ERROR, "Cannot open file.");
+
+		long length = -1;
+		if (fseek(file, 0, SEEK_END) == 0) {
+			length = ftell(file);
+		}
+		if ((length <= 0) || (fseek(file, 0, SEEK_SET) != 0)) {
+			fclose(file);
+			return iscc_make_error_msg(SCC_ER_IO_ERROR, "Cannot read file.");
+		}
+
+		void* const memory = iscc_malloc((size_t) length);
+		if (memory == NULL) {
+			fclose(file);
+			return iscc_make_error(SCC_ER_NO_MEMORY);
+		}
+		const size_t read = fread(memory, 1, (size_t) length, file);
+		fclose(file);
+		if (read != (size_t) length) {
+			iscc_free(memory);
+			return iscc_make_error_msg(SCC_ER_IO_ERROR, "Cannot read file.");
+		}
+
+		*out_map = (iscc_FileMap) {
+			.memory = memory,
+			.length = (size_t) length,
+			.is_mapped = false,
+		};
+
+	#endif // ifdef ISCC_USE_MMAP
+
+	return iscc_no_error();
+}
+
+
+void iscc_unmap_file(iscc_FileMap* const map)
+{
+	if ((map != NULL) && (map->memory != NULL)) {
+		#ifdef ISCC_USE_MMAP
+			if (map->is_mapped) {
+				munmap(map->memory, map->length);
+			} else {
+				iscc_free(map->memory);
+			}
+		#else
+			iscc_free(map->memory);
+		#endif // ifdef ISCC_USE_MMAP
+		*map = ISCC_NULL_FILE_MAP;
+	}
+}
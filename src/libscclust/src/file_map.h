@@ -0,0 +1,71 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+/** @file
+ *
+ * Read-only file mappings.
+ *
+ * Files are memory-mapped on platforms that support it. On other platforms,
+ * the file is read into memory so callers can use the same interface.
+ */
+
+#ifndef SCC_FILE_MAP_HG
+#define SCC_FILE_MAP_HG
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "../include/scclust.h"
+
+
+// =============================================================================
+// Structs and variables
+// =============================================================================
+
+/// Access pattern hints for mapped files.
+typedef enum iscc_FileAccess {
+	ISCC_FA_NORMAL,
+	ISCC_FA_SEQUENTIAL,
+	ISCC_FA_WILLNEED
+} iscc_FileAccess;
+
+
+typedef struct iscc_FileMap {
+	void* memory;
+	size_t length;
+	bool is_mapped;
+} iscc_FileMap;
+
+
+static const iscc_FileMap ISCC_NULL_FILE_MAP = { NULL, 0, false };
+
+
+// =============================================================================
+// Function prototypes
+// =============================================================================
+
+scc_ErrorCode iscc_map_file(const char* file_path,
+                            iscc_FileAccess access,
+                            iscc_FileMap* out_map);
+
+
+void iscc_unmap_file(iscc_FileMap* map);
+
+
+#endif // ifndef SCC_FILE_MAP_HG
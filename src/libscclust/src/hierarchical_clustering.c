@@ -26,30 +26,41 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#ifdef _OPENMP
+	#include <omp.h>
+#endif // ifdef _OPENMP
+#include "allocator.h"
 #include "dist_search.h"
 #include "clustering_struct.h"
 #include "error.h"
+#include "hierarchical_sort.h"
+#include "run_context.h"
+#include "run_report.h"
 #include "scclust_types.h"
+#include "utilities.h"
 
 // Maximum number of data points to check when finding centers.
 static const uint_fast16_t ISCC_HI_NUM_TO_CHECK = 100;
 
+static const int32_t ISCC_HIERARCHICAL_OPTIONS_STRUCT_VERSION = 722683003;
+
+// With compact edges, distances are computed for this many members at a time.
+static const size_t ISCC_HI_COMPACT_CHUNK_SIZE = 4096;
+
+#ifdef _OPENMP
+	// Clusters smaller than this are broken within the task that
+	// created them rather than as new tasks.
+	static const size_t ISCC_HI_MIN_TASK_SIZE = 2048;
+#endif // ifdef _OPENMP
+
 
 // =============================================================================
 // Internal structs
 // =============================================================================
 
-typedef struct iscc_hi_DistanceEdge iscc_hi_DistanceEdge;
-struct iscc_hi_DistanceEdge {
-	scc_PointIndex head;
-	double distance;
-	iscc_hi_DistanceEdge* next_dist;
-};
-
-
 typedef struct iscc_hi_ClusterItem {
 	size_t size;
-	uint_fast16_t marker;
+	uint16_t marker;
 	scc_PointIndex* members;
 } iscc_hi_ClusterItem;
 
@@ -62,20 +73,85 @@ typedef struct iscc_hi_ClusterStack {
 } iscc_hi_ClusterStack;
 
 
+typedef struct iscc_hi_WorkAreaSizes {
+	size_t pointindex_array;
+	size_t dist_array;
+	size_t edge_array;
+	size_t sort_dists;
+	size_t compact_dists;
+	size_t sample_dists;
+} iscc_hi_WorkAreaSizes;
+
+
+/* With compact edges, `dist_array` holds distances for one chunk of members,
+ * and edge lists use `compact_dists1`, `compact_dists2` and `compact_sort_dists`
+ * instead of `dist_array` and `sort_dists`.
+ */
 typedef struct iscc_hi_WorkArea {
-	scc_PointIndex* const pointindex_array1;
-	scc_PointIndex* const pointindex_array2;
-	double* const dist_array;
-	uint_fast16_t* const vertex_markers;
-	iscc_hi_DistanceEdge* const edge_store1;
-	iscc_hi_DistanceEdge* const edge_store2;
+	bool compact_edges;
+	scc_PointIndex* pointindex_array1;
+	scc_PointIndex* pointindex_array2;
+	double* dist_array;
+	uint16_t* vertex_markers;
+	scc_PointIndex* edge_heads1;
+	scc_PointIndex* edge_heads2;
+	double* sort_dists;
+	scc_PointIndex* sort_heads;
+	float* compact_dists1;
+	float* compact_dists2;
+	float* compact_sort_dists;
+	double* sample_dists;
 } iscc_hi_WorkArea;
 
 
+/* Edges from a center to the other members of a cluster, sorted by distance.
+ * Entries before `next` have been assigned. Entries after `next` may have been
+ * assigned to the other cluster; they are skipped and compacted away when found.
+ * Exactly one of `dists` and `compact_dists` is not NULL.
+ */
+typedef struct iscc_hi_EdgeList {
+	size_t next;
+	size_t len;
+	scc_PointIndex* heads;
+	double* dists;
+	float* compact_dists;
+} iscc_hi_EdgeList;
+
+
+static const iscc_hi_EdgeList ISCC_HI_NULL_EDGE_LIST = { 0, 0, NULL, NULL, NULL };
+
+
+#ifdef _OPENMP
+
+/* State shared by the tasks of a parallel run. Tasks work on disjoint
+ * parts of `pointindex_store`, and each data point belongs to exactly one
+ * cluster, so tasks never touch the same entries of `vertex_markers`.
+ * Each thread has its own work area for the remaining scratch arrays.
+ */
+typedef struct iscc_hi_ParallelState {
+	void* data_set;
+	const scc_HierarchicalOptions* options;
+	iscc_hi_WorkArea* work_areas;
+	size_t num_leaves;
+	iscc_hi_ClusterItem* leaves;
+	scc_ErrorCode ec;
+} iscc_hi_ParallelState;
+
+#endif // ifdef _OPENMP
+
+
 // =============================================================================
 // Static function prototypes
 // =============================================================================
 
+static scc_ErrorCode iscc_hi_check_options(const scc_HierarchicalOptions* options);
+
+
+static scc_ErrorCode iscc_hi_hierarchical_clustering(scc_Clustering* clustering,
+                                                     void* data_set,
+                                                     const scc_HierarchicalOptions* options);
+
+
 static scc_ErrorCode iscc_hi_empty_cl_stack(size_t num_data_points,
                                             iscc_hi_ClusterStack* out_cl_stack);
 
@@ -89,8 +165,50 @@ static scc_ErrorCode iscc_hi_run_hierarchical_clustering(iscc_hi_ClusterStack* c
                                                          scc_Clustering* cl,
                                                          void* data_set,
                                                          iscc_hi_WorkArea* work_area,
-                                                         uint32_t size_constraint,
-                                                         bool batch_assign);
+                                                         const scc_HierarchicalOptions* options);
+
+
+#ifdef _OPENMP
+
+static scc_ErrorCode iscc_hi_run_parallel_hierarchical_clustering(const iscc_hi_ClusterStack* cl_stack,
+                                                                  scc_Clustering* cl,
+                                                                  void* data_set,
+                                                                  size_t size_largest_cluster,
+                                                                  const scc_HierarchicalOptions* options,
+                                                                  uint32_t num_threads);
+
+
+static void iscc_hi_break_cluster_task(iscc_hi_ClusterItem cluster,
+                                       iscc_hi_ParallelState* state);
+
+
+static int iscc_hi_compare_leaves(const void* a,
+                                  const void* b);
+
+#endif // ifdef _OPENMP
+
+
+static scc_ErrorCode iscc_hi_get_work_area_sizes(const scc_HierarchicalOptions* options,
+                                                 size_t size_largest_cluster,
+                                                 iscc_hi_WorkAreaSizes* out_sizes);
+
+
+static scc_ErrorCode iscc_hi_check_memory_budget(const scc_HierarchicalOptions* options,
+                                                 const iscc_hi_ClusterStack* cl_stack,
+                                                 size_t num_data_points,
+                                                 size_t size_largest_cluster,
+                                                 uint32_t num_threads);
+
+
+static scc_ErrorCode iscc_hi_init_work_area(size_t num_data_points,
+                                            const scc_HierarchicalOptions* options,
+                                            size_t size_largest_cluster,
+                                            uint16_t vertex_markers[],
+                                            iscc_hi_WorkArea* out_work_area);
+
+
+static void iscc_hi_free_work_area(iscc_hi_WorkArea* work_area,
+                                   bool free_vertex_markers);
 
 
 static scc_ErrorCode iscc_hi_push_to_stack(iscc_hi_ClusterStack* cl_stack,
@@ -100,51 +218,69 @@ static scc_ErrorCode iscc_hi_push_to_stack(iscc_hi_ClusterStack* cl_stack,
 static scc_ErrorCode iscc_hi_break_cluster_into_two(iscc_hi_ClusterItem* cluster_to_break,
                                                     void* data_set,
                                                     iscc_hi_WorkArea* work_area,
-                                                    uint32_t size_constraint,
-                                                    bool batch_assign,
+                                                    const scc_HierarchicalOptions* options,
                                                     iscc_hi_ClusterItem* out_new_cluster);
 
 
-static inline uint_fast16_t iscc_hi_get_next_marker(iscc_hi_ClusterItem* cl,
-                                                    uint_fast16_t vertex_markers[]);
+static scc_ErrorCode iscc_hi_break_cluster_by_assignment(iscc_hi_ClusterItem* cluster_to_break,
+                                                         void* data_set,
+                                                         iscc_hi_WorkArea* work_area,
+                                                         uint32_t size_constraint,
+                                                         bool batch_assign,
+                                                         iscc_hi_ClusterItem* out_new_cluster);
+
+
+static scc_ErrorCode iscc_hi_break_cluster_by_projection(iscc_hi_ClusterItem* cluster_to_break,
+                                                         void* data_set,
+                                                         iscc_hi_WorkArea* work_area,
+                                                         const scc_HierarchicalOptions* options,
+                                                         iscc_hi_ClusterItem* out_new_cluster);
+
+
+static inline uint16_t iscc_hi_get_next_marker(iscc_hi_ClusterItem* cl,
+                                                    uint16_t vertex_markers[]);
+
 
+static inline double iscc_hi_get_edge_dist(const iscc_hi_EdgeList* edge_list,
+                                           size_t index);
 
-static inline iscc_hi_DistanceEdge* iscc_hi_get_next_k_nn(iscc_hi_DistanceEdge* prev_dist,
-                                                          uint32_t k,
-                                                          const uint_fast16_t vertex_markers[],
-                                                          uint_fast16_t curr_marker,
-                                                          scc_PointIndex out_dist_array[static k]);
 
+static inline size_t iscc_hi_get_next_k_nn(iscc_hi_EdgeList* edge_list,
+                                           uint32_t k,
+                                           const uint16_t vertex_markers[],
+                                           uint16_t curr_marker,
+                                           scc_PointIndex out_dist_array[static k]);
 
-static inline iscc_hi_DistanceEdge* iscc_hi_get_next_dist(iscc_hi_DistanceEdge* prev_dist,
-                                                          const uint_fast16_t vertex_markers[],
-                                                          uint_fast16_t curr_marker);
+
+static inline size_t iscc_hi_get_next_dist(iscc_hi_EdgeList* edge_list,
+                                           const uint16_t vertex_markers[],
+                                           uint16_t curr_marker);
 
 
 static inline void iscc_hi_move_point_to_cluster1(scc_PointIndex id,
                                                   iscc_hi_ClusterItem* cl,
-                                                  uint_fast16_t vertex_markers[],
-                                                  uint_fast16_t curr_marker);
+                                                  uint16_t vertex_markers[],
+                                                  uint16_t curr_marker);
 
 
 static inline void iscc_hi_move_point_to_cluster2(scc_PointIndex id,
                                                   iscc_hi_ClusterItem* cl,
-                                                  uint_fast16_t vertex_markers[],
-                                                  uint_fast16_t curr_marker);
+                                                  uint16_t vertex_markers[],
+                                                  uint16_t curr_marker);
 
 
 static inline void iscc_hi_move_array_to_cluster1(uint32_t len_ids,
                                                   const scc_PointIndex ids[static len_ids],
                                                   iscc_hi_ClusterItem* cl,
-                                                  uint_fast16_t vertex_markers[],
-                                                  uint_fast16_t curr_marker);
+                                                  uint16_t vertex_markers[],
+                                                  uint16_t curr_marker);
 
 
 static inline void iscc_hi_move_array_to_cluster2(uint32_t len_ids,
                                                   const scc_PointIndex ids[static len_ids],
                                                   iscc_hi_ClusterItem* cl,
-                                                  uint_fast16_t vertex_markers[],
-                                                  uint_fast16_t curr_marker);
+                                                  uint16_t vertex_markers[],
+                                                  uint16_t curr_marker);
 
 
 static scc_ErrorCode iscc_hi_find_centers(iscc_hi_ClusterItem* cl,
@@ -154,31 +290,74 @@ static scc_ErrorCode iscc_hi_find_centers(iscc_hi_ClusterItem* cl,
                                           scc_PointIndex* out_center2);
 
 
+static scc_ErrorCode iscc_hi_find_sampled_centers(const iscc_hi_ClusterItem* cl,
+                                                  void* data_set,
+                                                  uint32_t sample_size,
+                                                  iscc_hi_WorkArea* work_area,
+                                                  scc_PointIndex* out_center1,
+                                                  scc_PointIndex* out_center2);
+
+
 static scc_ErrorCode iscc_hi_populate_edge_lists(const iscc_hi_ClusterItem* cl,
                                                  void* data_set,
                                                  scc_PointIndex center1,
                                                  scc_PointIndex center2,
-                                                 iscc_hi_WorkArea* work_area);
+                                                 iscc_hi_WorkArea* work_area,
+                                                 iscc_hi_EdgeList* out_edge_list1,
+                                                 iscc_hi_EdgeList* out_edge_list2);
 
 
-static inline void iscc_hi_sort_edge_list(const iscc_hi_ClusterItem* cl,
-                                          scc_PointIndex center,
-                                          const double row_dists[static cl->size],
-                                          iscc_hi_DistanceEdge edge_store[static cl->size]);
+static scc_ErrorCode iscc_hi_populate_compact_edge_lists(const iscc_hi_ClusterItem* cl,
+                                                         void* data_set,
+                                                         scc_PointIndex center1,
+                                                         scc_PointIndex center2,
+                                                         iscc_hi_WorkArea* work_area,
+                                                         iscc_hi_EdgeList* out_edge_list1,
+                                                         iscc_hi_EdgeList* out_edge_list2);
 
 
-static int iscc_hi_compare_dist_edges(const void* a,
-                                      const void* b);
+static inline void iscc_hi_sort_edge_list(const iscc_hi_ClusterItem* cl,
+                                          scc_PointIndex center,
+                                          double row_dists[static cl->size],
+                                          scc_PointIndex edge_heads[static cl->size],
+                                          iscc_hi_WorkArea* work_area,
+                                          iscc_hi_EdgeList* out_edge_list);
 
 
 // =============================================================================
 // Public function implementations
 // =============================================================================
 
+scc_HierarchicalOptions scc_get_default_hierarchical_options(void)
+{
+	return (scc_HierarchicalOptions) {
+		.options_version = ISCC_HIERARCHICAL_OPTIONS_STRUCT_VERSION,
+		.size_constraint = 0,
+		.batch_assign = false,
+		.bisection_method = SCC_BM_FARTHEST_PAIR,
+		.bisection_sample_size = ISCC_HI_NUM_TO_CHECK,
+		.compact_edges = false,
+		.memory_budget = 0,
+		.run_report = NULL,
+	};
+}
+
+
 scc_ErrorCode scc_hierarchical_clustering(void* const data_set,
                                           const uint32_t size_constraint,
                                           const bool batch_assign,
                                           scc_Clustering* const out_clustering)
+{
+	scc_HierarchicalOptions options = scc_get_default_hierarchical_options();
+	options.size_constraint = size_constraint;
+	options.batch_assign = batch_assign;
+	return scc_hierarchical_clustering_with_options(data_set, &options, out_clustering);
+}
+
+
+scc_ErrorCode scc_hierarchical_clustering_with_options(void* const data_set,
+                                                       const scc_HierarchicalOptions* const options,
+                                                       scc_Clustering* const out_clustering)
 {
 	if (!iscc_check_input_clustering(out_clustering)) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid clustering object.");
@@ -189,29 +368,77 @@ scc_ErrorCode scc_hierarchical_clustering(void* const data_set,
 	if (iscc_num_data_points(data_set) != out_clustering->num_data_points) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Number of data points in data set does not match clustering object.");
 	}
-	if (size_constraint < 2) {
-		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Size constraint must be 2 or greater.");
+	scc_ErrorCode ec;
+	if ((ec = iscc_hi_check_options(options)) != SCC_ER_OK) {
+		return ec;
 	}
-	if (out_clustering->num_data_points < size_constraint) {
+	if (out_clustering->num_data_points < options->size_constraint) {
 		return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Fewer data points than size constraint.");
 	}
 
+	iscc_RunContext run_context;
+	const bool run = iscc_begin_run(&run_context, options->run_report);
+	const double phase_start = iscc_report_phase_start();
+	ec = iscc_hi_hierarchical_clustering(out_clustering, data_set, options);
+	iscc_report_phase_end(SCC_RP_HIERARCHICAL, phase_start);
+	if (run) iscc_end_run(&run_context);
+
+	return ec;
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static scc_ErrorCode iscc_hi_check_options(const scc_HierarchicalOptions* const options)
+{
+	if (options == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid options object.");
+	}
+	if (options->options_version != ISCC_HIERARCHICAL_OPTIONS_STRUCT_VERSION) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Incompatible scc_HierarchicalOptions version.");
+	}
+	if (options->size_constraint < 2) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Size constraint must be 2 or greater.");
+	}
+	if ((options->bisection_method != SCC_BM_FARTHEST_PAIR) &&
+	        (options->bisection_method != SCC_BM_SAMPLED_PROJECTION)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Unknown bisection method.");
+	}
+	if ((options->bisection_method == SCC_BM_SAMPLED_PROJECTION) && (options->bisection_sample_size < 2)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Bisection sample size must be 2 or greater.");
+	}
+
+	return iscc_no_error();
+}
+
+
+static scc_ErrorCode iscc_hi_hierarchical_clustering(scc_Clustering* const clustering,
+                                                     void* const data_set,
+                                                     const scc_HierarchicalOptions* const options)
+{
+	assert(iscc_check_input_clustering(clustering));
+	assert(iscc_check_data_set(data_set));
+	assert(iscc_num_data_points(data_set) == clustering->num_data_points);
+	assert(options != NULL);
+
 	scc_ErrorCode ec;
 	size_t size_largest_cluster = 0; // Initialize to avoid gcc warning
 	iscc_hi_ClusterStack cl_stack;
-	if (out_clustering->num_clusters == 0) {
-		if (out_clustering->cluster_label == NULL) {
-			out_clustering->external_labels = false;
-			out_clustering->cluster_label = malloc(sizeof(scc_Clabel[out_clustering->num_data_points]));
-			if (out_clustering->cluster_label == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+	if (clustering->num_clusters == 0) {
+		if (clustering->cluster_label == NULL) {
+			clustering->external_labels = false;
+			clustering->cluster_label = iscc_malloc(sizeof(scc_Clabel[clustering->num_data_points]));
+			if (clustering->cluster_label == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 		}
 
-		size_largest_cluster = out_clustering->num_data_points;
-		if ((ec = iscc_hi_empty_cl_stack(out_clustering->num_data_points, &cl_stack)) != SCC_ER_OK) {
+		size_largest_cluster = clustering->num_data_points;
+		if ((ec = iscc_hi_empty_cl_stack(clustering->num_data_points, &cl_stack)) != SCC_ER_OK) {
 			return ec;
 		}
 	} else {
-		if ((ec = iscc_hi_init_cl_stack(out_clustering, &cl_stack, &size_largest_cluster)) != SCC_ER_OK) {
+		if ((ec = iscc_hi_init_cl_stack(clustering, &cl_stack, &size_largest_cluster)) != SCC_ER_OK) {
 			return ec;
 		}
 	}
@@ -220,49 +447,56 @@ scc_ErrorCode scc_hierarchical_clustering(void* const data_set,
 	assert(cl_stack.clusters != NULL);
 	assert(cl_stack.pointindex_store != NULL);
 
-	const size_t size_pointindex_array = (size_constraint > ISCC_HI_NUM_TO_CHECK) ? size_constraint : ISCC_HI_NUM_TO_CHECK;
-	const size_t size_dist_array = ((2 * size_largest_cluster) > ISCC_HI_NUM_TO_CHECK) ? (2 * size_largest_cluster) : ISCC_HI_NUM_TO_CHECK;
-	iscc_hi_WorkArea work_area = {
-		.pointindex_array1 = malloc(sizeof(scc_PointIndex[size_pointindex_array])),
-		.pointindex_array2 = malloc(sizeof(scc_PointIndex[size_pointindex_array])),
-		.dist_array = malloc(sizeof(double[size_dist_array])),
-		.vertex_markers = calloc(out_clustering->num_data_points, sizeof(uint_fast16_t)),
-		.edge_store1 = malloc(sizeof(iscc_hi_DistanceEdge[size_largest_cluster])),
-		.edge_store2 = malloc(sizeof(iscc_hi_DistanceEdge[size_largest_cluster])),
-	};
-
-	if ((work_area.pointindex_array1 == NULL) || (work_area.pointindex_array2 == NULL) ||
-	        (work_area.dist_array == NULL) || (work_area.vertex_markers == NULL) ||
-	        (work_area.edge_store1 == NULL) || (work_area.edge_store2 == NULL)) {
-		ec = iscc_make_error(SCC_ER_NO_MEMORY);
+	uint32_t num_threads = 1;
+	#ifdef _OPENMP
+		num_threads = iscc_get_num_threads();
+	#endif // ifdef _OPENMP
+
+	if ((ec = iscc_hi_check_memory_budget(options,
+	                                      &cl_stack,
+	                                      clustering->num_data_points,
+	                                      size_largest_cluster,
+	                                      num_threads)) != SCC_ER_OK) {
+		iscc_free(cl_stack.clusters);
+		iscc_free(cl_stack.pointindex_store);
+		return ec;
 	}
 
-	if (ec == SCC_ER_OK) {
+	#ifdef _OPENMP
+		if (num_threads > 1) {
+			ec = iscc_hi_run_parallel_hierarchical_clustering(&cl_stack,
+			                                                  clustering,
+			                                                  data_set,
+			                                                  size_largest_cluster,
+			                                                  options,
+			                                                  num_threads);
+			iscc_free(cl_stack.clusters);
+			iscc_free(cl_stack.pointindex_store);
+			return ec;
+		}
+	#endif // ifdef _OPENMP
+
+	iscc_hi_WorkArea work_area;
+	if ((ec = iscc_hi_init_work_area(clustering->num_data_points,
+	                                 options,
+	                                 size_largest_cluster,
+	                                 NULL,
+	                                 &work_area)) == SCC_ER_OK) {
 		ec = iscc_hi_run_hierarchical_clustering(&cl_stack,
-		                                         out_clustering,
+		                                         clustering,
 		                                         data_set,
 		                                         &work_area,
-		                                         size_constraint,
-		                                         batch_assign);
+		                                         options);
+		iscc_hi_free_work_area(&work_area, true);
 	}
 
-	free(work_area.pointindex_array1);
-	free(work_area.pointindex_array2);
-	free(work_area.dist_array);
-	free(work_area.vertex_markers);
-	free(work_area.edge_store1);
-	free(work_area.edge_store2);
-	free(cl_stack.clusters);
-	free(cl_stack.pointindex_store);
+	iscc_free(cl_stack.clusters);
+	iscc_free(cl_stack.pointindex_store);
 
 	return ec;
 }
 
 
-// =============================================================================
-// Static function implementations
-// =============================================================================
-
 static scc_ErrorCode iscc_hi_empty_cl_stack(const size_t num_data_points,
                                             iscc_hi_ClusterStack* const out_cl_stack)
 {
@@ -273,12 +507,12 @@ static scc_ErrorCode iscc_hi_empty_cl_stack(const size_t num_data_points,
 	*out_cl_stack = (iscc_hi_ClusterStack) {
 		.capacity = tmp_capacity,
 		.items = 1,
-		.clusters = malloc(sizeof(iscc_hi_ClusterItem[tmp_capacity])),
-		.pointindex_store = malloc(sizeof(scc_PointIndex[num_data_points])),
+		.clusters = iscc_tmp_malloc(sizeof(iscc_hi_ClusterItem[tmp_capacity])),
+		.pointindex_store = iscc_tmp_malloc(sizeof(scc_PointIndex[num_data_points])),
 	};
 	if ((out_cl_stack->clusters == NULL) || (out_cl_stack->pointindex_store == NULL)) {
-		free(out_cl_stack->clusters);
-		free(out_cl_stack->pointindex_store);
+		iscc_free(out_cl_stack->clusters);
+		iscc_free(out_cl_stack->pointindex_store);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
@@ -314,12 +548,12 @@ static scc_ErrorCode iscc_hi_init_cl_stack(const scc_Clustering* const in_cl,
 	*out_cl_stack = (iscc_hi_ClusterStack) {
 		.capacity = (size_t) tmp_capacity,
 		.items = in_cl->num_clusters,
-		.clusters = calloc((size_t) tmp_capacity, sizeof(iscc_hi_ClusterItem)),
-		.pointindex_store = malloc(sizeof(scc_PointIndex[in_cl->num_data_points])),
+		.clusters = iscc_tmp_calloc((size_t) tmp_capacity, sizeof(iscc_hi_ClusterItem)),
+		.pointindex_store = iscc_tmp_malloc(sizeof(scc_PointIndex[in_cl->num_data_points])),
 	};
 	if ((out_cl_stack->clusters == NULL) || (out_cl_stack->pointindex_store == NULL)) {
-		free(out_cl_stack->clusters);
-		free(out_cl_stack->pointindex_store);
+		iscc_free(out_cl_stack->clusters);
+		iscc_free(out_cl_stack->pointindex_store);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
@@ -332,7 +566,7 @@ static scc_ErrorCode iscc_hi_init_cl_stack(const scc_Clustering* const in_cl,
 		}
 	}
 
-	size_t size_largest_cluster = 0;
+	size_t size_largest_cluster = clusters[0].size;
 	clusters[0].members = out_cl_stack->pointindex_store + clusters[0].size;
 	for (size_t c = 1; c < in_cl->num_clusters; ++c) {
 		clusters[c].members = clusters[c - 1].members + clusters[c].size;
@@ -357,8 +591,7 @@ static scc_ErrorCode iscc_hi_run_hierarchical_clustering(iscc_hi_ClusterStack* c
                                                          scc_Clustering* const cl,
                                                          void* const data_set,
                                                          iscc_hi_WorkArea* const work_area,
-                                                         const uint32_t size_constraint,
-                                                         const bool batch_assign)
+                                                         const scc_HierarchicalOptions* const options)
 {
 	assert(cl_stack != NULL);
 	assert(cl_stack->items > 0);
@@ -369,7 +602,10 @@ static scc_ErrorCode iscc_hi_run_hierarchical_clustering(iscc_hi_ClusterStack* c
 	assert(iscc_check_data_set(data_set));
 	assert(iscc_num_data_points(data_set) == cl->num_data_points);
 	assert(work_area != NULL);
-	assert(size_constraint >= 2);
+	assert(options != NULL);
+	assert(options->size_constraint >= 2);
+
+	const uint32_t size_constraint = options->size_constraint;
 
 	scc_ErrorCode ec;
 	scc_Clabel current_label = 0;
@@ -395,8 +631,7 @@ static scc_ErrorCode iscc_hi_run_hierarchical_clustering(iscc_hi_ClusterStack* c
 			if ((ec = iscc_hi_break_cluster_into_two(current_cluster,
 			                                         data_set,
 			                                         work_area,
-			                                         size_constraint,
-			                                         batch_assign,
+			                                         options,
 			                                         new_cluster)) != SCC_ER_OK) {
 				return ec;
 			}
@@ -411,6 +646,333 @@ static scc_ErrorCode iscc_hi_run_hierarchical_clustering(iscc_hi_ClusterStack* c
 }
 
 
+#ifdef _OPENMP
+
+static scc_ErrorCode iscc_hi_run_parallel_hierarchical_clustering(const iscc_hi_ClusterStack* const cl_stack,
+                                                                  scc_Clustering* const cl,
+                                                                  void* const data_set,
+                                                                  const size_t size_largest_cluster,
+                                                                  const scc_HierarchicalOptions* const options,
+                                                                  const uint32_t num_threads)
+{
+	assert(cl_stack != NULL);
+	assert(cl_stack->items > 0);
+	assert(cl_stack->clusters != NULL);
+	assert(cl_stack->pointindex_store != NULL);
+	assert(iscc_check_input_clustering(cl));
+	assert(iscc_check_data_set(data_set));
+	assert(options != NULL);
+	assert(options->size_constraint >= 2);
+	assert(num_threads > 1);
+
+	// Each broken cluster has at least `size_constraint` points, so this bounds the number of leaves
+	const size_t max_leaves = cl_stack->items + cl->num_data_points / options->size_constraint;
+	iscc_hi_ParallelState state = {
+		.data_set = data_set,
+		.options = options,
+		.work_areas = iscc_tmp_calloc(num_threads, sizeof(iscc_hi_WorkArea)),
+		.num_leaves = 0,
+		.leaves = iscc_tmp_malloc(sizeof(iscc_hi_ClusterItem[max_leaves])),
+		.ec = SCC_ER_OK,
+	};
+	uint16_t* const vertex_markers = iscc_tmp_calloc(cl->num_data_points, sizeof(uint16_t));
+	if ((state.work_areas == NULL) || (state.leaves == NULL) || (vertex_markers == NULL)) {
+		iscc_free(state.work_areas);
+		iscc_free(state.leaves);
+		iscc_free(vertex_markers);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	scc_ErrorCode ec = SCC_ER_OK;
+	for (uint32_t t = 0; (t < num_threads) && (ec == SCC_ER_OK); ++t) {
+		ec = iscc_hi_init_work_area(cl->num_data_points,
+		                            options,
+		                            size_largest_cluster,
+		                            vertex_markers,
+		                            &state.work_areas[t]);
+	}
+
+	if (ec == SCC_ER_OK) {
+		// Tasks are tied, so they run on threads that have entered the run
+		iscc_RunContext* const run_context = iscc_get_run_context();
+		#pragma omp parallel num_threads((int) num_threads)
+		{
+			iscc_RunContext* const prev_context = iscc_enter_run_context(run_context);
+			#pragma omp single
+			{
+				for (size_t c = cl_stack->items; c > 0; --c) {
+					const iscc_hi_ClusterItem cluster = cl_stack->clusters[c - 1];
+					#pragma omp task firstprivate(cluster)
+					iscc_hi_break_cluster_task(cluster, &state);
+				}
+			}
+			iscc_leave_run_context(prev_context);
+		}
+		ec = state.ec;
+	}
+
+	if (ec == SCC_ER_OK) {
+		if (state.num_leaves > (size_t) SCC_CLABEL_MAX) {
+			ec = iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many clusters (adjust the `scc_Clabel` type).");
+		}
+	}
+
+	if (ec == SCC_ER_OK) {
+		/* The serial run labels the top of the stack first and, after a break,
+		 * the second cluster before the first. Both orders put clusters later
+		 * in `pointindex_store` first, so sorting leaves by their position gives
+		 * the same labels.
+		 */
+		qsort(state.leaves, state.num_leaves, sizeof(iscc_hi_ClusterItem), iscc_hi_compare_leaves);
+		for (size_t l = 0; l < state.num_leaves; ++l) {
+			const scc_Clabel label = (scc_Clabel) l;
+			for (size_t v = 0; v < state.leaves[l].size; ++v) {
+				cl->cluster_label[state.leaves[l].members[v]] = label;
+			}
+		}
+		cl->num_clusters = state.num_leaves;
+	}
+
+	for (uint32_t t = 0; t < num_threads; ++t) {
+		iscc_hi_free_work_area(&state.work_areas[t], false);
+	}
+	iscc_free(state.work_areas);
+	iscc_free(state.leaves);
+	iscc_free(vertex_markers);
+
+	return ec;
+}
+
+
+static void iscc_hi_break_cluster_task(iscc_hi_ClusterItem cluster,
+                                       iscc_hi_ParallelState* const state)
+{
+	assert(state != NULL);
+
+	scc_ErrorCode state_ec;
+	#pragma omp atomic read
+	state_ec = state->ec;
+	if (state_ec != SCC_ER_OK) return;
+
+	if (cluster.size < (2 * state->options->size_constraint)) {
+		if (cluster.size > 0) {
+			size_t leaf_index;
+			#pragma omp atomic capture
+			leaf_index = state->num_leaves++;
+			state->leaves[leaf_index] = cluster;
+		}
+		return;
+	}
+
+	iscc_hi_ClusterItem new_cluster;
+	const scc_ErrorCode ec = iscc_hi_break_cluster_into_two(&cluster,
+	                                                        state->data_set,
+	                                                        &state->work_areas[omp_get_thread_num()],
+	                                                        state->options,
+	                                                        &new_cluster);
+	if (ec != SCC_ER_OK) {
+		#pragma omp critical (iscc_hi_parallel_state)
+		{
+			if (state->ec == SCC_ER_OK) state->ec = ec;
+		}
+		return;
+	}
+
+	// The work area is not used after this point, so it is free for new tasks on this thread
+	if (new_cluster.size >= ISCC_HI_MIN_TASK_SIZE) {
+		#pragma omp task firstprivate(new_cluster)
+		iscc_hi_break_cluster_task(new_cluster, state);
+	} else {
+		iscc_hi_break_cluster_task(new_cluster, state);
+	}
+	if (cluster.size >= ISCC_HI_MIN_TASK_SIZE) {
+		#pragma omp task firstprivate(cluster)
+		iscc_hi_break_cluster_task(cluster, state);
+	} else {
+		iscc_hi_break_cluster_task(cluster, state);
+	}
+}
+
+
+static int iscc_hi_compare_leaves(const void* const a,
+                                  const void* const b)
+{
+	const scc_PointIndex* const members_a = ((const iscc_hi_ClusterItem*) a)->members;
+	const scc_PointIndex* const members_b = ((const iscc_hi_ClusterItem*) b)->members;
+
+	// Descending order
+	if (members_a > members_b) return -1;
+	if (members_a < members_b) return 1;
+	return 0;
+}
+
+#endif // ifdef _OPENMP
+
+
+static scc_ErrorCode iscc_hi_get_work_area_sizes(const scc_HierarchicalOptions* const options,
+                                                 const size_t size_largest_cluster,
+                                                 iscc_hi_WorkAreaSizes* const out_sizes)
+{
+	assert(options != NULL);
+	assert(options->size_constraint >= 2);
+	assert(out_sizes != NULL);
+
+	*out_sizes = (iscc_hi_WorkAreaSizes) {
+		.pointindex_array = (options->size_constraint > ISCC_HI_NUM_TO_CHECK) ? options->size_constraint : ISCC_HI_NUM_TO_CHECK,
+		.dist_array = ((2 * size_largest_cluster) > ISCC_HI_NUM_TO_CHECK) ? (2 * size_largest_cluster) : ISCC_HI_NUM_TO_CHECK,
+		.edge_array = size_largest_cluster,
+		.sort_dists = size_largest_cluster,
+		.compact_dists = 0,
+		.sample_dists = 0,
+	};
+
+	if (options->compact_edges) {
+		const size_t size_chunk = (size_largest_cluster < ISCC_HI_COMPACT_CHUNK_SIZE) ? size_largest_cluster : ISCC_HI_COMPACT_CHUNK_SIZE;
+		out_sizes->dist_array = ((2 * size_chunk) > ISCC_HI_NUM_TO_CHECK) ? (2 * size_chunk) : ISCC_HI_NUM_TO_CHECK;
+		out_sizes->sort_dists = 0;
+		out_sizes->compact_dists = size_largest_cluster;
+	}
+
+	if (options->bisection_method == SCC_BM_SAMPLED_PROJECTION) {
+		// Samples are never larger than the largest cluster
+		const size_t sample_size = (options->bisection_sample_size < size_largest_cluster) ? options->bisection_sample_size : size_largest_cluster;
+		if (((uint64_t) sample_size) * (sample_size - 1) / 2 > SIZE_MAX / sizeof(double)) {
+			return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Bisection sample size is too large.");
+		}
+		out_sizes->sample_dists = sample_size * (sample_size - 1) / 2;
+		if (sample_size > out_sizes->pointindex_array) out_sizes->pointindex_array = sample_size;
+	}
+
+	return iscc_no_error();
+}
+
+
+static scc_ErrorCode iscc_hi_check_memory_budget(const scc_HierarchicalOptions* const options,
+                                                 const iscc_hi_ClusterStack* const cl_stack,
+                                                 const size_t num_data_points,
+                                                 const size_t size_largest_cluster,
+                                                 const uint32_t num_threads)
+{
+	assert(options != NULL);
+	assert(cl_stack != NULL);
+	assert(num_threads > 0);
+
+	if (options->memory_budget == 0) return iscc_no_error();
+
+	scc_ErrorCode ec;
+	iscc_hi_WorkAreaSizes sizes;
+	if ((ec = iscc_hi_get_work_area_sizes(options, size_largest_cluster, &sizes)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	// Working memory of the run, excluding the data set and the cluster labels
+	const double bytes_work_area = (double) sizes.pointindex_array * 2.0 * sizeof(scc_PointIndex) +
+	                               (double) sizes.dist_array * sizeof(double) +
+	                               (double) sizes.edge_array * 3.0 * sizeof(scc_PointIndex) +
+	                               (double) sizes.sort_dists * sizeof(double) +
+	                               (double) sizes.compact_dists * 3.0 * sizeof(float) +
+	                               (double) sizes.sample_dists * sizeof(double);
+	double bytes_total = (double) cl_stack->capacity * sizeof(iscc_hi_ClusterItem) +
+	                     (double) num_data_points * (sizeof(scc_PointIndex) + sizeof(uint16_t)) +
+	                     (double) num_threads * bytes_work_area;
+	if (num_threads > 1) {
+		// Leaves of the parallel run
+		bytes_total += (double) (cl_stack->items + num_data_points / options->size_constraint) * sizeof(iscc_hi_ClusterItem);
+	}
+
+	if (bytes_total > (double) options->memory_budget) {
+		return iscc_make_error_msg(SCC_ER_NO_MEMORY, "Predicted memory use exceeds the memory budget.");
+	}
+
+	return iscc_no_error();
+}
+
+
+static scc_ErrorCode iscc_hi_init_work_area(const size_t num_data_points,
+                                            const scc_HierarchicalOptions* const options,
+                                            const size_t size_largest_cluster,
+                                            uint16_t vertex_markers[const],
+                                            iscc_hi_WorkArea* const out_work_area)
+{
+	assert(num_data_points >= 2);
+	assert(options != NULL);
+	assert(options->size_constraint >= 2);
+	assert(out_work_area != NULL);
+
+	scc_ErrorCode ec;
+	iscc_hi_WorkAreaSizes sizes;
+	if ((ec = iscc_hi_get_work_area_sizes(options, size_largest_cluster, &sizes)) != SCC_ER_OK) {
+		*out_work_area = (iscc_hi_WorkArea) { .pointindex_array1 = NULL };
+		return ec;
+	}
+
+	*out_work_area = (iscc_hi_WorkArea) {
+		.compact_edges = options->compact_edges,
+		.pointindex_array1 = iscc_tmp_malloc(sizeof(scc_PointIndex[sizes.pointindex_array])),
+		.pointindex_array2 = iscc_tmp_malloc(sizeof(scc_PointIndex[sizes.pointindex_array])),
+		.dist_array = iscc_tmp_malloc(sizeof(double[sizes.dist_array])),
+		.vertex_markers = (vertex_markers != NULL) ? vertex_markers : iscc_tmp_calloc(num_data_points, sizeof(uint16_t)),
+		.edge_heads1 = iscc_tmp_malloc(sizeof(scc_PointIndex[sizes.edge_array])),
+		.edge_heads2 = iscc_tmp_malloc(sizeof(scc_PointIndex[sizes.edge_array])),
+		.sort_dists = (sizes.sort_dists > 0) ? iscc_tmp_malloc(sizeof(double[sizes.sort_dists])) : NULL,
+		.sort_heads = iscc_tmp_malloc(sizeof(scc_PointIndex[sizes.edge_array])),
+		.compact_dists1 = (sizes.compact_dists > 0) ? iscc_tmp_malloc(sizeof(float[sizes.compact_dists])) : NULL,
+		.compact_dists2 = (sizes.compact_dists > 0) ? iscc_tmp_malloc(sizeof(float[sizes.compact_dists])) : NULL,
+		.compact_sort_dists = (sizes.compact_dists > 0) ? iscc_tmp_malloc(sizeof(float[sizes.compact_dists])) : NULL,
+		.sample_dists = (sizes.sample_dists > 0) ? iscc_tmp_malloc(sizeof(double[sizes.sample_dists])) : NULL,
+	};
+
+	if ((out_work_area->pointindex_array1 == NULL) || (out_work_area->pointindex_array2 == NULL) ||
+	        (out_work_area->dist_array == NULL) || (out_work_area->vertex_markers == NULL) ||
+	        (out_work_area->edge_heads1 == NULL) || (out_work_area->edge_heads2 == NULL) ||
+	        ((sizes.sort_dists > 0) && (out_work_area->sort_dists == NULL)) || (out_work_area->sort_heads == NULL) ||
+	        ((sizes.compact_dists > 0) && ((out_work_area->compact_dists1 == NULL) ||
+	                                       (out_work_area->compact_dists2 == NULL) ||
+	                                       (out_work_area->compact_sort_dists == NULL))) ||
+	        ((sizes.sample_dists > 0) && (out_work_area->sample_dists == NULL))) {
+		iscc_hi_free_work_area(out_work_area, (vertex_markers == NULL));
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	return iscc_no_error();
+}
+
+
+static void iscc_hi_free_work_area(iscc_hi_WorkArea* const work_area,
+                                   const bool free_vertex_markers)
+{
+	assert(work_area != NULL);
+
+	iscc_free(work_area->pointindex_array1);
+	iscc_free(work_area->pointindex_array2);
+	iscc_free(work_area->dist_array);
+	if (free_vertex_markers) iscc_free(work_area->vertex_markers);
+	iscc_free(work_area->edge_heads1);
+	iscc_free(work_area->edge_heads2);
+	iscc_free(work_area->sort_dists);
+	iscc_free(work_area->sort_heads);
+	iscc_free(work_area->compact_dists1);
+	iscc_free(work_area->compact_dists2);
+	iscc_free(work_area->compact_sort_dists);
+	iscc_free(work_area->sample_dists);
+	*work_area = (iscc_hi_WorkArea) {
+		.compact_edges = false,
+		.pointindex_array1 = NULL,
+		.pointindex_array2 = NULL,
+		.dist_array = NULL,
+		.vertex_markers = NULL,
+		.edge_heads1 = NULL,
+		.edge_heads2 = NULL,
+		.sort_dists = NULL,
+		.sort_heads = NULL,
+		.compact_dists1 = NULL,
+		.compact_dists2 = NULL,
+		.compact_sort_dists = NULL,
+		.sample_dists = NULL,
+	};
+}
+
+
 static scc_ErrorCode iscc_hi_push_to_stack(iscc_hi_ClusterStack* const cl_stack,
                                            iscc_hi_ClusterItem** const cl)
 {
@@ -424,7 +986,7 @@ static scc_ErrorCode iscc_hi_push_to_stack(iscc_hi_ClusterStack* const cl_stack,
 		if ((capacity_tmp > SIZE_MAX) || (capacity_tmp < cl_stack->capacity)) {
 			return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many clusters.");
 		}
-		iscc_hi_ClusterItem* const clusters_tmp = realloc(cl_stack->clusters, sizeof(iscc_hi_ClusterItem[(size_t) capacity_tmp]));
+		iscc_hi_ClusterItem* const clusters_tmp = iscc_realloc(cl_stack->clusters, sizeof(iscc_hi_ClusterItem[(size_t) capacity_tmp]));
 		if (clusters_tmp == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 		cl_stack->clusters = clusters_tmp;
 		cl_stack->capacity = (size_t) capacity_tmp;
@@ -440,9 +1002,34 @@ static scc_ErrorCode iscc_hi_push_to_stack(iscc_hi_ClusterStack* const cl_stack,
 static scc_ErrorCode iscc_hi_break_cluster_into_two(iscc_hi_ClusterItem* const cluster_to_break,
                                                     void* const data_set,
                                                     iscc_hi_WorkArea* const work_area,
-                                                    const uint32_t size_constraint,
-                                                    const bool batch_assign,
+                                                    const scc_HierarchicalOptions* const options,
                                                     iscc_hi_ClusterItem* const out_new_cluster)
+{
+	assert(options != NULL);
+
+	if (options->bisection_method == SCC_BM_SAMPLED_PROJECTION) {
+		return iscc_hi_break_cluster_by_projection(cluster_to_break,
+		                                           data_set,
+		                                           work_area,
+		                                           options,
+		                                           out_new_cluster);
+	}
+
+	return iscc_hi_break_cluster_by_assignment(cluster_to_break,
+	                                           data_set,
+	                                           work_area,
+	                                           options->size_constraint,
+	                                           options->batch_assign,
+	                                           out_new_cluster);
+}
+
+
+static scc_ErrorCode iscc_hi_break_cluster_by_assignment(iscc_hi_ClusterItem* const cluster_to_break,
+                                                         void* const data_set,
+                                                         iscc_hi_WorkArea* const work_area,
+                                                         const uint32_t size_constraint,
+                                                         const bool batch_assign,
+                                                         iscc_hi_ClusterItem* const out_new_cluster)
 {
 	assert(cluster_to_break != NULL);
 	assert(cluster_to_break->size >= 2 * size_constraint);
@@ -452,8 +1039,8 @@ static scc_ErrorCode iscc_hi_break_cluster_into_two(iscc_hi_ClusterItem* const c
 	assert(work_area->pointindex_array1 != NULL);
 	assert(work_area->pointindex_array2 != NULL);
 	assert(work_area->vertex_markers != NULL);
-	assert(work_area->edge_store1 != NULL);
-	assert(work_area->edge_store2 != NULL);
+	assert(work_area->edge_heads1 != NULL);
+	assert(work_area->edge_heads2 != NULL);
 	assert(size_constraint >= 2);
 	assert(out_new_cluster != NULL);
 
@@ -469,27 +1056,27 @@ static scc_ErrorCode iscc_hi_break_cluster_into_two(iscc_hi_ClusterItem* const c
 		return ec;
 	}
 
+	iscc_hi_EdgeList edges1 = ISCC_HI_NULL_EDGE_LIST;
+	iscc_hi_EdgeList edges2 = ISCC_HI_NULL_EDGE_LIST;
 	if ((ec = iscc_hi_populate_edge_lists(cluster_to_break,
 	                                      data_set,
 	                                      center1,
 	                                      center2,
-	                                      work_area)) != SCC_ER_OK) {
+	                                      work_area,
+	                                      &edges1,
+	                                      &edges2)) != SCC_ER_OK) {
 		return ec;
 	}
 
 	scc_PointIndex* const k_nn_array1 = work_area->pointindex_array1;
 	scc_PointIndex* const k_nn_array2 = work_area->pointindex_array2;
-	uint_fast16_t* const vertex_markers = work_area->vertex_markers;
-
-	// `edge_store1` and `edge_store2` have been populated by `iscc_hi_populate_edge_lists`
-	iscc_hi_DistanceEdge* last_assigned_edge1 = work_area->edge_store1;
-	iscc_hi_DistanceEdge* last_assigned_edge2 = work_area->edge_store2;
+	uint16_t* const vertex_markers = work_area->vertex_markers;
 
-	iscc_hi_DistanceEdge* temp_edge1;
-	iscc_hi_DistanceEdge* temp_edge2;
+	size_t temp_edge1;
+	size_t temp_edge2;
 
 	size_t num_unassigned = cluster_to_break->size;
-	const uint_fast16_t curr_marker = iscc_hi_get_next_marker(cluster_to_break, vertex_markers);
+	const uint16_t curr_marker = iscc_hi_get_next_marker(cluster_to_break, vertex_markers);
 
 	*out_new_cluster = (iscc_hi_ClusterItem) {
 		.size = 0,
@@ -504,21 +1091,23 @@ static scc_ErrorCode iscc_hi_break_cluster_into_two(iscc_hi_ClusterItem* const c
 	iscc_hi_move_point_to_cluster1(center1, cluster1, vertex_markers, curr_marker);
 	iscc_hi_move_point_to_cluster2(center2, cluster2, vertex_markers, curr_marker);
 
-	temp_edge1 = iscc_hi_get_next_k_nn(last_assigned_edge1, size_constraint - 1, vertex_markers, curr_marker, k_nn_array1);
-	temp_edge2 = iscc_hi_get_next_k_nn(last_assigned_edge2, size_constraint - 1, vertex_markers, curr_marker, k_nn_array2);
+	temp_edge1 = iscc_hi_get_next_k_nn(&edges1, size_constraint - 1, vertex_markers, curr_marker, k_nn_array1);
+	temp_edge2 = iscc_hi_get_next_k_nn(&edges2, size_constraint - 1, vertex_markers, curr_marker, k_nn_array2);
 
-	if (temp_edge1->distance >= temp_edge2->distance) {
+	if (iscc_hi_get_edge_dist(&edges1, temp_edge1) >= iscc_hi_get_edge_dist(&edges2, temp_edge2)) {
 		iscc_hi_move_array_to_cluster1(size_constraint - 1, k_nn_array1, cluster1, vertex_markers, curr_marker);
-		last_assigned_edge1 = temp_edge1;
+		edges1.next = temp_edge1 + 1;
 
-		last_assigned_edge2 = iscc_hi_get_next_k_nn(last_assigned_edge2, size_constraint - 1, vertex_markers, curr_marker, k_nn_array2);
+		temp_edge2 = iscc_hi_get_next_k_nn(&edges2, size_constraint - 1, vertex_markers, curr_marker, k_nn_array2);
 		iscc_hi_move_array_to_cluster2(size_constraint - 1, k_nn_array2, cluster2, vertex_markers, curr_marker);
+		edges2.next = temp_edge2 + 1;
 	} else {
 		iscc_hi_move_array_to_cluster2(size_constraint - 1, k_nn_array2, cluster2, vertex_markers, curr_marker);
-		last_assigned_edge2 = temp_edge2;
+		edges2.next = temp_edge2 + 1;
 
-		last_assigned_edge1 = iscc_hi_get_next_k_nn(last_assigned_edge1, size_constraint - 1, vertex_markers, curr_marker, k_nn_array1);
+		temp_edge1 = iscc_hi_get_next_k_nn(&edges1, size_constraint - 1, vertex_markers, curr_marker, k_nn_array1);
 		iscc_hi_move_array_to_cluster1(size_constraint - 1, k_nn_array1, cluster1, vertex_markers, curr_marker);
+		edges1.next = temp_edge1 + 1;
 	}
 
 	assert((cluster1->size == size_constraint) && (cluster2->size == size_constraint));
@@ -531,29 +1120,29 @@ static scc_ErrorCode iscc_hi_break_cluster_into_two(iscc_hi_ClusterItem* const c
 
 			if (num_assign_in_batch > num_unassigned) num_assign_in_batch = (uint32_t) num_unassigned;
 
-			temp_edge1 = iscc_hi_get_next_k_nn(last_assigned_edge1, num_assign_in_batch, vertex_markers, curr_marker, k_nn_array1);
-			temp_edge2 = iscc_hi_get_next_k_nn(last_assigned_edge2, num_assign_in_batch, vertex_markers, curr_marker, k_nn_array2);
+			temp_edge1 = iscc_hi_get_next_k_nn(&edges1, num_assign_in_batch, vertex_markers, curr_marker, k_nn_array1);
+			temp_edge2 = iscc_hi_get_next_k_nn(&edges2, num_assign_in_batch, vertex_markers, curr_marker, k_nn_array2);
 
-			if (temp_edge1->distance <= temp_edge2->distance) {
+			if (iscc_hi_get_edge_dist(&edges1, temp_edge1) <= iscc_hi_get_edge_dist(&edges2, temp_edge2)) {
 				iscc_hi_move_array_to_cluster1(num_assign_in_batch, k_nn_array1, cluster1, vertex_markers, curr_marker);
-				last_assigned_edge1 = temp_edge1;
+				edges1.next = temp_edge1 + 1;
 			} else {
 				iscc_hi_move_array_to_cluster2(num_assign_in_batch, k_nn_array2, cluster2, vertex_markers, curr_marker);
-				last_assigned_edge2 = temp_edge2;
+				edges2.next = temp_edge2 + 1;
 			}
 		}
 
 	} else {
 		for (; num_unassigned > 0; --num_unassigned) {
-			temp_edge1 = iscc_hi_get_next_dist(last_assigned_edge1, vertex_markers, curr_marker);
-			temp_edge2 = iscc_hi_get_next_dist(last_assigned_edge2, vertex_markers, curr_marker);
+			temp_edge1 = iscc_hi_get_next_dist(&edges1, vertex_markers, curr_marker);
+			temp_edge2 = iscc_hi_get_next_dist(&edges2, vertex_markers, curr_marker);
 
-			if (temp_edge1->distance <= temp_edge2->distance) {
-				iscc_hi_move_point_to_cluster1(temp_edge1->head, cluster1, vertex_markers, curr_marker);
-				last_assigned_edge1 = temp_edge1;
+			if (iscc_hi_get_edge_dist(&edges1, temp_edge1) <= iscc_hi_get_edge_dist(&edges2, temp_edge2)) {
+				iscc_hi_move_point_to_cluster1(edges1.heads[temp_edge1], cluster1, vertex_markers, curr_marker);
+				edges1.next = temp_edge1 + 1;
 			} else {
-				iscc_hi_move_point_to_cluster2(temp_edge2->head, cluster2, vertex_markers, curr_marker);
-				last_assigned_edge2 = temp_edge2;
+				iscc_hi_move_point_to_cluster2(edges2.heads[temp_edge2], cluster2, vertex_markers, curr_marker);
+				edges2.next = temp_edge2 + 1;
 			}
 		}
 	}
@@ -567,15 +1156,139 @@ static scc_ErrorCode iscc_hi_break_cluster_into_two(iscc_hi_ClusterItem* const c
 }
 
 
-static inline uint_fast16_t iscc_hi_get_next_marker(iscc_hi_ClusterItem* const cl,
-                                                    uint_fast16_t vertex_markers[const])
+static scc_ErrorCode iscc_hi_break_cluster_by_projection(iscc_hi_ClusterItem* const cluster_to_break,
+                                                         void* const data_set,
+                                                         iscc_hi_WorkArea* const work_area,
+                                                         const scc_HierarchicalOptions* const options,
+                                                         iscc_hi_ClusterItem* const out_new_cluster)
+{
+	assert(cluster_to_break != NULL);
+	assert(options != NULL);
+	assert(options->size_constraint >= 2);
+	assert(cluster_to_break->size >= 2 * options->size_constraint);
+	assert(cluster_to_break->members != NULL);
+	assert(iscc_check_data_set(data_set));
+	assert(work_area != NULL);
+	assert(work_area->dist_array != NULL);
+	assert(work_area->edge_heads1 != NULL);
+	assert(work_area->sort_heads != NULL);
+	assert(out_new_cluster != NULL);
+
+	const size_t size = cluster_to_break->size;
+	const size_t size_constraint = options->size_constraint;
+	scc_PointIndex* const members = cluster_to_break->members;
+
+	scc_ErrorCode ec;
+	scc_PointIndex center1 = ISCC_POINTINDEX_MAX_PI, center2 = ISCC_POINTINDEX_MAX_PI; // Initialize these to avoid gcc warning
+	if ((ec = iscc_hi_find_sampled_centers(cluster_to_break,
+	                                       data_set,
+	                                       options->bisection_sample_size,
+	                                       work_area,
+	                                       &center1,
+	                                       &center2)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	// With Euclidean distances, `d1^2 - d2^2` is an affine function of the
+	// projection onto the line from `center1` to `center2`
+	double* const row_dists = work_area->dist_array;
+	const scc_PointIndex query_indices[2] = { center1, center2 };
+	scc_PointIndex* const sorted_members = work_area->edge_heads1;
+	size_t num_closer1 = 0;
+	size_t num_ties = 0;
+	if (work_area->compact_edges) {
+		float* const projections = work_area->compact_dists1;
+		for (size_t offset = 0; offset < size; offset += ISCC_HI_COMPACT_CHUNK_SIZE) {
+			const size_t len_chunk = ((size - offset) < ISCC_HI_COMPACT_CHUNK_SIZE) ? (size - offset) : ISCC_HI_COMPACT_CHUNK_SIZE;
+			if (!iscc_get_dist_rows(data_set,
+			                        2,
+			                        query_indices,
+			                        len_chunk,
+			                        members + offset,
+			                        row_dists)) {
+				return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+			}
+
+			const double* const row_dists2 = row_dists + len_chunk;
+			for (size_t i = 0; i < len_chunk; ++i) {
+				// Classify after rounding so the counts agree with the sorted order
+				const float projection = (float) (row_dists[i] * row_dists[i] - row_dists2[i] * row_dists2[i]);
+				projections[offset + i] = projection;
+				sorted_members[offset + i] = members[offset + i];
+				if (projection < 0.0f) {
+					++num_closer1;
+				} else if (projection == 0.0f) {
+					++num_ties;
+				}
+			}
+		}
+
+		iscc_hi_sort_compact_edges(size, projections, sorted_members, work_area->compact_sort_dists, work_area->sort_heads);
+
+	} else {
+		if (!iscc_get_dist_rows(data_set,
+		                        2,
+		                        query_indices,
+		                        size,
+		                        members,
+		                        row_dists)) {
+			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+		}
+
+		double* const projections = row_dists;
+		const double* const row_dists2 = row_dists + size;
+		for (size_t i = 0; i < size; ++i) {
+			projections[i] = row_dists[i] * row_dists[i] - row_dists2[i] * row_dists2[i];
+			sorted_members[i] = members[i];
+			if (projections[i] < 0.0) {
+				++num_closer1;
+			} else if (projections[i] == 0.0) {
+				++num_ties;
+			}
+		}
+
+		iscc_hi_sort_edges(size, projections, sorted_members, work_area->sort_dists, work_area->sort_heads);
+	}
+
+	// Split points equidistant to the centers evenly, so clusters of identical
+	// points are halved rather than broken one size constraint at a time
+	size_t split = num_closer1 + num_ties / 2;
+
+	if (options->batch_assign) {
+		split = size_constraint * ((split + size_constraint / 2) / size_constraint);
+	}
+	if (split < size_constraint) split = size_constraint;
+	if (split > size - size_constraint) split = size - size_constraint;
+
+	for (size_t i = 0; i < size; ++i) {
+		members[i] = sorted_members[i];
+	}
+
+	// Markers of the members are not changed, so both clusters keep the old marker
+	*out_new_cluster = (iscc_hi_ClusterItem) {
+		.size = size - split,
+		.marker = cluster_to_break->marker,
+		.members = members + split,
+	};
+	cluster_to_break->size = split;
+
+	assert(cluster_to_break->size >= size_constraint);
+	assert(out_new_cluster->size >= size_constraint);
+	assert(cluster_to_break->members + cluster_to_break->size == out_new_cluster->members);
+
+	return iscc_no_error();
+}
+
+
+static inline uint16_t iscc_hi_get_next_marker(iscc_hi_ClusterItem* const cl,
+                                                    uint16_t vertex_markers[const])
 {
 	assert(cl != NULL);
 	assert(cl->size > 0);
 	assert(cl->members != NULL);
 	assert(vertex_markers != NULL);
 
-	if (cl->marker == UINT_FAST16_MAX) {
+	if (cl->marker == UINT16_MAX) {
 		cl->marker = 0;
 		for (size_t i = 0; i < cl->size; ++i) {
 			vertex_markers[cl->members[i]] = 0;
@@ -587,49 +1300,90 @@ static inline uint_fast16_t iscc_hi_get_next_marker(iscc_hi_ClusterItem* const c
 }
 
 
-static inline iscc_hi_DistanceEdge* iscc_hi_get_next_k_nn(iscc_hi_DistanceEdge* prev_dist,
-                                                          const uint32_t k,
-                                                          const uint_fast16_t vertex_markers[const],
-                                                          const uint_fast16_t curr_marker,
-                                                          scc_PointIndex out_dist_array[const static k])
+static inline double iscc_hi_get_edge_dist(const iscc_hi_EdgeList* const edge_list,
+                                           const size_t index)
+{
+	assert(edge_list != NULL);
+	assert(index < edge_list->len);
+	assert((edge_list->dists == NULL) != (edge_list->compact_dists == NULL));
+
+	if (edge_list->dists != NULL) return edge_list->dists[index];
+	return (double) edge_list->compact_dists[index];
+}
+
+
+static inline size_t iscc_hi_get_next_k_nn(iscc_hi_EdgeList* const edge_list,
+                                           const uint32_t k,
+                                           const uint16_t vertex_markers[const],
+                                           const uint16_t curr_marker,
+                                           scc_PointIndex out_dist_array[const static k])
 {
-	assert(prev_dist != NULL);
-	assert(prev_dist->next_dist != NULL); // We should never reach the end!
+	assert(edge_list != NULL);
+	assert(edge_list->next < edge_list->len); // We should never reach the end!
 	assert(k > 0);
 	assert(vertex_markers != NULL);
 	assert(out_dist_array != NULL);
 
-	for (uint32_t found = 0; found < k; ++found) {
-		prev_dist = iscc_hi_get_next_dist(prev_dist, vertex_markers, curr_marker);
-		out_dist_array[found] = prev_dist->head;
+	scc_PointIndex* const heads = edge_list->heads;
+	size_t read = edge_list->next;
+	bool skipped = false;
+	for (uint32_t found = 0; found < k; ++read) {
+		assert(read < edge_list->len); // We should never reach the end!
+		if (vertex_markers[heads[read]] == curr_marker) {
+			// Vertex has already been assigned to a new cluster, skip it
+			skipped = true;
+		} else {
+			out_dist_array[found] = heads[read];
+			++found;
+		}
+	}
+
+	if (skipped) {
+		// Move the unassigned entries up to the k-th one, so skipped
+		// entries are not visited again
+		double* const dists = edge_list->dists;
+		float* const compact_dists = edge_list->compact_dists;
+		size_t write = read;
+		for (size_t i = read; i > edge_list->next; --i) {
+			if (vertex_markers[heads[i - 1]] != curr_marker) {
+				--write;
+				heads[write] = heads[i - 1];
+				if (dists != NULL) {
+					dists[write] = dists[i - 1];
+				} else {
+					compact_dists[write] = compact_dists[i - 1];
+				}
+			}
+		}
+		edge_list->next = write;
 	}
 
-	return prev_dist;
+	return read - 1;
 }
 
 
-static inline iscc_hi_DistanceEdge* iscc_hi_get_next_dist(iscc_hi_DistanceEdge* const prev_dist,
-                                                          const uint_fast16_t vertex_markers[const],
-                                                          const uint_fast16_t curr_marker)
+static inline size_t iscc_hi_get_next_dist(iscc_hi_EdgeList* const edge_list,
+                                           const uint16_t vertex_markers[const],
+                                           const uint16_t curr_marker)
 {
-	assert(prev_dist != NULL);
-	assert(prev_dist->next_dist != NULL); // We should never reach the end!
+	assert(edge_list != NULL);
+	assert(edge_list->next < edge_list->len); // We should never reach the end!
 	assert(vertex_markers != NULL);
 
-	while(vertex_markers[prev_dist->next_dist->head] == curr_marker) {
+	while (vertex_markers[edge_list->heads[edge_list->next]] == curr_marker) {
 		// Vertex has already been assigned to a new cluster, skip it
-		prev_dist->next_dist = prev_dist->next_dist->next_dist;
-		assert(prev_dist->next_dist != NULL); // We should never reach the end!
+		++(edge_list->next);
+		assert(edge_list->next < edge_list->len); // We should never reach the end!
 	}
 
-	return prev_dist->next_dist;
+	return edge_list->next;
 }
 
 
 static inline void iscc_hi_move_point_to_cluster1(const scc_PointIndex id,
                                                   iscc_hi_ClusterItem* const cl,
-                                                  uint_fast16_t vertex_markers[const],
-                                                  const uint_fast16_t curr_marker)
+                                                  uint16_t vertex_markers[const],
+                                                  const uint16_t curr_marker)
 {
 	assert(cl != NULL);
 	assert(cl->members != NULL);
@@ -645,8 +1399,8 @@ static inline void iscc_hi_move_point_to_cluster1(const scc_PointIndex id,
 
 static inline void iscc_hi_move_point_to_cluster2(const scc_PointIndex id,
                                                   iscc_hi_ClusterItem* const cl,
-                                                  uint_fast16_t vertex_markers[const],
-                                                  const uint_fast16_t curr_marker)
+                                                  uint16_t vertex_markers[const],
+                                                  const uint16_t curr_marker)
 {
 	assert(cl != NULL);
 	assert(cl->members != NULL);
@@ -664,8 +1418,8 @@ static inline void iscc_hi_move_point_to_cluster2(const scc_PointIndex id,
 static inline void iscc_hi_move_array_to_cluster1(const uint32_t len_ids,
                                                   const scc_PointIndex ids[static len_ids],
                                                   iscc_hi_ClusterItem* const cl,
-                                                  uint_fast16_t vertex_markers[const],
-                                                  const uint_fast16_t curr_marker)
+                                                  uint16_t vertex_markers[const],
+                                                  const uint16_t curr_marker)
 {
 	assert(len_ids > 0);
 	assert(ids != NULL);
@@ -689,8 +1443,8 @@ static inline void iscc_hi_move_array_to_cluster1(const uint32_t len_ids,
 static inline void iscc_hi_move_array_to_cluster2(const uint32_t len_ids,
                                                   const scc_PointIndex ids[static len_ids],
                                                   iscc_hi_ClusterItem* const cl,
-                                                  uint_fast16_t vertex_markers[const],
-                                                  const uint_fast16_t curr_marker)
+                                                  uint16_t vertex_markers[const],
+                                                  const uint16_t curr_marker)
 {
 	assert(len_ids > 0);
 	assert(ids != NULL);
@@ -732,9 +1486,9 @@ static scc_ErrorCode iscc_hi_find_centers(iscc_hi_ClusterItem* const cl,
 	scc_PointIndex* const to_check = work_area->pointindex_array1;
 	scc_PointIndex* const max_indices = work_area->pointindex_array2;
 	double* const max_dists = work_area->dist_array;
-	uint_fast16_t* const vertex_markers = work_area->vertex_markers;
+	uint16_t* const vertex_markers = work_area->vertex_markers;
 
-	const uint_fast16_t curr_marker = iscc_hi_get_next_marker(cl, vertex_markers);
+	const uint16_t curr_marker = iscc_hi_get_next_marker(cl, vertex_markers);
 
 	size_t step = cl->size / ISCC_HI_NUM_TO_CHECK;
 	if (step < 2) step = 2;
@@ -786,11 +1540,64 @@ static scc_ErrorCode iscc_hi_find_centers(iscc_hi_ClusterItem* const cl,
 }
 
 
+static scc_ErrorCode iscc_hi_find_sampled_centers(const iscc_hi_ClusterItem* const cl,
+                                                  void* const data_set,
+                                                  const uint32_t sample_size,
+                                                  iscc_hi_WorkArea* const work_area,
+                                                  scc_PointIndex* const out_center1,
+                                                  scc_PointIndex* const out_center2)
+{
+	assert(cl != NULL);
+	assert(cl->size >= 4);
+	assert(cl->members != NULL);
+	assert(iscc_check_data_set(data_set));
+	assert(sample_size >= 2);
+	assert(work_area != NULL);
+	assert(work_area->pointindex_array1 != NULL);
+	assert(work_area->sample_dists != NULL);
+	assert(out_center1 != NULL);
+	assert(out_center2 != NULL);
+
+	scc_PointIndex* const sample = work_area->pointindex_array1;
+	double* const sample_dists = work_area->sample_dists;
+
+	// Evenly spaced members, as in `iscc_hi_find_centers`
+	const size_t num_sample = (sample_size < cl->size) ? sample_size : cl->size;
+	const size_t step = cl->size / num_sample;
+	for (size_t i = 0; i < num_sample; ++i) {
+		sample[i] = cl->members[i * step];
+	}
+
+	if (!iscc_get_dist_matrix(data_set, num_sample, sample, sample_dists)) {
+		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	}
+
+	// `sample_dists` is the upper triangle of the distance matrix in row-major order
+	double max_dist = -1.0;
+	const double* dist = sample_dists;
+	for (size_t i = 0; i < num_sample; ++i) {
+		for (size_t j = i + 1; j < num_sample; ++j, ++dist) {
+			if (*dist > max_dist) {
+				max_dist = *dist;
+				*out_center1 = sample[i];
+				*out_center2 = sample[j];
+			}
+		}
+	}
+
+	assert(*out_center1 != *out_center2);
+
+	return iscc_no_error();
+}
+
+
 static scc_ErrorCode iscc_hi_populate_edge_lists(const iscc_hi_ClusterItem* const cl,
                                                  void* const data_set,
                                                  const scc_PointIndex center1,
                                                  const scc_PointIndex center2,
-                                                 iscc_hi_WorkArea* const work_area)
+                                                 iscc_hi_WorkArea* const work_area,
+                                                 iscc_hi_EdgeList* const out_edge_list1,
+                                                 iscc_hi_EdgeList* const out_edge_list2)
 {
 	assert(cl != NULL);
 	assert(cl->size >= 4);
@@ -799,8 +1606,20 @@ static scc_ErrorCode iscc_hi_populate_edge_lists(const iscc_hi_ClusterItem* cons
 	assert(iscc_check_data_set(data_set));
 	assert(work_area != NULL);
 	assert(work_area->dist_array != NULL);
-	assert(work_area->edge_store1 != NULL);
-	assert(work_area->edge_store2 != NULL);
+	assert(work_area->edge_heads1 != NULL);
+	assert(work_area->edge_heads2 != NULL);
+	assert(out_edge_list1 != NULL);
+	assert(out_edge_list2 != NULL);
+
+	if (work_area->compact_edges) {
+		return iscc_hi_populate_compact_edge_lists(cl,
+		                                           data_set,
+		                                           center1,
+		                                           center2,
+		                                           work_area,
+		                                           out_edge_list1,
+		                                           out_edge_list2);
+	}
 
 	double* const row_dists = work_area->dist_array;
 	const scc_PointIndex query_indices[2] = { center1, center2 };
@@ -814,8 +1633,9 @@ static scc_ErrorCode iscc_hi_populate_edge_lists(const iscc_hi_ClusterItem* cons
 		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 	}
 
-	iscc_hi_sort_edge_list(cl, center1, row_dists, work_area->edge_store1);
-	iscc_hi_sort_edge_list(cl, center2, row_dists + cl->size, work_area->edge_store2);
+	// The edge lists use the distance rows as their distance arrays
+	iscc_hi_sort_edge_list(cl, center1, row_dists, work_area->edge_heads1, work_area, out_edge_list1);
+	iscc_hi_sort_edge_list(cl, center2, row_dists + cl->size, work_area->edge_heads2, work_area, out_edge_list2);
 
 	return iscc_no_error();
 }
@@ -823,42 +1643,119 @@ static scc_ErrorCode iscc_hi_populate_edge_lists(const iscc_hi_ClusterItem* cons
 
 static inline void iscc_hi_sort_edge_list(const iscc_hi_ClusterItem* const cl,
                                           const scc_PointIndex center,
-                                          const double row_dists[const static cl->size],
-                                          iscc_hi_DistanceEdge edge_store[const static cl->size])
+                                          double row_dists[const static cl->size],
+                                          scc_PointIndex edge_heads[const static cl->size],
+                                          iscc_hi_WorkArea* const work_area,
+                                          iscc_hi_EdgeList* const out_edge_list)
 {
 	assert(cl != NULL);
 	assert(cl->size >= 4);
 	assert(cl->members != NULL);
 	assert(row_dists != NULL);
-	assert(edge_store != NULL);
+	assert(edge_heads != NULL);
+	assert(work_area != NULL);
+	assert(work_area->sort_dists != NULL);
+	assert(work_area->sort_heads != NULL);
+	assert(out_edge_list != NULL);
 
-	iscc_hi_DistanceEdge* write_edge = edge_store + 1;
+	size_t write = 0;
 	for (size_t i = 0; i < cl->size; ++i) {
 		if (cl->members[i] == center) continue;
-		write_edge->head = cl->members[i];
-		write_edge->distance = row_dists[i];
-		++write_edge;
+		edge_heads[write] = cl->members[i];
+		row_dists[write] = row_dists[i];
+		++write;
 	}
 
-	assert(write_edge == (edge_store + cl->size));
+	assert(write == cl->size - 1);
 
-	qsort(edge_store + 1, cl->size - 1, sizeof(iscc_hi_DistanceEdge), iscc_hi_compare_dist_edges);
+	iscc_hi_sort_edges(write, row_dists, edge_heads, work_area->sort_dists, work_area->sort_heads);
 
-	iscc_hi_DistanceEdge* const edge_stop = edge_store + cl->size - 1;
-	for (iscc_hi_DistanceEdge* edge = edge_store; edge != edge_stop; ++edge) {
-		edge->next_dist = edge + 1;
-	}
-	edge_stop->next_dist = NULL;
+	*out_edge_list = (iscc_hi_EdgeList) {
+		.next = 0,
+		.len = write,
+		.heads = edge_heads,
+		.dists = row_dists,
+		.compact_dists = NULL,
+	};
 }
 
 
-static int iscc_hi_compare_dist_edges(const void* const a,
-                                      const void* const b)
+static scc_ErrorCode iscc_hi_populate_compact_edge_lists(const iscc_hi_ClusterItem* const cl,
+                                                         void* const data_set,
+                                                         const scc_PointIndex center1,
+                                                         const scc_PointIndex center2,
+                                                         iscc_hi_WorkArea* const work_area,
+                                                         iscc_hi_EdgeList* const out_edge_list1,
+                                                         iscc_hi_EdgeList* const out_edge_list2)
 {
-	const double dist_a = ((const iscc_hi_DistanceEdge*)a)->distance;
-	const double dist_b = ((const iscc_hi_DistanceEdge*)b)->distance;
+	assert(cl != NULL);
+	assert(cl->size >= 4);
+	assert(cl->members != NULL);
+	assert(center1 != center2);
+	assert(iscc_check_data_set(data_set));
+	assert(work_area != NULL);
+	assert(work_area->compact_edges);
+	assert(work_area->dist_array != NULL);
+	assert(work_area->compact_dists1 != NULL);
+	assert(work_area->compact_dists2 != NULL);
+	assert(out_edge_list1 != NULL);
+	assert(out_edge_list2 != NULL);
 
-	if (dist_a < dist_b) return -1;
-	if (dist_a > dist_b) return 1;
-	return 0;
+	double* const chunk_dists = work_area->dist_array;
+	const scc_PointIndex query_indices[2] = { center1, center2 };
+	scc_PointIndex* const edge_heads1 = work_area->edge_heads1;
+	scc_PointIndex* const edge_heads2 = work_area->edge_heads2;
+	float* const edge_dists1 = work_area->compact_dists1;
+	float* const edge_dists2 = work_area->compact_dists2;
+
+	size_t write1 = 0;
+	size_t write2 = 0;
+	for (size_t offset = 0; offset < cl->size; offset += ISCC_HI_COMPACT_CHUNK_SIZE) {
+		const size_t len_chunk = ((cl->size - offset) < ISCC_HI_COMPACT_CHUNK_SIZE) ? (cl->size - offset) : ISCC_HI_COMPACT_CHUNK_SIZE;
+		if (!iscc_get_dist_rows(data_set,
+		                        2,
+		                        query_indices,
+		                        len_chunk,
+		                        cl->members + offset,
+		                        chunk_dists)) {
+			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+		}
+
+		for (size_t i = 0; i < len_chunk; ++i) {
+			const scc_PointIndex member = cl->members[offset + i];
+			if (member != center1) {
+				edge_heads1[write1] = member;
+				edge_dists1[write1] = (float) chunk_dists[i];
+				++write1;
+			}
+			if (member != center2) {
+				edge_heads2[write2] = member;
+				edge_dists2[write2] = (float) chunk_dists[len_chunk + i];
+				++write2;
+			}
+		}
+	}
+
+	assert(write1 == cl->size - 1);
+	assert(write2 == cl->size - 1);
+
+	iscc_hi_sort_compact_edges(write1, edge_dists1, edge_heads1, work_area->compact_sort_dists, work_area->sort_heads);
+	iscc_hi_sort_compact_edges(write2, edge_dists2, edge_heads2, work_area->compact_sort_dists, work_area->sort_heads);
+
+	*out_edge_list1 = (iscc_hi_EdgeList) {
+		.next = 0,
+		.len = write1,
+		.heads = edge_heads1,
+		.dists = NULL,
+		.compact_dists = edge_dists1,
+	};
+	*out_edge_list2 = (iscc_hi_EdgeList) {
+		.next = 0,
+		.len = write2,
+		.heads = edge_heads2,
+		.dists = NULL,
+		.compact_dists = edge_dists2,
+	};
+
+	return iscc_no_error();
 }
@@ -0,0 +1,255 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "hierarchical_sort.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "../include/scclust.h"
+
+
+// =============================================================================
+// Internal variables
+// =============================================================================
+
+// Edge lists shorter than this are sorted with insertion sort.
+static const size_t ISCC_HI_MIN_RADIX_SORT = 64;
+
+#define ISCC_HI_RADIX_BITS 8
+#define ISCC_HI_RADIX_BUCKETS (1 << ISCC_HI_RADIX_BITS)
+#define ISCC_HI_RADIX_PASSES (64 / ISCC_HI_RADIX_BITS)
+#define ISCC_HI_COMPACT_RADIX_PASSES (32 / ISCC_HI_RADIX_BITS)
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static inline uint64_t iscc_hi_get_sort_key(double distance);
+
+
+static inline uint32_t iscc_hi_get_compact_sort_key(float distance);
+
+
+static void iscc_hi_insertion_sort_edges(size_t len_edges,
+                                         double dists[],
+                                         scc_PointIndex heads[]);
+
+
+static void iscc_hi_insertion_sort_compact_edges(size_t len_edges,
+                                                 float dists[],
+                                                 scc_PointIndex heads[]);
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+void iscc_hi_sort_edges(const size_t len_edges,
+                        double dists[const],
+                        scc_PointIndex heads[const],
+                        double scratch_dists[const],
+                        scc_PointIndex scratch_heads[const])
+{
+	assert((len_edges == 0) || ((dists != NULL) && (heads != NULL)));
+	assert((len_edges == 0) || ((scratch_dists != NULL) && (scratch_heads != NULL)));
+
+	if (len_edges < ISCC_HI_MIN_RADIX_SORT) {
+		iscc_hi_insertion_sort_edges(len_edges, dists, heads);
+		return;
+	}
+
+	// Histograms for all digits in one pass over the keys
+	size_t counts[ISCC_HI_RADIX_PASSES][ISCC_HI_RADIX_BUCKETS];
+	memset(counts, 0, sizeof(counts));
+	for (size_t i = 0; i < len_edges; ++i) {
+		const uint64_t key = iscc_hi_get_sort_key(dists[i]);
+		for (size_t p = 0; p < ISCC_HI_RADIX_PASSES; ++p) {
+			++counts[p][(key >> (p * ISCC_HI_RADIX_BITS)) & (ISCC_HI_RADIX_BUCKETS - 1)];
+		}
+	}
+
+	double* from_dists = dists;
+	scc_PointIndex* from_heads = heads;
+	double* to_dists = scratch_dists;
+	scc_PointIndex* to_heads = scratch_heads;
+	for (size_t p = 0; p < ISCC_HI_RADIX_PASSES; ++p) {
+		const unsigned int shift = (unsigned int) (p * ISCC_HI_RADIX_BITS);
+
+		// Skip digits that are the same for all keys, e.g., the exponent
+		// bits when distances are of similar magnitude
+		if (counts[p][(iscc_hi_get_sort_key(from_dists[0]) >> shift) & (ISCC_HI_RADIX_BUCKETS - 1)] == len_edges) {
+			continue;
+		}
+
+		size_t offset = 0;
+		for (size_t b = 0; b < ISCC_HI_RADIX_BUCKETS; ++b) {
+			const size_t tmp_count = counts[p][b];
+			counts[p][b] = offset;
+			offset += tmp_count;
+		}
+
+		for (size_t i = 0; i < len_edges; ++i) {
+			const size_t bucket = (iscc_hi_get_sort_key(from_dists[i]) >> shift) & (ISCC_HI_RADIX_BUCKETS - 1);
+			to_dists[counts[p][bucket]] = from_dists[i];
+			to_heads[counts[p][bucket]] = from_heads[i];
+			++counts[p][bucket];
+		}
+
+		double* const tmp_dists = from_dists;
+		from_dists = to_dists;
+		to_dists = tmp_dists;
+		scc_PointIndex* const tmp_heads = from_heads;
+		from_heads = to_heads;
+		to_heads = tmp_heads;
+	}
+
+	if (from_dists != dists) {
+		memcpy(dists, from_dists, sizeof(double[len_edges]));
+		memcpy(heads, from_heads, sizeof(scc_PointIndex[len_edges]));
+	}
+}
+
+
+void iscc_hi_sort_compact_edges(const size_t len_edges,
+                                float dists[const],
+                                scc_PointIndex heads[const],
+                                float scratch_dists[const],
+                                scc_PointIndex scratch_heads[const])
+{
+	assert((len_edges == 0) || ((dists != NULL) && (heads != NULL)));
+	assert((len_edges == 0) || ((scratch_dists != NULL) && (scratch_heads != NULL)));
+
+	if (len_edges < ISCC_HI_MIN_RADIX_SORT) {
+		iscc_hi_insertion_sort_compact_edges(len_edges, dists, heads);
+		return;
+	}
+
+	size_t counts[ISCC_HI_COMPACT_RADIX_PASSES][ISCC_HI_RADIX_BUCKETS];
+	memset(counts, 0, sizeof(counts));
+	for (size_t i = 0; i < len_edges; ++i) {
+		const uint32_t key = iscc_hi_get_compact_sort_key(dists[i]);
+		for (size_t p = 0; p < ISCC_HI_COMPACT_RADIX_PASSES; ++p) {
+			++counts[p][(key >> (p * ISCC_HI_RADIX_BITS)) & (ISCC_HI_RADIX_BUCKETS - 1)];
+		}
+	}
+
+	float* from_dists = dists;
+	scc_PointIndex* from_heads = heads;
+	float* to_dists = scratch_dists;
+	scc_PointIndex* to_heads = scratch_heads;
+	for (size_t p = 0; p < ISCC_HI_COMPACT_RADIX_PASSES; ++p) {
+		const unsigned int shift = (unsigned int) (p * ISCC_HI_RADIX_BITS);
+
+		if (counts[p][(iscc_hi_get_compact_sort_key(from_dists[0]) >> shift) & (ISCC_HI_RADIX_BUCKETS - 1)] == len_edges) {
+			continue;
+		}
+
+		size_t offset = 0;
+		for (size_t b = 0; b < ISCC_HI_RADIX_BUCKETS; ++b) {
+			const size_t tmp_count = counts[p][b];
+			counts[p][b] = offset;
+			offset += tmp_count;
+		}
+
+		for (size_t i = 0; i < len_edges; ++i) {
+			const size_t bucket = (iscc_hi_get_compact_sort_key(from_dists[i]) >> shift) & (ISCC_HI_RADIX_BUCKETS - 1);
+			to_dists[counts[p][bucket]] = from_dists[i];
+			to_heads[counts[p][bucket]] = from_heads[i];
+			++counts[p][bucket];
+		}
+
+		float* const tmp_dists = from_dists;
+		from_dists = to_dists;
+		to_dists = tmp_dists;
+		scc_PointIndex* const tmp_heads = from_heads;
+		from_heads = to_heads;
+		to_heads = tmp_heads;
+	}
+
+	if (from_dists != dists) {
+		memcpy(dists, from_dists, sizeof(float[len_edges]));
+		memcpy(heads, from_heads, sizeof(scc_PointIndex[len_edges]));
+	}
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static inline uint64_t iscc_hi_get_sort_key(double distance)
+{
+	// Map the bit pattern to an unsigned integer with the same order. Zeros are
+	// normalized so that -0.0 and 0.0 compare equal.
+	if (distance == 0.0) distance = 0.0;
+	uint64_t bits;
+	memcpy(&bits, &distance, sizeof(bits));
+	const uint64_t sign_bit = UINT64_C(1) << 63;
+	return (bits & sign_bit) ? ~bits : (bits | sign_bit);
+}
+
+
+static inline uint32_t iscc_hi_get_compact_sort_key(float distance)
+{
+	if (distance == 0.0f) distance = 0.0f;
+	uint32_t bits;
+	memcpy(&bits, &distance, sizeof(bits));
+	const uint32_t sign_bit = UINT32_C(1) << 31;
+	return (bits & sign_bit) ? ~bits : (bits | sign_bit);
+}
+
+
+static void iscc_hi_insertion_sort_edges(const size_t len_edges,
+                                         double dists[const],
+                                         scc_PointIndex heads[const])
+{
+	for (size_t i = 1; i < len_edges; ++i) {
+		const double tmp_dist = dists[i];
+		const scc_PointIndex tmp_head = heads[i];
+		size_t j = i;
+		for (; (j > 0) && (dists[j - 1] > tmp_dist); --j) {
+			dists[j] = dists[j - 1];
+			heads[j] = heads[j - 1];
+		}
+		dists[j] = tmp_dist;
+		heads[j] = tmp_head;
+	}
+}
+
+
+static void iscc_hi_insertion_sort_compact_edges(const size_t len_edges,
+                                                 float dists[const],
+                                                 scc_PointIndex heads[const])
+{
+	for (size_t i = 1; i < len_edges; ++i) {
+		const float tmp_dist = dists[i];
+		const scc_PointIndex tmp_head = heads[i];
+		size_t j = i;
+		for (; (j > 0) && (dists[j - 1] > tmp_dist); --j) {
+			dists[j] = dists[j - 1];
+			heads[j] = heads[j - 1];
+		}
+		dists[j] = tmp_dist;
+		heads[j] = tmp_head;
+	}
+}
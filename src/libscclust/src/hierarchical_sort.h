@@ -0,0 +1,80 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+/** @file
+ *
+ * Sorting of distance edges in hierarchical clustering.
+ *
+ * Edges are stored as separate arrays of distances and heads. They are sorted
+ * by distance with a least significant digit radix sort on the bit patterns of
+ * the distances. The sort is stable, so edges with equal distance keep their
+ * input order. Compact edges use single precision distances and are sorted
+ * the same way.
+ */
+
+#ifndef SCC_HIERARCHICAL_SORT_HG
+#define SCC_HIERARCHICAL_SORT_HG
+
+#include <stddef.h>
+#include "../include/scclust.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// =============================================================================
+// Function prototypes
+// =============================================================================
+
+/** Sort edges by distance.
+ *
+ *  Sorts the edges given by `dists` and `heads` in ascending order of distance.
+ *  Edges with equal distance keep their relative order.
+ *
+ *  \param[in] len_edges number of edges to sort.
+ *  \param[in,out] dists distances of the edges.
+ *  \param[in,out] heads heads of the edges.
+ *  \param[out] scratch_dists scratch space with at least `len_edges` elements.
+ *  \param[out] scratch_heads scratch space with at least `len_edges` elements.
+ */
+void iscc_hi_sort_edges(size_t len_edges,
+                        double dists[],
+                        scc_PointIndex heads[],
+                        double scratch_dists[],
+                        scc_PointIndex scratch_heads[]);
+
+
+/** Sort compact edges by distance.
+ *
+ *  Same as #iscc_hi_sort_edges for edges with single precision distances.
+ */
+void iscc_hi_sort_compact_edges(size_t len_edges,
+                                float dists[],
+                                scc_PointIndex heads[],
+                                float scratch_dists[],
+                                scc_PointIndex scratch_heads[]);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ifndef SCC_HIERARCHICAL_SORT_HG
@@ -25,22 +25,74 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#ifdef _OPENMP
+	#include <omp.h>
+#endif // ifdef _OPENMP
 #include "../include/scclust.h"
+#include "allocator.h"
 #include "clustering_struct.h"
 #include "dist_search.h"
 #include "error.h"
+#include "run_context.h"
 #include "scclust_types.h"
+#include "spatial_order.h"
+#include "utilities.h"
+
+// Adaptive batches start at this size and are not halved below the minimum size.
+static const uint32_t ISCC_ADAPTIVE_BATCH_INITIAL_SIZE = 64;
+static const uint32_t ISCC_ADAPTIVE_BATCH_MIN_SIZE = 16;
+
+// Adaptive batches are doubled when at least this share of the searched points
+// are unassigned when reached, and halved when less than the lower share are.
+static const double ISCC_ADAPTIVE_BATCH_GROW_YIELD = 0.99;
+static const double ISCC_ADAPTIVE_BATCH_SHRINK_YIELD = 0.97;
+
+#ifdef _OPENMP
+	// With pipelining, batches are made small enough that the data
+	// points are split into at least this many rounds of batches.
+	static const size_t ISCC_BATCH_PIPELINE_MIN_ROUNDS = 8;
+#endif // ifdef _OPENMP
 
 
 // =============================================================================
-// Static function prototypes
+// Internal structs
 // =============================================================================
 
-#ifdef SCC_STABLE_NNG
+/* Size of the next batch. With adaptive sizing, the size is between
+ * `ISCC_ADAPTIVE_BATCH_MIN_SIZE` and `max_size` and follows the share of
+ * searched points that were still unassigned when reached. Otherwise,
+ * `size` equals `max_size`. */
+typedef struct iscc_BatchSizer {
+	bool adaptive;
+	uint32_t size;
+	uint32_t max_size;
+} iscc_BatchSizer;
 
-static int iscc_compare_PointIndex(const void* a, const void* b);
 
-#endif // ifdef SCC_STABLE_NNG
+#ifdef _OPENMP
+
+/* A batch searched ahead of assignment. It holds the unassigned data
+ * points at positions `[range_start, range_end)` in the visiting order
+ * when the batch was formed; points assigned after that are skipped when
+ * the batch is assigned. */
+typedef struct iscc_PipelinedBatch {
+	scc_PointIndex range_start;
+	scc_PointIndex range_end;
+	size_t in_batch;
+	size_t num_ok;
+	bool search_ok;
+	scc_PointIndex* batch_indices;
+	scc_PointIndex* out_indices;
+} iscc_PipelinedBatch;
+
+#endif // ifdef _OPENMP
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static int iscc_compare_PointIndex(const void* a, const void* b);
 
 
 static scc_ErrorCode iscc_run_nng_batches(scc_Clustering* clustering,
@@ -50,12 +102,88 @@ static scc_ErrorCode iscc_run_nng_batches(scc_Clustering* clustering,
                                           bool radius_constraint,
                                           double radius,
                                           const bool primary_data_points[],
-                                          uint32_t batch_size,
-                                          scc_PointIndex* batch_indices,
-                                          scc_PointIndex* out_indices,
+                                          const scc_PointIndex visit_order[],
+                                          iscc_BatchSizer* sizer,
+                                          bool stable,
                                           bool* assigned);
 
 
+#ifdef _OPENMP
+
+static scc_ErrorCode iscc_run_pipelined_nng_batches(scc_Clustering* clustering,
+                                                    iscc_NNSearchObject* nn_search_object,
+                                                    uint32_t size_constraint,
+                                                    bool ignore_unassigned,
+                                                    bool radius_constraint,
+                                                    double radius,
+                                                    const bool primary_data_points[],
+                                                    const scc_PointIndex visit_order[],
+                                                    iscc_BatchSizer* sizer,
+                                                    bool stable,
+                                                    uint32_t num_threads,
+                                                    bool* assigned);
+
+
+static scc_PointIndex iscc_fill_pipelined_round(iscc_PipelinedBatch round[],
+                                                uint32_t num_threads,
+                                                const bool primary_data_points[],
+                                                const scc_PointIndex visit_order[],
+                                                scc_PointIndex num_data_points,
+                                                uint32_t batch_size,
+                                                scc_PointIndex curr_pos,
+                                                const bool assigned[]);
+
+#endif // ifdef _OPENMP
+
+
+static size_t iscc_fill_batch(const bool primary_data_points[],
+                              const scc_PointIndex visit_order[],
+                              scc_PointIndex num_data_points,
+                              uint32_t batch_size,
+                              scc_PointIndex* curr_pos,
+                              scc_PointIndex batch_indices[],
+                              const bool assigned[]);
+
+
+static void iscc_reset_unassigned_labels(scc_Clustering* clustering,
+                                         const scc_PointIndex visit_order[],
+                                         scc_PointIndex range_start,
+                                         scc_PointIndex range_end,
+                                         const bool assigned[]);
+
+
+static bool iscc_search_batch(iscc_NNSearchObject* nn_search_object,
+                              size_t in_batch,
+                              uint32_t size_constraint,
+                              bool radius_constraint,
+                              double radius,
+                              bool stable,
+                              size_t* out_num_ok,
+                              scc_PointIndex batch_indices[],
+                              scc_PointIndex out_indices[]);
+
+
+static scc_ErrorCode iscc_assign_batch(scc_Clustering* clustering,
+                                       uint32_t size_constraint,
+                                       bool ignore_unassigned,
+                                       size_t num_ok_in_batch,
+                                       const scc_PointIndex batch_indices[],
+                                       const scc_PointIndex out_indices[],
+                                       bool assigned[],
+                                       scc_Clabel* next_cluster_label,
+                                       size_t* out_num_reached);
+
+
+static void iscc_update_batch_size(iscc_BatchSizer* sizer,
+                                   size_t num_searched,
+                                   size_t num_reached);
+
+
+static scc_ErrorCode iscc_finish_batches(scc_Clustering* clustering,
+                                         bool search_done,
+                                         scc_Clabel next_cluster_label);
+
+
 // =============================================================================
 // External function implementations
 // =============================================================================
@@ -68,7 +196,10 @@ scc_ErrorCode scc_nng_clustering_batches(scc_Clustering* const clustering,
                                          const double radius,
                                          const size_t len_primary_data_points,
                                          const scc_PointIndex primary_data_points[const],
-                                         uint32_t batch_size)
+                                         uint32_t batch_size,
+                                         const bool adaptive_batch_size,
+                                         const bool spatial_batch_order,
+                                         bool stable)
 {
 	if (!iscc_check_input_clustering(clustering)) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid clustering object.");
@@ -100,12 +231,38 @@ scc_ErrorCode scc_nng_clustering_batches(scc_Clustering* const clustering,
 	if (clustering->num_clusters != 0) {
 		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Cannot refine existing clusterings.");
 	}
+	// The curve order requires access to the data matrix
+	if (spatial_batch_order && !iscc_using_imp_dist_functions()) {
+		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Spatial batch order requires the built-in distance functions.");
+	}
+
+	#ifdef SCC_STABLE_NNG
+		stable = true;
+	#endif // ifdef SCC_STABLE_NNG
 
 	if (batch_size == 0) batch_size = UINT32_MAX;
 	if (batch_size > clustering->num_data_points) {
 		batch_size = (uint32_t) clustering->num_data_points;
 	}
 
+	// With several threads, batches are searched ahead while earlier batches are assigned
+	#ifdef _OPENMP
+		const uint32_t num_threads = omp_in_parallel() ? 1 : iscc_get_num_threads();
+		if (num_threads > 1) {
+			const size_t max_batch_size = 1 + (clustering->num_data_points - 1) / (ISCC_BATCH_PIPELINE_MIN_ROUNDS * num_threads);
+			if (batch_size > max_batch_size) batch_size = (uint32_t) max_batch_size;
+		}
+	#endif // ifdef _OPENMP
+
+	iscc_BatchSizer sizer = {
+		.adaptive = adaptive_batch_size,
+		.size = batch_size,
+		.max_size = batch_size,
+	};
+	if (adaptive_batch_size && (batch_size > ISCC_ADAPTIVE_BATCH_INITIAL_SIZE)) {
+		sizer.size = ISCC_ADAPTIVE_BATCH_INITIAL_SIZE;
+	}
+
 	iscc_NNSearchObject* nn_search_object;
 	if (!iscc_init_nn_search_object(data_set,
 	                                clustering->num_data_points,
@@ -114,13 +271,8 @@ scc_ErrorCode scc_nng_clustering_batches(scc_Clustering* const clustering,
 		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 	}
 
-	scc_PointIndex* const batch_indices = malloc(sizeof(scc_PointIndex[batch_size]));
-	scc_PointIndex* const out_indices = malloc(sizeof(scc_PointIndex[size_constraint * batch_size]));
-	bool* const assigned = calloc(clustering->num_data_points, sizeof(bool));
-	if ((batch_indices == NULL) || (out_indices == NULL) || (assigned == NULL)) {
-		free(batch_indices);
-		free(out_indices);
-		free(assigned);
+	bool* const assigned = iscc_tmp_calloc(clustering->num_data_points, sizeof(bool));
+	if (assigned == NULL) {
 		iscc_close_nn_search_object(&nn_search_object);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
@@ -128,11 +280,9 @@ scc_ErrorCode scc_nng_clustering_batches(scc_Clustering* const clustering,
 	// Initialize cluster labels
 	if (clustering->cluster_label == NULL) {
 		clustering->external_labels = false;
-		clustering->cluster_label = malloc(sizeof(scc_Clabel[clustering->num_data_points]));
+		clustering->cluster_label = iscc_malloc(sizeof(scc_Clabel[clustering->num_data_points]));
 		if (clustering->cluster_label == NULL) {
-			free(batch_indices);
-			free(out_indices);
-			free(assigned);
+			iscc_free(assigned);
 			iscc_close_nn_search_object(&nn_search_object);
 			return iscc_make_error(SCC_ER_NO_MEMORY);
 		}
@@ -140,28 +290,61 @@ scc_ErrorCode scc_nng_clustering_batches(scc_Clustering* const clustering,
 
 	bool* tmp_primary_data_points = NULL;
 	if (primary_data_points != NULL) {
-		tmp_primary_data_points = calloc(clustering->num_data_points, sizeof(bool));
+		tmp_primary_data_points = iscc_tmp_calloc(clustering->num_data_points, sizeof(bool));
 		for (size_t i = 0; i < len_primary_data_points; ++i) {
 			tmp_primary_data_points[primary_data_points[i]] = true;
 		}
 	}
 
-	scc_ErrorCode ec = iscc_run_nng_batches(clustering,
-	                                        nn_search_object,
-	                                        size_constraint,
-	                                        (unassigned_method == SCC_UM_IGNORE),
-	                                        radius_constraint,
-	                                        radius,
-	                                        tmp_primary_data_points,
-	                                        batch_size,
-	                                        batch_indices,
-	                                        out_indices,
-	                                        assigned);
-
-	free(batch_indices);
-	free(out_indices);
-	free(assigned);
-	free(tmp_primary_data_points);
+	// Points are visited along a space-filling curve, or in index order when `NULL`
+	scc_PointIndex* visit_order = NULL;
+	if (spatial_batch_order) {
+		visit_order = iscc_tmp_malloc(sizeof(scc_PointIndex[clustering->num_data_points]));
+		const scc_ErrorCode ec_order = (visit_order == NULL) ? iscc_make_error(SCC_ER_NO_MEMORY)
+		                                                     : iscc_get_spatial_order(data_set, visit_order);
+		if (ec_order != SCC_ER_OK) {
+			iscc_free(assigned);
+			iscc_free(tmp_primary_data_points);
+			iscc_free(visit_order);
+			iscc_close_nn_search_object(&nn_search_object);
+			return ec_order;
+		}
+	}
+
+	scc_ErrorCode ec;
+	#ifdef _OPENMP
+		if (num_threads > 1) {
+			ec = iscc_run_pipelined_nng_batches(clustering,
+			                                    nn_search_object,
+			                                    size_constraint,
+			                                    (unassigned_method == SCC_UM_IGNORE),
+			                                    radius_constraint,
+			                                    radius,
+			                                    tmp_primary_data_points,
+			                                    visit_order,
+			                                    &sizer,
+			                                    stable,
+			                                    num_threads,
+			                                    assigned);
+		} else
+	#endif // ifdef _OPENMP
+	{
+		ec = iscc_run_nng_batches(clustering,
+		                          nn_search_object,
+		                          size_constraint,
+		                          (unassigned_method == SCC_UM_IGNORE),
+		                          radius_constraint,
+		                          radius,
+		                          tmp_primary_data_points,
+		                          visit_order,
+		                          &sizer,
+		                          stable,
+		                          assigned);
+	}
+
+	iscc_free(assigned);
+	iscc_free(tmp_primary_data_points);
+	iscc_free(visit_order);
 	iscc_close_nn_search_object(&nn_search_object);
 
 	return ec;
@@ -172,8 +355,6 @@ scc_ErrorCode scc_nng_clustering_batches(scc_Clustering* const clustering,
 // Static function implementations
 // =============================================================================
 
-#ifdef SCC_STABLE_NNG
-
 static int iscc_compare_PointIndex(const void* const a, const void* const b)
 {
     const scc_PointIndex arg1 = *(const scc_PointIndex* const)a;
@@ -181,8 +362,6 @@ static int iscc_compare_PointIndex(const void* const a, const void* const b)
     return (arg1 > arg2) - (arg1 < arg2);
 }
 
-#endif // ifdef SCC_STABLE_NNG
-
 
 static scc_ErrorCode iscc_run_nng_batches(scc_Clustering* const clustering,
                                           iscc_NNSearchObject* const nn_search_object,
@@ -191,9 +370,9 @@ static scc_ErrorCode iscc_run_nng_batches(scc_Clustering* const clustering,
                                           const bool radius_constraint,
                                           const double radius,
                                           const bool primary_data_points[const],
-                                          const uint32_t batch_size,
-                                          scc_PointIndex* const batch_indices,
-                                          scc_PointIndex* const out_indices,
+                                          const scc_PointIndex visit_order[const],
+                                          iscc_BatchSizer* const sizer,
+                                          const bool stable,
                                           bool* const assigned)
 {
 	assert(iscc_check_input_clustering(clustering));
@@ -203,121 +382,510 @@ static scc_ErrorCode iscc_run_nng_batches(scc_Clustering* const clustering,
 	assert(size_constraint >= 2);
 	assert(clustering->num_data_points >= size_constraint);
 	assert(!radius_constraint || (radius > 0.0));
-	assert(batch_size > 0);
-	assert(batch_indices != NULL);
-	assert(out_indices != NULL);
+	assert(sizer->size > 0);
+	assert(sizer->size <= sizer->max_size);
+	assert(assigned != NULL);
+
+	// Buffers grow with the batch size
+	size_t capacity = sizer->size;
+	scc_PointIndex* batch_indices = iscc_tmp_malloc(sizeof(scc_PointIndex[capacity]));
+	scc_PointIndex* out_indices = iscc_tmp_malloc(sizeof(scc_PointIndex) * capacity * size_constraint);
+	if ((batch_indices == NULL) || (out_indices == NULL)) {
+		iscc_free(batch_indices);
+		iscc_free(out_indices);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	scc_ErrorCode ec = SCC_ER_OK;
+	bool search_done = false;
+	scc_Clabel next_cluster_label = 0;
+	assert(clustering->num_data_points <= ISCC_POINTINDEX_MAX);
+	const scc_PointIndex num_data_points = (scc_PointIndex) clustering->num_data_points; // If `scc_PointIndex` is signed
+
+	for (scc_PointIndex curr_pos = 0; curr_pos < num_data_points; ) {
+		if (sizer->size > capacity) {
+			capacity = sizer->size;
+			scc_PointIndex* const tmp_batch_indices = iscc_realloc(batch_indices, sizeof(scc_PointIndex[capacity]));
+			if (tmp_batch_indices != NULL) batch_indices = tmp_batch_indices;
+			scc_PointIndex* const tmp_out_indices = iscc_realloc(out_indices, sizeof(scc_PointIndex) * capacity * size_constraint);
+			if (tmp_out_indices != NULL) out_indices = tmp_out_indices;
+			if ((tmp_batch_indices == NULL) || (tmp_out_indices == NULL)) {
+				ec = iscc_make_error(SCC_ER_NO_MEMORY);
+				break;
+			}
+		}
+
+		const scc_PointIndex range_start = curr_pos;
+		const size_t in_batch = iscc_fill_batch(primary_data_points,
+		                                        visit_order,
+		                                        num_data_points,
+		                                        sizer->size,
+		                                        &curr_pos,
+		                                        batch_indices,
+		                                        assigned);
+		iscc_reset_unassigned_labels(clustering, visit_order, range_start, curr_pos, assigned);
+
+		if (in_batch == 0) {
+			assert(curr_pos == num_data_points);
+			break;
+		}
+
+		size_t num_ok_in_batch = 0;
+		search_done = true;
+		if (!iscc_search_batch(nn_search_object,
+		                       in_batch,
+		                       size_constraint,
+		                       radius_constraint,
+		                       radius,
+		                       stable,
+		                       &num_ok_in_batch,
+		                       batch_indices,
+		                       out_indices)) {
+			ec = iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+			break;
+		}
+
+		size_t num_reached;
+		if ((ec = iscc_assign_batch(clustering,
+		                            size_constraint,
+		                            ignore_unassigned,
+		                            num_ok_in_batch,
+		                            batch_indices,
+		                            out_indices,
+		                            assigned,
+		                            &next_cluster_label,
+		                            &num_reached)) != SCC_ER_OK) {
+			break;
+		}
+
+		iscc_update_batch_size(sizer, num_ok_in_batch, num_reached);
+	} // Loop between batches
+
+	iscc_free(batch_indices);
+	iscc_free(out_indices);
+	if (ec != SCC_ER_OK) return ec;
+
+	return iscc_finish_batches(clustering,
+	                           search_done,
+	                           next_cluster_label);
+}
+
+
+#ifdef _OPENMP
+
+/* Batches are searched in rounds of `num_threads` batches. While one
+ * thread assigns a round, the other threads search the next round.
+ * The next round is formed before the current round is assigned, so it
+ * may include points that become assigned; those are skipped when the
+ * round is assigned. Since data points are assigned in the same order,
+ * and their searches do not depend on the other points in the batch, the
+ * clustering is identical to the one from `iscc_run_nng_batches`. */
+static scc_ErrorCode iscc_run_pipelined_nng_batches(scc_Clustering* const clustering,
+                                                    iscc_NNSearchObject* const nn_search_object,
+                                                    const uint32_t size_constraint,
+                                                    const bool ignore_unassigned,
+                                                    const bool radius_constraint,
+                                                    const double radius,
+                                                    const bool primary_data_points[const],
+                                                    const scc_PointIndex visit_order[const],
+                                                    iscc_BatchSizer* const sizer,
+                                                    const bool stable,
+                                                    const uint32_t num_threads,
+                                                    bool* const assigned)
+{
+	assert(iscc_check_input_clustering(clustering));
+	assert(clustering->cluster_label != NULL);
+	assert(clustering->num_clusters == 0);
+	assert(nn_search_object != NULL);
+	assert(size_constraint >= 2);
+	assert(clustering->num_data_points >= size_constraint);
+	assert(!radius_constraint || (radius > 0.0));
+	assert(sizer->size > 0);
+	assert(sizer->size <= sizer->max_size);
+	assert(num_threads > 1);
 	assert(assigned != NULL);
 
+	// Two rounds of batches with buffers for the largest batch size
+	const size_t num_batches = 2 * (size_t) num_threads;
+	const size_t max_size = sizer->max_size;
+	iscc_PipelinedBatch* const batches = iscc_tmp_malloc(sizeof(iscc_PipelinedBatch[num_batches]));
+	scc_PointIndex* const batch_indices = iscc_tmp_malloc(sizeof(scc_PointIndex) * num_batches * max_size);
+	scc_PointIndex* const out_indices = iscc_tmp_malloc(sizeof(scc_PointIndex) * num_batches * max_size * size_constraint);
+	if ((batches == NULL) || (batch_indices == NULL) || (out_indices == NULL)) {
+		iscc_free(batches);
+		iscc_free(batch_indices);
+		iscc_free(out_indices);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+	for (size_t b = 0; b < num_batches; ++b) {
+		batches[b].batch_indices = batch_indices + b * max_size;
+		batches[b].out_indices = out_indices + b * max_size * size_constraint;
+	}
+
+	scc_ErrorCode ec = SCC_ER_OK;
 	bool search_done = false;
 	scc_Clabel next_cluster_label = 0;
 	assert(clustering->num_data_points <= ISCC_POINTINDEX_MAX);
 	const scc_PointIndex num_data_points = (scc_PointIndex) clustering->num_data_points; // If `scc_PointIndex` is signed
 
-	for (scc_PointIndex curr_point = 0; curr_point < num_data_points; ) {
+	iscc_PipelinedBatch* curr_round = batches;
+	iscc_PipelinedBatch* next_round = batches + num_threads;
+
+	scc_PointIndex curr_pos = iscc_fill_pipelined_round(curr_round,
+	                                                      num_threads,
+	                                                      primary_data_points,
+	                                                      visit_order,
+	                                                      num_data_points,
+	                                                      sizer->size,
+	                                                      0,
+	                                                      assigned);
+
+	iscc_RunContext* const run_context = iscc_get_run_context();
+	#pragma omp parallel for num_threads((int) num_threads) schedule(dynamic, 1)
+	for (size_t b = 0; b < num_threads; ++b) {
+		iscc_RunContext* const prev_context = iscc_enter_run_context(run_context);
+		curr_round[b].search_ok = iscc_search_batch(nn_search_object,
+		                                            curr_round[b].in_batch,
+		                                            size_constraint,
+		                                            radius_constraint,
+		                                            radius,
+		                                            stable,
+		                                            &curr_round[b].num_ok,
+		                                            curr_round[b].batch_indices,
+		                                            curr_round[b].out_indices);
+		iscc_leave_run_context(prev_context);
+	}
 
-		size_t in_batch = 0;
+	while (curr_round[0].range_start < num_data_points) {
+		curr_pos = iscc_fill_pipelined_round(next_round,
+		                                       num_threads,
+		                                       primary_data_points,
+		                                       visit_order,
+		                                       num_data_points,
+		                                       sizer->size,
+		                                       curr_pos,
+		                                       assigned);
+
+		size_t round_searched = 0;
+		size_t round_reached = 0;
+		#pragma omp parallel num_threads((int) num_threads)
+		{
+			iscc_RunContext* const prev_context = iscc_enter_run_context(run_context);
+
+			#pragma omp single nowait
+			{
+				for (size_t b = 0; b < num_threads; ++b) {
+					iscc_reset_unassigned_labels(clustering,
+					                             visit_order,
+					                             curr_round[b].range_start,
+					                             curr_round[b].range_end,
+					                             assigned);
+					if (curr_round[b].in_batch == 0) continue;
+					search_done = true;
+					if (!curr_round[b].search_ok) {
+						ec = iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+						break;
+					}
+					size_t num_reached;
+					if ((ec = iscc_assign_batch(clustering,
+					                            size_constraint,
+					                            ignore_unassigned,
+					                            curr_round[b].num_ok,
+					                            curr_round[b].batch_indices,
+					                            curr_round[b].out_indices,
+					                            assigned,
+					                            &next_cluster_label,
+					                            &num_reached)) != SCC_ER_OK) {
+						break;
+					}
+					round_searched += curr_round[b].num_ok;
+					round_reached += num_reached;
+				}
+			}
+
+			#pragma omp for schedule(dynamic, 1)
+			for (size_t b = 0; b < num_threads; ++b) {
+				next_round[b].search_ok = iscc_search_batch(nn_search_object,
+				                                            next_round[b].in_batch,
+				                                            size_constraint,
+				                                            radius_constraint,
+				                                            radius,
+				                                            stable,
+				                                            &next_round[b].num_ok,
+				                                            next_round[b].batch_indices,
+				                                            next_round[b].out_indices);
+			}
+
+			iscc_leave_run_context(prev_context);
+		}
+
+		if (ec != SCC_ER_OK) {
+			iscc_free(batches);
+			iscc_free(batch_indices);
+			iscc_free(out_indices);
+			return ec;
+		}
+
+		// The round after next is formed with the updated size
+		iscc_update_batch_size(sizer, round_searched, round_reached);
+
+		iscc_PipelinedBatch* const tmp_round = curr_round;
+		curr_round = next_round;
+		next_round = tmp_round;
+	}
+
+	iscc_free(batches);
+	iscc_free(batch_indices);
+	iscc_free(out_indices);
+
+	return iscc_finish_batches(clustering,
+	                           search_done,
+	                           next_cluster_label);
+}
+
+
+static scc_PointIndex iscc_fill_pipelined_round(iscc_PipelinedBatch round[const],
+                                                const uint32_t num_threads,
+                                                const bool primary_data_points[const],
+                                                const scc_PointIndex visit_order[const],
+                                                const scc_PointIndex num_data_points,
+                                                const uint32_t batch_size,
+                                                scc_PointIndex curr_pos,
+                                                const bool assigned[const])
+{
+	assert(round != NULL);
+	assert(num_threads > 1);
+	assert(batch_size > 0);
+	assert(assigned != NULL);
+
+	for (size_t b = 0; b < num_threads; ++b) {
+		round[b].range_start = curr_pos;
+		round[b].in_batch = iscc_fill_batch(primary_data_points,
+		                                    visit_order,
+		                                    num_data_points,
+		                                    batch_size,
+		                                    &curr_pos,
+		                                    round[b].batch_indices,
+		                                    assigned);
+		round[b].range_end = curr_pos;
+		round[b].num_ok = 0;
+		round[b].search_ok = true;
+	}
+
+	return curr_pos;
+}
+
+#endif // ifdef _OPENMP
+
+
+static size_t iscc_fill_batch(const bool primary_data_points[const],
+                              const scc_PointIndex visit_order[const],
+                              const scc_PointIndex num_data_points,
+                              const uint32_t batch_size,
+                              scc_PointIndex* const curr_pos,
+                              scc_PointIndex batch_indices[const],
+                              const bool assigned[const])
+{
+	assert(batch_size > 0);
+	assert(curr_pos != NULL);
+	assert(batch_indices != NULL);
+	assert(assigned != NULL);
+
+	size_t in_batch = 0;
+	scc_PointIndex pos = *curr_pos;
+	if (visit_order == NULL) {
 		if (primary_data_points == NULL) {
-			for (; (in_batch < batch_size) && (curr_point < num_data_points); ++curr_point) {
-				if (!assigned[curr_point]) {
-					clustering->cluster_label[curr_point] = SCC_CLABEL_NA;
-					batch_indices[in_batch] = curr_point;
+			for (; (in_batch < batch_size) && (pos < num_data_points); ++pos) {
+				if (!assigned[pos]) {
+					batch_indices[in_batch] = pos;
 					++in_batch;
 				}
 			}
 		} else {
-			for (; (in_batch < batch_size) && (curr_point < num_data_points); ++curr_point) {
-				if (!assigned[curr_point]) {
-					clustering->cluster_label[curr_point] = SCC_CLABEL_NA;
-					if (primary_data_points[curr_point]) {
-						batch_indices[in_batch] = curr_point;
-						++in_batch;
-					}
+			for (; (in_batch < batch_size) && (pos < num_data_points); ++pos) {
+				if (!assigned[pos] && primary_data_points[pos]) {
+					batch_indices[in_batch] = pos;
+					++in_batch;
 				}
 			}
 		}
-
-		if (in_batch == 0) {
-			assert(curr_point == num_data_points);
-			break;
+	} else {
+		for (; (in_batch < batch_size) && (pos < num_data_points); ++pos) {
+			const scc_PointIndex point = visit_order[pos];
+			if (!assigned[point] && ((primary_data_points == NULL) || primary_data_points[point])) {
+				batch_indices[in_batch] = point;
+				++in_batch;
+			}
 		}
+	}
 
-		size_t num_ok_in_batch = 0;
-		search_done = true;
-		if (!iscc_nearest_neighbor_search(nn_search_object,
-		                                  in_batch,
-		                                  batch_indices,
-		                                  size_constraint,
-		                                  radius_constraint,
-		                                  radius,
-		                                  &num_ok_in_batch,
-		                                  batch_indices,
-		                                  out_indices)) {
-			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	*curr_pos = pos;
+	return in_batch;
+}
+
+
+static void iscc_reset_unassigned_labels(scc_Clustering* const clustering,
+                                         const scc_PointIndex visit_order[const],
+                                         const scc_PointIndex range_start,
+                                         const scc_PointIndex range_end,
+                                         const bool assigned[const])
+{
+	assert(clustering->cluster_label != NULL);
+	assert(range_start <= range_end);
+	assert(assigned != NULL);
+
+	for (scc_PointIndex pos = range_start; pos < range_end; ++pos) {
+		const scc_PointIndex point = (visit_order == NULL) ? pos : visit_order[pos];
+		if (!assigned[point]) {
+			clustering->cluster_label[point] = SCC_CLABEL_NA;
 		}
+	}
+}
+
+
+static bool iscc_search_batch(iscc_NNSearchObject* const nn_search_object,
+                              const size_t in_batch,
+                              const uint32_t size_constraint,
+                              const bool radius_constraint,
+                              const double radius,
+                              const bool stable,
+                              size_t* const out_num_ok,
+                              scc_PointIndex batch_indices[const],
+                              scc_PointIndex out_indices[const])
+{
+	assert(nn_search_object != NULL);
+	assert(size_constraint >= 2);
+	assert(out_num_ok != NULL);
+	assert(batch_indices != NULL);
+	assert(out_indices != NULL);
 
-		#ifdef SCC_STABLE_NNG
-		for (size_t i = 0; i < num_ok_in_batch; ++i) {
+	*out_num_ok = 0;
+	if (in_batch == 0) return true;
+
+	if (!iscc_nearest_neighbor_search(nn_search_object,
+	                                  in_batch,
+	                                  batch_indices,
+	                                  size_constraint,
+	                                  radius_constraint,
+	                                  radius,
+	                                  out_num_ok,
+	                                  batch_indices,
+	                                  out_indices)) {
+		return false;
+	}
+
+	if (stable) {
+		for (size_t i = 0; i < *out_num_ok; ++i) {
 			qsort(out_indices + i * size_constraint, size_constraint, sizeof(scc_PointIndex), iscc_compare_PointIndex);
 		}
-		#endif // ifdef SCC_STABLE_NNG
-
-		const scc_PointIndex* check_indices = out_indices;
-		for (size_t i = 0; i < num_ok_in_batch; ++i) {
-			const scc_PointIndex* const stop_check_indices = check_indices + size_constraint;
-			if (!assigned[batch_indices[i]]) {
-				for (; (check_indices != stop_check_indices) && !assigned[*check_indices]; ++check_indices) {}
-				if (check_indices == stop_check_indices) {
-					// `i` has no assigned neighbors and can be seed
-					if (next_cluster_label == SCC_CLABEL_MAX) {
-						return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many clusters (adjust the `scc_Clabel` type).");
-					}
+	}
 
-					assert(!assigned[batch_indices[i]]);
-					const scc_PointIndex* const stop_assign_indices = stop_check_indices - 1;
-					for (check_indices -= size_constraint; check_indices != stop_assign_indices; ++check_indices) {
-						assert(!assigned[*check_indices]);
-						assigned[*check_indices] = true;
-						clustering->cluster_label[*check_indices] = next_cluster_label;
-					}
-					if (assigned[batch_indices[i]]) {
-						// Self-loop from `batch_indices[i]` to `batch_indices[i]` existed among NN
-						assert(!assigned[*check_indices]);
-						assigned[*check_indices] = true;
-						clustering->cluster_label[*check_indices] = next_cluster_label;
-					} else {
-						// Self-loop did not exist
-						assert(!assigned[batch_indices[i]]);
-						assigned[batch_indices[i]] = true;
-						clustering->cluster_label[batch_indices[i]] = next_cluster_label;
-					}
+	return true;
+}
+
+
+static scc_ErrorCode iscc_assign_batch(scc_Clustering* const clustering,
+                                       const uint32_t size_constraint,
+                                       const bool ignore_unassigned,
+                                       const size_t num_ok_in_batch,
+                                       const scc_PointIndex batch_indices[const],
+                                       const scc_PointIndex out_indices[const],
+                                       bool assigned[const],
+                                       scc_Clabel* const next_cluster_label,
+                                       size_t* const out_num_reached)
+{
+	assert(clustering->cluster_label != NULL);
+	assert(size_constraint >= 2);
+	assert(assigned != NULL);
+	assert(next_cluster_label != NULL);
+	assert(out_num_reached != NULL);
+
+	*out_num_reached = 0;
+	const scc_PointIndex* check_indices = out_indices;
+	for (size_t i = 0; i < num_ok_in_batch; ++i) {
+		const scc_PointIndex* const stop_check_indices = check_indices + size_constraint;
+		if (!assigned[batch_indices[i]]) {
+			++(*out_num_reached);
+			for (; (check_indices != stop_check_indices) && !assigned[*check_indices]; ++check_indices) {}
+			if (check_indices == stop_check_indices) {
+				// `i` has no assigned neighbors and can be seed
+				if (*next_cluster_label == SCC_CLABEL_MAX) {
+					return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many clusters (adjust the `scc_Clabel` type).");
+				}
 
-					assert(clustering->cluster_label[batch_indices[i]] == next_cluster_label);
-					++next_cluster_label;
+				assert(!assigned[batch_indices[i]]);
+				const scc_PointIndex* const stop_assign_indices = stop_check_indices - 1;
+				for (check_indices -= size_constraint; check_indices != stop_assign_indices; ++check_indices) {
+					assert(!assigned[*check_indices]);
+					assigned[*check_indices] = true;
+					clustering->cluster_label[*check_indices] = *next_cluster_label;
+				}
+				if (assigned[batch_indices[i]]) {
+					// Self-loop from `batch_indices[i]` to `batch_indices[i]` existed among NN
+					assert(!assigned[*check_indices]);
+					assigned[*check_indices] = true;
+					clustering->cluster_label[*check_indices] = *next_cluster_label;
 				} else {
-					// `i` has assigned neighbors and cannot be seed
-					if (!ignore_unassigned) {
-						// Assign `batch_indices[i]` to a preliminary cluster.
-						// If a future seed wants it as neighbor, it switches cluster.
-						assert(assigned[*check_indices]);
-						assert(clustering->cluster_label[batch_indices[i]] == SCC_CLABEL_NA);
-						assert(clustering->cluster_label[*check_indices] != SCC_CLABEL_NA);
-						assert(!assigned[batch_indices[i]]);
-						clustering->cluster_label[batch_indices[i]] = clustering->cluster_label[*check_indices];
-					}
+					// Self-loop did not exist
+					assert(!assigned[batch_indices[i]]);
+					assigned[batch_indices[i]] = true;
+					clustering->cluster_label[batch_indices[i]] = *next_cluster_label;
+				}
+
+				assert(clustering->cluster_label[batch_indices[i]] == *next_cluster_label);
+				++(*next_cluster_label);
+			} else {
+				// `i` has assigned neighbors and cannot be seed
+				if (!ignore_unassigned) {
+					// Assign `batch_indices[i]` to a preliminary cluster.
+					// If a future seed wants it as neighbor, it switches cluster.
+					assert(assigned[*check_indices]);
+					assert(clustering->cluster_label[batch_indices[i]] == SCC_CLABEL_NA);
+					assert(clustering->cluster_label[*check_indices] != SCC_CLABEL_NA);
+					assert(!assigned[batch_indices[i]]);
+					clustering->cluster_label[batch_indices[i]] = clustering->cluster_label[*check_indices];
 				}
 			}
-			check_indices = stop_check_indices;
-		} // Loop in batch
-	} // Loop between batches
+		}
+		check_indices = stop_check_indices;
+	} // Loop in batch
+
+	return iscc_no_error();
+}
+
+
+static void iscc_update_batch_size(iscc_BatchSizer* const sizer,
+                                   const size_t num_searched,
+                                   const size_t num_reached)
+{
+	assert(sizer->size > 0);
+	assert(sizer->size <= sizer->max_size);
+	assert(num_reached <= num_searched);
+
+	if (!sizer->adaptive || (num_searched == 0)) return;
+
+	// Points assigned by earlier points in their batch were searched in vain
+	const double yield = ((double) num_reached) / ((double) num_searched);
+	if (yield >= ISCC_ADAPTIVE_BATCH_GROW_YIELD) {
+		sizer->size = (sizer->size > sizer->max_size / 2) ? sizer->max_size : 2 * sizer->size;
+	} else if ((yield < ISCC_ADAPTIVE_BATCH_SHRINK_YIELD) && (sizer->size / 2 >= ISCC_ADAPTIVE_BATCH_MIN_SIZE)) {
+		sizer->size /= 2;
+	}
+}
+
+
+static scc_ErrorCode iscc_finish_batches(scc_Clustering* const clustering,
+                                         const bool search_done,
+                                         const scc_Clabel next_cluster_label)
+{
+	assert(clustering != NULL);
 
 	if (next_cluster_label == 0) {
 		if (!search_done) {
 			// Never did search, i.e., primary_data_points are all false
-			assert(primary_data_points != NULL);
 			return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "No primary data points.");
 		} else {
 			// Did search but still no clusters, i.e., too tight radius constraint
-			assert(radius_constraint);
 			return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Infeasible radius constraint.");
 		}
 	}
@@ -39,7 +39,10 @@ scc_ErrorCode scc_nng_clustering_batches(scc_Clustering* clustering,
                                          double radius,
                                          size_t len_primary_data_points,
                                          const scc_PointIndex primary_data_points[],
-                                         uint32_t batch_size);
+                                         uint32_t batch_size,
+                                         bool adaptive_batch_size,
+                                         bool spatial_batch_order,
+                                         bool stable);
 
 
 #endif // ifndef SCC_BATCH_CLUSTERING_HG
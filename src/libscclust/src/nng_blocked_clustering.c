@@ -0,0 +1,368 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "nng_blocked_clustering.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../include/scclust.h"
+#include "allocator.h"
+#include "clustering_struct.h"
+#include "data_set_struct.h"
+#include "dist_search.h"
+#include "error.h"
+#include "run_context.h"
+#include "scclust_types.h"
+#include "utilities.h"
+
+
+// =============================================================================
+// Internal structs
+// =============================================================================
+
+typedef struct iscc_BlockPoint {
+	scc_TypeLabel label;
+	scc_PointIndex point;
+} iscc_BlockPoint;
+
+
+typedef struct iscc_BlockSize {
+	size_t size;
+	size_t block;
+} iscc_BlockSize;
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static int iscc_compare_BlockPoint(const void* a,
+                                   const void* b);
+
+
+static int iscc_compare_BlockSize(const void* a,
+                                  const void* b);
+
+
+static scc_ErrorCode iscc_cluster_block(const scc_DataSet* data_set,
+                                        const scc_ClusterOptions* options,
+                                        size_t len_block,
+                                        const iscc_BlockPoint block[],
+                                        const bool is_primary[],
+                                        scc_Clabel out_labels[],
+                                        size_t* out_num_clusters);
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+scc_ErrorCode iscc_nng_clustering_blocks(scc_Clustering* const clustering,
+                                         void* const data_set,
+                                         const scc_ClusterOptions* const options)
+{
+	assert(iscc_check_input_clustering(clustering));
+	assert(clustering->num_clusters == 0);
+	assert(iscc_check_data_set(data_set));
+	assert(options->blocking_labels != NULL);
+	assert(options->len_blocking_labels >= clustering->num_data_points);
+
+	// Blocks are clustered as separate data sets, which requires access to the data matrix
+	if (!iscc_using_imp_dist_functions()) {
+		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Blocking requires the built-in distance functions.");
+	}
+
+	const scc_DataSet* const data_set_cast = (const scc_DataSet*) data_set;
+	const size_t num_data_points = clustering->num_data_points;
+
+	iscc_BlockPoint* const block_points = iscc_tmp_malloc(sizeof(iscc_BlockPoint[num_data_points]));
+	if (block_points == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+	assert(num_data_points <= ISCC_POINTINDEX_MAX);
+	for (size_t i = 0; i < num_data_points; ++i) {
+		block_points[i] = (iscc_BlockPoint) {
+			.label = options->blocking_labels[i],
+			.point = (scc_PointIndex) i,
+		};
+	}
+
+	// Sort data points by block, and by index within blocks
+	qsort(block_points, num_data_points, sizeof(iscc_BlockPoint), iscc_compare_BlockPoint);
+
+	size_t num_blocks = 1;
+	for (size_t i = 1; i < num_data_points; ++i) {
+		num_blocks += (block_points[i - 1].label != block_points[i].label);
+	}
+
+	size_t* const block_start = iscc_tmp_malloc(sizeof(size_t[num_blocks + 1]));
+	iscc_BlockSize* const block_order = iscc_tmp_malloc(sizeof(iscc_BlockSize[num_blocks]));
+	size_t* const block_num_clusters = iscc_tmp_malloc(sizeof(size_t[num_blocks]));
+	scc_ErrorCode* const block_ec = iscc_tmp_malloc(sizeof(scc_ErrorCode[num_blocks]));
+	scc_Clabel* const block_labels = iscc_tmp_malloc(sizeof(scc_Clabel[num_data_points]));
+	bool* const is_primary = (options->primary_data_points == NULL) ? NULL : iscc_tmp_calloc(num_data_points, sizeof(bool));
+	if ((block_start == NULL) || (block_order == NULL) || (block_num_clusters == NULL) ||
+	        (block_ec == NULL) || (block_labels == NULL) ||
+	        ((options->primary_data_points != NULL) && (is_primary == NULL))) {
+		iscc_free(block_points);
+		iscc_free(block_start);
+		iscc_free(block_order);
+		iscc_free(block_num_clusters);
+		iscc_free(block_ec);
+		iscc_free(block_labels);
+		iscc_free(is_primary);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	if (options->primary_data_points != NULL) {
+		for (size_t i = 0; i < options->len_primary_data_points; ++i) {
+			is_primary[options->primary_data_points[i]] = true;
+		}
+	}
+
+	size_t b = 0;
+	block_start[0] = 0;
+	for (size_t i = 1; i < num_data_points; ++i) {
+		if (block_points[i - 1].label != block_points[i].label) {
+			++b;
+			block_start[b] = i;
+		}
+	}
+	block_start[num_blocks] = num_data_points;
+
+	// Process largest blocks first to balance work between threads
+	for (b = 0; b < num_blocks; ++b) {
+		block_order[b] = (iscc_BlockSize) {
+			.size = block_start[b + 1] - block_start[b],
+			.block = b,
+		};
+	}
+	qsort(block_order, num_blocks, sizeof(iscc_BlockSize), iscc_compare_BlockSize);
+
+	// Blocks are clustered in the run of the calling thread
+	iscc_RunContext* const run_context = iscc_get_run_context();
+	#ifdef _OPENMP
+		#pragma omp parallel for num_threads((int) iscc_get_num_threads()) schedule(dynamic, 1)
+	#endif // ifdef _OPENMP
+	for (size_t i = 0; i < num_blocks; ++i) {
+		iscc_RunContext* const prev_context = iscc_enter_run_context(run_context);
+		const size_t ob = block_order[i].block;
+		block_ec[ob] = iscc_cluster_block(data_set_cast,
+		                                  options,
+		                                  block_start[ob + 1] - block_start[ob],
+		                                  block_points + block_start[ob],
+		                                  is_primary,
+		                                  block_labels + block_start[ob],
+		                                  &block_num_clusters[ob]);
+		iscc_leave_run_context(prev_context);
+	}
+
+	iscc_free(block_order);
+	iscc_free(is_primary);
+
+	// Infeasible blocks are reported, all other errors are returned
+	scc_ErrorCode ec = SCC_ER_OK;
+	size_t num_clusters = 0;
+	bool any_feasible = false;
+	for (b = 0; b < num_blocks; ++b) {
+		if (block_ec[b] == SCC_ER_OK) {
+			any_feasible = true;
+			num_clusters += block_num_clusters[b];
+		} else if ((block_ec[b] != SCC_ER_NO_SOLUTION) && (ec == SCC_ER_OK)) {
+			ec = block_ec[b]; // Error message is set by the block
+		}
+	}
+
+	if ((ec == SCC_ER_OK) && !any_feasible) {
+		ec = iscc_make_error_msg(SCC_ER_NO_SOLUTION, "No block has a feasible clustering.");
+	}
+	if ((ec == SCC_ER_OK) && (num_clusters > (size_t) SCC_CLABEL_MAX)) {
+		ec = iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many clusters (adjust the `scc_Clabel` type).");
+	}
+	if ((ec == SCC_ER_OK) && (clustering->cluster_label == NULL)) {
+		clustering->external_labels = false;
+		clustering->cluster_label = iscc_malloc(sizeof(scc_Clabel[num_data_points]));
+		if (clustering->cluster_label == NULL) ec = iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	if (ec == SCC_ER_OK) {
+		// Merge labels with offsets so that labels are consecutive over blocks
+		scc_Clabel offset = 0;
+		for (b = 0; b < num_blocks; ++b) {
+			for (size_t i = block_start[b]; i < block_start[b + 1]; ++i) {
+				if ((block_ec[b] == SCC_ER_OK) && (block_labels[i] != SCC_CLABEL_NA)) {
+					clustering->cluster_label[block_points[i].point] = block_labels[i] + offset;
+				} else {
+					clustering->cluster_label[block_points[i].point] = SCC_CLABEL_NA;
+				}
+			}
+
+			if (b < options->len_block_reports) {
+				options->block_reports[b] = (scc_BlockReport) {
+					.blocking_label = block_points[block_start[b]].label,
+					.num_data_points = (uint64_t) (block_start[b + 1] - block_start[b]),
+					.num_clusters = (block_ec[b] == SCC_ER_OK) ? (uint64_t) block_num_clusters[b] : 0,
+					.error = block_ec[b],
+				};
+			}
+
+			if (block_ec[b] == SCC_ER_OK) offset += (scc_Clabel) block_num_clusters[b];
+		}
+
+		clustering->num_clusters = num_clusters;
+	}
+
+	iscc_free(block_points);
+	iscc_free(block_start);
+	iscc_free(block_num_clusters);
+	iscc_free(block_ec);
+	iscc_free(block_labels);
+
+	return ec;
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static int iscc_compare_BlockPoint(const void* const a,
+                                   const void* const b)
+{
+	const iscc_BlockPoint* const bp_a = (const iscc_BlockPoint*) a;
+	const iscc_BlockPoint* const bp_b = (const iscc_BlockPoint*) b;
+	if (bp_a->label != bp_b->label) return (bp_a->label < bp_b->label) ? -1 : 1;
+	return (bp_a->point > bp_b->point) - (bp_a->point < bp_b->point);
+}
+
+
+static int iscc_compare_BlockSize(const void* const a,
+                                  const void* const b)
+{
+	const iscc_BlockSize* const bs_a = (const iscc_BlockSize*) a;
+	const iscc_BlockSize* const bs_b = (const iscc_BlockSize*) b;
+	if (bs_a->size != bs_b->size) return (bs_a->size > bs_b->size) ? -1 : 1;
+	return (bs_a->block > bs_b->block) - (bs_a->block < bs_b->block);
+}
+
+
+static scc_ErrorCode iscc_cluster_block(const scc_DataSet* const data_set,
+                                        const scc_ClusterOptions* const options,
+                                        const size_t len_block,
+                                        const iscc_BlockPoint block[const],
+                                        const bool is_primary[const],
+                                        scc_Clabel out_labels[const],
+                                        size_t* const out_num_clusters)
+{
+	assert(scc_is_initialized_data_set(data_set));
+	assert(len_block > 0);
+	assert(block != NULL);
+	assert(out_labels != NULL);
+	assert(out_num_clusters != NULL);
+
+	*out_num_clusters = 0;
+	for (size_t i = 0; i < len_block; ++i) {
+		out_labels[i] = SCC_CLABEL_NA;
+	}
+
+	// Primary data points in the block, as indices in the block
+	size_t len_primary_data_points = 0;
+	if (is_primary != NULL) {
+		for (size_t i = 0; i < len_block; ++i) {
+			len_primary_data_points += is_primary[block[i].point];
+		}
+		// Nothing to cluster if the block has no primary data points
+		if (len_primary_data_points == 0) return iscc_no_error();
+	}
+
+	if (len_block < options->size_constraint) {
+		return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Fewer data points than size constraint.");
+	}
+
+	const uint_fast16_t num_dimensions = data_set->num_dimensions;
+	double* const block_data_matrix = iscc_tmp_malloc(sizeof(double) * len_block * num_dimensions);
+	scc_PointIndex* const primary_data_points = (is_primary == NULL) ? NULL : iscc_tmp_malloc(sizeof(scc_PointIndex[len_primary_data_points]));
+	scc_TypeLabel* const type_labels = (options->num_types < 2) ? NULL : iscc_tmp_malloc(sizeof(scc_TypeLabel[len_block]));
+	if ((block_data_matrix == NULL) ||
+	        ((is_primary != NULL) && (primary_data_points == NULL)) ||
+	        ((options->num_types >= 2) && (type_labels == NULL))) {
+		iscc_free(block_data_matrix);
+		iscc_free(primary_data_points);
+		iscc_free(type_labels);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	size_t write_primary = 0;
+	for (size_t i = 0; i < len_block; ++i) {
+		const size_t point = (size_t) block[i].point;
+		for (uint_fast16_t d = 0; d < num_dimensions; ++d) {
+			block_data_matrix[i * num_dimensions + d] = data_set->data_matrix[point * num_dimensions + d];
+		}
+		if (type_labels != NULL) {
+			type_labels[i] = options->type_labels[point];
+		}
+		if ((is_primary != NULL) && is_primary[point]) {
+			primary_data_points[write_primary] = (scc_PointIndex) i;
+			++write_primary;
+		}
+	}
+
+	scc_ClusterOptions block_options = *options;
+	if (type_labels != NULL) {
+		block_options.len_type_labels = len_block;
+		block_options.type_labels = type_labels;
+	}
+	if (primary_data_points != NULL) {
+		block_options.len_primary_data_points = len_primary_data_points;
+		block_options.primary_data_points = primary_data_points;
+	}
+	block_options.len_blocking_labels = 0;
+	block_options.blocking_labels = NULL;
+	block_options.len_block_reports = 0;
+	block_options.block_reports = NULL;
+	block_options.run_report = NULL;
+
+	scc_ErrorCode ec;
+	scc_DataSet* block_data_set = NULL;
+	scc_Clustering* block_clustering = NULL;
+	if (((ec = iscc_init_derived_data_set(data_set,
+	                                      (uint64_t) len_block,
+	                                      len_block * num_dimensions,
+	                                      block_data_matrix,
+	                                      &block_data_set)) == SCC_ER_OK) &&
+	        ((ec = scc_init_empty_clustering((uint64_t) len_block,
+	                                         out_labels,
+	                                         &block_clustering)) == SCC_ER_OK) &&
+	        ((ec = scc_sc_clustering(block_data_set,
+	                                 &block_options,
+	                                 block_clustering)) == SCC_ER_OK)) {
+		*out_num_clusters = block_clustering->num_clusters;
+	}
+
+	scc_free_clustering(&block_clustering);
+	scc_free_data_set(&block_data_set);
+	iscc_free(block_data_matrix);
+	iscc_free(primary_data_points);
+	iscc_free(type_labels);
+
+	return ec;
+}
@@ -25,13 +25,22 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include "allocator.h"
 #include "clustering_struct.h"
+#include "data_set_collapse.h"
+#include "data_set_struct.h"
 #include "digraph_core.h"
 #include "dist_search.h"
 #include "error.h"
 #include "nng_batch_clustering.h"
+#include "nng_blocked_clustering.h"
 #include "nng_core.h"
 #include "nng_findseeds.h"
+#include "nng_store.h"
+#include "run_context.h"
+#include "run_report.h"
+#include "spatial_order.h"
 #include "utilities.h"
 
 
@@ -39,12 +48,79 @@
 // Static function prototypes
 // =============================================================================
 
+static scc_ErrorCode iscc_sc_clustering(scc_Clustering* clustering,
+                                        void* data_set,
+                                        const scc_ClusterOptions* options);
+
+
+static scc_ErrorCode iscc_sc_clustering_from_nng_file(scc_Clustering* clustering,
+                                                      void* data_set,
+                                                      const scc_ClusterOptions* options,
+                                                      const char* file_path);
+
+
+static scc_ErrorCode iscc_sc_clustering_collapse_duplicates(scc_Clustering* clustering,
+                                                            scc_DataSet* data_set,
+                                                            const scc_ClusterOptions* options);
+
+
+static scc_ErrorCode iscc_sc_clustering_renumbered(scc_Clustering* clustering,
+                                                   void* data_set,
+                                                   const scc_ClusterOptions* options);
+
+
+static scc_ErrorCode iscc_check_nng_clustering_input(void* data_set,
+                                                     const scc_ClusterOptions* options,
+                                                     size_t num_data_points);
+
+
+static scc_ErrorCode iscc_get_nng_from_options(void* data_set,
+                                               size_t num_data_points,
+                                               const scc_ClusterOptions* options,
+                                               iscc_Digraph* out_nng);
+
+
+static uint64_t iscc_nng_fingerprint(void* data_set,
+                                     size_t num_data_points,
+                                     const scc_ClusterOptions* options);
+
+
+static inline uint64_t iscc_fnv1a_hash(uint64_t hash,
+                                       const void* data,
+                                       size_t size);
+
+
+static inline uint64_t iscc_fnv1a_hash_doubles(uint64_t hash,
+                                               const double values[],
+                                               size_t len_values);
+
+
 static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* clustering,
                                                    void* data_set,
                                                    iscc_Digraph* nng,
                                                    const scc_ClusterOptions* options);
 
 
+static scc_ErrorCode iscc_make_lexical_clustering(scc_Clustering* clustering,
+                                                  void* data_set,
+                                                  const scc_ClusterOptions* options);
+
+
+static scc_ErrorCode iscc_make_clustering_from_seeds(scc_Clustering* clustering,
+                                                     void* data_set,
+                                                     iscc_Digraph* nng,
+                                                     const double arc_weights[],
+                                                     const iscc_SeedResult* seed_result,
+                                                     const scc_ClusterOptions* options);
+
+
+static scc_ErrorCode iscc_expand_collapsed_clustering(scc_Clustering* clustering,
+                                                     const scc_Clustering* unique_clustering,
+                                                     const iscc_CollapsedDataSet* collapsed,
+                                                     const iscc_SeedResult* seed_result,
+                                                     uint32_t size_constraint);
+
+
 // =============================================================================
 // Public function implementations
 // =============================================================================
@@ -56,64 +132,232 @@ scc_ErrorCode scc_sc_clustering(void* const data_set,
 	if (!iscc_check_input_clustering(out_clustering)) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid clustering object.");
 	}
+	scc_ErrorCode ec;
+	if ((ec = iscc_check_nng_clustering_input(data_set, options, out_clustering->num_data_points)) != SCC_ER_OK) {
+		return ec;
+	}
+	if (out_clustering->num_clusters != 0) {
+		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Cannot refine existing clusterings.");
+	}
+
+	iscc_RunContext run_context;
+	const bool run = iscc_begin_run(&run_context, options->run_report);
+	ec = iscc_sc_clustering(out_clustering, data_set, options);
+	if (run) iscc_end_run(&run_context);
+
+	return ec;
+}
+
+
+scc_ErrorCode scc_write_nng_file(void* const data_set,
+                                 const scc_ClusterOptions* const options,
+                                 const bool include_arc_distances,
+                                 const char* const file_path)
+{
+	if (file_path == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid file path.");
+	}
 	if (!iscc_check_data_set(data_set)) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data set object.");
 	}
-	if (iscc_num_data_points(data_set) != out_clustering->num_data_points) {
-		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Number of data points in data set does not match clustering object.");
+	const size_t num_data_points = iscc_num_data_points(data_set);
+	scc_ErrorCode ec;
+	if ((ec = iscc_check_nng_clustering_input(data_set, options, num_data_points)) != SCC_ER_OK) {
+		return ec;
+	}
+	if (options->seed_method == SCC_SM_BATCHES) {
+		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Batch clustering does not construct a NNG.");
+	}
+	if (options->blocking_labels != NULL) {
+		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Blocked clustering does not construct a single NNG.");
+	}
+
+	iscc_Digraph nng;
+	if ((ec = iscc_get_nng_from_options(data_set,
+	                                    num_data_points,
+	                                    options,
+	                                    &nng)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	iscc_SeedResult seed_result = {
+		.capacity = 1 + (num_data_points / options->size_constraint),
+		.count = 0,
+		.seeds = NULL,
+	};
+
+	if ((ec = iscc_find_seeds(&nng, options->seed_method, options->stable, &seed_result)) != SCC_ER_OK) {
+		iscc_free_digraph(&nng);
+		return ec;
+	}
+
+	double* arc_distances = NULL;
+	if (include_arc_distances) {
+		arc_distances = iscc_tmp_malloc(sizeof(double) * nng.tail_ptr[nng.vertices]);
+		if (arc_distances == NULL) {
+			iscc_free(seed_result.seeds);
+			iscc_free_digraph(&nng);
+			return iscc_make_error(SCC_ER_NO_MEMORY);
+		}
+		const scc_PointIndex vertices_pi = (scc_PointIndex) nng.vertices; // If `scc_PointIndex` is signed.
+		for (scc_PointIndex v = 0; v < vertices_pi; ++v) {
+			const size_t num_arcs = nng.tail_ptr[v + 1] - nng.tail_ptr[v];
+			if ((num_arcs > 0) && !iscc_get_dist_rows(data_set,
+			                                          1,
+			                                          &v,
+			                                          num_arcs,
+			                                          nng.head + nng.tail_ptr[v],
+			                                          arc_distances + nng.tail_ptr[v])) {
+				iscc_free(arc_distances);
+				iscc_free(seed_result.seeds);
+				iscc_free_digraph(&nng);
+				return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+			}
+		}
+	}
+
+	const iscc_NNGFileInfo info = {
+		.seed_method = options->seed_method,
+		.fingerprint = iscc_nng_fingerprint(data_set, num_data_points, options),
+	};
+
+	ec = iscc_write_nng_file(file_path, &info, &nng, arc_distances, &seed_result);
+
+	iscc_free(arc_distances);
+	iscc_free(seed_result.seeds);
+	iscc_free_digraph(&nng);
+
+	return ec;
+}
+
+
+scc_ErrorCode scc_sc_clustering_from_nng_file(void* const data_set,
+                                              const scc_ClusterOptions* const options,
+                                              const char* const file_path,
+                                              scc_Clustering* const out_clustering)
+{
+	if (file_path == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid file path.");
+	}
+	if (!iscc_check_input_clustering(out_clustering)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid clustering object.");
+	}
+	scc_ErrorCode ec;
+	if ((ec = iscc_check_nng_clustering_input(data_set, options, out_clustering->num_data_points)) != SCC_ER_OK) {
+		return ec;
+	}
+	if (out_clustering->num_clusters != 0) {
+		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Cannot refine existing clusterings.");
+	}
+	if (options->seed_method == SCC_SM_BATCHES) {
+		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Batch clustering does not construct a NNG.");
+	}
+	if (options->blocking_labels != NULL) {
+		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Blocked clustering does not construct a single NNG.");
+	}
+
+	iscc_RunContext run_context;
+	const bool run = iscc_begin_run(&run_context, options->run_report);
+	ec = iscc_sc_clustering_from_nng_file(out_clustering, data_set, options, file_path);
+	if (run) iscc_end_run(&run_context);
+
+	return ec;
+}
+
+
+scc_ErrorCode scc_sc_clustering_collapse_duplicates(scc_DataSet* const data_set,
+                                                    const scc_ClusterOptions* const options,
+                                                    scc_Clustering* const out_clustering)
+{
+	if (!iscc_check_input_clustering(out_clustering)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid clustering object.");
+	}
+	if (!scc_is_initialized_data_set(data_set)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data set object.");
 	}
 	scc_ErrorCode ec;
-	if ((ec = iscc_check_cluster_options(options, out_clustering->num_data_points)) != SCC_ER_OK) {
+	if ((ec = iscc_check_nng_clustering_input(data_set, options, out_clustering->num_data_points)) != SCC_ER_OK) {
 		return ec;
 	}
 	if (out_clustering->num_clusters != 0) {
 		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Cannot refine existing clusterings.");
 	}
+	if (options->seed_method == SCC_SM_BATCHES) {
+		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Batch clustering cannot collapse duplicates.");
+	}
+	if (options->num_types >= 2) {
+		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Type constraints cannot be combined with collapsed duplicates.");
+	}
+	if (options->blocking_labels != NULL) {
+		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Blocking cannot be combined with collapsed duplicates.");
+	}
+
+	iscc_RunContext run_context;
+	const bool run = iscc_begin_run(&run_context, options->run_report);
+	ec = iscc_sc_clustering_collapse_duplicates(out_clustering, data_set, options);
+	if (run) iscc_end_run(&run_context);
+
+	return ec;
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static scc_ErrorCode iscc_sc_clustering(scc_Clustering* const clustering,
+                                        void* const data_set,
+                                        const scc_ClusterOptions* const options)
+{
+	assert(iscc_check_input_clustering(clustering));
+	assert(iscc_check_data_set(data_set));
+	assert(iscc_num_data_points(data_set) == clustering->num_data_points);
+	assert(options != NULL);
+
+	if (options->blocking_labels != NULL) {
+		return iscc_nng_clustering_blocks(clustering, data_set, options);
+	}
+
+	if (options->spatial_renumbering) {
+		return iscc_sc_clustering_renumbered(clustering, data_set, options);
+	}
 
+	scc_ErrorCode ec;
 	if (options->seed_method == SCC_SM_BATCHES) {
-		return scc_nng_clustering_batches(out_clustering,
-		                                  data_set,
-		                                  options->size_constraint,
-		                                  options->primary_unassigned_method,
-		                                  (options->seed_radius == SCC_RM_USE_SUPPLIED),
-		                                  options->seed_supplied_radius,
-		                                  options->len_primary_data_points,
-		                                  options->primary_data_points,
-		                                  options->batch_size);
+		// Batches interleave nearest neighbor searches and assignment
+		const double phase_start = iscc_report_phase_start();
+		ec = scc_nng_clustering_batches(clustering,
+		                                data_set,
+		                                options->size_constraint,
+		                                options->primary_unassigned_method,
+		                                (options->seed_radius == SCC_RM_USE_SUPPLIED),
+		                                options->seed_supplied_radius,
+		                                options->len_primary_data_points,
+		                                options->primary_data_points,
+		                                options->batch_size,
+		                                options->adaptive_batch_size,
+		                                options->spatial_batch_order,
+		                                options->stable);
+		iscc_report_phase_end(SCC_RP_ASSIGNMENT, phase_start);
+		return ec;
+	}
+
+	if ((options->seed_method == SCC_SM_LEXICAL) && (options->num_types < 2)) {
+		// Lexical seeds only need the arcs of vertices the scan reaches unmarked
+		return iscc_make_lexical_clustering(clustering, data_set, options);
 	}
 
 	iscc_Digraph nng;
-	if (options->num_types < 2) {
-		if ((ec = iscc_get_nng_with_size_constraint(data_set,
-		                                            out_clustering->num_data_points,
-		                                            options->size_constraint,
-		                                            options->len_primary_data_points,
-		                                            options->primary_data_points,
-		                                            (options->seed_radius == SCC_RM_USE_SUPPLIED),
-		                                            options->seed_supplied_radius,
-		                                            &nng)) != SCC_ER_OK) {
-			return ec;
-		}
-	} else {
-		assert(options->num_types <= UINT16_MAX);
-		if ((ec = iscc_get_nng_with_type_constraint(data_set,
-		                                            out_clustering->num_data_points,
-		                                            options->size_constraint,
-		                                            (uint_fast16_t) options->num_types,
-		                                            options->type_constraints,
-		                                            options->type_labels,
-		                                            options->len_primary_data_points,
-		                                            options->primary_data_points,
-		                                            (options->seed_radius == SCC_RM_USE_SUPPLIED),
-		                                            options->seed_supplied_radius,
-		                                            &nng)) != SCC_ER_OK) {
-			return ec;
-		}
+	if ((ec = iscc_get_nng_from_options(data_set,
+	                                    clustering->num_data_points,
+	                                    options,
+	                                    &nng)) != SCC_ER_OK) {
+		return ec;
 	}
 
 	assert(!iscc_digraph_is_empty(&nng));
 
-	ec = iscc_make_clustering_from_nng(out_clustering,
+	ec = iscc_make_clustering_from_nng(clustering,
 	                                   data_set,
 	                                   &nng,
 	                                   options);
@@ -124,9 +368,406 @@ scc_ErrorCode scc_sc_clustering(void* const data_set,
 }
 
 
-// =============================================================================
-// Static function implementations
-// =============================================================================
+static scc_ErrorCode iscc_sc_clustering_from_nng_file(scc_Clustering* const clustering,
+                                                      void* const data_set,
+                                                      const scc_ClusterOptions* const options,
+                                                      const char* const file_path)
+{
+	assert(iscc_check_input_clustering(clustering));
+	assert(iscc_check_data_set(data_set));
+	assert(iscc_num_data_points(data_set) == clustering->num_data_points);
+	assert(options != NULL);
+	assert(file_path != NULL);
+
+	scc_ErrorCode ec;
+	iscc_NNGFile nng_file;
+	if ((ec = iscc_open_nng_file(file_path, &nng_file)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	if ((nng_file.nng.vertices != clustering->num_data_points) ||
+	        (nng_file.info.fingerprint != iscc_nng_fingerprint(data_set, clustering->num_data_points, options))) {
+		iscc_close_nng_file(&nng_file);
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "NNG file was constructed with different data or options.");
+	}
+	if (iscc_digraph_is_empty(&nng_file.nng)) {
+		iscc_close_nng_file(&nng_file);
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Corrupt NNG file.");
+	}
+
+	// Stored seeds can be used if the seed method is the same, otherwise find new seeds in the stored NNG
+	iscc_SeedResult seed_result = nng_file.seeds;
+	bool free_seeds = false;
+	if ((nng_file.info.seed_method != options->seed_method) || (seed_result.count == 0)) {
+		seed_result = (iscc_SeedResult) {
+			.capacity = 1 + (clustering->num_data_points / options->size_constraint),
+			.count = 0,
+			.seeds = NULL,
+		};
+		if ((ec = iscc_find_seeds(&nng_file.nng, options->seed_method, options->stable, &seed_result)) != SCC_ER_OK) {
+			iscc_close_nng_file(&nng_file);
+			return ec;
+		}
+		free_seeds = true;
+	}
+
+	// `nng_file.nng` has external arrays so it is not freed by `iscc_make_nng_clusters_from_seeds`
+	iscc_Digraph nng = nng_file.nng;
+	ec = iscc_make_clustering_from_seeds(clustering,
+	                                     data_set,
+	                                     &nng,
+	                                     nng_file.arc_weights,
+	                                     &seed_result,
+	                                     options);
+
+	if (free_seeds) iscc_free(seed_result.seeds);
+	iscc_close_nng_file(&nng_file);
+
+	return ec;
+}
+
+
+static scc_ErrorCode iscc_sc_clustering_collapse_duplicates(scc_Clustering* const clustering,
+                                                            scc_DataSet* const data_set,
+                                                            const scc_ClusterOptions* const options)
+{
+	assert(iscc_check_input_clustering(clustering));
+	assert(scc_is_initialized_data_set(data_set));
+	assert(options != NULL);
+
+	scc_ErrorCode ec;
+	iscc_CollapsedDataSet collapsed;
+	if ((ec = iscc_collapse_data_set(data_set,
+	                                 options->len_primary_data_points,
+	                                 options->primary_data_points,
+	                                 &collapsed)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	scc_Clustering* unique_clustering;
+	if ((ec = scc_init_empty_clustering(collapsed.num_unique, NULL, &unique_clustering)) != SCC_ER_OK) {
+		iscc_free_collapsed_data_set(&collapsed);
+		return ec;
+	}
+
+	iscc_SeedResult seed_result = {
+		.capacity = 1 + (collapsed.num_unique / options->size_constraint),
+		.count = 0,
+		.seeds = NULL,
+	};
+
+	if (collapsed.num_unique == 1) {
+		// All data points are identical and the only point is a seed
+		unique_clustering->cluster_label = iscc_malloc(sizeof(scc_Clabel));
+		seed_result.seeds = iscc_tmp_malloc(sizeof(scc_PointIndex));
+		if ((unique_clustering->cluster_label == NULL) || (seed_result.seeds == NULL)) {
+			iscc_free(seed_result.seeds);
+			scc_free_clustering(&unique_clustering);
+			iscc_free_collapsed_data_set(&collapsed);
+			return iscc_make_error(SCC_ER_NO_MEMORY);
+		}
+		unique_clustering->cluster_label[0] = 0;
+		unique_clustering->num_clusters = 1;
+		seed_result.seeds[0] = 0;
+		seed_result.count = 1;
+	} else {
+		iscc_Digraph nng;
+		double* arc_weights;
+		const double phase_start = iscc_report_phase_start();
+		if ((ec = iscc_get_nng_with_weighted_size_constraint(collapsed.unique_data_set,
+		                                                     collapsed.num_unique,
+		                                                     collapsed.group_weights,
+		                                                     options->size_constraint,
+		                                                     collapsed.len_unique_primary_data_points,
+		                                                     collapsed.unique_primary_data_points,
+		                                                     (options->seed_radius == SCC_RM_USE_SUPPLIED),
+		                                                     options->seed_supplied_radius,
+		                                                     &nng,
+		                                                     &arc_weights)) != SCC_ER_OK) {
+			scc_free_clustering(&unique_clustering);
+			iscc_free_collapsed_data_set(&collapsed);
+			return ec;
+		}
+		iscc_report_nng_arcs(nng.tail_ptr[nng.vertices]);
+		iscc_report_phase_end(SCC_RP_NNG, phase_start);
+
+		if ((ec = iscc_find_seeds(&nng, options->seed_method, options->stable, &seed_result)) == SCC_ER_OK) {
+			scc_ClusterOptions unique_options = *options;
+			unique_options.len_primary_data_points = collapsed.len_unique_primary_data_points;
+			unique_options.primary_data_points = collapsed.unique_primary_data_points;
+			ec = iscc_make_clustering_from_seeds(unique_clustering,
+			                                     collapsed.unique_data_set,
+			                                     &nng,
+			                                     arc_weights,
+			                                     &seed_result,
+			                                     &unique_options);
+		} else {
+			seed_result.seeds = NULL; // Freed by `iscc_find_seeds` on error
+		}
+
+		iscc_free(arc_weights);
+		iscc_free_digraph(&nng);
+	}
+
+	if (ec == SCC_ER_OK) {
+		ec = iscc_expand_collapsed_clustering(clustering,
+		                                      unique_clustering,
+		                                      &collapsed,
+		                                      &seed_result,
+		                                      options->size_constraint);
+	}
+
+	iscc_free(seed_result.seeds);
+	scc_free_clustering(&unique_clustering);
+	iscc_free_collapsed_data_set(&collapsed);
+
+	return ec;
+}
+
+
+static scc_ErrorCode iscc_sc_clustering_renumbered(scc_Clustering* const clustering,
+                                                   void* const data_set,
+                                                   const scc_ClusterOptions* const options)
+{
+	assert(iscc_check_input_clustering(clustering));
+	assert(clustering->num_clusters == 0);
+	assert(iscc_check_data_set(data_set));
+	assert(options->spatial_renumbering);
+
+	// Renumbering copies the data matrix, which requires access to it
+	if (!iscc_using_imp_dist_functions()) {
+		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Spatial renumbering requires the built-in distance functions.");
+	}
+
+	const scc_DataSet* const data_set_cast = (const scc_DataSet*) data_set;
+	const size_t num_data_points = clustering->num_data_points;
+	const uint_fast16_t num_dimensions = data_set_cast->num_dimensions;
+	const bool has_primary = (options->primary_data_points != NULL);
+	const bool has_types = (options->num_types >= 2);
+
+	// `order[i]` is the original index of the data point renumbered to `i`
+	scc_PointIndex* const order = iscc_tmp_malloc(sizeof(scc_PointIndex[num_data_points]));
+	double* const renumbered_data_matrix = iscc_tmp_malloc(sizeof(double) * num_data_points * num_dimensions);
+	scc_Clabel* const renumbered_labels = iscc_tmp_malloc(sizeof(scc_Clabel[num_data_points]));
+	bool* const is_primary = has_primary ? iscc_tmp_calloc(num_data_points, sizeof(bool)) : NULL;
+	scc_PointIndex* const primary_data_points = has_primary ? iscc_tmp_malloc(sizeof(scc_PointIndex[options->len_primary_data_points])) : NULL;
+	scc_TypeLabel* const type_labels = has_types ? iscc_tmp_malloc(sizeof(scc_TypeLabel[num_data_points])) : NULL;
+	scc_ErrorCode ec = SCC_ER_OK;
+	if ((order == NULL) || (renumbered_data_matrix == NULL) || (renumbered_labels == NULL) ||
+	        (has_primary && ((is_primary == NULL) || (primary_data_points == NULL))) ||
+	        (has_types && (type_labels == NULL))) {
+		ec = iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	if (ec == SCC_ER_OK) ec = iscc_get_spatial_order(data_set_cast, order);
+
+	scc_DataSet* renumbered_data_set = NULL;
+	scc_Clustering* renumbered_clustering = NULL;
+	if (ec == SCC_ER_OK) {
+		if (has_primary) {
+			for (size_t i = 0; i < options->len_primary_data_points; ++i) {
+				is_primary[options->primary_data_points[i]] = true;
+			}
+		}
+
+		// Primary data points are written in ascending order of the new indices
+		size_t len_primary_data_points = 0;
+		for (size_t i = 0; i < num_data_points; ++i) {
+			const size_t point = (size_t) order[i];
+			for (uint_fast16_t d = 0; d < num_dimensions; ++d) {
+				renumbered_data_matrix[i * num_dimensions + d] = data_set_cast->data_matrix[point * num_dimensions + d];
+			}
+			if (has_types) {
+				type_labels[i] = options->type_labels[point];
+			}
+			if (has_primary && is_primary[point]) {
+				primary_data_points[len_primary_data_points] = (scc_PointIndex) i;
+				++len_primary_data_points;
+			}
+		}
+
+		scc_ClusterOptions renumbered_options = *options;
+		renumbered_options.spatial_renumbering = false;
+		if (has_types) {
+			renumbered_options.len_type_labels = num_data_points;
+			renumbered_options.type_labels = type_labels;
+		}
+		if (has_primary) {
+			renumbered_options.len_primary_data_points = len_primary_data_points;
+			renumbered_options.primary_data_points = primary_data_points;
+		}
+
+		if (((ec = iscc_init_derived_data_set(data_set_cast,
+		                                      (uint64_t) num_data_points,
+		                                      num_data_points * num_dimensions,
+		                                      renumbered_data_matrix,
+		                                      &renumbered_data_set)) == SCC_ER_OK) &&
+		        ((ec = scc_init_empty_clustering((uint64_t) num_data_points,
+		                                         renumbered_labels,
+		                                         &renumbered_clustering)) == SCC_ER_OK)) {
+			ec = iscc_sc_clustering(renumbered_clustering,
+			                        renumbered_data_set,
+			                        &renumbered_options);
+		}
+	}
+
+	if ((ec == SCC_ER_OK) && (clustering->cluster_label == NULL)) {
+		clustering->external_labels = false;
+		clustering->cluster_label = iscc_malloc(sizeof(scc_Clabel[num_data_points]));
+		if (clustering->cluster_label == NULL) ec = iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	// Map labels back to the original indices
+	if (ec == SCC_ER_OK) {
+		for (size_t i = 0; i < num_data_points; ++i) {
+			clustering->cluster_label[order[i]] = renumbered_labels[i];
+		}
+		clustering->num_clusters = renumbered_clustering->num_clusters;
+	}
+
+	scc_free_clustering(&renumbered_clustering);
+	scc_free_data_set(&renumbered_data_set);
+	iscc_free(order);
+	iscc_free(renumbered_data_matrix);
+	iscc_free(renumbered_labels);
+	iscc_free(is_primary);
+	iscc_free(primary_data_points);
+	iscc_free(type_labels);
+
+	return ec;
+}
+
+
+static scc_ErrorCode iscc_check_nng_clustering_input(void* const data_set,
+                                                     const scc_ClusterOptions* const options,
+                                                     const size_t num_data_points)
+{
+	if (!iscc_check_data_set(data_set)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data set object.");
+	}
+	if (iscc_num_data_points(data_set) != num_data_points) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Number of data points in data set does not match clustering object.");
+	}
+	return iscc_check_cluster_options(options, num_data_points);
+}
+
+
+static scc_ErrorCode iscc_get_nng_from_options(void* const data_set,
+                                               const size_t num_data_points,
+                                               const scc_ClusterOptions* const options,
+                                               iscc_Digraph* const out_nng)
+{
+	assert(iscc_check_data_set(data_set));
+	assert(iscc_num_data_points(data_set) == num_data_points);
+	assert(options->seed_method != SCC_SM_BATCHES);
+	assert(out_nng != NULL);
+
+	scc_ErrorCode ec;
+	const double phase_start = iscc_report_phase_start();
+	if (options->num_types < 2) {
+		ec = iscc_get_nng_with_size_constraint(data_set,
+		                                       num_data_points,
+		                                       options->size_constraint,
+		                                       options->len_primary_data_points,
+		                                       options->primary_data_points,
+		                                       (options->seed_radius == SCC_RM_USE_SUPPLIED),
+		                                       options->seed_supplied_radius,
+		                                       options->stable,
+		                                       out_nng);
+	} else {
+		assert(options->num_types <= UINT16_MAX);
+		ec = iscc_get_nng_with_type_constraint(data_set,
+		                                       num_data_points,
+		                                       options->size_constraint,
+		                                       (uint_fast16_t) options->num_types,
+		                                       options->type_constraints,
+		                                       options->type_labels,
+		                                       options->len_primary_data_points,
+		                                       options->primary_data_points,
+		                                       (options->seed_radius == SCC_RM_USE_SUPPLIED),
+		                                       options->seed_supplied_radius,
+		                                       options->stable,
+		                                       out_nng);
+	}
+
+	if (ec == SCC_ER_OK) {
+		iscc_report_nng_arcs(out_nng->tail_ptr[out_nng->vertices]);
+	}
+	iscc_report_phase_end(SCC_RP_NNG, phase_start);
+
+	return ec;
+}
+
+
+static uint64_t iscc_nng_fingerprint(void* const data_set,
+                                     const size_t num_data_points,
+                                     const scc_ClusterOptions* const options)
+{
+	// Hash of the data and all options that affect the NNG
+	const uint64_t num_data_points_u64 = (uint64_t) num_data_points;
+	const bool radius_constraint = (options->seed_radius == SCC_RM_USE_SUPPLIED);
+	const double radius = radius_constraint ? options->seed_supplied_radius : 0.0;
+	const uint64_t len_primary_data_points = (options->primary_data_points == NULL) ? 0 : (uint64_t) options->len_primary_data_points;
+
+	uint64_t hash = UINT64_C(14695981039346656037);
+	hash = iscc_fnv1a_hash(hash, &num_data_points_u64, sizeof(num_data_points_u64));
+	hash = iscc_fnv1a_hash(hash, &options->size_constraint, sizeof(options->size_constraint));
+	hash = iscc_fnv1a_hash(hash, &options->stable, sizeof(options->stable));
+	hash = iscc_fnv1a_hash(hash, &radius_constraint, sizeof(radius_constraint));
+	hash = iscc_fnv1a_hash(hash, &radius, sizeof(radius));
+	hash = iscc_fnv1a_hash(hash, &len_primary_data_points, sizeof(len_primary_data_points));
+	if (options->primary_data_points != NULL) {
+		hash = iscc_fnv1a_hash(hash, options->primary_data_points, sizeof(scc_PointIndex) * options->len_primary_data_points);
+	}
+	if (options->num_types >= 2) {
+		hash = iscc_fnv1a_hash(hash, &options->num_types, sizeof(options->num_types));
+		hash = iscc_fnv1a_hash(hash, options->type_constraints, sizeof(uint32_t) * options->num_types);
+		hash = iscc_fnv1a_hash(hash, options->type_labels, sizeof(scc_TypeLabel) * num_data_points);
+	}
+
+	// The data matrix is only accessible with the built-in distance functions.
+	// Metric parameters are covered by the hash of the data matrix, which is
+	// transformed with them.
+	if (iscc_using_imp_dist_functions()) {
+		const scc_DataSet* const data_set_cast = (const scc_DataSet*) data_set;
+		const uint64_t num_dimensions_u64 = (uint64_t) data_set_cast->num_dimensions;
+		const uint64_t metric_u64 = (uint64_t) data_set_cast->metric;
+		hash = iscc_fnv1a_hash(hash, &num_dimensions_u64, sizeof(num_dimensions_u64));
+		hash = iscc_fnv1a_hash(hash, &metric_u64, sizeof(metric_u64));
+		hash = iscc_fnv1a_hash_doubles(hash, data_set_cast->data_matrix, num_data_points * data_set_cast->num_dimensions);
+	}
+
+	return hash;
+}
+
+
+static inline uint64_t iscc_fnv1a_hash(uint64_t hash,
+                                       const void* const data,
+                                       const size_t size)
+{
+	const unsigned char* const bytes = data;
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= UINT64_C(1099511628211);
+	}
+	return hash;
+}
+
+
+static inline uint64_t iscc_fnv1a_hash_doubles(uint64_t hash,
+                                               const double values[const],
+                                               const size_t len_values)
+{
+	// Hashes whole words rather than bytes, which is eight times faster on large data matrices
+	for (size_t i = 0; i < len_values; ++i) {
+		uint64_t word;
+		memcpy(&word, &values[i], sizeof(word));
+		hash ^= word;
+		hash *= UINT64_C(1099511628211);
+	}
+	return hash;
+}
+
 
 static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* const clustering,
                                                    void* const data_set,
@@ -146,10 +787,87 @@ static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* const cluster
 	};
 
 	scc_ErrorCode ec;
-	if ((ec = iscc_find_seeds(nng, options->seed_method, &seed_result)) != SCC_ER_OK) {
+	if ((ec = iscc_find_seeds(nng, options->seed_method, options->stable, &seed_result)) != SCC_ER_OK) {
 		return ec;
 	}
 
+	ec = iscc_make_clustering_from_seeds(clustering,
+	                                     data_set,
+	                                     nng,
+	                                     NULL,
+	                                     &seed_result,
+	                                     options);
+
+	iscc_free(seed_result.seeds);
+	return ec;
+}
+
+
+static scc_ErrorCode iscc_make_lexical_clustering(scc_Clustering* const clustering,
+                                                  void* const data_set,
+                                                  const scc_ClusterOptions* const options)
+{
+	assert(iscc_check_input_clustering(clustering));
+	assert(iscc_check_data_set(data_set));
+	assert(iscc_num_data_points(data_set) == clustering->num_data_points);
+	assert(options->seed_method == SCC_SM_LEXICAL);
+	assert(options->num_types < 2);
+
+	iscc_SeedResult seed_result = {
+		.capacity = 1 + (clustering->num_data_points / options->size_constraint),
+		.count = 0,
+		.seeds = NULL,
+	};
+
+	// Seed finding is fused with the NNG and timed as part of it
+	iscc_Digraph nng;
+	scc_ErrorCode ec;
+	const double phase_start = iscc_report_phase_start();
+	ec = iscc_get_nng_with_lexical_seeds(data_set,
+	                                     clustering->num_data_points,
+	                                     options->size_constraint,
+	                                     options->len_primary_data_points,
+	                                     options->primary_data_points,
+	                                     (options->seed_radius == SCC_RM_USE_SUPPLIED),
+	                                     options->seed_supplied_radius,
+	                                     options->stable,
+	                                     &nng,
+	                                     &seed_result);
+	if (ec == SCC_ER_OK) {
+		iscc_report_nng_arcs(nng.tail_ptr[nng.vertices]);
+	}
+	iscc_report_phase_end(SCC_RP_NNG, phase_start);
+	if (ec != SCC_ER_OK) return ec;
+
+	ec = iscc_make_clustering_from_seeds(clustering,
+	                                     data_set,
+	                                     &nng,
+	                                     NULL,
+	                                     &seed_result,
+	                                     options);
+
+	iscc_free(seed_result.seeds);
+	iscc_free_digraph(&nng);
+
+	return ec;
+}
+
+
+static scc_ErrorCode iscc_make_clustering_from_seeds(scc_Clustering* const clustering,
+                                                     void* const data_set,
+                                                     iscc_Digraph* const nng,
+                                                     const double arc_weights[const],
+                                                     const iscc_SeedResult* const seed_result,
+                                                     const scc_ClusterOptions* const options)
+{
+	assert(iscc_check_input_clustering(clustering));
+	assert(iscc_check_data_set(data_set));
+	assert(iscc_num_data_points(data_set) == clustering->num_data_points);
+	assert(iscc_digraph_is_valid(nng));
+	assert(!iscc_digraph_is_empty(nng));
+	assert(seed_result->count > 0);
+
+	scc_ErrorCode ec;
 	scc_RadiusMethod primary_radius = options->primary_radius;
 	double primary_supplied_radius = options->primary_supplied_radius;
 	scc_RadiusMethod secondary_radius = options->secondary_radius;
@@ -179,12 +897,16 @@ static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* const cluster
 	if ((primary_radius == SCC_RM_USE_ESTIMATED) ||
 	        (secondary_radius == SCC_RM_USE_ESTIMATED)) {
 		double avg_seed_dist;
-		if ((ec = iscc_estimate_avg_seed_dist(data_set,
-		                                      &seed_result,
-		                                      nng,
-		                                      options->size_constraint,
-		                                      &avg_seed_dist)) != SCC_ER_OK) {
-			free(seed_result.seeds);
+		if (arc_weights != NULL) {
+			iscc_estimate_avg_seed_dist_from_weights(seed_result,
+			                                         nng,
+			                                         arc_weights,
+			                                         &avg_seed_dist);
+		} else if ((ec = iscc_estimate_avg_seed_dist(data_set,
+		                                             seed_result,
+		                                             nng,
+		                                             options->size_constraint,
+		                                             &avg_seed_dist)) != SCC_ER_OK) {
 			return ec;
 		}
 
@@ -193,7 +915,6 @@ static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* const cluster
 				primary_radius = SCC_RM_USE_SUPPLIED;
 				primary_supplied_radius = avg_seed_dist;
 			} else {
-				free(seed_result.seeds);
 				return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Infeasible radius constraint.");
 			}
 		}
@@ -203,7 +924,6 @@ static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* const cluster
 				secondary_radius = SCC_RM_USE_SUPPLIED;
 				secondary_supplied_radius = avg_seed_dist;
 			} else {
-				free(seed_result.seeds);
 				return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Infeasible radius constraint.");
 			}
 		}
@@ -215,16 +935,14 @@ static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* const cluster
 	// Initialize cluster labels
 	if (clustering->cluster_label == NULL) {
 		clustering->external_labels = false;
-		clustering->cluster_label = malloc(sizeof(scc_Clabel[clustering->num_data_points]));
-		if (clustering->cluster_label == NULL) {
-			free(seed_result.seeds);
-			return iscc_make_error(SCC_ER_NO_MEMORY);
-		}
+		clustering->cluster_label = iscc_malloc(sizeof(scc_Clabel[clustering->num_data_points]));
+		if (clustering->cluster_label == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
+	const double phase_start = iscc_report_phase_start();
 	ec = iscc_make_nng_clusters_from_seeds(clustering,
 	                                       data_set,
-	                                       &seed_result,
+	                                       seed_result,
 	                                       nng,
 	                                       (options->num_types < 2),
 	                                       options->primary_unassigned_method,
@@ -235,7 +953,83 @@ static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* const cluster
 	                                       options->secondary_unassigned_method,
 	                                       (secondary_radius == SCC_RM_USE_SUPPLIED),
 	                                       secondary_supplied_radius);
+	iscc_report_phase_end(SCC_RP_ASSIGNMENT, phase_start);
 
-	free(seed_result.seeds);
 	return ec;
 }
+
+
+static scc_ErrorCode iscc_expand_collapsed_clustering(scc_Clustering* const clustering,
+                                                     const scc_Clustering* const unique_clustering,
+                                                     const iscc_CollapsedDataSet* const collapsed,
+                                                     const iscc_SeedResult* const seed_result,
+                                                     const uint32_t size_constraint)
+{
+	assert(iscc_check_input_clustering(clustering));
+	assert(iscc_check_input_clustering(unique_clustering));
+	assert(unique_clustering->num_data_points == collapsed->num_unique);
+	assert(seed_result->count == unique_clustering->num_clusters);
+	assert(size_constraint >= 2);
+
+	const size_t num_unique = collapsed->num_unique;
+
+	/* Seeds that alone satisfy the size constraint represent identical data points.
+	 * These points are split into as many clusters as the size constraint allows,
+	 * as they would have been if they were not collapsed. The first part keeps the
+	 * label of the seed so that points assigned to the seed are unaffected. */
+	size_t num_clusters = unique_clustering->num_clusters;
+	scc_Clabel* split_label_start = NULL;
+	size_t* num_expanded = NULL;
+	for (size_t s = 0; s < seed_result->count; ++s) {
+		const size_t num_parts = collapsed->group_weights[seed_result->seeds[s]] / size_constraint;
+		if (num_parts < 2) continue;
+		if (split_label_start == NULL) {
+			split_label_start = iscc_tmp_malloc(sizeof(scc_Clabel[num_unique]));
+			num_expanded = iscc_tmp_calloc(num_unique, sizeof(size_t));
+			if ((split_label_start == NULL) || (num_expanded == NULL)) {
+				iscc_free(split_label_start);
+				iscc_free(num_expanded);
+				return iscc_make_error(SCC_ER_NO_MEMORY);
+			}
+			for (size_t u = 0; u < num_unique; ++u) split_label_start[u] = SCC_CLABEL_NA;
+		}
+		if (num_clusters + num_parts - 1 > (size_t) SCC_CLABEL_MAX) {
+			iscc_free(split_label_start);
+			iscc_free(num_expanded);
+			return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many clusters (adjust the `scc_Clabel` type).");
+		}
+		split_label_start[seed_result->seeds[s]] = (scc_Clabel) num_clusters;
+		num_clusters += num_parts - 1;
+	}
+
+	if (clustering->cluster_label == NULL) {
+		clustering->external_labels = false;
+		clustering->cluster_label = iscc_malloc(sizeof(scc_Clabel[clustering->num_data_points]));
+		if (clustering->cluster_label == NULL) {
+			iscc_free(split_label_start);
+			iscc_free(num_expanded);
+			return iscc_make_error(SCC_ER_NO_MEMORY);
+		}
+	}
+
+	for (size_t i = 0; i < clustering->num_data_points; ++i) {
+		const scc_PointIndex u = collapsed->point_group[i];
+		clustering->cluster_label[i] = unique_clustering->cluster_label[u];
+		if ((split_label_start != NULL) && (split_label_start[u] != SCC_CLABEL_NA)) {
+			// The remainder of points is kept in the first part
+			const size_t num_parts = collapsed->group_weights[u] / size_constraint;
+			const size_t part = (collapsed->group_weights[u] - 1 - num_expanded[u]) / size_constraint;
+			if (part < num_parts - 1) {
+				clustering->cluster_label[i] = split_label_start[u] + (scc_Clabel) part;
+			}
+			++num_expanded[u];
+		}
+	}
+
+	clustering->num_clusters = num_clusters;
+
+	iscc_free(split_label_start);
+	iscc_free(num_expanded);
+
+	return iscc_no_error();
+}
@@ -27,6 +27,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "../include/scclust.h"
+#include "allocator.h"
 #include "clustering_struct.h"
 #include "digraph_core.h"
 #include "digraph_operations.h"
@@ -51,6 +52,11 @@ typedef struct iscc_TypeCount {
 static const size_t ISCC_ESTIMATE_AVG_MAX_SAMPLE = 1000;
 
 
+// Vertices searched together when the NNG is built during lexical seed finding.
+// Searches of vertices marked by earlier seeds in the same batch are wasted.
+static const size_t ISCC_LEXICAL_NNG_BATCH_SIZE = 64;
+
+
 // =============================================================================
 // Static function prototypes
 // =============================================================================
@@ -111,11 +117,11 @@ static scc_ErrorCode iscc_assign_by_nn_search(scc_Clustering* clustering,
                                               double radius);
 
 
-#ifdef SCC_STABLE_NNG
-
 static void iscc_sort_nng(iscc_Digraph* nng);
 
-#endif // ifdef SCC_STABLE_NNG
+
+static int iscc_compare_PointIndex(const void* a,
+                                   const void* b);
 
 
 // =============================================================================
@@ -129,6 +135,7 @@ scc_ErrorCode iscc_get_nng_with_size_constraint(void* const data_set,
                                                 const scc_PointIndex primary_data_points[],
                                                 const bool radius_constraint,
                                                 const double radius,
+                                                bool stable,
                                                 iscc_Digraph* const out_nng)
 {
 	assert(iscc_check_data_set(data_set));
@@ -139,6 +146,10 @@ scc_ErrorCode iscc_get_nng_with_size_constraint(void* const data_set,
 	assert(!radius_constraint || (radius > 0.0));
 	assert(out_nng != NULL);
 
+	#ifdef SCC_STABLE_NNG
+		stable = true;
+	#endif // ifdef SCC_STABLE_NNG
+
 	size_t num_queries;
 	if (primary_data_points == NULL) {
 		num_queries = num_data_points;
@@ -174,10 +185,304 @@ scc_ErrorCode iscc_get_nng_with_size_constraint(void* const data_set,
 		return ec;
 	}
 
+	if (stable) iscc_sort_nng(out_nng);
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode iscc_get_nng_with_lexical_seeds(void* const data_set,
+                                              const size_t num_data_points,
+                                              const uint32_t size_constraint,
+                                              const size_t len_primary_data_points,
+                                              const scc_PointIndex primary_data_points[const],
+                                              const bool radius_constraint,
+                                              const double radius,
+                                              bool stable,
+                                              iscc_Digraph* const out_nng,
+                                              iscc_SeedResult* const out_seeds)
+{
+	assert(iscc_check_data_set(data_set));
+	assert(iscc_num_data_points(data_set) == num_data_points);
+	assert(num_data_points >= 2);
+	assert(size_constraint <= num_data_points);
+	assert(size_constraint >= 2);
+	assert(!radius_constraint || (radius > 0.0));
+	assert(out_nng != NULL);
+	assert(out_seeds->capacity > 0);
+	assert(out_seeds->count == 0);
+	assert(out_seeds->seeds == NULL);
+
 	#ifdef SCC_STABLE_NNG
-		iscc_sort_nng(out_nng);
+		stable = true;
 	#endif // ifdef SCC_STABLE_NNG
 
+	const size_t k = size_constraint;
+	const size_t batch_size = ISCC_LEXICAL_NNG_BATCH_SIZE;
+	bool* const marks = iscc_tmp_calloc(num_data_points, sizeof(bool));
+	bool* const is_primary = (primary_data_points == NULL) ? NULL : iscc_tmp_calloc(num_data_points, sizeof(bool));
+	scc_PointIndex* const batch_indices = iscc_tmp_malloc(sizeof(scc_PointIndex[batch_size]));
+	scc_PointIndex* const ok_indices = iscc_tmp_malloc(sizeof(scc_PointIndex[batch_size]));
+	scc_PointIndex* const out_indices = iscc_tmp_malloc(sizeof(scc_PointIndex) * batch_size * k);
+	out_seeds->seeds = iscc_tmp_malloc(sizeof(scc_PointIndex[out_seeds->capacity]));
+	scc_ErrorCode ec = SCC_ER_OK;
+	if ((marks == NULL) || ((primary_data_points != NULL) && (is_primary == NULL)) ||
+	        (batch_indices == NULL) || (ok_indices == NULL) || (out_indices == NULL) ||
+	        (out_seeds->seeds == NULL)) {
+		ec = iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	*out_nng = ISCC_NULL_DIGRAPH;
+	if (ec == SCC_ER_OK) {
+		ec = iscc_init_digraph(num_data_points, batch_size * k, out_nng);
+	}
+
+	iscc_NNSearchObject* nn_search_object = NULL;
+	if ((ec == SCC_ER_OK) && !iscc_init_nn_search_object(data_set,
+	                                                     num_data_points,
+	                                                     NULL,
+	                                                     &nn_search_object)) {
+		ec = iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	}
+
+	if ((ec == SCC_ER_OK) && (primary_data_points != NULL)) {
+		for (size_t i = 0; i < len_primary_data_points; ++i) {
+			is_primary[primary_data_points[i]] = true;
+		}
+	}
+
+	// Vertices are searched in batches as the lexical scan reaches them. Vertices
+	// that are marked when reached are not searched, and their rows are left empty.
+	assert(num_data_points <= ISCC_POINTINDEX_MAX);
+	const scc_PointIndex vertices = (scc_PointIndex) num_data_points; // If `scc_PointIndex` is signed
+	if (ec == SCC_ER_OK) out_nng->tail_ptr[0] = 0;
+	for (scc_PointIndex curr_vertex = 0; (ec == SCC_ER_OK) && (curr_vertex < vertices); ) {
+		const scc_PointIndex range_start = curr_vertex;
+		size_t in_batch = 0;
+		for (; (in_batch < batch_size) && (curr_vertex < vertices); ++curr_vertex) {
+			if (!marks[curr_vertex] && ((is_primary == NULL) || is_primary[curr_vertex])) {
+				batch_indices[in_batch] = curr_vertex;
+				++in_batch;
+			}
+		}
+
+		size_t num_ok = 0;
+		if ((in_batch > 0) && !iscc_nearest_neighbor_search(nn_search_object,
+		                                                    in_batch,
+		                                                    batch_indices,
+		                                                    size_constraint,
+		                                                    radius_constraint,
+		                                                    radius,
+		                                                    &num_ok,
+		                                                    radius_constraint ? ok_indices : NULL,
+		                                                    out_indices)) {
+			ec = iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+			break;
+		}
+		const scc_PointIndex* const ok_queries = radius_constraint ? ok_indices : batch_indices;
+
+		const iscc_ArcIndex num_arcs = out_nng->tail_ptr[range_start];
+		if (num_arcs + num_ok * (k - 1) > out_nng->max_arcs) {
+			uintmax_t new_max_arcs = 2 * out_nng->max_arcs;
+			if (new_max_arcs < num_arcs + num_ok * (k - 1)) new_max_arcs = num_arcs + num_ok * (k - 1);
+			if (new_max_arcs > num_data_points * (k - 1)) new_max_arcs = num_data_points * (k - 1);
+			out_nng->tail_ptr[num_data_points] = num_arcs; // Rows after `range_start` are unwritten
+			if ((ec = iscc_change_arc_storage(out_nng, new_max_arcs)) != SCC_ER_OK) break;
+		}
+
+		// Rows as in `iscc_get_nng_with_size_constraint`: the self-loop, or the
+		// farthest neighbor if no self-loop was found, is removed
+		iscc_ArcIndex write_arc = num_arcs;
+		size_t q = 0;
+		for (scc_PointIndex v = range_start; v < curr_vertex; ++v) {
+			if ((q < num_ok) && (ok_queries[q] == v)) {
+				const scc_PointIndex* const row = out_indices + q * k;
+				size_t self_pos = k - 1;
+				for (size_t i = 0; i < k; ++i) {
+					if (row[i] == v) {
+						self_pos = i;
+						break;
+					}
+				}
+				for (size_t i = 0; i < k; ++i) {
+					if (i != self_pos) {
+						out_nng->head[write_arc] = row[i];
+						++write_arc;
+					}
+				}
+				if (stable) {
+					qsort(out_nng->head + out_nng->tail_ptr[v], k - 1, sizeof(scc_PointIndex), iscc_compare_PointIndex);
+				}
+				++q;
+			}
+			out_nng->tail_ptr[v + 1] = write_arc;
+		}
+		assert(q == num_ok);
+
+		ec = iscc_find_lexical_seeds_in_range(out_nng,
+		                                      range_start,
+		                                      curr_vertex,
+		                                      marks,
+		                                      out_seeds);
+	}
+
+	if ((nn_search_object != NULL) && !iscc_close_nn_search_object(&nn_search_object) && (ec == SCC_ER_OK)) {
+		ec = iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	}
+
+	if ((ec == SCC_ER_OK) && iscc_digraph_is_empty(out_nng)) {
+		ec = iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Infeasible radius constraint.");
+	}
+
+	if (ec == SCC_ER_OK) {
+		ec = iscc_change_arc_storage(out_nng, out_nng->tail_ptr[num_data_points]);
+	}
+
+	if ((ec == SCC_ER_OK) && (out_seeds->count < out_seeds->capacity)) {
+		scc_PointIndex* const tmp_seed_ptr = iscc_realloc(out_seeds->seeds, sizeof(scc_PointIndex[out_seeds->count]));
+		if (tmp_seed_ptr != NULL) {
+			out_seeds->seeds = tmp_seed_ptr;
+			out_seeds->capacity = out_seeds->count;
+		}
+	}
+
+	if (ec != SCC_ER_OK) {
+		iscc_free_digraph(out_nng);
+		iscc_free(out_seeds->seeds);
+		out_seeds->seeds = NULL;
+	}
+	iscc_free(marks);
+	iscc_free(is_primary);
+	iscc_free(batch_indices);
+	iscc_free(ok_indices);
+	iscc_free(out_indices);
+
+	return ec;
+}
+
+
+scc_ErrorCode iscc_get_nng_with_weighted_size_constraint(void* const data_set,
+                                                         const size_t num_data_points,
+                                                         const size_t point_weights[const static num_data_points],
+                                                         const uint32_t size_constraint,
+                                                         const size_t len_primary_data_points,
+                                                         const scc_PointIndex primary_data_points[const],
+                                                         const bool radius_constraint,
+                                                         const double radius,
+                                                         iscc_Digraph* const out_nng,
+                                                         double** const out_arc_weights)
+{
+	assert(iscc_check_data_set(data_set));
+	assert(iscc_num_data_points(data_set) == num_data_points);
+	assert(num_data_points >= 2);
+	assert(point_weights != NULL);
+	assert(size_constraint >= 2);
+	assert(!radius_constraint || (radius > 0.0));
+	assert(out_nng != NULL);
+	assert(out_arc_weights != NULL);
+
+	size_t num_queries;
+	if (primary_data_points == NULL) {
+		num_queries = num_data_points;
+	} else {
+		num_queries = len_primary_data_points;
+	}
+
+	// All weights are at least one, so `size_constraint` neighbors always satisfy the constraint
+	const uint32_t k = (size_constraint < num_data_points) ? size_constraint : (uint32_t) num_data_points;
+
+	scc_ErrorCode ec;
+	if ((ec = iscc_make_nng(data_set,
+	                        num_data_points,
+	                        num_data_points,
+	                        NULL,
+	                        num_queries,
+	                        primary_data_points,
+	                        k,
+	                        false,
+	                        0.0,
+	                        NULL,
+	                        NULL,
+	                        out_nng)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	iscc_ensure_self_match(out_nng, num_data_points, NULL);
+
+	double* const arc_weights = iscc_tmp_malloc(sizeof(double) * out_nng->tail_ptr[num_data_points]);
+	if (arc_weights == NULL) {
+		iscc_free_digraph(out_nng);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	/* Keep the shortest prefix of each neighborhood whose total weight, including
+	 * the vertex itself, satisfies the size constraint. Self-loops are removed,
+	 * except when a vertex alone satisfies the constraint; the self-loop then
+	 * makes the vertex eligible as a seed. Neighborhoods are compacted in place. */
+	iscc_ArcIndex write_arc = 0;
+	iscc_ArcIndex read_arc_start = out_nng->tail_ptr[0];
+	assert(num_data_points <= ISCC_POINTINDEX_MAX);
+	const scc_PointIndex num_data_points_pi = (scc_PointIndex) num_data_points; // If `scc_PointIndex` is signed.
+	for (scc_PointIndex v = 0; v < num_data_points_pi; ++v) {
+		const iscc_ArcIndex read_arc_stop = out_nng->tail_ptr[v + 1];
+		const iscc_ArcIndex v_arc_start = write_arc;
+
+		if (read_arc_start != read_arc_stop) {
+			size_t total_weight = point_weights[v];
+			for (iscc_ArcIndex a = read_arc_start; (a != read_arc_stop) && (total_weight < size_constraint); ++a) {
+				if (out_nng->head[a] != v) {
+					total_weight += point_weights[out_nng->head[a]];
+					out_nng->head[write_arc] = out_nng->head[a];
+					++write_arc;
+				}
+			}
+			assert(total_weight >= size_constraint);
+
+			if (write_arc == v_arc_start) {
+				out_nng->head[write_arc] = v;
+				++write_arc;
+			}
+
+			if (!iscc_get_dist_rows(data_set,
+			                        1,
+			                        &v,
+			                        write_arc - v_arc_start,
+			                        out_nng->head + v_arc_start,
+			                        arc_weights + v_arc_start)) {
+				iscc_free(arc_weights);
+				iscc_free_digraph(out_nng);
+				return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+			}
+
+			if (radius_constraint) {
+				for (iscc_ArcIndex a = v_arc_start; a != write_arc; ++a) {
+					if (arc_weights[a] > radius) {
+						write_arc = v_arc_start;
+						break;
+					}
+				}
+			}
+		}
+
+		out_nng->tail_ptr[v + 1] = write_arc;
+		read_arc_start = read_arc_stop;
+	}
+
+	if (write_arc == 0) {
+		iscc_free(arc_weights);
+		iscc_free_digraph(out_nng);
+		return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Infeasible radius constraint.");
+	}
+
+	if ((ec = iscc_change_arc_storage(out_nng, write_arc)) != SCC_ER_OK) {
+		iscc_free(arc_weights);
+		iscc_free_digraph(out_nng);
+		return ec;
+	}
+
+	// The NNG is not sorted for stability as that would separate arcs from their weights
+	*out_arc_weights = arc_weights;
+
 	return iscc_no_error();
 }
 
@@ -192,6 +497,7 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
                                                 const scc_PointIndex primary_data_points[],
                                                 const bool radius_constraint,
                                                 const double radius,
+                                                bool stable,
                                                 iscc_Digraph* const out_nng)
 {
 	assert(iscc_check_data_set(data_set));
@@ -206,6 +512,10 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
 	assert(!radius_constraint || (radius > 0.0));
 	assert(out_nng != NULL);
 
+	#ifdef SCC_STABLE_NNG
+		stable = true;
+	#endif // ifdef SCC_STABLE_NNG
+
 	size_t num_queries;
 	if (primary_data_points == NULL) {
 		num_queries = num_data_points;
@@ -216,7 +526,7 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
 	scc_PointIndex* seedable;
 	const scc_PointIndex* seedable_const;
 	if (radius_constraint) {
-		seedable = malloc(sizeof(scc_PointIndex[num_queries]));
+		seedable = iscc_tmp_malloc(sizeof(scc_PointIndex[num_queries]));
 		if (seedable == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 		seedable_const = seedable;
 		if (primary_data_points == NULL) {
@@ -231,9 +541,9 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
 		seedable_const = primary_data_points;
 	}
 
-	iscc_Digraph* const nng_by_type = malloc(sizeof(iscc_Digraph[num_types]));
+	iscc_Digraph* const nng_by_type = iscc_tmp_malloc(sizeof(iscc_Digraph[num_types]));
 	if (nng_by_type == NULL) {
-		free(seedable);
+		iscc_free(seedable);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
@@ -245,8 +555,8 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
 	                          type_constraints,
 	                          type_labels,
 	                          &tc)) != SCC_ER_OK) {
-		free(seedable);
-		free(nng_by_type);
+		iscc_free(seedable);
+		iscc_free(nng_by_type);
 		return ec;
 	}
 
@@ -278,9 +588,9 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
 		}
 	}
 
-	free(tc.type_group_size);
-	free(tc.point_store);
-	free(tc.type_groups);
+	iscc_free(tc.type_group_size);
+	iscc_free(tc.point_store);
+	iscc_free(tc.type_groups);
 
 	if (ec == SCC_ER_OK) {
 		if (size_constraint > tc.sum_type_constraints) {
@@ -294,11 +604,11 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
 	for (uint_fast16_t i = 0; i < num_non_zero_type_constraints; ++i) {
 		iscc_free_digraph(&nng_by_type[i]);
 	}
-	free(nng_by_type);
+	iscc_free(nng_by_type);
 
 	if (ec != SCC_ER_OK) {
 		// When `ec != SCC_ER_OK`, error is from `iscc_digraph_union_and_delete` so `out_nng` is already freed
-		free(seedable);
+		iscc_free(seedable);
 		return ec;
 	}
 
@@ -319,7 +629,7 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
 		                        &num_queries,
 		                        seedable,
 		                        &nng_sum[1])) != SCC_ER_OK) {
-			free(seedable);
+			iscc_free(seedable);
 			iscc_free_digraph(&nng_sum[0]);
 			return ec;
 		}
@@ -338,16 +648,14 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
 		iscc_free_digraph(&nng_sum[1]);
 
 		if (ec != SCC_ER_OK) {
-			free(seedable);
+			iscc_free(seedable);
 			return ec;
 		}
 	}
 
-	free(seedable);
+	iscc_free(seedable);
 
-	#ifdef SCC_STABLE_NNG
-		iscc_sort_nng(out_nng);
-	#endif // ifdef SCC_STABLE_NNG
+	if (stable) iscc_sort_nng(out_nng);
 
 	return iscc_no_error();
 }
@@ -373,7 +681,7 @@ scc_ErrorCode iscc_estimate_avg_seed_dist(void* const data_set,
 
 	size_t sampled = 0;
 	double sum_dist = 0.0;
-	double* const dist_scratch = malloc(sizeof(double[size_constraint]));
+	double* const dist_scratch = iscc_tmp_malloc(sizeof(double[size_constraint]));
 	if (dist_scratch == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 	for (size_t s = 0; s < seed_result->count; s += step) {
@@ -391,7 +699,7 @@ scc_ErrorCode iscc_estimate_avg_seed_dist(void* const data_set,
 		                        num_neighbors,
 		                        neighbors,
 		                        dist_scratch)) {
-			free(dist_scratch);
+			iscc_free(dist_scratch);
 			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 		}
 
@@ -410,7 +718,7 @@ scc_ErrorCode iscc_estimate_avg_seed_dist(void* const data_set,
 		sum_dist += tmp_dist / ((double) num_non_self_loops);
 	}
 
-	free(dist_scratch);
+	iscc_free(dist_scratch);
 
 	*out_avg_seed_dist = sum_dist / ((double) sampled);
 
@@ -418,6 +726,44 @@ scc_ErrorCode iscc_estimate_avg_seed_dist(void* const data_set,
 }
 
 
+void iscc_estimate_avg_seed_dist_from_weights(const iscc_SeedResult* const seed_result,
+                                              const iscc_Digraph* const nng,
+                                              const double arc_weights[const],
+                                              double* const out_avg_seed_dist)
+{
+	assert(seed_result->count > 0);
+	assert(seed_result->seeds != NULL);
+	assert(iscc_digraph_is_valid(nng));
+	assert(!iscc_digraph_is_empty(nng));
+	assert(arc_weights != NULL);
+	assert(out_avg_seed_dist != NULL);
+
+	// Same sample as `iscc_estimate_avg_seed_dist`, but arc lengths are already known
+	const size_t step = (seed_result->count > ISCC_ESTIMATE_AVG_MAX_SAMPLE) ? (seed_result->count / ISCC_ESTIMATE_AVG_MAX_SAMPLE) : 1;
+	assert(step > 0);
+
+	size_t sampled = 0;
+	double sum_dist = 0.0;
+	for (size_t s = 0; s < seed_result->count; s += step) {
+		const scc_PointIndex seed = seed_result->seeds[s];
+		double tmp_dist = 0.0;
+		size_t num_non_self_loops = 0;
+		for (iscc_ArcIndex a = nng->tail_ptr[seed]; a < nng->tail_ptr[seed + 1]; ++a) {
+			if (nng->head[a] != seed) {
+				tmp_dist += arc_weights[a];
+				++num_non_self_loops;
+			}
+		}
+		// Seeds in NNGs of collapsed data sets may only have a self-loop
+		if (num_non_self_loops > 0) tmp_dist /= (double) num_non_self_loops;
+		++sampled;
+		sum_dist += tmp_dist;
+	}
+
+	*out_avg_seed_dist = sum_dist / ((double) sampled);
+}
+
+
 scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering,
                                                 void* const data_set,
                                                 const iscc_SeedResult* const seed_result,
@@ -463,7 +809,7 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering
 	scc_PointIndex* seed_or_neighbor = NULL;
 	if ((unassigned_method == SCC_UM_CLOSEST_ASSIGNED) ||
 	        (secondary_unassigned_method == SCC_UM_CLOSEST_ASSIGNED)) {
-		seed_or_neighbor = malloc(sizeof(scc_PointIndex[num_assigned_as_seed_or_neighbor]));
+		seed_or_neighbor = iscc_tmp_malloc(sizeof(scc_PointIndex[num_assigned_as_seed_or_neighbor]));
 		if (seed_or_neighbor == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 		scc_PointIndex* write_seed_or_neighbor = seed_or_neighbor;
@@ -492,7 +838,7 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering
 		// Are we done?
 		if ((total_assigned == clustering->num_data_points) ||
 		        ((unassigned_method == SCC_UM_IGNORE) && (secondary_unassigned_method == SCC_UM_IGNORE))) {
-			free(seed_or_neighbor);
+			iscc_free(seed_or_neighbor);
 			return iscc_no_error();
 		}
 	}
@@ -516,7 +862,7 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering
 	}
 
 	if (ec != SCC_ER_OK) {
-		free(seed_or_neighbor);
+		iscc_free(seed_or_neighbor);
 		return ec;
 	}
 
@@ -531,7 +877,7 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering
 	}
 
 	if (ec != SCC_ER_OK) {
-		free(seed_or_neighbor);
+		iscc_free(seed_or_neighbor);
 		if (nn_assigned_search_object != NULL) {
 			iscc_close_nn_search_object(&nn_assigned_search_object);
 		}
@@ -539,9 +885,9 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering
 	}
 
 	size_t num_to_assign = 0;
-	scc_PointIndex* const to_assign = malloc(sizeof(scc_PointIndex[clustering->num_data_points - total_assigned + 1]));
+	scc_PointIndex* const to_assign = iscc_tmp_malloc(sizeof(scc_PointIndex[clustering->num_data_points - total_assigned + 1]));
 	if (to_assign == NULL) {
-		free(seed_or_neighbor);
+		iscc_free(seed_or_neighbor);
 		if (nn_assigned_search_object != NULL) {
 			iscc_close_nn_search_object(&nn_assigned_search_object);
 		}
@@ -583,8 +929,8 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering
 	}
 
 	if (ec != SCC_ER_OK) {
-		free(seed_or_neighbor);
-		free(to_assign);
+		iscc_free(seed_or_neighbor);
+		iscc_free(to_assign);
 		if (nn_assigned_search_object != NULL) {
 			iscc_close_nn_search_object(&nn_assigned_search_object);
 		}
@@ -621,8 +967,8 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering
 		}
 	}
 
-	free(seed_or_neighbor);
-	free(to_assign);
+	iscc_free(seed_or_neighbor);
+	iscc_free(to_assign);
 	if (nn_assigned_search_object != NULL) {
 		iscc_close_nn_search_object(&nn_assigned_search_object);
 	}
@@ -715,7 +1061,7 @@ static scc_ErrorCode iscc_make_nng_from_search_object(iscc_NNSearchObject* const
 		if (out_query_indices != NULL) {
 			dist_out_query_indices = out_query_indices;
 		} else {
-			internal_out_query_indices = malloc(sizeof(scc_PointIndex[len_query_indices]));
+			internal_out_query_indices = iscc_tmp_malloc(sizeof(scc_PointIndex[len_query_indices]));
 			if (internal_out_query_indices == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 			dist_out_query_indices = internal_out_query_indices;
 		}
@@ -725,7 +1071,7 @@ static scc_ErrorCode iscc_make_nng_from_search_object(iscc_NNSearchObject* const
 	if ((ec = iscc_init_digraph(num_data_points,
 	                            len_query_indices * k,
 	                            out_nng)) != SCC_ER_OK) {
-		free(internal_out_query_indices);
+		iscc_free(internal_out_query_indices);
 		return ec;
 	}
 
@@ -739,7 +1085,7 @@ static scc_ErrorCode iscc_make_nng_from_search_object(iscc_NNSearchObject* const
 	                                  &num_ok_queries,
 	                                  dist_out_query_indices,
 	                                  out_nng->head)) {
-		free(internal_out_query_indices);
+		iscc_free(internal_out_query_indices);
 		iscc_free_digraph(out_nng);
 		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 	}
@@ -787,7 +1133,7 @@ static scc_ErrorCode iscc_make_nng_from_search_object(iscc_NNSearchObject* const
 	if (internal_out_query_indices != NULL) {
 		assert(radius_search);
 		assert(out_query_indices == NULL);
-		free(internal_out_query_indices);
+		iscc_free(internal_out_query_indices);
 	}
 
 	if (len_query_indices > num_ok_queries) {
@@ -862,15 +1208,15 @@ static scc_ErrorCode iscc_type_count(const size_t num_data_points,
 
 	*out_type_result = (iscc_TypeCount) {
 		.sum_type_constraints = 0,
-		.type_group_size = calloc(num_types, sizeof(size_t)),
-		.point_store = malloc(sizeof(scc_PointIndex[num_data_points])),
-		.type_groups = malloc(sizeof(scc_PointIndex*[num_types])),
+		.type_group_size = iscc_tmp_calloc(num_types, sizeof(size_t)),
+		.point_store = iscc_tmp_malloc(sizeof(scc_PointIndex[num_data_points])),
+		.type_groups = iscc_tmp_malloc(sizeof(scc_PointIndex*[num_types])),
 	};
 
 	if ((out_type_result->type_group_size == NULL) || (out_type_result->point_store == NULL) || (out_type_result->type_groups == NULL)) {
-		free(out_type_result->type_group_size);
-		free(out_type_result->point_store);
-		free(out_type_result->type_groups);
+		iscc_free(out_type_result->type_group_size);
+		iscc_free(out_type_result->point_store);
+		iscc_free(out_type_result->type_groups);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
@@ -881,18 +1227,18 @@ static scc_ErrorCode iscc_type_count(const size_t num_data_points,
 
 	for (uint_fast16_t i = 0; i < num_types; ++i) {
 		if (out_type_result->type_group_size[i] < type_constraints[i]) {
-			free(out_type_result->type_group_size);
-			free(out_type_result->point_store);
-			free(out_type_result->type_groups);
+			iscc_free(out_type_result->type_group_size);
+			iscc_free(out_type_result->point_store);
+			iscc_free(out_type_result->type_groups);
 			return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Fewer data points than type size constraint.");
 		}
 		out_type_result->sum_type_constraints += type_constraints[i];
 	}
 
 	if (out_type_result->sum_type_constraints > size_constraint) {
-		free(out_type_result->type_group_size);
-		free(out_type_result->point_store);
-		free(out_type_result->type_groups);
+		iscc_free(out_type_result->type_group_size);
+		iscc_free(out_type_result->point_store);
+		iscc_free(out_type_result->type_groups);
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Type constraint cannot be larger than overall size constraint.");
 	}
 
@@ -962,7 +1308,7 @@ static size_t iscc_assign_by_nng(scc_Clustering* const clustering,
 	assert(iscc_digraph_is_valid(nng));
 	assert(!iscc_digraph_is_empty(nng));
 
-	bool* const scratch = malloc(sizeof(bool[clustering->num_data_points]));
+	bool* const scratch = iscc_tmp_malloc(sizeof(bool[clustering->num_data_points]));
 	if (scratch == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 	for (size_t i = 0; i < clustering->num_data_points; ++i) {
 		scratch[i] = (clustering->cluster_label[i] == SCC_CLABEL_NA);
@@ -985,7 +1331,7 @@ static size_t iscc_assign_by_nng(scc_Clustering* const clustering,
 		}
 	}
 
-	free(scratch);
+	iscc_free(scratch);
 
 	return num_assigned_by_nng;
 }
@@ -1009,7 +1355,7 @@ static scc_ErrorCode iscc_assign_by_nn_search(scc_Clustering* const clustering,
 	if (radius_constraint) {
 		out_ok_query = to_assign;
 	}
-	scc_PointIndex* const out_nn_indices = malloc(sizeof(scc_PointIndex[num_to_assign]));
+	scc_PointIndex* const out_nn_indices = iscc_tmp_malloc(sizeof(scc_PointIndex[num_to_assign]));
 
 	if (!iscc_nearest_neighbor_search(nn_search_object,
 	                                  num_to_assign,
@@ -1020,7 +1366,7 @@ static scc_ErrorCode iscc_assign_by_nn_search(scc_Clustering* const clustering,
 	                                  &num_ok_queries,
 	                                  out_ok_query,
 	                                  out_nn_indices)) {
-		free(out_nn_indices);
+		iscc_free(out_nn_indices);
 		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 	}
 
@@ -1035,14 +1381,12 @@ static scc_ErrorCode iscc_assign_by_nn_search(scc_Clustering* const clustering,
 		clustering->cluster_label[out_ok_query[i]] = clustering->cluster_label[out_nn_indices[i]];
 	}
 
-	free(out_nn_indices);
+	iscc_free(out_nn_indices);
 
 	return iscc_no_error();
 }
 
 
-#ifdef SCC_STABLE_NNG
-
 static int iscc_compare_PointIndex(const void* const a, const void* const b)
 {
     const scc_PointIndex arg1 = *(const scc_PointIndex* const)a;
@@ -1060,5 +1404,3 @@ static void iscc_sort_nng(iscc_Digraph* const nng)
 		}
 	}
 }
-
-#endif // ifdef SCC_STABLE_NNG
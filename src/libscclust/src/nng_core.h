@@ -40,9 +40,38 @@ scc_ErrorCode iscc_get_nng_with_size_constraint(void* data_set,
                                                 const scc_PointIndex primary_data_points[],
                                                 bool radius_constraint,
                                                 double radius,
+                                                bool stable,
                                                 iscc_Digraph* out_nng);
 
 
+/* Constructs the NNG of `iscc_get_nng_with_size_constraint` while finding seeds
+ * with `SCC_SM_LEXICAL`. Vertices are only searched when the lexical scan reaches
+ * them unmarked, so rows of vertices marked by earlier seeds are empty. This is
+ * sufficient for assignment, which only reads rows of seeds and unassigned vertices. */
+scc_ErrorCode iscc_get_nng_with_lexical_seeds(void* data_set,
+                                              size_t num_data_points,
+                                              uint32_t size_constraint,
+                                              size_t len_primary_data_points,
+                                              const scc_PointIndex primary_data_points[],
+                                              bool radius_constraint,
+                                              double radius,
+                                              bool stable,
+                                              iscc_Digraph* out_nng,
+                                              iscc_SeedResult* out_seeds);
+
+
+scc_ErrorCode iscc_get_nng_with_weighted_size_constraint(void* data_set,
+                                                         size_t num_data_points,
+                                                         const size_t point_weights[static num_data_points],
+                                                         uint32_t size_constraint,
+                                                         size_t len_primary_data_points,
+                                                         const scc_PointIndex primary_data_points[],
+                                                         bool radius_constraint,
+                                                         double radius,
+                                                         iscc_Digraph* out_nng,
+                                                         double** out_arc_weights);
+
+
 scc_ErrorCode iscc_get_nng_with_type_constraint(void* data_set,
                                                 size_t num_data_points,
                                                 uint32_t size_constraint,
@@ -53,6 +82,7 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* data_set,
                                                 const scc_PointIndex primary_data_points[],
                                                 bool radius_constraint,
                                                 double radius,
+                                                bool stable,
                                                 iscc_Digraph* out_nng);
 
 
@@ -63,6 +93,12 @@ scc_ErrorCode iscc_estimate_avg_seed_dist(void* data_set,
                                           double* out_avg_seed_dist);
 
 
+void iscc_estimate_avg_seed_dist_from_weights(const iscc_SeedResult* seed_result,
+                                              const iscc_Digraph* nng,
+                                              const double arc_weights[],
+                                              double* out_avg_seed_dist);
+
+
 scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* clustering,
                                                 void* data_set,
                                                 const iscc_SeedResult* seed_result,
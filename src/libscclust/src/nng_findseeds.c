@@ -25,9 +25,11 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include "../include/scclust.h"
+#include "allocator.h"
 #include "digraph_core.h"
 #include "digraph_operations.h"
 #include "error.h"
+#include "run_report.h"
 #include "scclust_types.h"
 
 
@@ -35,11 +37,21 @@
 // Internal structs
 // =============================================================================
 
+/** Vertices sorted by inwards count.
+ *
+ *  With stable ordering, the vertices not yet considered are instead kept in a binary heap
+ *  ordered by inwards count with the vertex ID as tie-break. `sorted_vertices` is then filled
+ *  as vertices are popped from the heap, and `vertex_index` points past the end of `sorted_vertices`
+ *  for vertices still in the heap.
+ */
 typedef struct iscc_fs_SortResult {
 	scc_PointIndex* inwards_count;
 	scc_PointIndex* sorted_vertices;
 	scc_PointIndex** vertex_index;
 	scc_PointIndex** bucket_index;
+	size_t heap_size;
+	scc_PointIndex* heap;
+	scc_PointIndex* heap_pos;
 } iscc_fs_SortResult;
 
 
@@ -53,14 +65,20 @@ static scc_ErrorCode iscc_findseeds_lexical(const iscc_Digraph* nng,
 
 static scc_ErrorCode iscc_findseeds_inwards(const iscc_Digraph* nng,
                                             bool updating,
+                                            bool stable,
                                             iscc_SeedResult* out_seeds);
 
 
 static scc_ErrorCode iscc_findseeds_exclusion(const iscc_Digraph* nng,
                                               bool updating,
+                                              bool stable,
                                               iscc_SeedResult* out_seeds);
 
 
+static scc_ErrorCode iscc_findseeds_pair_matching(const iscc_Digraph* nng,
+                                                  iscc_SeedResult* out_seeds);
+
+
 static scc_ErrorCode iscc_fs_exclusion_graph(const iscc_Digraph* nng,
                                              size_t len_not_excluded,
                                              const scc_PointIndex not_excluded[],
@@ -86,6 +104,7 @@ static void iscc_fs_free_sort_result(iscc_fs_SortResult* sr);
 
 static scc_ErrorCode iscc_fs_sort_by_inwards(const iscc_Digraph* nng,
                                              bool make_indices,
+                                             bool make_heap,
                                              iscc_fs_SortResult* out_sort);
 
 
@@ -96,23 +115,17 @@ static inline void iscc_fs_decrease_v_in_sort(scc_PointIndex v_to_decrease,
                                               scc_PointIndex* current_pos);
 
 
-#ifdef SCC_STABLE_FINDSEED
+static inline bool iscc_fs_heap_before(scc_PointIndex a,
+                                       scc_PointIndex b,
+                                       const scc_PointIndex inwards_count[]);
 
-static inline void iscc_fs_debug_bucket_sort(const scc_PointIndex* bucket_start,
-                                             scc_PointIndex* pos,
-                                             const scc_PointIndex inwards_count[],
-                                             scc_PointIndex* vertex_index[]);
 
-#endif // ifdef SCC_STABLE_FINDSEED
+static inline void iscc_fs_pop_from_heap(iscc_fs_SortResult* sort,
+                                         scc_PointIndex* current_pos);
 
 
-#if defined(SCC_STABLE_FINDSEED) && !defined(NDEBUG)
-
-static inline void iscc_fs_debug_check_sort(const scc_PointIndex* current_pos,
-                                            const scc_PointIndex* last_pos,
-                                            const scc_PointIndex inwards_count[]);
-
-#endif // if defined(SCC_STABLE_FINDSEED) && !defined(NDEBUG)
+static inline void iscc_fs_decrease_v_in_heap(scc_PointIndex v_to_decrease,
+                                              iscc_fs_SortResult* sort);
 
 
 // =============================================================================
@@ -121,6 +134,7 @@ static inline void iscc_fs_debug_check_sort(const scc_PointIndex* current_pos,
 
 scc_ErrorCode iscc_find_seeds(const iscc_Digraph* const nng,
                               const scc_SeedMethod seed_method,
+                              bool stable,
                               iscc_SeedResult* const out_seeds)
 {
 	assert(iscc_digraph_is_valid(nng));
@@ -131,26 +145,35 @@ scc_ErrorCode iscc_find_seeds(const iscc_Digraph* const nng,
 	assert(out_seeds->count == 0);
 	assert(out_seeds->seeds == NULL);
 
+	#ifdef SCC_STABLE_FINDSEED
+		stable = true;
+	#endif // ifdef SCC_STABLE_FINDSEED
+
 	scc_ErrorCode ec;
+	const double phase_start = iscc_report_phase_start();
 	switch(seed_method) {
 		case SCC_SM_LEXICAL:
 			ec = iscc_findseeds_lexical(nng, out_seeds);
 			break;
 
 		case SCC_SM_INWARDS_ORDER:
-			ec = iscc_findseeds_inwards(nng, false, out_seeds);
+			ec = iscc_findseeds_inwards(nng, false, stable, out_seeds);
 			break;
 
 		case SCC_SM_INWARDS_UPDATING:
-			ec = iscc_findseeds_inwards(nng, true, out_seeds);
+			ec = iscc_findseeds_inwards(nng, true, stable, out_seeds);
 			break;
 
 		case SCC_SM_EXCLUSION_ORDER:
-			ec = iscc_findseeds_exclusion(nng, false, out_seeds);
+			ec = iscc_findseeds_exclusion(nng, false, stable, out_seeds);
 			break;
 
 		case SCC_SM_EXCLUSION_UPDATING:
-			ec = iscc_findseeds_exclusion(nng, true, out_seeds);
+			ec = iscc_findseeds_exclusion(nng, true, stable, out_seeds);
+			break;
+
+		case SCC_SM_PAIR_MATCHING:
+			ec = iscc_findseeds_pair_matching(nng, out_seeds);
 			break;
 
 		default:
@@ -162,7 +185,7 @@ scc_ErrorCode iscc_find_seeds(const iscc_Digraph* const nng,
 	if (ec == SCC_ER_OK) {
 		assert(out_seeds->seeds != NULL);
 		if ((out_seeds->count < out_seeds->capacity) && (out_seeds->count > 0)) {
-			scc_PointIndex* const tmp_seed_ptr = realloc(out_seeds->seeds, sizeof(scc_PointIndex[out_seeds->count]));
+			scc_PointIndex* const tmp_seed_ptr = iscc_realloc(out_seeds->seeds, sizeof(scc_PointIndex[out_seeds->count]));
 			if (tmp_seed_ptr != NULL) {
 				out_seeds->seeds = tmp_seed_ptr;
 				out_seeds->capacity = out_seeds->count;
@@ -170,10 +193,41 @@ scc_ErrorCode iscc_find_seeds(const iscc_Digraph* const nng,
 		}
 	}
 
+	iscc_report_phase_end(SCC_RP_SEED_FINDING, phase_start);
+
 	return ec;
 }
 
 
+scc_ErrorCode iscc_find_lexical_seeds_in_range(const iscc_Digraph* const nng,
+                                               const scc_PointIndex range_start,
+                                               const scc_PointIndex range_end,
+                                               bool marks[const],
+                                               iscc_SeedResult* const out_seeds)
+{
+	assert(nng->tail_ptr != NULL);
+	assert(range_start <= range_end);
+	assert(((size_t) range_end) <= nng->vertices);
+	assert(marks != NULL);
+	assert(out_seeds->seeds != NULL);
+
+	scc_ErrorCode ec;
+	for (scc_PointIndex v = range_start; v < range_end; ++v) {
+		if (iscc_fs_check_neighbors_marks(v, nng, marks)) {
+			assert(nng->tail_ptr[v] != nng->tail_ptr[v + 1]);
+
+			if ((ec = iscc_fs_add_seed(v, out_seeds)) != SCC_ER_OK) {
+				return ec;
+			}
+
+			iscc_fs_mark_seed_neighbors(v, nng, marks);
+		}
+	}
+
+	return iscc_no_error();
+}
+
+
 // =============================================================================
 // Static function implementations
 // =============================================================================
@@ -189,39 +243,28 @@ static scc_ErrorCode iscc_findseeds_lexical(const iscc_Digraph* const nng,
 	assert(out_seeds->count == 0);
 	assert(out_seeds->seeds == NULL);
 
-	bool* const marks = calloc(nng->vertices, sizeof(bool));
-	out_seeds->seeds = malloc(sizeof(scc_PointIndex[out_seeds->capacity]));
+	bool* const marks = iscc_tmp_calloc(nng->vertices, sizeof(bool));
+	out_seeds->seeds = iscc_tmp_malloc(sizeof(scc_PointIndex[out_seeds->capacity]));
 	if ((marks == NULL) || (out_seeds->seeds == NULL)) {
-		free(marks);
-		free(out_seeds->seeds);
+		iscc_free(marks);
+		iscc_free(out_seeds->seeds);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
-	scc_ErrorCode ec;
 	assert(nng->vertices <= ISCC_POINTINDEX_MAX);
 	const scc_PointIndex vertices = (scc_PointIndex) nng->vertices; // If `scc_PointIndex` is signed
-	for (scc_PointIndex v = 0; v < vertices; ++v) {
-		if (iscc_fs_check_neighbors_marks(v, nng, marks)) {
-			assert(nng->tail_ptr[v] != nng->tail_ptr[v + 1]);
+	const scc_ErrorCode ec = iscc_find_lexical_seeds_in_range(nng, 0, vertices, marks, out_seeds);
+	if (ec != SCC_ER_OK) iscc_free(out_seeds->seeds);
 
-			if ((ec = iscc_fs_add_seed(v, out_seeds)) != SCC_ER_OK) {
-				free(marks);
-				free(out_seeds->seeds);
-				return ec;
-			}
+	iscc_free(marks);
 
-			iscc_fs_mark_seed_neighbors(v, nng, marks);
-		}
-	}
-
-	free(marks);
-
-	return iscc_no_error();
+	return ec;
 }
 
 
 static scc_ErrorCode iscc_findseeds_inwards(const iscc_Digraph* const nng,
                                             const bool updating,
+                                            const bool stable,
                                             iscc_SeedResult* const out_seeds)
 {
 	assert(iscc_digraph_is_valid(nng));
@@ -232,16 +275,19 @@ static scc_ErrorCode iscc_findseeds_inwards(const iscc_Digraph* const nng,
 	assert(out_seeds->count == 0);
 	assert(out_seeds->seeds == NULL);
 
+	// The initial sort is stable, so ties only need to be broken when counts are updated
+	const bool use_heap = updating && stable;
+
 	scc_ErrorCode ec;
 	iscc_fs_SortResult sort;
-	if ((ec = iscc_fs_sort_by_inwards(nng, updating, &sort)) != SCC_ER_OK) return ec;
+	if ((ec = iscc_fs_sort_by_inwards(nng, updating, use_heap, &sort)) != SCC_ER_OK) return ec;
 
-	bool* const marks = calloc(nng->vertices, sizeof(bool));
-	out_seeds->seeds = malloc(sizeof(scc_PointIndex[out_seeds->capacity]));
+	bool* const marks = iscc_tmp_calloc(nng->vertices, sizeof(bool));
+	out_seeds->seeds = iscc_tmp_malloc(sizeof(scc_PointIndex[out_seeds->capacity]));
 	if ((marks == NULL) || (out_seeds->seeds == NULL)) {
 		iscc_fs_free_sort_result(&sort);
-		free(marks);
-		free(out_seeds->seeds);
+		iscc_free(marks);
+		iscc_free(out_seeds->seeds);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
@@ -249,17 +295,15 @@ static scc_ErrorCode iscc_findseeds_inwards(const iscc_Digraph* const nng,
 	for (scc_PointIndex* sorted_v = sort.sorted_vertices;
 	        sorted_v != sorted_v_stop; ++sorted_v) {
 
-		#if defined(SCC_STABLE_FINDSEED) && !defined(NDEBUG)
-			if (updating) iscc_fs_debug_check_sort(sorted_v, sorted_v_stop - 1, sort.inwards_count);
-		#endif
+		if (use_heap) iscc_fs_pop_from_heap(&sort, sorted_v);
 
 		if (iscc_fs_check_neighbors_marks(*sorted_v, nng, marks)) {
 			assert(nng->tail_ptr[*sorted_v] != nng->tail_ptr[*sorted_v + 1]);
 
 			if ((ec = iscc_fs_add_seed(*sorted_v, out_seeds)) != SCC_ER_OK) {
 				iscc_fs_free_sort_result(&sort);
-				free(marks);
-				free(out_seeds->seeds);
+				iscc_free(marks);
+				iscc_free(out_seeds->seeds);
 				return ec;
 			}
 
@@ -275,7 +319,11 @@ static scc_ErrorCode iscc_findseeds_inwards(const iscc_Digraph* const nng,
 						        v_arc_arc != v_arc_arc_stop; ++v_arc_arc) {
 							// Only decrease if vertex can be seed (i.e., not already assigned, not already considered and has arcs in nng)
 							if (!marks[*v_arc_arc] && (sorted_v < sort.vertex_index[*v_arc_arc]) && (nng->tail_ptr[*v_arc_arc] != nng->tail_ptr[*v_arc_arc + 1])) {
-								iscc_fs_decrease_v_in_sort(*v_arc_arc, sort.inwards_count, sort.vertex_index, sort.bucket_index, sorted_v);
+								if (use_heap) {
+									iscc_fs_decrease_v_in_heap(*v_arc_arc, &sort);
+								} else {
+									iscc_fs_decrease_v_in_sort(*v_arc_arc, sort.inwards_count, sort.vertex_index, sort.bucket_index, sorted_v);
+								}
 							}
 						}
 					}
@@ -287,14 +335,18 @@ static scc_ErrorCode iscc_findseeds_inwards(const iscc_Digraph* const nng,
 			        v_arc != v_arc_stop; ++v_arc) {
 				// Only decrease if vertex can be seed (i.e., not already assigned, not already considered and has arcs in nng)
 				if (!marks[*v_arc] && (sorted_v < sort.vertex_index[*v_arc]) && (nng->tail_ptr[*v_arc] != nng->tail_ptr[*v_arc + 1])) {
-					iscc_fs_decrease_v_in_sort(*v_arc, sort.inwards_count, sort.vertex_index, sort.bucket_index, sorted_v);
+					if (use_heap) {
+						iscc_fs_decrease_v_in_heap(*v_arc, &sort);
+					} else {
+						iscc_fs_decrease_v_in_sort(*v_arc, sort.inwards_count, sort.vertex_index, sort.bucket_index, sorted_v);
+					}
 				}
 			}
 		}
 	}
 
 	iscc_fs_free_sort_result(&sort);
-	free(marks);
+	iscc_free(marks);
 
 	return iscc_no_error();
 }
@@ -302,6 +354,7 @@ static scc_ErrorCode iscc_findseeds_inwards(const iscc_Digraph* const nng,
 
 static scc_ErrorCode iscc_findseeds_exclusion(const iscc_Digraph* const nng,
                                               const bool updating,
+                                              const bool stable,
                                               iscc_SeedResult* const out_seeds)
 {
 	assert(iscc_digraph_is_valid(nng));
@@ -312,14 +365,14 @@ static scc_ErrorCode iscc_findseeds_exclusion(const iscc_Digraph* const nng,
 	assert(out_seeds->count == 0);
 	assert(out_seeds->seeds == NULL);
 
-	bool* const not_excluded = malloc(sizeof(bool[nng->vertices]));
+	bool* const not_excluded = iscc_tmp_malloc(sizeof(bool[nng->vertices]));
 	if (not_excluded == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 	// FIX THIS
 	size_t tmp_num_not_excluded = 0;
-	scc_PointIndex* tmp_index_not_excluded = malloc(sizeof(scc_PointIndex[nng->vertices]));
+	scc_PointIndex* tmp_index_not_excluded = iscc_tmp_malloc(sizeof(scc_PointIndex[nng->vertices]));
 	if (tmp_index_not_excluded == NULL) {
-		free(not_excluded);
+		iscc_free(not_excluded);
 		iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 	assert(nng->vertices <= ISCC_POINTINDEX_MAX);
@@ -331,7 +384,7 @@ static scc_ErrorCode iscc_findseeds_exclusion(const iscc_Digraph* const nng,
 	}
 	if (tmp_num_not_excluded == nng->vertices) {
 		tmp_num_not_excluded = 0;
-		free(tmp_index_not_excluded);
+		iscc_free(tmp_index_not_excluded);
 		tmp_index_not_excluded = NULL;
 	}
 	// UNTIL HERE
@@ -342,26 +395,32 @@ static scc_ErrorCode iscc_findseeds_exclusion(const iscc_Digraph* const nng,
 
 	scc_ErrorCode ec;
 	iscc_Digraph exclusion_graph;
+	const double phase_start = iscc_report_phase_start();
 	if ((ec = iscc_fs_exclusion_graph(nng, tmp_num_not_excluded, tmp_index_not_excluded, &exclusion_graph)) != SCC_ER_OK) {
-		free(not_excluded);
+		iscc_free(not_excluded);
 		return ec;
 	}
+	iscc_report_exclusion_graph_arcs(exclusion_graph.tail_ptr[exclusion_graph.vertices]);
+	iscc_report_phase_end(SCC_RP_EXCLUSION_GRAPH, phase_start);
 
 	// FIX THIS
-	free(tmp_index_not_excluded);
+	iscc_free(tmp_index_not_excluded);
 	tmp_index_not_excluded = NULL;
 	// UNTIL HERE
 
+	// The initial sort is stable, so ties only need to be broken when counts are updated
+	const bool use_heap = updating && stable;
+
 	iscc_fs_SortResult sort;
-	if ((ec = iscc_fs_sort_by_inwards(&exclusion_graph, updating, &sort)) != SCC_ER_OK) {
-		free(not_excluded);
+	if ((ec = iscc_fs_sort_by_inwards(&exclusion_graph, updating, use_heap, &sort)) != SCC_ER_OK) {
+		iscc_free(not_excluded);
 		iscc_free_digraph(&exclusion_graph);
 		return ec;
 	}
 
-	out_seeds->seeds = malloc(sizeof(scc_PointIndex[out_seeds->capacity]));
+	out_seeds->seeds = iscc_tmp_malloc(sizeof(scc_PointIndex[out_seeds->capacity]));
 	if (out_seeds->seeds == NULL) {
-		free(not_excluded);
+		iscc_free(not_excluded);
 		iscc_free_digraph(&exclusion_graph);
 		iscc_fs_free_sort_result(&sort);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
@@ -371,18 +430,16 @@ static scc_ErrorCode iscc_findseeds_exclusion(const iscc_Digraph* const nng,
 	for (scc_PointIndex* sorted_v = sort.sorted_vertices;
 	        sorted_v != sorted_v_stop; ++sorted_v) {
 
-		#if defined(SCC_STABLE_FINDSEED) && !defined(NDEBUG)
-			if (updating) iscc_fs_debug_check_sort(sorted_v, sorted_v_stop - 1, sort.inwards_count);
-		#endif
+		if (use_heap) iscc_fs_pop_from_heap(&sort, sorted_v);
 
 		if (not_excluded[*sorted_v]) {
 			assert(nng->tail_ptr[*sorted_v] != nng->tail_ptr[*sorted_v + 1]);
 
 			if ((ec = iscc_fs_add_seed(*sorted_v, out_seeds)) != SCC_ER_OK) {
-				free(not_excluded);
+				iscc_free(not_excluded);
 				iscc_free_digraph(&exclusion_graph);
 				iscc_fs_free_sort_result(&sort);
-				free(out_seeds->seeds);
+				iscc_free(out_seeds->seeds);
 				return ec;
 			}
 
@@ -421,7 +478,11 @@ static scc_ErrorCode iscc_findseeds_exclusion(const iscc_Digraph* const nng,
 					for (scc_PointIndex* ex_arc_arc = exclusion_graph.head + exclusion_graph.tail_ptr[*ex_arc];
 					        ex_arc_arc != ex_arc_arc_stop; ++ex_arc_arc) {
 						if (not_excluded[*ex_arc_arc]) {
-							iscc_fs_decrease_v_in_sort(*ex_arc_arc, sort.inwards_count, sort.vertex_index, sort.bucket_index, sorted_v);
+							if (use_heap) {
+								iscc_fs_decrease_v_in_heap(*ex_arc_arc, &sort);
+							} else {
+								iscc_fs_decrease_v_in_sort(*ex_arc_arc, sort.inwards_count, sort.vertex_index, sort.bucket_index, sorted_v);
+							}
 						}
 					}
 				}
@@ -429,7 +490,7 @@ static scc_ErrorCode iscc_findseeds_exclusion(const iscc_Digraph* const nng,
 		}
 	}
 
-	free(not_excluded);
+	iscc_free(not_excluded);
 	iscc_free_digraph(&exclusion_graph);
 	iscc_fs_free_sort_result(&sort);
 
@@ -454,6 +515,105 @@ bool iscc_findseeds_onearc_updating(const scc_Digraph* const nng, ...) {
 */
 
 
+static scc_ErrorCode iscc_findseeds_pair_matching(const iscc_Digraph* const nng,
+                                                  iscc_SeedResult* const out_seeds)
+{
+	assert(iscc_digraph_is_valid(nng));
+	assert(!iscc_digraph_is_empty(nng));
+	assert(nng->vertices > 1);
+	assert(out_seeds != NULL);
+	assert(out_seeds->capacity > 0);
+	assert(out_seeds->count == 0);
+	assert(out_seeds->seeds == NULL);
+
+	const size_t vertices = nng->vertices;
+	const iscc_ArcIndex* const tail_ptr = nng->tail_ptr;
+	const scc_PointIndex* const head = nng->head;
+
+	scc_PointIndex* const inwards_count = iscc_tmp_calloc(vertices, sizeof(scc_PointIndex));
+	scc_PointIndex* const queue = iscc_tmp_malloc(sizeof(scc_PointIndex[vertices]));
+	bool* const marks = iscc_tmp_calloc(vertices, sizeof(bool));
+	out_seeds->seeds = iscc_tmp_malloc(sizeof(scc_PointIndex[out_seeds->capacity]));
+	if ((inwards_count == NULL) || (queue == NULL) || (marks == NULL) || (out_seeds->seeds == NULL)) {
+		iscc_free(inwards_count);
+		iscc_free(queue);
+		iscc_free(marks);
+		iscc_free(out_seeds->seeds);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	/* Each vertex has at most one arc, pointing to its nearest neighbor. Vertices
+	 * that alone satisfy the size constraint keep a self-loop and are seeds by
+	 * themselves. The remaining arcs are counted by their heads. */
+	scc_ErrorCode ec = iscc_no_error();
+	assert(vertices <= ISCC_POINTINDEX_MAX);
+	for (scc_PointIndex v = 0; (size_t) v < vertices; ++v) {
+		if (tail_ptr[v] == tail_ptr[v + 1]) continue;
+		assert(tail_ptr[v] + 1 == tail_ptr[v + 1]);
+		if (head[tail_ptr[v]] == v) {
+			if ((ec = iscc_fs_add_seed(v, out_seeds)) != SCC_ER_OK) break;
+			marks[v] = true;
+		} else {
+			++inwards_count[head[tail_ptr[v]]];
+		}
+	}
+
+	/* Vertices that no unassigned vertex points to are matched with their nearest
+	 * neighbors first. Later unassigned vertices can then only point to the second
+	 * vertex of the pair, so all clusters are stars around it. Once no such vertex
+	 * remains, the unassigned vertices with unassigned nearest neighbors form
+	 * cycles, which are broken by removing the arc of their lowest vertex. */
+	size_t queue_end = 0;
+	for (scc_PointIndex v = 0; (size_t) v < vertices; ++v) {
+		if (!marks[v] && (tail_ptr[v] != tail_ptr[v + 1]) && (inwards_count[v] == 0)) {
+			queue[queue_end++] = v;
+		}
+	}
+
+	size_t queue_pos = 0;
+	scc_PointIndex cycle_v = 0;
+	while (ec == SCC_ER_OK) {
+		for (; queue_pos < queue_end; ++queue_pos) {
+			const scc_PointIndex s = queue[queue_pos];
+			if (marks[s]) continue;
+			const scc_PointIndex t = head[tail_ptr[s]];
+			if (marks[t]) continue; // `s` is assigned to the cluster of `t` later
+
+			if ((ec = iscc_fs_add_seed(s, out_seeds)) != SCC_ER_OK) break;
+			marks[s] = true;
+			marks[t] = true;
+
+			if (tail_ptr[t] != tail_ptr[t + 1]) {
+				const scc_PointIndex u = head[tail_ptr[t]];
+				--inwards_count[u];
+				if (!marks[u] && (inwards_count[u] == 0) && (tail_ptr[u] != tail_ptr[u + 1])) {
+					queue[queue_end++] = u;
+				}
+			}
+		}
+		if (ec != SCC_ER_OK) break;
+
+		for (; (size_t) cycle_v < vertices; ++cycle_v) {
+			if (!marks[cycle_v] && (tail_ptr[cycle_v] != tail_ptr[cycle_v + 1]) && !marks[head[tail_ptr[cycle_v]]]) break;
+		}
+		if ((size_t) cycle_v == vertices) break;
+
+		const scc_PointIndex t = head[tail_ptr[cycle_v]];
+		assert(inwards_count[t] == 1);
+		--inwards_count[t];
+		queue[queue_end++] = t;
+	}
+	assert((ec != SCC_ER_OK) || (queue_end <= vertices));
+
+	iscc_free(inwards_count);
+	iscc_free(queue);
+	iscc_free(marks);
+	if (ec != SCC_ER_OK) iscc_free(out_seeds->seeds);
+
+	return ec;
+}
+
+
 static scc_ErrorCode iscc_fs_exclusion_graph(const iscc_Digraph* const nng,
                                              const size_t len_not_excluded,
                                              const scc_PointIndex not_excluded[const],
@@ -506,7 +666,7 @@ static inline scc_ErrorCode iscc_fs_add_seed(const scc_PointIndex s,
 	if (seed_result->count == seed_result->capacity) {
 		seed_result->capacity = seed_result->capacity + (seed_result->capacity >> 3) + 1024;
 		if (seed_result->capacity > ((uintmax_t) SCC_CLABEL_MAX)) seed_result->capacity = ((size_t) SCC_CLABEL_MAX);
-		scc_PointIndex* const seeds_tmp_ptr = realloc(seed_result->seeds, sizeof(scc_PointIndex[seed_result->capacity]));
+		scc_PointIndex* const seeds_tmp_ptr = iscc_realloc(seed_result->seeds, sizeof(scc_PointIndex[seed_result->capacity]));
 		if (seeds_tmp_ptr == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 		seed_result->seeds = seeds_tmp_ptr;
 	}
@@ -556,30 +716,37 @@ static inline void iscc_fs_mark_seed_neighbors(const scc_PointIndex s,
 static void iscc_fs_free_sort_result(iscc_fs_SortResult* const sr)
 {
 	if (sr != NULL) {
-		free(sr->inwards_count);
-		free(sr->sorted_vertices);
-		free(sr->vertex_index);
-		free(sr->bucket_index);
+		iscc_free(sr->inwards_count);
+		iscc_free(sr->sorted_vertices);
+		iscc_free(sr->vertex_index);
+		iscc_free(sr->bucket_index);
+		iscc_free(sr->heap);
+		iscc_free(sr->heap_pos);
 	}
 }
 
 
 static scc_ErrorCode iscc_fs_sort_by_inwards(const iscc_Digraph* const nng,
                                              const bool make_indices,
+                                             const bool make_heap,
                                              iscc_fs_SortResult* const out_sort)
 {
+	// `nng` may be an empty exclusion graph when no vertices exclude each other
 	assert(iscc_digraph_is_valid(nng));
-	assert(!iscc_digraph_is_empty(nng));
 	assert(nng->vertices > 1);
+	assert(!make_heap || make_indices);
 	assert(out_sort != NULL);
 
 	const size_t vertices = nng->vertices;
 
 	*out_sort = (iscc_fs_SortResult) {
-		.inwards_count = calloc(vertices, sizeof(scc_PointIndex)),
-		.sorted_vertices = malloc(sizeof(scc_PointIndex[vertices])),
+		.inwards_count = iscc_tmp_calloc(vertices, sizeof(scc_PointIndex)),
+		.sorted_vertices = iscc_tmp_malloc(sizeof(scc_PointIndex[vertices])),
 		.vertex_index = NULL,
 		.bucket_index = NULL,
+		.heap_size = 0,
+		.heap = NULL,
+		.heap_pos = NULL,
 	};
 
 	if ((out_sort->inwards_count == NULL) || (out_sort->sorted_vertices == NULL)) {
@@ -600,10 +767,10 @@ static scc_ErrorCode iscc_fs_sort_by_inwards(const iscc_Digraph* const nng,
 	}
 	const size_t max_inwards = (size_t) max_inwards_tmp; // If `scc_PointIndex` is signed
 
-	size_t* bucket_count = calloc(max_inwards + 1, sizeof(size_t));
-	out_sort->bucket_index = malloc(sizeof(scc_PointIndex*[max_inwards + 1]));
+	size_t* bucket_count = iscc_tmp_calloc(max_inwards + 1, sizeof(size_t));
+	out_sort->bucket_index = iscc_tmp_malloc(sizeof(scc_PointIndex*[max_inwards + 1]));
 	if ((bucket_count == NULL) || (out_sort->bucket_index == NULL)) {
-		free(bucket_count);
+		iscc_free(bucket_count);
 		iscc_fs_free_sort_result(out_sort);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
@@ -616,11 +783,11 @@ static scc_ErrorCode iscc_fs_sort_by_inwards(const iscc_Digraph* const nng,
 	for (size_t b = 1; b <= max_inwards; ++b) {
 		out_sort->bucket_index[b] = out_sort->bucket_index[b - 1] + bucket_count[b];
 	}
-	free(bucket_count);
+	iscc_free(bucket_count);
 
 	assert(vertices <= ISCC_POINTINDEX_MAX);
 	if (make_indices) {
-		out_sort->vertex_index = malloc(sizeof(scc_PointIndex*[vertices]));
+		out_sort->vertex_index = iscc_tmp_malloc(sizeof(scc_PointIndex*[vertices]));
 		if (out_sort->vertex_index == NULL) {
 			iscc_fs_free_sort_result(out_sort);
 			return iscc_make_error(SCC_ER_NO_MEMORY);
@@ -631,6 +798,25 @@ static scc_ErrorCode iscc_fs_sort_by_inwards(const iscc_Digraph* const nng,
 			*out_sort->bucket_index[out_sort->inwards_count[v]] = v;
 			out_sort->vertex_index[v] = out_sort->bucket_index[out_sort->inwards_count[v]];
 		}
+
+		if (make_heap) {
+			// A sorted array is a valid heap
+			out_sort->heap = iscc_tmp_malloc(sizeof(scc_PointIndex[vertices]));
+			out_sort->heap_pos = iscc_tmp_malloc(sizeof(scc_PointIndex[vertices]));
+			if ((out_sort->heap == NULL) || (out_sort->heap_pos == NULL)) {
+				iscc_fs_free_sort_result(out_sort);
+				return iscc_make_error(SCC_ER_NO_MEMORY);
+			}
+			out_sort->heap_size = vertices;
+			scc_PointIndex* const not_considered = out_sort->sorted_vertices + vertices;
+			for (size_t i = 0; i < vertices; ++i) {
+				out_sort->heap[i] = out_sort->sorted_vertices[i];
+				out_sort->heap_pos[out_sort->sorted_vertices[i]] = (scc_PointIndex) i;
+				out_sort->vertex_index[out_sort->sorted_vertices[i]] = not_considered;
+			}
+			iscc_free(out_sort->bucket_index);
+			out_sort->bucket_index = NULL;
+		}
 	} else {
 		for (scc_PointIndex v = (scc_PointIndex) vertices; v > 0; ) {
 			--v;
@@ -638,8 +824,8 @@ static scc_ErrorCode iscc_fs_sort_by_inwards(const iscc_Digraph* const nng,
 			*out_sort->bucket_index[out_sort->inwards_count[v]] = v;
 		}
 
-		free(out_sort->inwards_count);
-		free(out_sort->bucket_index);
+		iscc_free(out_sort->inwards_count);
+		iscc_free(out_sort->bucket_index);
 		out_sort->inwards_count = NULL;
 		out_sort->bucket_index = NULL;
 	}
@@ -683,57 +869,61 @@ static inline void iscc_fs_decrease_v_in_sort(const scc_PointIndex v_to_decrease
 	vertex_index[*move_to] = move_to;
 	vertex_index[*move_from] = move_from;
 
-	#ifdef SCC_STABLE_FINDSEED
-		// Sort old bucket by vertex ID
-		if (move_to != move_from) {
-			iscc_fs_debug_bucket_sort(move_to + 1, move_from, inwards_count, vertex_index);
-		}
-
-		// If new bucket start on or before current_pos in the sorted vertices, move it to next in line
-		if (bucket_index[inwards_count[v_to_decrease]] <= current_pos) {
-			bucket_index[inwards_count[v_to_decrease]] = current_pos + 1;
-		}
-
-		// Sort new bucket by vertex ID
-		iscc_fs_debug_bucket_sort(bucket_index[inwards_count[v_to_decrease]],
-		                          move_to, inwards_count, vertex_index);
-	#endif
 }
 
 
-#ifdef SCC_STABLE_FINDSEED
-
-static inline void iscc_fs_debug_bucket_sort(const scc_PointIndex* const bucket_start,
-                                             scc_PointIndex* pos,
-                                             const scc_PointIndex inwards_count[const],
-                                             scc_PointIndex* vertex_index[const])
+static inline bool iscc_fs_heap_before(const scc_PointIndex a,
+                                       const scc_PointIndex b,
+                                       const scc_PointIndex inwards_count[const])
 {
-	scc_PointIndex tmp_v = *pos;
-	for (; pos != bucket_start; --pos) {
-		assert(inwards_count[tmp_v] == inwards_count[*(pos - 1)]);
-		if (tmp_v >= *(pos - 1)) break;
-		*pos = *(pos - 1);
-		vertex_index[*pos] = pos;
-	}
-	*pos = tmp_v;
-	vertex_index[*pos] = pos;
+	return (inwards_count[a] < inwards_count[b]) ||
+	       ((inwards_count[a] == inwards_count[b]) && (a < b));
 }
 
-#endif // ifdef SCC_STABLE_FINDSEED
 
+static inline void iscc_fs_pop_from_heap(iscc_fs_SortResult* const sort,
+                                         scc_PointIndex* const current_pos)
+{
+	assert(sort->heap_size > 0);
+
+	scc_PointIndex* const heap = sort->heap;
+	*current_pos = heap[0];
+	sort->vertex_index[heap[0]] = current_pos;
+
+	// Sift the last vertex down from the root
+	--sort->heap_size;
+	const scc_PointIndex last = heap[sort->heap_size];
+	size_t pos = 0;
+	for (size_t child = 1; child < sort->heap_size; child = 2 * pos + 1) {
+		if ((child + 1 < sort->heap_size) && iscc_fs_heap_before(heap[child + 1], heap[child], sort->inwards_count)) ++child;
+		if (!iscc_fs_heap_before(heap[child], last, sort->inwards_count)) break;
+		heap[pos] = heap[child];
+		sort->heap_pos[heap[pos]] = (scc_PointIndex) pos;
+		pos = child;
+	}
+	heap[pos] = last;
+	sort->heap_pos[last] = (scc_PointIndex) pos;
+}
 
-#if defined(SCC_STABLE_FINDSEED) && !defined(NDEBUG)
 
-static inline void iscc_fs_debug_check_sort(const scc_PointIndex* current_pos,
-                                            const scc_PointIndex* const last_pos,
-                                            const scc_PointIndex inwards_count[const])
+static inline void iscc_fs_decrease_v_in_heap(const scc_PointIndex v_to_decrease,
+                                              iscc_fs_SortResult* const sort)
 {
-	for (; current_pos != last_pos; ++current_pos) {
-		assert(inwards_count[*(current_pos)] <= inwards_count[*(current_pos + 1)]);
-		if (inwards_count[*(current_pos)] == inwards_count[*(current_pos + 1)]) {
-			assert(*(current_pos) < *(current_pos + 1));
-		}
+	assert(sort->inwards_count[v_to_decrease] > 0);
+	assert(sort->heap[sort->heap_pos[v_to_decrease]] == v_to_decrease);
+
+	--sort->inwards_count[v_to_decrease];
+
+	// Sift up
+	scc_PointIndex* const heap = sort->heap;
+	size_t pos = (size_t) sort->heap_pos[v_to_decrease];
+	while (pos > 0) {
+		const size_t parent = (pos - 1) / 2;
+		if (!iscc_fs_heap_before(v_to_decrease, heap[parent], sort->inwards_count)) break;
+		heap[pos] = heap[parent];
+		sort->heap_pos[heap[pos]] = (scc_PointIndex) pos;
+		pos = parent;
 	}
+	heap[pos] = v_to_decrease;
+	sort->heap_pos[v_to_decrease] = (scc_PointIndex) pos;
 }
-
-#endif // if defined(SCC_STABLE_FINDSEED) && !defined(NDEBUG)
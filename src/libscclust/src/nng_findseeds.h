@@ -44,7 +44,18 @@ typedef struct iscc_SeedResult {
 
 scc_ErrorCode iscc_find_seeds(const iscc_Digraph* nng,
                               scc_SeedMethod seed_method,
+                              bool stable,
                               iscc_SeedResult* out_seeds);
 
 
+/* Finds seeds lexically among the vertices in `[range_start, range_end)`.
+ * Only the arcs of these vertices are read, so the rest of `nng` may be
+ * unfinished. `marks` carries the vertices marked by earlier ranges. */
+scc_ErrorCode iscc_find_lexical_seeds_in_range(const iscc_Digraph* nng,
+                                               scc_PointIndex range_start,
+                                               scc_PointIndex range_end,
+                                               bool marks[],
+                                               iscc_SeedResult* out_seeds);
+
+
 #endif // ifndef SCC_NNG_FINDSEEDS_HG
@@ -0,0 +1,292 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "nng_store.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "../include/scclust.h"
+#include "digraph_core.h"
+#include "error.h"
+#include "file_map.h"
+#include "nng_findseeds.h"
+#include "scclust_types.h"
+
+
+// =============================================================================
+// Internal structs & variables
+// =============================================================================
+
+// All fields are 64 bits so the header has the same layout on all platforms
+typedef struct iscc_NNGFileHeader {
+	char magic[8];
+	uint64_t format_version;
+	uint64_t byte_order;
+	uint64_t sizeof_point_index;
+	uint64_t sizeof_arc_index;
+	uint64_t vertices;
+	uint64_t num_arcs;
+	uint64_t has_arc_weights;
+	uint64_t num_seeds;
+	uint64_t seed_method;
+	uint64_t fingerprint;
+} iscc_NNGFileHeader;
+
+
+typedef struct iscc_NNGFileLayout {
+	uint64_t tail_ptr_offset;
+	uint64_t head_offset;
+	uint64_t arc_weights_offset;
+	uint64_t seeds_offset;
+	uint64_t file_size;
+} iscc_NNGFileLayout;
+
+
+static const char ISCC_NNG_FILE_MAGIC[8] = { 'S', 'C', 'C', 'N', 'N', 'G', '\0', '\0' };
+static const uint64_t ISCC_NNG_FILE_BYTE_ORDER = UINT64_C(0x0102030405060708);
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static inline uint64_t iscc_align8(uint64_t size);
+
+
+static iscc_NNGFileLayout iscc_get_nng_file_layout(const iscc_NNGFileHeader* header);
+
+
+static bool iscc_write_padded(FILE* file,
+                              const void* data,
+                              size_t size,
+                              uint64_t padded_size);
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+scc_ErrorCode iscc_write_nng_file(const char* const file_path,
+                                  const iscc_NNGFileInfo* const info,
+                                  const iscc_Digraph* const nng,
+                                  const double arc_weights[const],
+                                  const iscc_SeedResult* const seeds)
+{
+	assert(file_path != NULL);
+	assert(info != NULL);
+	assert(iscc_digraph_is_valid(nng));
+	assert(seeds != NULL);
+	assert((seeds->count == 0) || (seeds->seeds != NULL));
+
+	iscc_NNGFileHeader header = {
+		.format_version = ISCC_NNG_FILE_FORMAT_VERSION,
+		.byte_order = ISCC_NNG_FILE_BYTE_ORDER,
+		.sizeof_point_index = sizeof(scc_PointIndex),
+		.sizeof_arc_index = sizeof(iscc_ArcIndex),
+		.vertices = (uint64_t) nng->vertices,
+		.num_arcs = (uint64_t) nng->tail_ptr[nng->vertices],
+		.has_arc_weights = (arc_weights != NULL),
+		.num_seeds = (uint64_t) seeds->count,
+		.seed_method = (uint64_t) info->seed_method,
+		.fingerprint = info->fingerprint,
+	};
+	memcpy(header.magic, ISCC_NNG_FILE_MAGIC, sizeof(header.magic));
+
+	const iscc_NNGFileLayout layout = iscc_get_nng_file_layout(&header);
+	const size_t num_arcs = nng->tail_ptr[nng->vertices];
+
+	FILE* const file = fopen(file_path, "wb");
+	if (file == NULL) return iscc_make_error_msg(SCC_ER_IO_ERROR, "Cannot open NNG file for writing.");
+
+	bool write_ok = iscc_write_padded(file, &header, sizeof(header), layout.tail_ptr_offset) &&
+	                iscc_write_padded(file, nng->tail_ptr, sizeof(iscc_ArcIndex[nng->vertices + 1]), layout.head_offset - layout.tail_ptr_offset) &&
+	                iscc_write_padded(file, nng->head, sizeof(scc_PointIndex) * num_arcs, layout.arc_weights_offset - layout.head_offset);
+	if (write_ok && (arc_weights != NULL)) {
+		write_ok = iscc_write_padded(file, arc_weights, sizeof(double) * num_arcs, layout.seeds_offset - layout.arc_weights_offset);
+	}
+	if (write_ok) {
+		write_ok = iscc_write_padded(file, seeds->seeds, sizeof(scc_PointIndex) * seeds->count, layout.file_size - layout.seeds_offset);
+	}
+
+	if ((fclose(file) != 0) || !write_ok) {
+		return iscc_make_error_msg(SCC_ER_IO_ERROR, "Cannot write NNG file.");
+	}
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode iscc_open_nng_file(const char* const file_path,
+                                 iscc_NNGFile* const out_file)
+{
+	assert(file_path != NULL);
+	assert(out_file != NULL);
+
+	*out_file = (iscc_NNGFile) {
+		.nng = ISCC_NULL_DIGRAPH,
+		.arc_weights = NULL,
+		.file_map = ISCC_NULL_FILE_MAP,
+	};
+
+	scc_ErrorCode ec;
+	if ((ec = iscc_map_file(file_path, ISCC_FA_NORMAL, &out_file->file_map)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	const char* const file_memory = out_file->file_map.memory;
+	iscc_NNGFileHeader header;
+	if (out_file->file_map.length < sizeof(header)) {
+		iscc_close_nng_file(out_file);
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Not a NNG file.");
+	}
+	memcpy(&header, file_memory, sizeof(header));
+
+	if (memcmp(header.magic, ISCC_NNG_FILE_MAGIC, sizeof(header.magic)) != 0) {
+		iscc_close_nng_file(out_file);
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Not a NNG file.");
+	}
+	if ((header.format_version != ISCC_NNG_FILE_FORMAT_VERSION) ||
+	        (header.byte_order != ISCC_NNG_FILE_BYTE_ORDER) ||
+	        (header.sizeof_point_index != sizeof(scc_PointIndex)) ||
+	        (header.sizeof_arc_index != sizeof(iscc_ArcIndex))) {
+		iscc_close_nng_file(out_file);
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "NNG file was written by an incompatible version or platform.");
+	}
+	if ((header.vertices == 0) ||
+	        (header.vertices > ISCC_POINTINDEX_MAX) ||
+	        (header.vertices >= SIZE_MAX) ||
+	        (header.num_arcs > ISCC_ARCINDEX_MAX) ||
+	        (header.num_arcs > SIZE_MAX) ||
+	        (header.num_seeds > header.vertices) ||
+	        (header.has_arc_weights > 1) ||
+	        (header.seed_method > SCC_SM_PAIR_MATCHING)) {
+		iscc_close_nng_file(out_file);
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Corrupt NNG file.");
+	}
+
+	const iscc_NNGFileLayout layout = iscc_get_nng_file_layout(&header);
+	if (layout.file_size != (uint64_t) out_file->file_map.length) {
+		iscc_close_nng_file(out_file);
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Corrupt NNG file.");
+	}
+
+	out_file->info = (iscc_NNGFileInfo) {
+		.seed_method = (scc_SeedMethod) header.seed_method,
+		.fingerprint = header.fingerprint,
+	};
+
+	out_file->nng = (iscc_Digraph) {
+		.vertices = (size_t) header.vertices,
+		.max_arcs = (size_t) header.num_arcs,
+		.head = (header.num_arcs > 0) ? (scc_PointIndex*) (file_memory + layout.head_offset) : NULL,
+		.tail_ptr = (iscc_ArcIndex*) (file_memory + layout.tail_ptr_offset),
+		.external_arrays = true,
+	};
+
+	out_file->arc_weights = NULL;
+	if (header.has_arc_weights == 1) {
+		out_file->arc_weights = (const double*) (file_memory + layout.arc_weights_offset);
+	}
+
+	out_file->seeds = (iscc_SeedResult) {
+		.capacity = (size_t) header.num_seeds,
+		.count = (size_t) header.num_seeds,
+		.seeds = (header.num_seeds > 0) ? (scc_PointIndex*) (file_memory + layout.seeds_offset) : NULL,
+	};
+
+	bool seeds_ok = true;
+	const scc_PointIndex vertices_pi = (scc_PointIndex) header.vertices;
+	for (size_t s = 0; s < out_file->seeds.count; ++s) {
+		seeds_ok = seeds_ok && (out_file->seeds.seeds[s] >= 0) && (out_file->seeds.seeds[s] < vertices_pi);
+	}
+
+	// `iscc_digraph_is_valid` does not catch negative heads when `scc_PointIndex` is signed
+	bool arcs_ok = iscc_digraph_is_valid(&out_file->nng);
+	if (arcs_ok) {
+		const size_t num_arcs = (size_t) out_file->nng.tail_ptr[out_file->nng.vertices];
+		for (size_t a = 0; a < num_arcs; ++a) {
+			arcs_ok = arcs_ok && (out_file->nng.head[a] >= 0) && (out_file->nng.head[a] < vertices_pi);
+		}
+	}
+
+	if (!seeds_ok || !arcs_ok) {
+		iscc_close_nng_file(out_file);
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Corrupt NNG file.");
+	}
+
+	return iscc_no_error();
+}
+
+
+void iscc_close_nng_file(iscc_NNGFile* const file)
+{
+	if (file != NULL) {
+		iscc_unmap_file(&file->file_map);
+		*file = (iscc_NNGFile) {
+			.nng = ISCC_NULL_DIGRAPH,
+			.arc_weights = NULL,
+			.file_map = ISCC_NULL_FILE_MAP,
+		};
+	}
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static inline uint64_t iscc_align8(const uint64_t size)
+{
+	return (size + 7) & ~UINT64_C(7);
+}
+
+
+static iscc_NNGFileLayout iscc_get_nng_file_layout(const iscc_NNGFileHeader* const header)
+{
+	// Header fields are checked before this is called, so no overflow
+	iscc_NNGFileLayout layout;
+	layout.tail_ptr_offset = iscc_align8(sizeof(iscc_NNGFileHeader));
+	layout.head_offset = layout.tail_ptr_offset + iscc_align8(header->sizeof_arc_index * (header->vertices + 1));
+	layout.arc_weights_offset = layout.head_offset + iscc_align8(header->sizeof_point_index * header->num_arcs);
+	layout.seeds_offset = layout.arc_weights_offset + ((header->has_arc_weights == 1) ? sizeof(double) * header->num_arcs : 0);
+	layout.file_size = layout.seeds_offset + header->sizeof_point_index * header->num_seeds;
+	return layout;
+}
+
+
+static bool iscc_write_padded(FILE* const file,
+                              const void* const data,
+                              const size_t size,
+                              const uint64_t padded_size)
+{
+	assert(file != NULL);
+	assert(size <= padded_size);
+	assert(padded_size - size < 8);
+
+	static const char padding[8] = { 0 };
+	if ((size > 0) && (fwrite(data, 1, size, file) != size)) return false;
+	const size_t len_padding = (size_t) (padded_size - size);
+	if ((len_padding > 0) && (fwrite(padding, 1, len_padding, file) != len_padding)) return false;
+	return true;
+}
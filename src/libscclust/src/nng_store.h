@@ -0,0 +1,93 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+/** @file
+ *
+ * Binary storage of NNGs and seed results.
+ *
+ * A stored NNG file contains a fixed header followed by the `tail_ptr` and `head`
+ * arrays of the digraph, optional arc weights and the seeds found in the digraph.
+ * Each section starts at an eight byte boundary so a loaded file can be used
+ * directly from a memory map without copying.
+ */
+
+#ifndef SCC_NNG_STORE_HG
+#define SCC_NNG_STORE_HG
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../include/scclust.h"
+#include "digraph_core.h"
+#include "file_map.h"
+#include "nng_findseeds.h"
+
+
+// =============================================================================
+// Structs and variables
+// =============================================================================
+
+/// Version of the NNG file format. Increase when the layout changes.
+static const uint64_t ISCC_NNG_FILE_FORMAT_VERSION = 2;
+
+
+/// Meta data about a stored NNG.
+typedef struct iscc_NNGFileInfo {
+	/// Seed method used to derive the stored seeds.
+	scc_SeedMethod seed_method;
+
+	/// Fingerprint of the data and options that the NNG was constructed with.
+	uint64_t fingerprint;
+} iscc_NNGFileInfo;
+
+
+/** A loaded NNG file.
+ *
+ *  #nng and #seeds point into the loaded file. They must not be
+ *  modified, and they are valid until #iscc_close_nng_file is called.
+ */
+typedef struct iscc_NNGFile {
+	iscc_NNGFileInfo info;
+	iscc_Digraph nng;
+	const double* arc_weights;
+	iscc_SeedResult seeds;
+	iscc_FileMap file_map;
+} iscc_NNGFile;
+
+
+// =============================================================================
+// Function prototypes
+// =============================================================================
+
+scc_ErrorCode iscc_write_nng_file(const char* file_path,
+                                  const iscc_NNGFileInfo* info,
+                                  const iscc_Digraph* nng,
+                                  const double arc_weights[],
+                                  const iscc_SeedResult* seeds);
+
+
+scc_ErrorCode iscc_open_nng_file(const char* file_path,
+                                 iscc_NNGFile* out_file);
+
+
+void iscc_close_nng_file(iscc_NNGFile* file);
+
+
+#endif // ifndef SCC_NNG_STORE_HG
@@ -0,0 +1,77 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "run_context.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../include/scclust.h"
+#include "allocator.h"
+#include "run_report.h"
+
+
+// =============================================================================
+// Variables
+// =============================================================================
+
+ISCC_THREAD_LOCAL iscc_RunContext* iscc_run_context = NULL;
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+bool iscc_begin_run(iscc_RunContext* const out_context,
+                    scc_RunReport* const report)
+{
+	assert(out_context != NULL);
+
+	if (iscc_run_context != NULL) {
+		if (report != iscc_run_context->report) iscc_reset_run_report(report);
+		return false;
+	}
+
+	*out_context = (iscc_RunContext) {
+		.arena_active = false,
+		.arena_top = NULL,
+		.arena_bytes = 0,
+		.report = NULL,
+		.report_start = 0.0,
+		.digraph_bytes = 0,
+		.alloc_bytes = 0,
+	};
+	iscc_run_context = out_context;
+	iscc_start_run_report(out_context, report);
+	iscc_start_arena(out_context);
+
+	return true;
+}
+
+
+void iscc_end_run(iscc_RunContext* const context)
+{
+	assert(context != NULL);
+	assert(iscc_run_context == context);
+
+	iscc_release_arena(context);
+	iscc_finish_run_report(context);
+	iscc_run_context = NULL;
+}
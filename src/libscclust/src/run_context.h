@@ -0,0 +1,151 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+/** @file
+ *
+ * State of a clustering run.
+ *
+ * Each public clustering function starts a run with #iscc_begin_run. The run
+ * context holds the state that belongs to that call alone (e.g., the arena and
+ * the run report), so
+ * calls made concurrently from different application threads never share it.
+ * The context of the calling thread is kept in thread-local storage, so it is
+ * not visible to threads started by OpenMP. Parallel regions inside a run must
+ * therefore capture the context with #iscc_get_run_context before the region
+ * and enter it on each thread with #iscc_enter_run_context.
+ */
+
+#ifndef SCC_RUN_CONTEXT_HG
+#define SCC_RUN_CONTEXT_HG
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "../include/scclust.h"
+
+
+// =============================================================================
+// Macros
+// =============================================================================
+
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
+	#define ISCC_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__) || defined(__clang__) || defined(__SUNPRO_C) || defined(__INTEL_COMPILER) || defined(__IBMC__)
+	#define ISCC_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+	#define ISCC_THREAD_LOCAL __declspec(thread)
+#else
+	#error "scclust requires thread-local storage."
+#endif
+
+
+// =============================================================================
+// Structs and variables
+// =============================================================================
+
+struct iscc_ArenaChunk;
+
+/// State of a clustering run.
+typedef struct iscc_RunContext {
+	/// Whether the arena is active.
+	bool arena_active;
+	/// Most recent chunk of the arena, `NULL` if no chunk is allocated.
+	struct iscc_ArenaChunk* arena_top;
+	/// Bytes currently held by the arena.
+	size_t arena_bytes;
+	/// Report to collect to, `NULL` if no report is collected.
+	scc_RunReport* report;
+	/// Time when the run began, if a report is collected.
+	double report_start;
+	/// Bytes currently allocated in digraphs, if a report is collected.
+	size_t digraph_bytes;
+	/// Bytes currently allocated, if a report is collected.
+	size_t alloc_bytes;
+} iscc_RunContext;
+
+/// Context of the run on the current thread, \c NULL if no run is active.
+extern ISCC_THREAD_LOCAL iscc_RunContext* iscc_run_context;
+
+
+// =============================================================================
+// Function prototypes
+// =============================================================================
+
+/** Begins a run on the current thread.
+ *
+ *  \p report is always reset. If the thread already is in a run (e.g., when
+ *  blocked clustering clusters each block), nothing else is done and \c false
+ *  is returned; the enclosing run and its report are used instead. Otherwise,
+ *  \p out_context is initialized with \p report and made the context of the
+ *  thread. Each call that returned \c true must be matched by a call to
+ *  #iscc_end_run.
+ *
+ *  \param[out] out_context storage for the context, must outlive the run.
+ *  \param[out] report report to collect to, \c NULL if no report is collected.
+ *
+ *  \return \c true if a run was begun.
+ */
+bool iscc_begin_run(iscc_RunContext* out_context,
+                    scc_RunReport* report);
+
+
+/** Ends the run on the current thread.
+ *
+ *  Releases the arena of the run, finishes its report and clears the context
+ *  of the thread.
+ *
+ *  \param context context passed to #iscc_begin_run.
+ */
+void iscc_end_run(iscc_RunContext* context);
+
+
+// =============================================================================
+// Inline functions
+// =============================================================================
+
+/// Returns the context of the run on the current thread.
+static inline iscc_RunContext* iscc_get_run_context(void)
+{
+	return iscc_run_context;
+}
+
+
+/** Makes \p context the context of the current thread.
+ *
+ *  Used in parallel regions so OpenMP threads work in the run of the thread
+ *  that started the region.
+ *
+ *  \return the previous context, to be passed to #iscc_leave_run_context.
+ */
+static inline iscc_RunContext* iscc_enter_run_context(iscc_RunContext* const context)
+{
+	iscc_RunContext* const prev = iscc_run_context;
+	iscc_run_context = context;
+	return prev;
+}
+
+
+/// Restores the context replaced by #iscc_enter_run_context.
+static inline void iscc_leave_run_context(iscc_RunContext* const prev)
+{
+	iscc_run_context = prev;
+}
+
+
+#endif // ifndef SCC_RUN_CONTEXT_HG
@@ -0,0 +1,168 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#if defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))
+	#define ISCC_USE_MONOTONIC_CLOCK
+	#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "run_report.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "../include/scclust.h"
+#include "run_context.h"
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+void iscc_reset_run_report(scc_RunReport* const report)
+{
+	if (report == NULL) return;
+	*report = (scc_RunReport) {
+		.total_seconds = 0.0,
+		.phase_seconds = { 0.0 },
+		.num_dist_evaluations = 0,
+		.num_nn_queries = 0,
+		.num_max_dist_queries = 0,
+		.nng_arcs = 0,
+		.exclusion_graph_arcs = 0,
+		.peak_digraph_bytes = 0,
+		.peak_arena_bytes = 0,
+		.peak_alloc_bytes = 0,
+	};
+}
+
+
+void iscc_start_run_report(iscc_RunContext* const context,
+                           scc_RunReport* const report)
+{
+	assert(context != NULL);
+
+	iscc_reset_run_report(report);
+	context->report = report;
+	context->report_start = (report == NULL) ? 0.0 : iscc_report_time();
+	context->digraph_bytes = 0;
+	context->alloc_bytes = 0;
+}
+
+
+void iscc_finish_run_report(iscc_RunContext* const context)
+{
+	assert(context != NULL);
+
+	if (context->report != NULL) {
+		context->report->total_seconds = iscc_report_time() - context->report_start;
+	}
+	context->report = NULL;
+}
+
+
+double iscc_report_time(void)
+{
+	#ifdef ISCC_USE_MONOTONIC_CLOCK
+		struct timespec ts;
+		if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+			return (double) ts.tv_sec + 1e-9 * (double) ts.tv_nsec;
+		}
+	#endif // ifdef ISCC_USE_MONOTONIC_CLOCK
+	return (double) clock() / CLOCKS_PER_SEC;
+}
+
+
+void iscc_report_digraph_alloc__(const size_t bytes)
+{
+	iscc_RunContext* const context = iscc_get_run_context();
+	assert(context != NULL);
+	assert(context->report != NULL);
+
+	#ifdef _OPENMP
+		#pragma omp critical(iscc_report_digraph_bytes)
+	#endif // ifdef _OPENMP
+	{
+		context->digraph_bytes += bytes;
+		if (context->report->peak_digraph_bytes < context->digraph_bytes) {
+			context->report->peak_digraph_bytes = context->digraph_bytes;
+		}
+	}
+}
+
+
+void iscc_report_digraph_free__(const size_t bytes)
+{
+	iscc_RunContext* const context = iscc_get_run_context();
+	assert(context != NULL);
+	assert(context->report != NULL);
+
+	#ifdef _OPENMP
+		#pragma omp critical(iscc_report_digraph_bytes)
+	#endif // ifdef _OPENMP
+	{
+		// Digraphs allocated before collection started are not counted.
+		if (context->digraph_bytes < bytes) {
+			context->digraph_bytes = 0;
+		} else {
+			context->digraph_bytes -= bytes;
+		}
+	}
+}
+
+
+void iscc_report_alloc__(const size_t bytes)
+{
+	iscc_RunContext* const context = iscc_get_run_context();
+	assert(context != NULL);
+	assert(context->report != NULL);
+
+	#ifdef _OPENMP
+		#pragma omp critical(iscc_report_alloc_bytes)
+	#endif // ifdef _OPENMP
+	{
+		context->alloc_bytes += bytes;
+		if (context->report->peak_alloc_bytes < context->alloc_bytes) {
+			context->report->peak_alloc_bytes = context->alloc_bytes;
+		}
+	}
+}
+
+
+void iscc_report_free__(const size_t bytes)
+{
+	iscc_RunContext* const context = iscc_get_run_context();
+	assert(context != NULL);
+	assert(context->report != NULL);
+
+	#ifdef _OPENMP
+		#pragma omp critical(iscc_report_alloc_bytes)
+	#endif // ifdef _OPENMP
+	{
+		// Memory allocated before collection started is not counted.
+		if (context->alloc_bytes < bytes) {
+			context->alloc_bytes = 0;
+		} else {
+			context->alloc_bytes -= bytes;
+		}
+	}
+}
@@ -0,0 +1,202 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+/** @file
+ *
+ * Collection of timings and counters for #scc_RunReport.
+ *
+ * The report is stored in the context of the run (see run_context.h), so
+ * only threads working in the run add to it. When no report is requested,
+ * all functions in this header return immediately, so collection costs a
+ * single branch.
+ */
+
+#ifndef SCC_RUN_REPORT_HG
+#define SCC_RUN_REPORT_HG
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../include/scclust.h"
+#include "run_context.h"
+
+
+// =============================================================================
+// Function prototypes
+// =============================================================================
+
+/// Sets all fields of \p report to zero. Does nothing if \p report is \c NULL.
+void iscc_reset_run_report(scc_RunReport* report);
+
+
+/** Starts collection to a report in a run.
+ *
+ *  \p report is reset and made the report of \p context. Called by #iscc_begin_run.
+ *
+ *  \param context context of the run.
+ *  \param[out] report the report to collect to, \c NULL if no report is collected.
+ */
+void iscc_start_run_report(iscc_RunContext* context,
+                           scc_RunReport* report);
+
+
+/** Finishes collection to the report of a run.
+ *
+ *  Records the total time of the run. Called by #iscc_end_run.
+ *
+ *  \param context context of the run.
+ */
+void iscc_finish_run_report(iscc_RunContext* context);
+
+
+/// Wall time in seconds from an arbitrary point.
+double iscc_report_time(void);
+
+
+/// Records an allocation of \p bytes in digraphs.
+void iscc_report_digraph_alloc__(size_t bytes);
+
+
+/// Records a deallocation of \p bytes in digraphs.
+void iscc_report_digraph_free__(size_t bytes);
+
+
+/// Records an allocation of \p bytes.
+void iscc_report_alloc__(size_t bytes);
+
+
+/// Records a deallocation of \p bytes.
+void iscc_report_free__(size_t bytes);
+
+
+// =============================================================================
+// Inline functions
+// =============================================================================
+
+/// Returns the report of the run on the current thread, \c NULL if no report is collected.
+static inline scc_RunReport* iscc_get_run_report(void)
+{
+	const iscc_RunContext* const context = iscc_get_run_context();
+	return (context == NULL) ? NULL : context->report;
+}
+
+
+static inline double iscc_report_phase_start(void)
+{
+	return (iscc_get_run_report() == NULL) ? 0.0 : iscc_report_time();
+}
+
+
+static inline void iscc_report_phase_end(const scc_RunPhase phase,
+                                         const double start)
+{
+	scc_RunReport* const report = iscc_get_run_report();
+	if (report != NULL) {
+		const double elapsed = iscc_report_time() - start;
+		#ifdef _OPENMP
+			#pragma omp atomic
+		#endif // ifdef _OPENMP
+		report->phase_seconds[phase] += elapsed;
+	}
+}
+
+
+static inline void iscc_report_count(uint64_t* const counter,
+                                     const uint64_t count)
+{
+	assert(counter != NULL);
+	#ifdef _OPENMP
+		#pragma omp atomic
+	#endif // ifdef _OPENMP
+	*counter += count;
+}
+
+
+static inline void iscc_report_dist_evaluations(const uint64_t count)
+{
+	scc_RunReport* const report = iscc_get_run_report();
+	if (report != NULL) iscc_report_count(&report->num_dist_evaluations, count);
+}
+
+
+static inline void iscc_report_nn_queries(const uint64_t count)
+{
+	scc_RunReport* const report = iscc_get_run_report();
+	if (report != NULL) iscc_report_count(&report->num_nn_queries, count);
+}
+
+
+static inline void iscc_report_max_dist_queries(const uint64_t count)
+{
+	scc_RunReport* const report = iscc_get_run_report();
+	if (report != NULL) iscc_report_count(&report->num_max_dist_queries, count);
+}
+
+
+static inline void iscc_report_nng_arcs(const uint64_t count)
+{
+	scc_RunReport* const report = iscc_get_run_report();
+	if (report != NULL) iscc_report_count(&report->nng_arcs, count);
+}
+
+
+static inline void iscc_report_exclusion_graph_arcs(const uint64_t count)
+{
+	scc_RunReport* const report = iscc_get_run_report();
+	if (report != NULL) iscc_report_count(&report->exclusion_graph_arcs, count);
+}
+
+
+static inline void iscc_report_arena_bytes(const size_t bytes)
+{
+	// Only called outside parallel regions
+	scc_RunReport* const report = iscc_get_run_report();
+	if ((report != NULL) && (report->peak_arena_bytes < bytes)) {
+		report->peak_arena_bytes = bytes;
+	}
+}
+
+
+static inline void iscc_report_digraph_alloc(const size_t bytes)
+{
+	if (iscc_get_run_report() != NULL) iscc_report_digraph_alloc__(bytes);
+}
+
+
+static inline void iscc_report_digraph_free(const size_t bytes)
+{
+	if (iscc_get_run_report() != NULL) iscc_report_digraph_free__(bytes);
+}
+
+
+static inline void iscc_report_alloc(const size_t bytes)
+{
+	if (iscc_get_run_report() != NULL) iscc_report_alloc__(bytes);
+}
+
+
+static inline void iscc_report_free(const size_t bytes)
+{
+	if (iscc_get_run_report() != NULL) iscc_report_free__(bytes);
+}
+
+
+#endif // ifndef SCC_RUN_REPORT_HG
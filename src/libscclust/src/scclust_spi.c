@@ -44,6 +44,21 @@ iscc_dist_functions_struct iscc_dist_functions = {
 };
 
 
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+bool iscc_using_imp_dist_functions(void)
+{
+	return (iscc_dist_functions.check_data_set == iscc_imp_check_data_set) &&
+	       (iscc_dist_functions.num_data_points == iscc_imp_num_data_points) &&
+	       (iscc_dist_functions.get_dist_matrix == iscc_imp_get_dist_matrix) &&
+	       (iscc_dist_functions.get_dist_rows == iscc_imp_get_dist_rows) &&
+	       (iscc_dist_functions.init_max_dist_object == iscc_imp_init_max_dist_object) &&
+	       (iscc_dist_functions.init_nn_search_object == iscc_imp_init_nn_search_object);
+}
+
+
 // =============================================================================
 // Public function implementations
 // =============================================================================
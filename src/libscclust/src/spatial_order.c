@@ -0,0 +1,154 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "spatial_order.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../include/scclust.h"
+#include "allocator.h"
+#include "data_set_struct.h"
+#include "error.h"
+#include "scclust_types.h"
+
+// Dimensions beyond this are ignored in the curve order.
+static const uint_fast16_t ISCC_SPATIAL_MAX_DIMENSIONS = 64;
+
+// Each dimension contributes at most this many bits to the code.
+static const uint_fast16_t ISCC_SPATIAL_MAX_BITS = 32;
+
+
+// =============================================================================
+// Internal structs
+// =============================================================================
+
+typedef struct iscc_SpatialCode {
+	uint64_t code;
+	scc_PointIndex point;
+} iscc_SpatialCode;
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static int iscc_compare_SpatialCode(const void* a,
+                                    const void* b);
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+scc_ErrorCode iscc_get_spatial_order(const scc_DataSet* const data_set,
+                                     scc_PointIndex out_order[const])
+{
+	assert(scc_is_initialized_data_set(data_set));
+	assert(out_order != NULL);
+
+	const size_t num_data_points = data_set->num_data_points;
+	const uint_fast16_t num_dimensions = data_set->num_dimensions;
+	const uint_fast16_t num_used = (num_dimensions < ISCC_SPATIAL_MAX_DIMENSIONS) ? num_dimensions : ISCC_SPATIAL_MAX_DIMENSIONS;
+	uint_fast16_t num_bits = (uint_fast16_t) (64 / num_used);
+	if (num_bits > ISCC_SPATIAL_MAX_BITS) num_bits = ISCC_SPATIAL_MAX_BITS;
+	assert(num_bits >= 1);
+
+	iscc_SpatialCode* const codes = iscc_tmp_malloc(sizeof(iscc_SpatialCode[num_data_points]));
+	double* const lower = iscc_tmp_malloc(sizeof(double[num_used]));
+	double* const scale = iscc_tmp_malloc(sizeof(double[num_used]));
+	uint64_t* const cell = iscc_tmp_malloc(sizeof(uint64_t[num_used]));
+	if ((codes == NULL) || (lower == NULL) || (scale == NULL) || (cell == NULL)) {
+		iscc_free(codes);
+		iscc_free(lower);
+		iscc_free(scale);
+		iscc_free(cell);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	// Bounding box
+	const double* row = data_set->data_matrix;
+	for (uint_fast16_t d = 0; d < num_used; ++d) {
+		lower[d] = scale[d] = row[d];
+	}
+	for (size_t i = 1; i < num_data_points; ++i) {
+		row += num_dimensions;
+		for (uint_fast16_t d = 0; d < num_used; ++d) {
+			if (row[d] < lower[d]) lower[d] = row[d];
+			if (row[d] > scale[d]) scale[d] = row[d];
+		}
+	}
+
+	// Cells per dimension are `2^num_bits`; flat dimensions map to cell zero
+	const double max_cell = (double) ((UINT64_C(1) << num_bits) - 1);
+	for (uint_fast16_t d = 0; d < num_used; ++d) {
+		const double range = scale[d] - lower[d];
+		scale[d] = (range > 0.0) ? (max_cell / range) : 0.0;
+	}
+
+	row = data_set->data_matrix;
+	for (size_t i = 0; i < num_data_points; ++i, row += num_dimensions) {
+		for (uint_fast16_t d = 0; d < num_used; ++d) {
+			const double scaled = (row[d] - lower[d]) * scale[d];
+			cell[d] = (scaled < max_cell) ? (uint64_t) scaled : (uint64_t) max_cell;
+		}
+
+		// Interleave bits from the most significant
+		uint64_t code = 0;
+		for (uint_fast16_t b = num_bits; b > 0; --b) {
+			for (uint_fast16_t d = 0; d < num_used; ++d) {
+				code = (code << 1) | ((cell[d] >> (b - 1)) & 1);
+			}
+		}
+
+		codes[i] = (iscc_SpatialCode) {
+			.code = code,
+			.point = (scc_PointIndex) i,
+		};
+	}
+
+	qsort(codes, num_data_points, sizeof(iscc_SpatialCode), iscc_compare_SpatialCode);
+
+	for (size_t i = 0; i < num_data_points; ++i) {
+		out_order[i] = codes[i].point;
+	}
+
+	iscc_free(codes);
+	iscc_free(lower);
+	iscc_free(scale);
+	iscc_free(cell);
+
+	return iscc_no_error();
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static int iscc_compare_SpatialCode(const void* const a,
+                                    const void* const b)
+{
+	const iscc_SpatialCode* const sc_a = (const iscc_SpatialCode*) a;
+	const iscc_SpatialCode* const sc_b = (const iscc_SpatialCode*) b;
+	if (sc_a->code != sc_b->code) return (sc_a->code > sc_b->code) - (sc_a->code < sc_b->code);
+	return (sc_a->point > sc_b->point) - (sc_a->point < sc_b->point);
+}
@@ -0,0 +1,55 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+/** @file
+ *
+ * Ordering of data points along a space-filling curve.
+ *
+ * Points that are close in the order are close in space, so visiting
+ * points in this order keeps consecutive accesses to the data matrix
+ * and to per-point arrays local.
+ */
+
+#ifndef SCC_SPATIAL_ORDER_HG
+#define SCC_SPATIAL_ORDER_HG
+
+#include "../include/scclust.h"
+
+
+// =============================================================================
+// Function prototypes
+// =============================================================================
+
+/** Orders data points along a Morton (Z-order) curve.
+ *
+ *  Coordinates are scaled to the bounding box of the data set, and the bits of the
+ *  first (at most 64) dimensions are interleaved into a 64-bit code. Points are sorted
+ *  by code, with ties broken by point index.
+ *
+ *  \param[in] data_set the data set to order.
+ *  \param[out] out_order the data points in curve order, of length `num_data_points`.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode iscc_get_spatial_order(const scc_DataSet* data_set,
+                                     scc_PointIndex out_order[]);
+
+
+#endif // ifndef SCC_SPATIAL_ORDER_HG
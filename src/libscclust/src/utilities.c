@@ -23,10 +23,12 @@
 
 #include <assert.h>
 #include <float.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include "allocator.h"
 #include "clustering_struct.h"
 #include "dist_search.h"
 #include "error.h"
@@ -41,9 +43,104 @@
  *
  *  This is an easily detectable invalid struct used as return value on errors.
  */
-static const scc_ClusteringStats ISCC_NULL_CLUSTERING_STATS = { 0, 0, 0, 0, 0, 0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+static const scc_ClusteringStats ISCC_NULL_CLUSTERING_STATS = { 0, 0, 0, 0, 0, 0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0, 0.0, 0.0, 0.0 };
 
-static const int32_t ISCC_OPTIONS_STRUCT_VERSION = 722678001;
+static const int32_t ISCC_OPTIONS_STRUCT_VERSION = 722678007;
+
+// Pairwise distances within clusters are computed in tiles of this many points
+// squared, so the scratch space of a tile fits in the L1 or L2 cache.
+#define ISCC_STATS_TILE_SIZE 64
+
+// Sampled pairs are drawn in batches of this many pairs that share one point.
+// The batch means are independent, and the confidence intervals are based on them.
+#define ISCC_STATS_SAMPLE_BATCH 32
+
+// Minimum number of batches drawn from a sampled cluster. Smaller sampling
+// budgets are raised to this many batches, so the confidence intervals have
+// at least seven degrees of freedom.
+static const uint64_t ISCC_STATS_MIN_SAMPLE_BATCHES = 8;
+
+// Quantile of the normal distribution for 95% confidence intervals.
+static const double ISCC_STATS_Z_95 = 1.959963984540054;
+
+// Quantiles of Student's t-distribution for 95% confidence intervals with
+// 1 to 30 degrees of freedom.
+static const double ISCC_STATS_T_95[30] = {
+	12.706204736, 4.302652730, 3.182446305, 2.776445105, 2.570581836,
+	2.446911851, 2.364624252, 2.306004135, 2.262157163, 2.228138852,
+	2.200985160, 2.178812830, 2.160368656, 2.144786688, 2.131449546,
+	2.119905299, 2.109815578, 2.100922040, 2.093024054, 2.085963447,
+	2.079613845, 2.073873068, 2.068657610, 2.063898562, 2.059538553,
+	2.055529439, 2.051830516, 2.048407142, 2.045229642, 2.042272456
+};
+
+static uint32_t iscc_num_threads = 1;
+
+
+/* For sampled clusters, `sum_dists` is estimated and `sum_dists_se` is its
+ * standard error with `sum_dists_df` degrees of freedom. The standard error is
+ * infinite if it cannot be estimated. `max_dist_upper_bound` equals `max_dist`
+ * for exact clusters.
+ * `radius` is the smallest of the members' largest distances to other members,
+ * and it is only derived on request for exact clusters (otherwise zero).
+ */
+typedef struct iscc_ClusterDistStats {
+	bool sampled;
+	double sum_dists;
+	double sum_dists_se;
+	double sum_dists_df;
+	double min_dist;
+	double max_dist;
+	double max_dist_upper_bound;
+	double radius;
+} iscc_ClusterDistStats;
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static scc_ErrorCode iscc_get_clustering_stats(void* data_set,
+                                               const scc_Clustering* clustering,
+                                               uint64_t max_sample_pairs,
+                                               double target_relative_error,
+                                               scc_ClusteringStats* out_stats);
+
+
+static void iscc_count_cluster_sizes(const scc_Clustering* clustering,
+                                     size_t out_cluster_size[]);
+
+
+static scc_ErrorCode iscc_get_all_cluster_dist_stats(void* data_set,
+                                                     const scc_Clustering* clustering,
+                                                     const size_t cluster_size[],
+                                                     size_t num_assigned,
+                                                     uint64_t max_sample_pairs,
+                                                     double target_relative_error,
+                                                     bool find_radius,
+                                                     iscc_ClusterDistStats out_cl_dist_stats[]);
+
+
+static bool iscc_get_cluster_dist_stats(void* data_set,
+                                        size_t size_cluster,
+                                        const scc_PointIndex members[],
+                                        double member_max_dists[],
+                                        iscc_ClusterDistStats* out_stats);
+
+
+static bool iscc_sample_cluster_dist_stats(void* data_set,
+                                           size_t size_cluster,
+                                           const scc_PointIndex members[],
+                                           uint64_t max_sample_pairs,
+                                           double target_relative_error,
+                                           uint64_t seed,
+                                           iscc_ClusterDistStats* out_stats);
+
+
+static double iscc_t_quantile_95(double df);
+
+
+static inline uint64_t iscc_next_random(uint64_t* state);
 
 
 // =============================================================================
@@ -71,6 +168,15 @@ scc_ClusterOptions scc_get_default_options(void)
 		.secondary_radius = SCC_RM_USE_SEED_RADIUS,
 		.secondary_supplied_radius = 0.0,
 		.batch_size = 0,
+		.adaptive_batch_size = false,
+		.spatial_batch_order = false,
+		.stable = false,
+		.spatial_renumbering = false,
+		.len_blocking_labels = 0,
+		.blocking_labels = NULL,
+		.len_block_reports = 0,
+		.block_reports = NULL,
+		.run_report = NULL,
 	};
 }
 
@@ -108,6 +214,33 @@ scc_ErrorCode scc_check_clustering(const scc_Clustering* const clustering,
 		return iscc_no_error(); // Error found, return. (`out_is_OK` is set to false)
 	}
 
+	if (options->blocking_labels != NULL) {
+		// All points in a cluster must share blocking label
+		scc_TypeLabel* const cluster_block = iscc_malloc(sizeof(scc_TypeLabel[clustering->num_clusters]));
+		bool* const cluster_seen = iscc_calloc(clustering->num_clusters, sizeof(bool));
+		if ((cluster_block == NULL) || (cluster_seen == NULL)) {
+			iscc_free(cluster_block);
+			iscc_free(cluster_seen);
+			return iscc_make_error(SCC_ER_NO_MEMORY);
+		}
+
+		bool blocks_OK = true;
+		for (size_t i = 0; blocks_OK && (i < clustering->num_data_points); ++i) {
+			const scc_Clabel label = clustering->cluster_label[i];
+			if (label == SCC_CLABEL_NA) continue;
+			if (!cluster_seen[label]) {
+				cluster_seen[label] = true;
+				cluster_block[label] = options->blocking_labels[i];
+			} else {
+				blocks_OK = (cluster_block[label] == options->blocking_labels[i]);
+			}
+		}
+
+		iscc_free(cluster_block);
+		iscc_free(cluster_seen);
+		if (!blocks_OK) return iscc_no_error(); // Error found, return. (`out_is_OK` is set to false)
+	}
+
 	if (options->primary_data_points != NULL) {
 		for (size_t i = 0; i < options->len_primary_data_points; ++i) {
 			if (clustering->cluster_label[options->primary_data_points[i]] == SCC_CLABEL_NA) {
@@ -118,7 +251,7 @@ scc_ErrorCode scc_check_clustering(const scc_Clustering* const clustering,
 
 	if (num_types < 2) {
 
-		size_t* const cluster_sizes = calloc(clustering->num_clusters, sizeof(size_t));
+		size_t* const cluster_sizes = iscc_calloc(clustering->num_clusters, sizeof(size_t));
 		if (cluster_sizes == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 		for (size_t i = 0; i < clustering->num_data_points; ++i) {
@@ -129,16 +262,16 @@ scc_ErrorCode scc_check_clustering(const scc_Clustering* const clustering,
 
 		for (size_t i = 0; i < clustering->num_clusters; ++i) {
 			if (cluster_sizes[i] < size_constraint) {
-				free(cluster_sizes);
+				iscc_free(cluster_sizes);
 				return iscc_no_error(); // Error found, return. (`out_is_OK` is set to false)
 			}
 		}
 
-		free(cluster_sizes);
+		iscc_free(cluster_sizes);
 
 	} else { // num_types >= 2
 
-		size_t* const cluster_type_sizes = calloc(num_types * clustering->num_clusters, sizeof(size_t));
+		size_t* const cluster_type_sizes = iscc_calloc(num_types * clustering->num_clusters, sizeof(size_t));
 		if (cluster_type_sizes == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 		for (size_t i = 0; i < clustering->num_data_points; ++i) {
@@ -152,17 +285,17 @@ scc_ErrorCode scc_check_clustering(const scc_Clustering* const clustering,
 			for (size_t t = 0; t < num_types; ++t) {
 				tmp_total_size += cluster_type_sizes[(i * num_types) + t];
 				if (cluster_type_sizes[(i * num_types) + t] < type_constraints[t]) {
-					free(cluster_type_sizes);
+					iscc_free(cluster_type_sizes);
 					return iscc_no_error(); // Error found, return. (`out_is_OK` is set to false)
 				}
 			}
 			if (tmp_total_size < size_constraint) {
-				free(cluster_type_sizes);
+				iscc_free(cluster_type_sizes);
 				return iscc_no_error(); // Error found, return. (`out_is_OK` is set to false)
 			}
 		}
 
-		free(cluster_type_sizes);
+		iscc_free(cluster_type_sizes);
 
 	}
 
@@ -171,14 +304,51 @@ scc_ErrorCode scc_check_clustering(const scc_Clustering* const clustering,
 }
 
 
+scc_ErrorCode scc_set_num_threads(const uint32_t num_threads)
+{
+	if (num_threads == 0) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Number of threads must be positive.");
+	}
+	iscc_num_threads = num_threads;
+	return iscc_no_error();
+}
+
+
 scc_ErrorCode scc_get_clustering_stats(void* const data_set,
                                        const scc_Clustering* const clustering,
                                        scc_ClusteringStats* const out_stats)
 {
-	if (out_stats == NULL) {
-		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Output parameter may not be NULL.");
+	return iscc_get_clustering_stats(data_set, clustering, 0, 0.0, out_stats);
+}
+
+
+scc_ErrorCode scc_get_approximate_clustering_stats(void* const data_set,
+                                                   const scc_Clustering* const clustering,
+                                                   const uint64_t max_sample_pairs,
+                                                   const double target_relative_error,
+                                                   scc_ClusteringStats* const out_stats)
+{
+	if (max_sample_pairs == 0) {
+		if (out_stats != NULL) *out_stats = ISCC_NULL_CLUSTERING_STATS;
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Number of sampled pairs must be positive.");
 	}
-	*out_stats = ISCC_NULL_CLUSTERING_STATS;
+	if (!(target_relative_error >= 0.0) || !isfinite(target_relative_error)) {
+		if (out_stats != NULL) *out_stats = ISCC_NULL_CLUSTERING_STATS;
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Target relative error must be non-negative.");
+	}
+
+	return iscc_get_clustering_stats(data_set, clustering, max_sample_pairs, target_relative_error, out_stats);
+}
+
+
+scc_ErrorCode scc_get_cluster_stats(void* const data_set,
+                                    const scc_Clustering* const clustering,
+                                    const size_t len_out_buffers,
+                                    uint64_t out_sizes[const],
+                                    double out_diameters[const],
+                                    double out_mean_dists[const],
+                                    double out_radii[const])
+{
 	if (!iscc_check_input_clustering(clustering)) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid clustering object.");
 	}
@@ -191,133 +361,57 @@ scc_ErrorCode scc_get_clustering_stats(void* const data_set,
 	if (iscc_num_data_points(data_set) != clustering->num_data_points) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Number of data points in data set does not match clustering object.");
 	}
-
-	size_t* const cluster_size = calloc(clustering->num_clusters, sizeof(size_t));
-	if (cluster_size == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
-
-	for (size_t i = 0; i < clustering->num_data_points; ++i) {
-		if (clustering->cluster_label[i] != SCC_CLABEL_NA) {
-			++cluster_size[clustering->cluster_label[i]];
-		}
+	if (len_out_buffers < clustering->num_clusters) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Output buffers are too short.");
 	}
 
-	scc_ClusteringStats tmp_stats = {
-		.num_data_points = clustering->num_data_points,
-		.num_assigned = 0,
-		.num_clusters = clustering->num_clusters,
-		.num_populated_clusters = 0,
-		.min_cluster_size = UINT64_MAX,
-		.max_cluster_size = 0,
-		.avg_cluster_size = 0.0,
-		.sum_dists = 0.0,
-		.min_dist = DBL_MAX,
-		.max_dist = 0.0,
-		.avg_min_dist = 0.0,
-		.avg_max_dist = 0.0,
-		.avg_dist_weighted = 0.0,
-		.avg_dist_unweighted = 0.0,
-	};
-
-	for (size_t c = 0; c < clustering->num_clusters; ++c) {
-		if (cluster_size[c] == 0) continue;
-		++tmp_stats.num_populated_clusters;
-		tmp_stats.num_assigned += cluster_size[c];
-		if (tmp_stats.min_cluster_size > cluster_size[c]) {
-			tmp_stats.min_cluster_size = cluster_size[c];
-		}
-		if (tmp_stats.max_cluster_size < cluster_size[c]) {
-			tmp_stats.max_cluster_size = cluster_size[c];
-		}
-	}
-
-	if (tmp_stats.num_populated_clusters == 0) {
-		free(cluster_size);
-		*out_stats = tmp_stats;
-		return iscc_no_error();
-	}
-
-	const size_t largest_dist_matrix = (tmp_stats.max_cluster_size * (tmp_stats.max_cluster_size - 1)) / 2;
-	scc_PointIndex* const id_store = malloc(sizeof(scc_PointIndex[tmp_stats.num_assigned]));
-	scc_PointIndex** const cl_members = malloc(sizeof(scc_PointIndex*[clustering->num_clusters]));
-	double* const dist_scratch = malloc(sizeof(double[largest_dist_matrix]));
-	if ((id_store == NULL) || (cl_members == NULL) || (dist_scratch == NULL)) {
-		free(cluster_size);
-		free(id_store);
-		free(cl_members);
-		free(dist_scratch);
+	const size_t num_clusters = clustering->num_clusters;
+	size_t* const cluster_size = iscc_calloc(num_clusters, sizeof(size_t));
+	iscc_ClusterDistStats* const cl_dist_stats = iscc_malloc(sizeof(iscc_ClusterDistStats[num_clusters]));
+	if ((cluster_size == NULL) || (cl_dist_stats == NULL)) {
+		iscc_free(cluster_size);
+		iscc_free(cl_dist_stats);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
-	cl_members[0] = id_store + cluster_size[0];
-	for (size_t c = 1; c < clustering->num_clusters; ++c) {
-		cl_members[c] = cl_members[c - 1] + cluster_size[c];
+	iscc_count_cluster_sizes(clustering, cluster_size);
+	size_t num_assigned = 0;
+	for (size_t c = 0; c < num_clusters; ++c) {
+		num_assigned += cluster_size[c];
 	}
 
-	assert(clustering->num_data_points <= ISCC_POINTINDEX_MAX);
-	const scc_PointIndex num_data_points = (scc_PointIndex) clustering->num_data_points; // If `scc_PointIndex` is signed
-	for (scc_PointIndex i = 0; i < num_data_points; ++i) {
-		if (clustering->cluster_label[i] != SCC_CLABEL_NA) {
-			--cl_members[clustering->cluster_label[i]];
-			*(cl_members[clustering->cluster_label[i]]) = i;
+	if ((out_diameters != NULL) || (out_mean_dists != NULL) || (out_radii != NULL)) {
+		scc_ErrorCode ec;
+		if ((ec = iscc_get_all_cluster_dist_stats(data_set,
+		                                          clustering,
+		                                          cluster_size,
+		                                          num_assigned,
+		                                          0,
+		                                          0.0,
+		                                          (out_radii != NULL),
+		                                          cl_dist_stats)) != SCC_ER_OK) {
+			iscc_free(cluster_size);
+			iscc_free(cl_dist_stats);
+			return ec;
 		}
 	}
 
-	for (size_t c = 0; c < clustering->num_clusters; ++c) {
+	for (size_t c = 0; c < num_clusters; ++c) {
+		if (out_sizes != NULL) out_sizes[c] = (uint64_t) cluster_size[c];
 		if (cluster_size[c] < 2) {
-			if (cluster_size[c] == 1) tmp_stats.min_dist = 0.0;
-			continue;
+			if (out_diameters != NULL) out_diameters[c] = 0.0;
+			if (out_mean_dists != NULL) out_mean_dists[c] = 0.0;
+			if (out_radii != NULL) out_radii[c] = 0.0;
+		} else {
+			const size_t size_dist_matrix = (cluster_size[c] * (cluster_size[c] - 1)) / 2;
+			if (out_diameters != NULL) out_diameters[c] = cl_dist_stats[c].max_dist;
+			if (out_mean_dists != NULL) out_mean_dists[c] = cl_dist_stats[c].sum_dists / ((double) size_dist_matrix);
+			if (out_radii != NULL) out_radii[c] = cl_dist_stats[c].radius;
 		}
-
-		const size_t size_dist_matrix = (cluster_size[c] * (cluster_size[c] - 1)) / 2;
-		if (!iscc_get_dist_matrix(data_set, cluster_size[c], cl_members[c], dist_scratch)) {
-			free(cluster_size);
-			free(id_store);
-			free(cl_members);
-			free(dist_scratch);
-			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
-		}
-
-		double cluster_sum_dists = dist_scratch[0];
-		double cluster_min = dist_scratch[0];
-		double cluster_max = dist_scratch[0];
-
-		for (size_t d = 1; d < size_dist_matrix; ++d) {
-			cluster_sum_dists += dist_scratch[d];
-			if (cluster_min > dist_scratch[d]) {
-				cluster_min = dist_scratch[d];
-			}
-			if (cluster_max < dist_scratch[d]) {
-				cluster_max = dist_scratch[d];
-			}
-		}
-
-		tmp_stats.sum_dists += cluster_sum_dists;
-
-		if (tmp_stats.min_dist > cluster_min) {
-			tmp_stats.min_dist = cluster_min;
-		}
-		if (tmp_stats.max_dist < cluster_max) {
-			tmp_stats.max_dist = cluster_max;
-		}
-		tmp_stats.avg_min_dist += cluster_min;
-		tmp_stats.avg_max_dist += cluster_max;
-
-		tmp_stats.avg_dist_weighted += ((double) cluster_size[c]) * cluster_sum_dists / ((double) size_dist_matrix);
-		tmp_stats.avg_dist_unweighted += cluster_sum_dists / ((double) size_dist_matrix);
 	}
 
-	tmp_stats.avg_cluster_size = ((double) tmp_stats.num_assigned) / ((double) tmp_stats.num_populated_clusters);
-	tmp_stats.avg_min_dist = tmp_stats.avg_min_dist / ((double) tmp_stats.num_populated_clusters);
-	tmp_stats.avg_max_dist = tmp_stats.avg_max_dist / ((double) tmp_stats.num_populated_clusters);
-	tmp_stats.avg_dist_weighted = tmp_stats.avg_dist_weighted / ((double) tmp_stats.num_assigned);
-	tmp_stats.avg_dist_unweighted = tmp_stats.avg_dist_unweighted / ((double) tmp_stats.num_populated_clusters);
-
-	free(cluster_size);
-	free(id_store);
-	free(cl_members);
-	free(dist_scratch);
-
-	*out_stats = tmp_stats;
+	iscc_free(cluster_size);
+	iscc_free(cl_dist_stats);
 
 	return iscc_no_error();
 }
@@ -373,7 +467,8 @@ scc_ErrorCode iscc_check_cluster_options(const scc_ClusterOptions* const options
 			(options->seed_method != SCC_SM_INWARDS_ORDER) &&
 			(options->seed_method != SCC_SM_INWARDS_UPDATING) &&
 			(options->seed_method != SCC_SM_EXCLUSION_ORDER) &&
-			(options->seed_method != SCC_SM_EXCLUSION_UPDATING)) {
+			(options->seed_method != SCC_SM_EXCLUSION_UPDATING) &&
+			(options->seed_method != SCC_SM_PAIR_MATCHING)) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Unknown seed method.");
 	}
 	if ((options->primary_data_points != NULL) && (options->len_primary_data_points == 0)) {
@@ -430,6 +525,19 @@ scc_ErrorCode iscc_check_cluster_options(const scc_ClusterOptions* const options
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid radius.");
 	}
 
+	if ((options->blocking_labels == NULL) && (options->len_blocking_labels > 0)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid blocking labels.");
+	}
+	if ((options->blocking_labels != NULL) && (options->len_blocking_labels < num_data_points)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid blocking labels.");
+	}
+	if ((options->block_reports == NULL) && (options->len_block_reports > 0)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid block reports.");
+	}
+	if ((options->block_reports != NULL) && (options->blocking_labels == NULL)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Block reports require blocking labels.");
+	}
+
 	if (options->seed_method == SCC_SM_BATCHES) {
 		if (options->num_types >= 2) {
 			return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "SCC_SM_BATCHES cannot be used with type constraints.");
@@ -442,5 +550,525 @@ scc_ErrorCode iscc_check_cluster_options(const scc_ClusterOptions* const options
 		}
 	}
 
+	if (options->seed_method == SCC_SM_PAIR_MATCHING) {
+		if (options->size_constraint != 2) {
+			return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "SCC_SM_PAIR_MATCHING must be used with `size_constraint = 2`.");
+		}
+		if (options->num_types >= 2) {
+			return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "SCC_SM_PAIR_MATCHING cannot be used with type constraints.");
+		}
+	}
+
+	return iscc_no_error();
+}
+
+
+uint32_t iscc_get_num_threads(void)
+{
+	return iscc_num_threads;
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static scc_ErrorCode iscc_get_clustering_stats(void* const data_set,
+                                               const scc_Clustering* const clustering,
+                                               const uint64_t max_sample_pairs,
+                                               const double target_relative_error,
+                                               scc_ClusteringStats* const out_stats)
+{
+	if (out_stats == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Output parameter may not be NULL.");
+	}
+	*out_stats = ISCC_NULL_CLUSTERING_STATS;
+	if (!iscc_check_input_clustering(clustering)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid clustering object.");
+	}
+	if (clustering->num_clusters == 0) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Empty clustering.");
+	}
+	if (!iscc_check_data_set(data_set)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data set object.");
+	}
+	if (iscc_num_data_points(data_set) != clustering->num_data_points) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Number of data points in data set does not match clustering object.");
+	}
+
+	size_t* const cluster_size = iscc_calloc(clustering->num_clusters, sizeof(size_t));
+	if (cluster_size == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+	iscc_count_cluster_sizes(clustering, cluster_size);
+
+	scc_ClusteringStats tmp_stats = {
+		.num_data_points = clustering->num_data_points,
+		.num_assigned = 0,
+		.num_clusters = clustering->num_clusters,
+		.num_populated_clusters = 0,
+		.min_cluster_size = UINT64_MAX,
+		.max_cluster_size = 0,
+		.avg_cluster_size = 0.0,
+		.sum_dists = 0.0,
+		.min_dist = DBL_MAX,
+		.max_dist = 0.0,
+		.avg_min_dist = 0.0,
+		.avg_max_dist = 0.0,
+		.avg_dist_weighted = 0.0,
+		.avg_dist_unweighted = 0.0,
+		.num_sampled_clusters = 0,
+		.max_dist_upper_bound = 0.0,
+		.avg_dist_weighted_margin = 0.0,
+		.avg_dist_unweighted_margin = 0.0,
+	};
+
+	for (size_t c = 0; c < clustering->num_clusters; ++c) {
+		if (cluster_size[c] == 0) continue;
+		++tmp_stats.num_populated_clusters;
+		tmp_stats.num_assigned += cluster_size[c];
+		if (tmp_stats.min_cluster_size > cluster_size[c]) {
+			tmp_stats.min_cluster_size = cluster_size[c];
+		}
+		if (tmp_stats.max_cluster_size < cluster_size[c]) {
+			tmp_stats.max_cluster_size = cluster_size[c];
+		}
+	}
+
+	if (tmp_stats.num_populated_clusters == 0) {
+		iscc_free(cluster_size);
+		*out_stats = tmp_stats;
+		return iscc_no_error();
+	}
+
+	iscc_ClusterDistStats* const cl_dist_stats = iscc_malloc(sizeof(iscc_ClusterDistStats[clustering->num_clusters]));
+	if (cl_dist_stats == NULL) {
+		iscc_free(cluster_size);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	scc_ErrorCode ec;
+	if ((ec = iscc_get_all_cluster_dist_stats(data_set,
+	                                          clustering,
+	                                          cluster_size,
+	                                          tmp_stats.num_assigned,
+	                                          max_sample_pairs,
+	                                          target_relative_error,
+	                                          false,
+	                                          cl_dist_stats)) != SCC_ER_OK) {
+		iscc_free(cluster_size);
+		iscc_free(cl_dist_stats);
+		return ec;
+	}
+
+	// Variances of the estimated averages and their Welch-Satterthwaite denominators
+	double weighted_var = 0.0;
+	double weighted_var_df = 0.0;
+	double unweighted_var = 0.0;
+	double unweighted_var_df = 0.0;
+	bool finite_var = true;
+
+	for (size_t c = 0; c < clustering->num_clusters; ++c) {
+		if (cluster_size[c] < 2) {
+			if (cluster_size[c] == 1) tmp_stats.min_dist = 0.0;
+			continue;
+		}
+
+		const size_t size_dist_matrix = (cluster_size[c] * (cluster_size[c] - 1)) / 2;
+		const double cluster_sum_dists = cl_dist_stats[c].sum_dists;
+		const double cluster_min = cl_dist_stats[c].min_dist;
+		const double cluster_max = cl_dist_stats[c].max_dist;
+
+		tmp_stats.sum_dists += cluster_sum_dists;
+
+		if (tmp_stats.min_dist > cluster_min) {
+			tmp_stats.min_dist = cluster_min;
+		}
+		if (tmp_stats.max_dist < cluster_max) {
+			tmp_stats.max_dist = cluster_max;
+		}
+		if (tmp_stats.max_dist_upper_bound < cl_dist_stats[c].max_dist_upper_bound) {
+			tmp_stats.max_dist_upper_bound = cl_dist_stats[c].max_dist_upper_bound;
+		}
+		tmp_stats.avg_min_dist += cluster_min;
+		tmp_stats.avg_max_dist += cluster_max;
+
+		tmp_stats.avg_dist_weighted += ((double) cluster_size[c]) * cluster_sum_dists / ((double) size_dist_matrix);
+		tmp_stats.avg_dist_unweighted += cluster_sum_dists / ((double) size_dist_matrix);
+
+		if (cl_dist_stats[c].sampled) {
+			++tmp_stats.num_sampled_clusters;
+			if (!isfinite(cl_dist_stats[c].sum_dists_se)) {
+				finite_var = false;
+				continue;
+			}
+			const double avg_dist_se = cl_dist_stats[c].sum_dists_se / ((double) size_dist_matrix);
+			const double cluster_weighted_var = ((double) cluster_size[c]) * ((double) cluster_size[c]) * avg_dist_se * avg_dist_se;
+			const double cluster_unweighted_var = avg_dist_se * avg_dist_se;
+			weighted_var += cluster_weighted_var;
+			weighted_var_df += cluster_weighted_var * cluster_weighted_var / cl_dist_stats[c].sum_dists_df;
+			unweighted_var += cluster_unweighted_var;
+			unweighted_var_df += cluster_unweighted_var * cluster_unweighted_var / cl_dist_stats[c].sum_dists_df;
+		}
+	}
+
+	tmp_stats.avg_cluster_size = ((double) tmp_stats.num_assigned) / ((double) tmp_stats.num_populated_clusters);
+	tmp_stats.avg_min_dist = tmp_stats.avg_min_dist / ((double) tmp_stats.num_populated_clusters);
+	tmp_stats.avg_max_dist = tmp_stats.avg_max_dist / ((double) tmp_stats.num_populated_clusters);
+	tmp_stats.avg_dist_weighted = tmp_stats.avg_dist_weighted / ((double) tmp_stats.num_assigned);
+	tmp_stats.avg_dist_unweighted = tmp_stats.avg_dist_unweighted / ((double) tmp_stats.num_populated_clusters);
+	if (!finite_var) {
+		tmp_stats.avg_dist_weighted_margin = INFINITY;
+		tmp_stats.avg_dist_unweighted_margin = INFINITY;
+	} else {
+		// Welch-Satterthwaite approximation of the degrees of freedom of the summed variances
+		if (weighted_var > 0.0) {
+			const double t_95 = iscc_t_quantile_95(weighted_var * weighted_var / weighted_var_df);
+			tmp_stats.avg_dist_weighted_margin = t_95 * sqrt(weighted_var) / ((double) tmp_stats.num_assigned);
+		}
+		if (unweighted_var > 0.0) {
+			const double t_95 = iscc_t_quantile_95(unweighted_var * unweighted_var / unweighted_var_df);
+			tmp_stats.avg_dist_unweighted_margin = t_95 * sqrt(unweighted_var) / ((double) tmp_stats.num_populated_clusters);
+		}
+	}
+
+	iscc_free(cluster_size);
+	iscc_free(cl_dist_stats);
+
+	*out_stats = tmp_stats;
+
 	return iscc_no_error();
 }
+
+
+static void iscc_count_cluster_sizes(const scc_Clustering* const clustering,
+                                     size_t out_cluster_size[const])
+{
+	assert(iscc_check_input_clustering(clustering));
+	assert(out_cluster_size != NULL);
+
+	for (size_t c = 0; c < clustering->num_clusters; ++c) {
+		out_cluster_size[c] = 0;
+	}
+	for (size_t i = 0; i < clustering->num_data_points; ++i) {
+		if (clustering->cluster_label[i] != SCC_CLABEL_NA) {
+			++out_cluster_size[clustering->cluster_label[i]];
+		}
+	}
+}
+
+
+static scc_ErrorCode iscc_get_all_cluster_dist_stats(void* const data_set,
+                                                     const scc_Clustering* const clustering,
+                                                     const size_t cluster_size[const],
+                                                     const size_t num_assigned,
+                                                     const uint64_t max_sample_pairs,
+                                                     const double target_relative_error,
+                                                     const bool find_radius,
+                                                     iscc_ClusterDistStats out_cl_dist_stats[const])
+{
+	assert(iscc_check_data_set(data_set));
+	assert(iscc_check_input_clustering(clustering));
+	assert(clustering->num_clusters > 0);
+	assert(cluster_size != NULL);
+	assert(!find_radius || (max_sample_pairs == 0));
+	assert(out_cl_dist_stats != NULL);
+
+	if (num_assigned == 0) return iscc_no_error();
+
+	scc_PointIndex* const id_store = iscc_malloc(sizeof(scc_PointIndex[num_assigned]));
+	scc_PointIndex** const cl_members = iscc_malloc(sizeof(scc_PointIndex*[clustering->num_clusters]));
+	double* const max_dist_store = find_radius ? iscc_malloc(sizeof(double[num_assigned])) : NULL;
+	if ((id_store == NULL) || (cl_members == NULL) || (find_radius && (max_dist_store == NULL))) {
+		iscc_free(id_store);
+		iscc_free(cl_members);
+		iscc_free(max_dist_store);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	cl_members[0] = id_store + cluster_size[0];
+	for (size_t c = 1; c < clustering->num_clusters; ++c) {
+		cl_members[c] = cl_members[c - 1] + cluster_size[c];
+	}
+
+	assert(clustering->num_data_points <= ISCC_POINTINDEX_MAX);
+	const scc_PointIndex num_data_points = (scc_PointIndex) clustering->num_data_points; // If `scc_PointIndex` is signed
+	for (scc_PointIndex i = 0; i < num_data_points; ++i) {
+		if (clustering->cluster_label[i] != SCC_CLABEL_NA) {
+			--cl_members[clustering->cluster_label[i]];
+			*(cl_members[clustering->cluster_label[i]]) = i;
+		}
+	}
+
+	// Budgets below the minimum number of batches are raised, and clusters
+	// with fewer pairs than the budget are cheaper to derive exactly
+	const uint64_t min_sample_pairs = ISCC_STATS_MIN_SAMPLE_BATCHES * ISCC_STATS_SAMPLE_BATCH;
+	const uint64_t sample_budget = ((max_sample_pairs > 0) && (max_sample_pairs < min_sample_pairs)) ? min_sample_pairs : max_sample_pairs;
+
+	// Clusters are processed in parallel and the totals are reduced in
+	// cluster order, so the result does not depend on the number of threads
+	bool dist_search_ok = true;
+	const size_t num_clusters = clustering->num_clusters;
+	#ifdef _OPENMP
+		#pragma omp parallel for num_threads((int) iscc_get_num_threads()) schedule(dynamic, 16)
+	#endif // ifdef _OPENMP
+	for (size_t c = 0; c < num_clusters; ++c) {
+		if (cluster_size[c] < 2) continue;
+		bool cluster_ok;
+		if ((sample_budget > 0) && ((((uint64_t) cluster_size[c]) * (cluster_size[c] - 1)) / 2 > sample_budget)) {
+			// Seed with the cluster label so the sample does not depend on the thread
+			cluster_ok = iscc_sample_cluster_dist_stats(data_set,
+			                                            cluster_size[c],
+			                                            cl_members[c],
+			                                            sample_budget,
+			                                            target_relative_error,
+			                                            (uint64_t) c,
+			                                            &out_cl_dist_stats[c]);
+		} else {
+			double* const member_max_dists = find_radius ? max_dist_store + (cl_members[c] - id_store) : NULL;
+			cluster_ok = iscc_get_cluster_dist_stats(data_set,
+			                                         cluster_size[c],
+			                                         cl_members[c],
+			                                         member_max_dists,
+			                                         &out_cl_dist_stats[c]);
+		}
+		if (!cluster_ok) {
+			#ifdef _OPENMP
+				#pragma omp atomic write
+			#endif // ifdef _OPENMP
+			dist_search_ok = false;
+		}
+	}
+
+	iscc_free(id_store);
+	iscc_free(cl_members);
+	iscc_free(max_dist_store);
+
+	if (!dist_search_ok) return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+
+	return iscc_no_error();
+}
+
+
+static bool iscc_get_cluster_dist_stats(void* const data_set,
+                                        const size_t size_cluster,
+                                        const scc_PointIndex members[const],
+                                        double member_max_dists[const],
+                                        iscc_ClusterDistStats* const out_stats)
+{
+	assert(iscc_check_data_set(data_set));
+	assert(size_cluster >= 2);
+	assert(members != NULL);
+	assert(out_stats != NULL);
+
+	if (member_max_dists != NULL) {
+		for (size_t i = 0; i < size_cluster; ++i) {
+			member_max_dists[i] = 0.0;
+		}
+	}
+
+	double tile_dists[ISCC_STATS_TILE_SIZE * ISCC_STATS_TILE_SIZE];
+	double sum_dists = 0.0;
+	double min_dist = DBL_MAX;
+	double max_dist = 0.0;
+
+	// Each pair of points is in exactly one tile: tiles on the diagonal hold the
+	// pairs within a block of points, the others the pairs between two blocks
+	for (size_t row = 0; row < size_cluster; row += ISCC_STATS_TILE_SIZE) {
+		const size_t len_rows = ((size_cluster - row) < ISCC_STATS_TILE_SIZE) ? (size_cluster - row) : ISCC_STATS_TILE_SIZE;
+		for (size_t col = row; col < size_cluster; col += ISCC_STATS_TILE_SIZE) {
+			size_t len_tile;
+			if (col == row) {
+				if (len_rows < 2) continue;
+				if (!iscc_get_dist_matrix(data_set, len_rows, members + row, tile_dists)) {
+					return false;
+				}
+				len_tile = (len_rows * (len_rows - 1)) / 2;
+			} else {
+				const size_t len_cols = ((size_cluster - col) < ISCC_STATS_TILE_SIZE) ? (size_cluster - col) : ISCC_STATS_TILE_SIZE;
+				if (!iscc_get_dist_rows(data_set, len_rows, members + row, len_cols, members + col, tile_dists)) {
+					return false;
+				}
+				len_tile = len_rows * len_cols;
+			}
+
+			for (size_t d = 0; d < len_tile; ++d) {
+				sum_dists += tile_dists[d];
+				if (min_dist > tile_dists[d]) {
+					min_dist = tile_dists[d];
+				}
+				if (max_dist < tile_dists[d]) {
+					max_dist = tile_dists[d];
+				}
+			}
+
+			if (member_max_dists != NULL) {
+				// Each distance in the tile is also a candidate for the largest
+				// distance of both its points
+				const double* tile_dist = tile_dists;
+				if (col == row) {
+					for (size_t i = 0; i < len_rows; ++i) {
+						for (size_t j = i + 1; j < len_rows; ++j, ++tile_dist) {
+							if (member_max_dists[row + i] < *tile_dist) member_max_dists[row + i] = *tile_dist;
+							if (member_max_dists[row + j] < *tile_dist) member_max_dists[row + j] = *tile_dist;
+						}
+					}
+				} else {
+					const size_t len_cols = len_tile / len_rows;
+					for (size_t i = 0; i < len_rows; ++i) {
+						for (size_t j = 0; j < len_cols; ++j, ++tile_dist) {
+							if (member_max_dists[row + i] < *tile_dist) member_max_dists[row + i] = *tile_dist;
+							if (member_max_dists[col + j] < *tile_dist) member_max_dists[col + j] = *tile_dist;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	double radius = 0.0;
+	if (member_max_dists != NULL) {
+		radius = member_max_dists[0];
+		for (size_t i = 1; i < size_cluster; ++i) {
+			if (radius > member_max_dists[i]) radius = member_max_dists[i];
+		}
+	}
+
+	*out_stats = (iscc_ClusterDistStats) {
+		.sampled = false,
+		.sum_dists = sum_dists,
+		.sum_dists_se = 0.0,
+		.sum_dists_df = 0.0,
+		.min_dist = min_dist,
+		.max_dist = max_dist,
+		.max_dist_upper_bound = max_dist,
+		.radius = radius,
+	};
+
+	return true;
+}
+
+
+static bool iscc_sample_cluster_dist_stats(void* const data_set,
+                                           const size_t size_cluster,
+                                           const scc_PointIndex members[const],
+                                           const uint64_t max_sample_pairs,
+                                           const double target_relative_error,
+                                           const uint64_t seed,
+                                           iscc_ClusterDistStats* const out_stats)
+{
+	assert(iscc_check_data_set(data_set));
+	assert(size_cluster >= 2);
+	assert(members != NULL);
+	assert(max_sample_pairs >= ISCC_STATS_MIN_SAMPLE_BATCHES * ISCC_STATS_SAMPLE_BATCH);
+	assert(target_relative_error >= 0.0);
+	assert(out_stats != NULL);
+
+	double dists[ISCC_STATS_TILE_SIZE * ISCC_STATS_TILE_SIZE];
+	double min_dist = DBL_MAX;
+	double max_dist = 0.0;
+
+	// Distances from one point bound the diameter with the triangle inequality:
+	// max_dist <= d(p, i) + d(p, j) <= 2 max_i d(p, i)
+	const scc_PointIndex pivot = members[0];
+	double max_pivot_dist = 0.0;
+	for (size_t offset = 1; offset < size_cluster; offset += ISCC_STATS_TILE_SIZE * ISCC_STATS_TILE_SIZE) {
+		const size_t len_chunk = ((size_cluster - offset) < ISCC_STATS_TILE_SIZE * ISCC_STATS_TILE_SIZE) ? (size_cluster - offset) : ISCC_STATS_TILE_SIZE * ISCC_STATS_TILE_SIZE;
+		if (!iscc_get_dist_rows(data_set, 1, &pivot, len_chunk, members + offset, dists)) {
+			return false;
+		}
+		for (size_t d = 0; d < len_chunk; ++d) {
+			if (min_dist > dists[d]) min_dist = dists[d];
+			if (max_pivot_dist < dists[d]) max_pivot_dist = dists[d];
+		}
+	}
+	max_dist = max_pivot_dist;
+
+	// Each batch draws a uniformly random point and `ISCC_STATS_SAMPLE_BATCH`
+	// uniformly random other points, so every batch mean is an unbiased estimate
+	// of the average distance in the cluster
+	uint64_t random_state = seed;
+	scc_PointIndex batch_points[ISCC_STATS_SAMPLE_BATCH];
+	uint64_t num_batches = 0;
+	double mean_batch_means = 0.0;
+	double m2_batch_means = 0.0;
+	const uint64_t max_batches = (max_sample_pairs + ISCC_STATS_SAMPLE_BATCH - 1) / ISCC_STATS_SAMPLE_BATCH;
+	while (num_batches < max_batches) {
+		const size_t query = (size_t) (iscc_next_random(&random_state) % size_cluster);
+		for (size_t b = 0; b < ISCC_STATS_SAMPLE_BATCH; ++b) {
+			size_t other = (size_t) (iscc_next_random(&random_state) % (size_cluster - 1));
+			if (other >= query) ++other;
+			batch_points[b] = members[other];
+		}
+
+		if (!iscc_get_dist_rows(data_set, 1, &members[query], ISCC_STATS_SAMPLE_BATCH, batch_points, dists)) {
+			return false;
+		}
+
+		double batch_sum = 0.0;
+		for (size_t b = 0; b < ISCC_STATS_SAMPLE_BATCH; ++b) {
+			batch_sum += dists[b];
+			if (min_dist > dists[b]) min_dist = dists[b];
+			if (max_dist < dists[b]) max_dist = dists[b];
+		}
+
+		// Running mean and variance of batch means (Welford)
+		const double batch_mean = batch_sum / ISCC_STATS_SAMPLE_BATCH;
+		++num_batches;
+		const double delta = batch_mean - mean_batch_means;
+		mean_batch_means += delta / ((double) num_batches);
+		m2_batch_means += delta * (batch_mean - mean_batch_means);
+
+		if ((target_relative_error > 0.0) && (num_batches >= ISCC_STATS_MIN_SAMPLE_BATCHES)) {
+			const double se = sqrt(m2_batch_means / ((double) (num_batches - 1)) / ((double) num_batches));
+			if (iscc_t_quantile_95((double) (num_batches - 1)) * se <= target_relative_error * mean_batch_means) break;
+		}
+	}
+
+	// The budget ensures enough batches, but the variance cannot be estimated from one batch
+	const double num_pairs = ((double) size_cluster) * ((double) (size_cluster - 1)) / 2.0;
+	const double se = (num_batches > 1) ? sqrt(m2_batch_means / ((double) (num_batches - 1)) / ((double) num_batches)) : INFINITY;
+
+	*out_stats = (iscc_ClusterDistStats) {
+		.sampled = true,
+		.sum_dists = mean_batch_means * num_pairs,
+		.sum_dists_se = se * num_pairs,
+		.sum_dists_df = (double) (num_batches - 1),
+		.min_dist = min_dist,
+		.max_dist = max_dist,
+		.max_dist_upper_bound = 2.0 * max_pivot_dist,
+		.radius = 0.0,
+	};
+
+	return true;
+}
+
+
+static double iscc_t_quantile_95(const double df)
+{
+	if (!(df >= 1.0)) return INFINITY;
+
+	// Rounding down the degrees of freedom gives a conservative quantile
+	if (df < 31.0) return ISCC_STATS_T_95[((size_t) df) - 1];
+
+	// Cornish-Fisher expansion around the normal quantile, accurate to
+	// five digits from 31 degrees of freedom
+	const double z = ISCC_STATS_Z_95;
+	const double z2 = z * z;
+	const double g1 = (z2 + 1.0) * z / 4.0;
+	const double g2 = ((5.0 * z2 + 16.0) * z2 + 3.0) * z / 96.0;
+	const double g3 = (((3.0 * z2 + 19.0) * z2 + 17.0) * z2 - 15.0) * z / 384.0;
+	const double df_floor = floor(df);
+	return z + (g1 + (g2 + g3 / df_floor) / df_floor) / df_floor;
+}
+
+
+static inline uint64_t iscc_next_random(uint64_t* const state)
+{
+	assert(state != NULL);
+
+	// splitmix64
+	uint64_t z = (*state += UINT64_C(0x9E3779B97F4A7C15));
+	z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+	z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+	return z ^ (z >> 31);
+}
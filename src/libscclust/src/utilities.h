@@ -22,6 +22,7 @@
 #define SCC_UTILITIES_HG
 
 #include <stddef.h>
+#include <stdint.h>
 #include "../include/scclust.h"
 
 
@@ -33,4 +34,7 @@ scc_ErrorCode iscc_check_cluster_options(const scc_ClusterOptions* options,
                                          size_t num_data_points);
 
 
+uint32_t iscc_get_num_threads(void);
+
+
 #endif // ifndef SCC_UTILITIES_HG
@@ -0,0 +1,283 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+/* Clustering runs made concurrently from several application threads.
+ *
+ * Usage: test_concurrent_runs [num_threads]
+ *
+ * Each application thread makes repeated calls to #scc_sc_clustering (with
+ * the default seed method and with batches) and to
+ * #scc_hierarchical_clustering_with_options on the same data set, with arena
+ * mode set and `num_threads` library threads per call. The labels must equal
+ * those of a serial run, and the counters in the run report of each call must
+ * equal those of a single call. Returns zero on success.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/scclust.h"
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+#define ITEST_NUM_APP_THREADS 4
+#define ITEST_NUM_CALLS 10
+#define ITEST_NUM_METHODS 3
+
+static const uint64_t ITEST_NUM_DATA_POINTS = 3000;
+
+static const uint32_t ITEST_NUM_DIMENSIONS = 2;
+
+
+typedef struct itest_Labels {
+	scc_Clabel* nng;
+	scc_Clabel* batches;
+	scc_Clabel* hierarchical;
+	scc_RunReport reports[ITEST_NUM_METHODS];
+} itest_Labels;
+
+
+typedef struct itest_Thread {
+	pthread_t thread;
+	scc_DataSet* data_set;
+	const itest_Labels* reference;
+	itest_Labels labels;
+	bool ok;
+} itest_Thread;
+
+
+static scc_ErrorCode itest_run(scc_DataSet* data_set,
+                               itest_Labels* out_labels);
+
+
+static void* itest_thread_main(void* arg);
+
+
+static bool itest_equal_labels(const itest_Labels* labels,
+                               const itest_Labels* reference);
+
+
+static bool itest_equal_reports(const itest_Labels* labels,
+                                const itest_Labels* reference);
+
+
+static bool itest_alloc_labels(itest_Labels* out_labels);
+
+
+static void itest_free_labels(itest_Labels* labels);
+
+
+static uint64_t itest_next_random(uint64_t* state);
+
+
+static int itest_fail(const char* message);
+
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(const int argc, char** const argv)
+{
+	const uint32_t num_threads = (argc >= 2) ? (uint32_t) strtoul(argv[1], NULL, 10) : 2;
+	if ((argc > 2) || (num_threads == 0)) {
+		fprintf(stderr, "Usage: %s [num_threads]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	double* const data = malloc(sizeof(double[ITEST_NUM_DATA_POINTS * ITEST_NUM_DIMENSIONS]));
+	if (data == NULL) return itest_fail("Out of memory.");
+	uint64_t state = 12345;
+	for (size_t i = 0; i < ITEST_NUM_DATA_POINTS * ITEST_NUM_DIMENSIONS; ++i) {
+		data[i] = (double) (itest_next_random(&state) >> 11) / 9007199254740992.0;
+	}
+
+	scc_DataSet* data_set;
+	if (scc_init_data_set(ITEST_NUM_DATA_POINTS,
+	                      ITEST_NUM_DIMENSIONS,
+	                      ITEST_NUM_DATA_POINTS * ITEST_NUM_DIMENSIONS,
+	                      data,
+	                      &data_set) != SCC_ER_OK) {
+		return itest_fail("Cannot make data set.");
+	}
+
+	// Reference labels without arena and with one thread
+	itest_Labels reference;
+	if (!itest_alloc_labels(&reference)) return itest_fail("Out of memory.");
+	if (itest_run(data_set, &reference) != SCC_ER_OK) return itest_fail("Reference run failed.");
+
+	if (scc_set_num_threads(num_threads) != SCC_ER_OK) return itest_fail("Cannot set threads.");
+	if (scc_set_arena_mode(true) != SCC_ER_OK) return itest_fail("Cannot set arena mode.");
+
+	// Reference reports with the same settings as the concurrent runs
+	itest_Labels single;
+	if (!itest_alloc_labels(&single)) return itest_fail("Out of memory.");
+	if (itest_run(data_set, &single) != SCC_ER_OK) return itest_fail("Single run failed.");
+	if (!itest_equal_labels(&single, &reference)) return itest_fail("Threaded run differs from the serial run.");
+	memcpy(reference.reports, single.reports, sizeof(reference.reports));
+	itest_free_labels(&single);
+
+	itest_Thread threads[ITEST_NUM_APP_THREADS];
+	for (size_t t = 0; t < ITEST_NUM_APP_THREADS; ++t) {
+		threads[t] = (itest_Thread) {
+			.data_set = data_set,
+			.reference = &reference,
+			.ok = false,
+		};
+		if (!itest_alloc_labels(&threads[t].labels)) return itest_fail("Out of memory.");
+	}
+	for (size_t t = 0; t < ITEST_NUM_APP_THREADS; ++t) {
+		if (pthread_create(&threads[t].thread, NULL, itest_thread_main, &threads[t]) != 0) {
+			return itest_fail("Cannot start thread.");
+		}
+	}
+	bool all_ok = true;
+	for (size_t t = 0; t < ITEST_NUM_APP_THREADS; ++t) {
+		pthread_join(threads[t].thread, NULL);
+		all_ok = all_ok && threads[t].ok;
+		itest_free_labels(&threads[t].labels);
+	}
+
+	scc_set_arena_mode(false);
+	itest_free_labels(&reference);
+	scc_free_data_set(&data_set);
+	free(data);
+
+	if (!all_ok) return itest_fail("Concurrent runs differ from the serial run.");
+	printf("OK\n");
+	return EXIT_SUCCESS;
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static scc_ErrorCode itest_run(scc_DataSet* const data_set,
+                               itest_Labels* const out_labels)
+{
+	scc_ErrorCode ec = SCC_ER_OK;
+	scc_Clabel* const out[ITEST_NUM_METHODS] = { out_labels->nng, out_labels->batches, out_labels->hierarchical };
+	for (size_t m = 0; (m < ITEST_NUM_METHODS) && (ec == SCC_ER_OK); ++m) {
+		scc_Clustering* clustering;
+		if ((ec = scc_init_empty_clustering(ITEST_NUM_DATA_POINTS, NULL, &clustering)) != SCC_ER_OK) return ec;
+
+		if (m < 2) {
+			scc_ClusterOptions options = scc_get_default_options();
+			options.size_constraint = 3;
+			if (m == 1) options.seed_method = SCC_SM_BATCHES;
+			options.run_report = &out_labels->reports[m];
+			ec = scc_sc_clustering(data_set, &options, clustering);
+		} else {
+			scc_HierarchicalOptions options = scc_get_default_hierarchical_options();
+			options.size_constraint = 3;
+			options.run_report = &out_labels->reports[m];
+			ec = scc_hierarchical_clustering_with_options(data_set, &options, clustering);
+		}
+		if (ec == SCC_ER_OK) {
+			ec = scc_get_cluster_labels(clustering, ITEST_NUM_DATA_POINTS, out[m]);
+		}
+
+		scc_free_clustering(&clustering);
+	}
+	return ec;
+}
+
+
+static void* itest_thread_main(void* const arg)
+{
+	itest_Thread* const thread = arg;
+	thread->ok = true;
+	for (size_t c = 0; (c < ITEST_NUM_CALLS) && thread->ok; ++c) {
+		thread->ok = (itest_run(thread->data_set, &thread->labels) == SCC_ER_OK) &&
+		             itest_equal_labels(&thread->labels, thread->reference) &&
+		             itest_equal_reports(&thread->labels, thread->reference);
+	}
+	return NULL;
+}
+
+
+static bool itest_equal_labels(const itest_Labels* const labels,
+                               const itest_Labels* const reference)
+{
+	return (memcmp(labels->nng, reference->nng, sizeof(scc_Clabel[ITEST_NUM_DATA_POINTS])) == 0) &&
+	       (memcmp(labels->batches, reference->batches, sizeof(scc_Clabel[ITEST_NUM_DATA_POINTS])) == 0) &&
+	       (memcmp(labels->hierarchical, reference->hierarchical, sizeof(scc_Clabel[ITEST_NUM_DATA_POINTS])) == 0);
+}
+
+
+static bool itest_equal_reports(const itest_Labels* const labels,
+                                const itest_Labels* const reference)
+{
+	for (size_t m = 0; m < ITEST_NUM_METHODS; ++m) {
+		const scc_RunReport* const a = &labels->reports[m];
+		const scc_RunReport* const b = &reference->reports[m];
+		if ((a->num_dist_evaluations != b->num_dist_evaluations) ||
+		        (a->num_nn_queries != b->num_nn_queries) ||
+		        (a->num_max_dist_queries != b->num_max_dist_queries) ||
+		        (a->nng_arcs != b->nng_arcs) ||
+		        (a->exclusion_graph_arcs != b->exclusion_graph_arcs) ||
+		        (a->peak_alloc_bytes == 0)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+static bool itest_alloc_labels(itest_Labels* const out_labels)
+{
+	out_labels->nng = malloc(sizeof(scc_Clabel[ITEST_NUM_DATA_POINTS]));
+	out_labels->batches = malloc(sizeof(scc_Clabel[ITEST_NUM_DATA_POINTS]));
+	out_labels->hierarchical = malloc(sizeof(scc_Clabel[ITEST_NUM_DATA_POINTS]));
+	return (out_labels->nng != NULL) && (out_labels->batches != NULL) && (out_labels->hierarchical != NULL);
+}
+
+
+static void itest_free_labels(itest_Labels* const labels)
+{
+	free(labels->nng);
+	free(labels->batches);
+	free(labels->hierarchical);
+}
+
+
+static uint64_t itest_next_random(uint64_t* const state)
+{
+	// xorshift64*
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 2685821657736338717ULL;
+}
+
+
+static int itest_fail(const char* const message)
+{
+	fprintf(stderr, "%s\n", message);
+	return EXIT_FAILURE;
+}
@@ -28,7 +28,8 @@ static const R_CallMethodDef callMethods[] = {
 	{"Rscc_hierarchical_clustering",  (DL_FUNC) &Rscc_hierarchical_clustering,  4},
 	{"Rscc_sc_clustering",            (DL_FUNC) &Rscc_sc_clustering,           12},
 	{"Rscc_check_clustering",         (DL_FUNC) &Rscc_check_clustering,         5},
-	{"Rscc_get_clustering_stats",     (DL_FUNC) &Rscc_get_clustering_stats,     2},
+	{"Rscc_get_clustering_stats",     (DL_FUNC) &Rscc_get_clustering_stats,     4},
+	{"Rscc_get_cluster_stats",        (DL_FUNC) &Rscc_get_cluster_stats,        2},
 	{NULL,                            NULL,                                     0}
 };
 
@@ -128,7 +128,9 @@ SEXP Rscc_check_clustering(const SEXP R_clustering,
 
 
 SEXP Rscc_get_clustering_stats(const SEXP R_distances,
-                               const SEXP R_clustering)
+                               const SEXP R_clustering,
+                               const SEXP R_sample_pairs,
+                               const SEXP R_relative_error)
 {
 	Rscc_set_dist_functions();
 
@@ -141,6 +143,18 @@ SEXP Rscc_get_clustering_stats(const SEXP R_distances,
 	if (!idist_check_distance_object(R_distances)) {
 		iRscc_error("`R_distances` is not a valid distance object.");
 	}
+	if (isNull(R_sample_pairs)) {
+		if (!isNull(R_relative_error)) {
+			iRscc_error("`R_relative_error` must be NULL when `R_sample_pairs` is NULL.");
+		}
+	} else {
+		if (!isReal(R_sample_pairs)) {
+			iRscc_error("`R_sample_pairs` must be NULL or double.");
+		}
+		if (!isReal(R_relative_error)) {
+			iRscc_error("`R_relative_error` must be double.");
+		}
+	}
 
 	const uint64_t num_data_points = (uint64_t) idist_num_data_points(R_distances);
 	const uint64_t num_clusters = (uint64_t) asInteger(getAttrib(R_clustering, install("cluster_count")));
@@ -162,10 +176,25 @@ SEXP Rscc_get_clustering_stats(const SEXP R_distances,
 		iRscc_scc_error();
 	}
 
+	const bool approximate = isReal(R_sample_pairs);
 	scc_ClusteringStats clust_stats;
-	if ((ec = scc_get_clustering_stats(Rscc_get_distances_pointer(R_distances),
-	                                   clustering,
-	                                   &clust_stats)) != SCC_ER_OK) {
+	if (approximate) {
+		const double sample_pairs = asReal(R_sample_pairs);
+		if (!(sample_pairs >= 1.0) || !(sample_pairs < 18446744073709551616.0)) {
+			scc_free_clustering(&clustering);
+			iRscc_error("`R_sample_pairs` must be positive.");
+		}
+		ec = scc_get_approximate_clustering_stats(Rscc_get_distances_pointer(R_distances),
+		                                          clustering,
+		                                          (uint64_t) sample_pairs,
+		                                          asReal(R_relative_error),
+		                                          &clust_stats);
+	} else {
+		ec = scc_get_clustering_stats(Rscc_get_distances_pointer(R_distances),
+		                              clustering,
+		                              &clust_stats);
+	}
+	if (ec != SCC_ER_OK) {
 		scc_free_clustering(&clustering);
 		iRscc_scc_error();
 	}
@@ -178,7 +207,12 @@ SEXP Rscc_get_clustering_stats(const SEXP R_distances,
 	if (clust_stats.min_cluster_size > INT_MAX) iRscc_error("Too large clusters.");
 	if (clust_stats.max_cluster_size > INT_MAX) iRscc_error("Too large clusters.");
 
-	const SEXP R_clust_stats = PROTECT(allocVector(VECSXP, 13));
+	if (clust_stats.num_sampled_clusters > INT_MAX) iRscc_error("Too many clusters.");
+
+	// Approximate statistics report how they were sampled in four extra elements
+	const R_xlen_t num_stats = approximate ? 17 : 13;
+
+	const SEXP R_clust_stats = PROTECT(allocVector(VECSXP, num_stats));
 	SET_VECTOR_ELT(R_clust_stats, 0, ScalarInteger((int) clust_stats.num_data_points));
 	SET_VECTOR_ELT(R_clust_stats, 1, ScalarInteger((int) clust_stats.num_assigned));
 	SET_VECTOR_ELT(R_clust_stats, 2, ScalarInteger((int) clust_stats.num_populated_clusters));
@@ -192,8 +226,14 @@ SEXP Rscc_get_clustering_stats(const SEXP R_distances,
 	SET_VECTOR_ELT(R_clust_stats, 10, ScalarReal(clust_stats.avg_max_dist));
 	SET_VECTOR_ELT(R_clust_stats, 11, ScalarReal(clust_stats.avg_dist_weighted));
 	SET_VECTOR_ELT(R_clust_stats, 12, ScalarReal(clust_stats.avg_dist_unweighted));
+	if (approximate) {
+		SET_VECTOR_ELT(R_clust_stats, 13, ScalarInteger((int) clust_stats.num_sampled_clusters));
+		SET_VECTOR_ELT(R_clust_stats, 14, ScalarReal(clust_stats.max_dist_upper_bound));
+		SET_VECTOR_ELT(R_clust_stats, 15, ScalarReal(clust_stats.avg_dist_weighted_margin));
+		SET_VECTOR_ELT(R_clust_stats, 16, ScalarReal(clust_stats.avg_dist_unweighted_margin));
+	}
 
-	const SEXP R_clust_stats_names = PROTECT(allocVector(STRSXP, 13));
+	const SEXP R_clust_stats_names = PROTECT(allocVector(STRSXP, num_stats));
 	SET_STRING_ELT(R_clust_stats_names, 0, mkChar("num_data_points"));
 	SET_STRING_ELT(R_clust_stats_names, 1, mkChar("num_assigned"));
 	SET_STRING_ELT(R_clust_stats_names, 2, mkChar("num_clusters"));
@@ -207,8 +247,97 @@ SEXP Rscc_get_clustering_stats(const SEXP R_distances,
 	SET_STRING_ELT(R_clust_stats_names, 10, mkChar("avg_max_dist"));
 	SET_STRING_ELT(R_clust_stats_names, 11, mkChar("avg_dist_weighted"));
 	SET_STRING_ELT(R_clust_stats_names, 12, mkChar("avg_dist_unweighted"));
+	if (approximate) {
+		SET_STRING_ELT(R_clust_stats_names, 13, mkChar("num_sampled_clusters"));
+		SET_STRING_ELT(R_clust_stats_names, 14, mkChar("max_dist_upper_bound"));
+		SET_STRING_ELT(R_clust_stats_names, 15, mkChar("avg_dist_weighted_margin"));
+		SET_STRING_ELT(R_clust_stats_names, 16, mkChar("avg_dist_unweighted_margin"));
+	}
 	setAttrib(R_clust_stats, R_NamesSymbol, R_clust_stats_names);
 
 	UNPROTECT(2);
 	return R_clust_stats;
 }
+
+
+SEXP Rscc_get_cluster_stats(const SEXP R_distances,
+                            const SEXP R_clustering)
+{
+	Rscc_set_dist_functions();
+
+	if (!isInteger(R_clustering)) {
+		iRscc_error("`R_clustering` is not a valid clustering object.");
+	}
+	if (!isInteger(getAttrib(R_clustering, install("cluster_count")))) {
+		iRscc_error("`R_clustering` is not a valid clustering object.");
+	}
+	if (!idist_check_distance_object(R_distances)) {
+		iRscc_error("`R_distances` is not a valid distance object.");
+	}
+
+	const uint64_t num_data_points = (uint64_t) idist_num_data_points(R_distances);
+	const uint64_t num_clusters = (uint64_t) asInteger(getAttrib(R_clustering, install("cluster_count")));
+
+	if (((uint64_t) xlength(R_clustering)) != num_data_points) {
+		iRscc_error("`R_distances` does not match `R_clustering`.");
+	}
+	if (num_clusters == 0) {
+		iRscc_error("`R_clustering` is empty.");
+	}
+
+	scc_ErrorCode ec;
+	scc_Clustering* clustering;
+	if ((ec = scc_init_existing_clustering(num_data_points,
+	                                       num_clusters,
+	                                       INTEGER(R_clustering),
+	                                       false,
+	                                       &clustering)) != SCC_ER_OK) {
+		iRscc_scc_error();
+	}
+
+	uint64_t* const cluster_sizes = (uint64_t*) R_alloc(num_clusters, sizeof(uint64_t)); // Automatically freed by R on return
+	if (cluster_sizes == NULL) {
+		scc_free_clustering(&clustering);
+		iRscc_error("Could not allocate memory.");
+	}
+
+	const SEXP R_size = PROTECT(allocVector(INTSXP, (R_xlen_t) num_clusters));
+	const SEXP R_diameter = PROTECT(allocVector(REALSXP, (R_xlen_t) num_clusters));
+	const SEXP R_mean_dist = PROTECT(allocVector(REALSXP, (R_xlen_t) num_clusters));
+	const SEXP R_radius = PROTECT(allocVector(REALSXP, (R_xlen_t) num_clusters));
+
+	if ((ec = scc_get_cluster_stats(Rscc_get_distances_pointer(R_distances),
+	                                clustering,
+	                                num_clusters,
+	                                cluster_sizes,
+	                                REAL(R_diameter),
+	                                REAL(R_mean_dist),
+	                                REAL(R_radius))) != SCC_ER_OK) {
+		scc_free_clustering(&clustering);
+		iRscc_scc_error();
+	}
+
+	scc_free_clustering(&clustering);
+
+	int* const size = INTEGER(R_size);
+	for (size_t c = 0; c < num_clusters; ++c) {
+		if (cluster_sizes[c] > INT_MAX) iRscc_error("Too large clusters.");
+		size[c] = (int) cluster_sizes[c];
+	}
+
+	const SEXP R_cluster_stats = PROTECT(allocVector(VECSXP, 4));
+	SET_VECTOR_ELT(R_cluster_stats, 0, R_size);
+	SET_VECTOR_ELT(R_cluster_stats, 1, R_diameter);
+	SET_VECTOR_ELT(R_cluster_stats, 2, R_mean_dist);
+	SET_VECTOR_ELT(R_cluster_stats, 3, R_radius);
+
+	const SEXP R_cluster_stats_names = PROTECT(allocVector(STRSXP, 4));
+	SET_STRING_ELT(R_cluster_stats_names, 0, mkChar("size"));
+	SET_STRING_ELT(R_cluster_stats_names, 1, mkChar("diameter"));
+	SET_STRING_ELT(R_cluster_stats_names, 2, mkChar("mean_dist"));
+	SET_STRING_ELT(R_cluster_stats_names, 3, mkChar("radius"));
+	setAttrib(R_cluster_stats, R_NamesSymbol, R_cluster_stats_names);
+
+	UNPROTECT(6);
+	return R_cluster_stats;
+}
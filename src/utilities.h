@@ -33,7 +33,13 @@ SEXP Rscc_check_clustering(SEXP R_clustering,
 
 
 SEXP Rscc_get_clustering_stats(SEXP R_distances,
-                               SEXP R_clustering);
+                               SEXP R_clustering,
+                               SEXP R_sample_pairs,
+                               SEXP R_relative_error);
+
+
+SEXP Rscc_get_cluster_stats(SEXP R_distances,
+                            SEXP R_clustering);
 
 
 #endif // ifndef RSCC_UTILITIES_HG